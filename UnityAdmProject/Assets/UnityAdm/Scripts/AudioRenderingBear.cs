@@ -16,8 +16,8 @@ namespace ADM
 
     public struct ChannelAudioBounds
     {
-        public int lowerFrameBound;
-        public int upperFrameBound;
+        public Int64 lowerFrameBound;
+        public Int64 upperFrameBound; // Inclusive. Int64.MaxValue for unbounded
     }
 
     class ItemBlockTracker
@@ -68,6 +68,7 @@ namespace ADM
             {
                 addId(id);
             }
+            mappingsDirty = true; // Either way - an item already known may have gained channels
         }
 
         public bool hasId(UInt64 id)
@@ -132,10 +133,14 @@ namespace ADM
 
                 inputChannelNums = new int[totalChs];
                 audioBounds = new ChannelAudioBounds[totalChs];
+                itemChannelStarts = new int[orderedFilteredItems.Count];
+                itemChannelCounts = new int[orderedFilteredItems.Count];
                 int arrIndex = 0;
 
                 for (int index = 0; index < orderedFilteredItems.Count; index++)
                 {
+                    itemChannelStarts[index] = arrIndex;
+                    itemChannelCounts[index] = GlobalState.metadataHandler.renderableItems[orderedFilteredItems[index].id].originChannelNums.Count;
                     for (int ch = 0; ch < GlobalState.metadataHandler.renderableItems[orderedFilteredItems[index].id].originChannelNums.Count; ch++)
                     {
                         inputChannelNums[arrIndex] = GlobalState.metadataHandler.renderableItems[orderedFilteredItems[index].id].originChannelNums[ch];
@@ -156,17 +161,16 @@ namespace ADM
             return ref inputChannelNums;
         }
 
-        public int[] getChannelIndicesForIndex(int index)
+        public int[] getChannelIndicesForIndex(int index, ref ItemDescriptor itemDescriptor)
         {
-            var chs = new int[GlobalState.metadataHandler.renderableItems[orderedFilteredItems[index].id].originChannelNums.Count];
-            int startCh = 0;
-            for (int i = 0; i < index; i++)
+            // The BEAR channel of each of the descriptor's channels, as mapped - null if any aren't mapped (yet).
+            // A block's descriptor can list fewer channels than its item has now, or more than have been mapped so far.
+            var chs = new int[itemDescriptor.channelCount];
+            for (int i = 0; i < chs.Length; i++)
             {
-                startCh += GlobalState.metadataHandler.renderableItems[orderedFilteredItems[i].id].originChannelNums.Count;
-            }
-            for (int i = 0; i < GlobalState.metadataHandler.renderableItems[orderedFilteredItems[index].id].originChannelNums.Count; i++)
-            {
-                chs[i] = startCh + i;
+                int mapped = Array.IndexOf(inputChannelNums, (int)itemDescriptor.channelNums[i], itemChannelStarts[index], itemChannelCounts[index]);
+                if (mapped < 0) return null;
+                chs[i] = mapped;
             }
             return chs;
         }
@@ -183,6 +187,8 @@ namespace ADM
         private bool mappingsDirty = false;
         private int[] inputChannelNums = new int[0];
         private ChannelAudioBounds[] audioBounds = new ChannelAudioBounds[0];
+        private int[] itemChannelStarts = new int[0]; // Per orderedFilteredItems index, in to inputChannelNums
+        private int[] itemChannelCounts = new int[0];
     }
 
     public class BearAudioRenderer : AudioRenderer
@@ -198,8 +204,8 @@ namespace ADM
 
         public bool offsetCalculated = false;
         private double scheduledStartTime;
-        public int framePosition = 0;
-        public int framePositionOffset = 0;
+        public Int64 framePosition = 0;
+        public Int64 framePositionOffset = 0;
         private bool impulseSent = false;
 
         public readonly object bearObjectsLock = new object();
@@ -227,20 +233,22 @@ namespace ADM
             audioSource.loop = false;
             audioSource.playOnAwake = false;
 
-            sampleRate = LibraryInterface.getSampleRate();
+            sampleRate = LibraryInterface.getSampleRate(LibraryInterface.session);
             if (sampleRate == 0)
             {
                 Debug.LogError("Library reported sample rate as 0");
             }
-            clipFrames = LibraryInterface.getNumberOfFrames();
-            if (clipFrames == 0)
+            Int64 availableAudioFrames = LibraryInterface.getNumberOfFrames64(LibraryInterface.session);
+            if (availableAudioFrames == 0)
             {
                 Debug.LogError("Library reported frame count as 0");
             }
             if (GlobalState.startingAdmPlayheadPosition < 0)
             {
-                clipFrames += Mathf.CeilToInt((float)((-GlobalState.startingAdmPlayheadPosition) * sampleRate));
+                availableAudioFrames += (Int64)System.Math.Ceiling((-GlobalState.startingAdmPlayheadPosition) * sampleRate);
             }
+            // AudioClip lengths are 32-bit - longer content just stops at the end of the clip
+            clipFrames = (int)System.Math.Min(availableAudioFrames, int.MaxValue);
             if (audioSource.clip)
             {
                 audioSource.clip = null;
@@ -257,7 +265,7 @@ namespace ADM
             {
                 int opBufferFrames, opBufferCount;
                 AudioSettings.GetDSPBufferSize(out opBufferFrames, out opBufferCount);
-                if (!LibraryInterface.setupBearEx(GlobalState.BearMaxObjectChannels,
+                if (!LibraryInterface.setupBearEx(LibraryInterface.session, GlobalState.BearMaxObjectChannels,
                     GlobalState.BearMaxDirectSpeakerChannels,
                     GlobalState.BearMaxHoaChannels,
                     System.Math.Max(System.Math.Max(opBufferFrames * opBufferCount, GlobalState.BearInternalBlockSize * 2), 4096),
@@ -265,7 +273,7 @@ namespace ADM
                     StringHelpers.stringToAsciiBytes(filepath),
                     StringHelpers.stringToAsciiBytes(GlobalState.BearFftImplementation)))
                 {
-                    Debug.LogError("Setup BEAR: " + LibraryInterface.getLatestExceptionString());
+                    Debug.LogError("Setup BEAR: " + LibraryInterface.getLatestExceptionString(LibraryInterface.session));
                 }
             }
             else
@@ -287,7 +295,7 @@ namespace ADM
             /// 0 = this was scheduled on initial playback.
             /// +ve = this was scheduled n sec after initial playback (probably discovered later on, so advance internal offset)
 
-            framePositionOffset = (int)((double)sampleRate * (GlobalState.startingAdmPlayheadPosition + globalLocalPlaybackDiff));
+            framePositionOffset = (Int64)((double)sampleRate * (GlobalState.startingAdmPlayheadPosition + globalLocalPlaybackDiff));
             offsetCalculated = true;
 
             if (DebugSettings.Scheduling)
@@ -314,6 +322,7 @@ namespace ADM
         {
             lock (GlobalState.metadataHandler.renderableItemsLock)
             {
+                LibraryInterface.setAudioProgrammeFilter(LibraryInterface.session, progId); // Lets the library drop other programmes' channels from its audio cache
                 bearObjects.filterByAudioProgrammeId(progId);
                 bearObjects.updateMappings(); // Forces a regen if dirty
                 bearDirectSpeakers.filterByAudioProgrammeId(progId);
@@ -327,6 +336,7 @@ namespace ADM
         {
             lock (GlobalState.metadataHandler.renderableItemsLock)
             {
+                LibraryInterface.setAudioProgrammeFilter(LibraryInterface.session, -1);
                 bearObjects.removeFilter();
                 bearObjects.updateMappings(); // Forces a regen if dirty
                 bearDirectSpeakers.removeFilter();
@@ -339,6 +349,7 @@ namespace ADM
         public void configureNewItems(ref List<UInt64> itemsAwaitingConfig)
         {
             // Don't need to do any per-object work here BUT we need to do our channel mappings
+            // Items already configured come back through here when their channels change, to be mapped again
 
             lock (GlobalState.metadataHandler.renderableItemsLock)
             {
@@ -351,7 +362,7 @@ namespace ADM
                         lock (bearObjectsLock)
                         {
                             {
-                                bearObjects.addId(id);
+                                bearObjects.addIdIfMissing(id);
                             }
                         }
                     }
@@ -360,7 +371,7 @@ namespace ADM
                         lock (bearDirectSpeakersLock)
                         {
                             {
-                                bearDirectSpeakers.addId(id);
+                                bearDirectSpeakers.addIdIfMissing(id);
                             }
                         }
                     }
@@ -369,7 +380,7 @@ namespace ADM
                         lock (bearHoaLock)
                         {
                             {
-                                bearHoa.addId(id);
+                                bearHoa.addIdIfMissing(id);
                             }
                         }
                     }
@@ -410,9 +421,9 @@ namespace ADM
             Quaternion orientation = Camera.main.transform.rotation;
 
             //NOTE: Z/Y swapped!! - different coordinate systems
-            if (!LibraryInterface.setListener(position.x, position.z, position.y, orientation.w, orientation.x, orientation.z, orientation.y))
+            if (!LibraryInterface.setListener(LibraryInterface.session, position.x, position.z, position.y, orientation.w, orientation.x, orientation.z, orientation.y))
             {
-                Debug.LogError("BEAR Render: " + LibraryInterface.getLatestExceptionString());
+                Debug.LogError("BEAR Render: " + LibraryInterface.getLatestExceptionString(LibraryInterface.session));
                 internalHaltPlayback = true;
                 return;
             }
@@ -424,11 +435,11 @@ namespace ADM
             }
 
             /* Temp: Determine coordinate system
-                var vec = LibraryInterface.getLookVec();
+                var vec = LibraryInterface.getLookVec(LibraryInterface.session);
                 Debug.Log("Current Look,  X: " + vec.x + " Y: " + vec.y + " Z: " + vec.z);
-                vec = LibraryInterface.getUpVec();
+                vec = LibraryInterface.getUpVec(LibraryInterface.session);
                 Debug.Log("90deg Up,  X: " + vec.x + " Y: " + vec.y + " Z: " + vec.z);
-                vec = LibraryInterface.getRightVec();
+                vec = LibraryInterface.getRightVec(LibraryInterface.session);
                 Debug.Log("90deg Right,  X: " + vec.x + " Y: " + vec.y + " Z: " + vec.z);
             */
         }
@@ -57,6 +57,8 @@ namespace ADM
                 {
                     var typeDef = GlobalState.metadataHandler.renderableItems[id].typeDef;
 
+                    if (channelRenderers.ContainsKey(id)) continue; // Already configured - single channel, so nothing to map again
+
                     if (typeDef == AdmTypeDefs.OBJECTS || typeDef == AdmTypeDefs.DIRECTSPEAKERS)
                     {
                         lock (GlobalState.gameObjectHandler.gameObjectsLock)
@@ -128,7 +130,7 @@ namespace ADM
         public string name;
         public int[] channelNums;
         private int sampleRate = 0;
-        private int availableAudioFrames = 0;
+        private Int64 availableAudioFrames = 0;
         private int clipFrames = 0; // May be greater than available audio frames if the starting playhead position is negative (delayed start)
         public bool internalHaltPlayback = false; // Can't stop from a thread, so use this flag to trigger on next update
 
@@ -137,13 +139,13 @@ namespace ADM
 
         private bool offsetCalculated = false;
         private double scheduledStartTime;
-        private int framePosition = 0;
-        private int framePositionOffset = 0;
+        private Int64 framePosition = 0;
+        private Int64 framePositionOffset = 0;
 
-        private int lowerFrameBound = 0;
-        private int upperFrameBound = int.MaxValue;
+        private Int64 lowerFrameBound = 0;
+        private Int64 upperFrameBound = Int64.MaxValue;
 
-        public UnityObjectChannelRender(string desiredName, int originChannelNum, int audioLowerFrameBound, int audioUpperFrameBound, GameObject parentGameObject)
+        public UnityObjectChannelRender(string desiredName, int originChannelNum, Int64 audioLowerFrameBound, Int64 audioUpperFrameBound, GameObject parentGameObject)
         {
             name = desiredName;
             channelNums = new int[] { originChannelNum };
@@ -161,12 +163,12 @@ namespace ADM
             audioSource.loop = false;
             audioSource.playOnAwake = false;
 
-            sampleRate = LibraryInterface.getSampleRate();
+            sampleRate = LibraryInterface.getSampleRate(LibraryInterface.session);
             if (sampleRate == 0)
             {
                 Debug.LogError("Library reported sample rate as 0");
             }
-            availableAudioFrames = LibraryInterface.getNumberOfFrames();
+            availableAudioFrames = LibraryInterface.getNumberOfFrames64(LibraryInterface.session);
             if (availableAudioFrames == 0)
             {
                 Debug.LogError("Library reported frame count as 0");
@@ -192,7 +194,7 @@ namespace ADM
             /// 0 = this was scheduled on initial playback.
             /// +ve = this was scheduled n sec after initial playback (probably discovered later on, so advance internal offset)
 
-            framePositionOffset = (int)((double)sampleRate * (GlobalState.startingAdmPlayheadPosition + globalLocalPlaybackDiff));
+            framePositionOffset = (Int64)((double)sampleRate * (GlobalState.startingAdmPlayheadPosition + globalLocalPlaybackDiff));
             offsetCalculated = true;
 
             if (DebugSettings.Scheduling)
@@ -223,11 +225,13 @@ namespace ADM
 
         private AudioClip createAudioClip()
         {
-            clipFrames = availableAudioFrames;
+            Int64 totalFrames = availableAudioFrames;
             if (GlobalState.startingAdmPlayheadPosition < 0)
             {
-                clipFrames += Mathf.CeilToInt((float)((-GlobalState.startingAdmPlayheadPosition) * sampleRate));
+                totalFrames += (Int64)System.Math.Ceiling((-GlobalState.startingAdmPlayheadPosition) * sampleRate);
             }
+            // AudioClip lengths are 32-bit - longer content just stops at the end of the clip
+            clipFrames = (int)System.Math.Min(totalFrames, int.MaxValue);
             AudioClip clip = AudioClip.Create(name, clipFrames, channelNums.Length, sampleRate, true, OnAudioRead, OnAudioSetPosition);
             if (DebugSettings.AudioClipConfig) Debug.Log("Creating \"" + name + "\" AudioClip from channel num: " + channelNums[0]);
             return clip;
@@ -242,9 +246,9 @@ namespace ADM
                 Debug.LogWarning("OnAudioRead for \"" + name + "\" called before setting offset!");
             }
 
-            if (!LibraryInterface.getAudioBlockBounded(framePosition + framePositionOffset, numFramesToRequest, channelNums, channelNums.Length, lowerFrameBound, upperFrameBound, data))
+            if (!LibraryInterface.getAudioBlockBounded64(LibraryInterface.session, framePosition + framePositionOffset, numFramesToRequest, channelNums, channelNums.Length, lowerFrameBound, upperFrameBound, data))
             {
-                Debug.LogError("Get Audio Block: " + LibraryInterface.getLatestExceptionString());
+                Debug.LogError("Get Audio Block: " + LibraryInterface.getLatestExceptionString(LibraryInterface.session));
                 internalHaltPlayback = true;
                 return;
             }
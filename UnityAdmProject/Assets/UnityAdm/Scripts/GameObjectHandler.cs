@@ -35,6 +35,8 @@ namespace ADM
                 {
                     foreach (var id in itemsAwaitingConfig)
                     {
+                        if (gameObjects.ContainsKey(id)) continue; // Already has one - it's only come back for its channels to be mapped again
+
                         var typeDef = GlobalState.metadataHandler.renderableItems[id].typeDef;
                         GameObject newGo = null;
 
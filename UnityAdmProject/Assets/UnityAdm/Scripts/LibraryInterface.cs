@@ -76,108 +76,334 @@ namespace ADM
         public double nfcRefDist;
     };
 
+    // An item's values which are the same from block to block - see getItemDescriptor
+    [StructLayout(LayoutKind.Sequential, CharSet = CharSet.Ansi)]
+    public struct ItemDescriptor
+    {
+        public UInt64 id;
+        public UInt32 revision; // Bumped whenever any of the values below change - see BlockRecord.descriptorRevision
+        public UInt8 typeDef;
+        public UInt8 channelCount;
+        [MarshalAs(UnmanagedType.ByValArray, SizeConst = 64)]
+        public UInt8[] channelNums;
+        [MarshalAs(UnmanagedType.ByValArray, SizeConst = 100)]
+        public CppChar[] name;
+        [MarshalAs(UnmanagedType.ByValArray, SizeConst = 64)]
+        public UInt16[] audioProgrammeId;
+        public UInt8 audioProgrammeIdCount;
+
+        public double audioStartTime;
+        public double audioEndTime;
+
+        [MarshalAs(UnmanagedType.ByValArray, SizeConst = 12)]
+        public CppChar[] audioPackFormatId;
+        public double absoluteDistance;
+        public double highPass;
+        public double lowPass;
+        [MarshalAs(UnmanagedType.ByValArray, SizeConst = 64)]
+        public CppChar[] speakerLabel;
+
+        [MarshalAs(UnmanagedType.ByValArray, SizeConst = 8)]
+        public CppChar[] normalisation;
+        [MarshalAs(UnmanagedType.ByValArray, SizeConst = 64)]
+        public Int8[] order;
+        [MarshalAs(UnmanagedType.ByValArray, SizeConst = 64)]
+        public Int8[] degree;
+        public double nfcRefDist;
+    };
+
+    // The values which change from block to block - see getNextBlockRecords
+    [StructLayout(LayoutKind.Sequential)]
+    public struct BlockRecord
+    {
+        public UInt64 id;
+        public double rTime;
+        public double duration;
+        public double interpolationLength;
+        [MarshalAs(UnmanagedType.ByValArray, SizeConst = 3)]
+        public double[] position; // x, y, z when cartesian - otherwise azimuth, elevation, distance
+
+        public float width;
+        public float height;
+        public float depth;
+        public float gain;
+        public float diffuse;
+        public float divergence;
+        public float divergenceAzimuthRange;
+        public float divergencePositionRange;
+        public float channelLockMaxDistance;
+        public UInt32 descriptorRevision; // Of the item's descriptor this block goes with - fetch it again when this differs from the one held
+
+        public CppBool jumpPosition;
+        public CppBool cartesian;
+        public CppBool channelLock;
+        public CppBool screenRef;
+    };
+
     public class LibraryInterface
     {
         const string dll = "libunityadm";
 
+        // Every call takes a session from createSession - each holds its own file, renderer and latest exception
+        [DllImport(dll)]
+        public static extern IntPtr createSession();
+
+        [DllImport(dll)]
+        public static extern void destroySession(IntPtr session);
+
+        // The player's session - only startSession/endSession change it, and both must be called from the main thread.
+        // endSession must only follow stopping the pull thread and renderers (see UnityAdm.OnDestroy) - nothing may call in to the library after it.
+        private static IntPtr _session = IntPtr.Zero;
+        public static IntPtr session
+        {
+            get { return _session; }
+        }
+
+        public static bool hasSession
+        {
+            get { return _session != IntPtr.Zero; }
+        }
+
+        public static void startSession()
+        {
+            if (_session == IntPtr.Zero)
+            {
+                _session = createSession();
+            }
+        }
+
+        public static void endSession()
+        {
+            if (_session != IntPtr.Zero)
+            {
+                IntPtr ending = _session;
+                _session = IntPtr.Zero;
+                destroySession(ending);
+            }
+        }
+
+        [DllImport(dll)]
+        public static extern int readAdm(IntPtr session, byte[] filePath);
+
+        // As readAdm, but returns once audio is available - the ADM is parsed in the background (see getAdmParseStatus)
+        [DllImport(dll)]
+        public static extern int readAdmAsync(IntPtr session, byte[] filePath);
+
+        // 0 = nothing read, 1 = parsing, 2 = ready, 3 = failed (reason in getLatestExceptionString)
+        [DllImport(dll)]
+        public static extern int getAdmParseStatus(IntPtr session);
+
+        // Buffer is not copied - keep it pinned and unchanged until the next readAdm/readAdmFromMemory
+        [DllImport(dll)]
+        public static extern int readAdmFromMemory(IntPtr session, IntPtr data, UInt64 size);
+
+        // S-ADM frames from a file of concatenated frames, or a named pipe being fed them - metadata only, no audio.
+        // Poll getAdmParseStatus for the first frame, then discover and pull blocks as usual while more arrive.
+        [DllImport(dll)]
+        public static extern int readSadm(IntPtr session, byte[] feedPath);
+
+        // Latency is from a frame fully arriving to its content being discoverable. False if not reading S-ADM.
+        [DllImport(dll)]
+        public static extern unsafe bool getSadmIngestStats(IntPtr session, UInt64* frameCount, UInt64* failedFrameCount, double* lastLatencyMs, double* meanLatencyMs, double* maxLatencyMs, UInt32* feedEnded);
+
+        [DllImport(dll)]
+        public static extern int getSampleRate(IntPtr session);
+
+        [DllImport(dll)]
+        public static extern int getNumberOfFrames(IntPtr session);
+
+        [DllImport(dll)]
+        public static extern Int64 getNumberOfFrames64(IntPtr session);
+
+        [DllImport(dll)]
+        public static extern unsafe bool getAudioBlock(IntPtr session, int startFrame, int numFrames, int[] channelNums, int channelNumsSize, float[] outputBuffer);
+
+        [DllImport(dll)]
+        public static extern unsafe bool getAudioBlock64(IntPtr session, Int64 startFrame, int numFrames, int[] channelNums, int channelNumsSize, float[] outputBuffer);
+
+        [DllImport(dll)]
+        public static extern unsafe bool getAudioBlockBounded(IntPtr session, int startFrame, int numFrames, int[] channelNums, int channelNumsSize, int lowerFrameBound, int upperFrameBound, float[] outputBuffer);
+
+        [DllImport(dll)]
+        public static extern unsafe bool getAudioBlockBounded64(IntPtr session, Int64 startFrame, int numFrames, int[] channelNums, int channelNumsSize, Int64 lowerFrameBound, Int64 upperFrameBound, float[] outputBuffer);
+
+        [DllImport(dll)]
+        public static extern bool isAudioChannelSilent(IntPtr session, int channelNum, int startFrame, int numFrames);
+
+        [DllImport(dll)]
+        public static extern bool isAudioChannelSilent64(IntPtr session, int channelNum, Int64 startFrame, int numFrames);
+
+        [DllImport(dll)]
+        public static extern bool setAudioAccessMode(IntPtr session, int mode);
+
+        [DllImport(dll)]
+        public static extern bool setAudioIoBackend(IntPtr session, int backend);
+
+        [DllImport(dll)]
+        public static extern int getAudioIoBackend(IntPtr session);
+
+        [DllImport(dll)]
+        public static extern bool setAudioReadAhead(IntPtr session, float readAheadSec);
+
+        [DllImport(dll)]
+        public static extern int getAudioReadAheadBufferedFrames(IntPtr session);
+
         [DllImport(dll)]
-        public static extern int readAdm(byte[] filePath);
+        public static extern UInt64 getAudioReadAheadUnderrunCount(IntPtr session);
 
         [DllImport(dll)]
-        public static extern int getSampleRate();
+        public static extern void setAudioCacheBudget(IntPtr session, UInt64 budgetBytes);
 
         [DllImport(dll)]
-        public static extern int getNumberOfFrames();
+        public static extern unsafe bool getAudioCacheStats(IntPtr session, UInt64* hits, UInt64* misses, UInt64* evictions, UInt64* residentBytes);
 
         [DllImport(dll)]
-        public static extern unsafe bool getAudioBlock(int startFrame, int numFrames, int[] channelNums, int channelNumsSize, float[] outputBuffer);
+        public static extern void setAudioCacheReferencedChannelsOnly(IntPtr session, bool referencedOnly);
 
         [DllImport(dll)]
-        public static extern unsafe bool getAudioBlockBounded(int startFrame, int numFrames, int[] channelNums, int channelNumsSize, int lowerFrameBound, int upperFrameBound, float[] outputBuffer);
+        public static extern void setAudioProgrammeFilter(IntPtr session, int audioProgrammeId);
 
         [DllImport(dll)]
-        public static extern int discoverNewRenderableItems();
+        public static extern int discoverNewRenderableItems(IntPtr session);
 
         [DllImport(dll)]
-        public static extern bool getNextMetadataBlock(ref RawMetadataBlock metadataBlock);
+        public static extern bool getNextMetadataBlock(IntPtr session, ref RawMetadataBlock metadataBlock);
+
+        // Fills up to capacity blocks per call, returning the count - itemIdFilter 0 and typeDefinitionFilter -1 match everything
+        [DllImport(dll)]
+        public static extern int getNextMetadataBlocks(IntPtr session, [Out] RawMetadataBlock[] metadataBlocks, int capacity, UInt64 itemIdFilter, int typeDefinitionFilter);
+
+        // As getNextMetadataBlocks, without the per-item values - get those with getItemDescriptor whenever a record's descriptorRevision is new.
+        // Stops after a record with a new revision, so the descriptor fetched then is the one that goes with it.
+        [DllImport(dll)]
+        public static extern int getNextBlockRecords(IntPtr session, [Out] BlockRecord[] blockRecords, int capacity, UInt64 itemIdFilter, int typeDefinitionFilter);
+
+        [DllImport(dll)]
+        public static extern bool getItemDescriptor(IntPtr session, UInt64 itemId, ref ItemDescriptor itemDescriptor);
+
+        // Per item, the block in effect at fromSec and those starting by toSec - returns the total, which may exceed capacity
+        [DllImport(dll)]
+        public static extern int getMetadataBlocksInRange(IntPtr session, double fromSec, double toSec, [Out] RawMetadataBlock[] metadataBlocks, int capacity, UInt64 itemIdFilter, int typeDefinitionFilter);
+
+        // getNextMetadataBlock(s) carry on from the blocks in effect at positionSec
+        [DllImport(dll)]
+        public static extern bool seekMetadata(IntPtr session, double positionSec);
+
+        // Seconds of audioBlockFormats kept in memory ahead of the render position (0 for all) - for files read from now on.
+        // When set, blocks are only returned by getNextMetadataBlock once setMetadataRenderPosition brings them in to the window.
+        [DllImport(dll)]
+        public static extern void setMetadataBlockWindow(IntPtr session, double windowSec);
+
+        // Flattened metadata is cached here, keyed by content, so repeat loads skip parsing - empty to not cache
+        [DllImport(dll)]
+        public static extern void setMetadataCacheDirectory(IntPtr session, byte[] cacheDirectory);
+
+        [DllImport(dll)]
+        public static extern bool isMetadataFromCache(IntPtr session);
+
+        [DllImport(dll)]
+        public static extern bool setMetadataRenderPosition(IntPtr session, double positionSec);
+
+        // Threads later discoveries of the current content are spread across - 0 for one per core, 1 for just the calling thread.
+        // Items are discovered with the same IDs, in the same order, either way.
+        [DllImport(dll)]
+        public static extern bool setMetadataDiscoveryThreads(IntPtr session, int threadCount);
+
+        [DllImport(dll)]
+        public static extern UInt64 getMetadataMaterialisedBlockCount(IntPtr session);
 
         [DllImport(dll, CharSet = CharSet.Ansi)]
-        private static extern IntPtr getLatestException();
-        public static string getLatestExceptionString()
+        private static extern IntPtr getLatestException(IntPtr session);
+        public static string getLatestExceptionString(IntPtr session)
         {
-            return Marshal.PtrToStringAnsi(getLatestException());
+            return Marshal.PtrToStringAnsi(getLatestException(session));
         }
 
         // BEAR
 
         [DllImport(dll)]
-        public static extern bool setupBear(int maxObjectsChannels, int maxDirectSpeakersChannels, int maxHoaChannels);
+        public static extern bool setupBear(IntPtr session, int maxObjectsChannels, int maxDirectSpeakersChannels, int maxHoaChannels);
+
+        [DllImport(dll)]
+        public static extern bool setupBearEx(IntPtr session, int maxObjectsChannels, int maxDirectSpeakersChannels, int maxHoaChannels, int maxAnticipatedBlockFrameRequest, int rendererInternalBlockFrameCount, byte[] dataPath, byte[] fftImpl);
 
         [DllImport(dll)]
-        public static extern bool setupBearEx(int maxObjectsChannels, int maxDirectSpeakersChannels, int maxHoaChannels, int maxAnticipatedBlockFrameRequest, int rendererInternalBlockFrameCount, byte[] dataPath, byte[] fftImpl);
+        public static extern bool restartBear(IntPtr session);
 
         [DllImport(dll)]
-        public static extern bool restartBear();
+        public static extern bool prewarnBearRender(IntPtr session, int startFrame, int numFrames);
 
         [DllImport(dll)]
-        public static extern bool prewarnBearRender(int startFrame, int numFrames);
+        public static extern bool prewarnBearRenderSrc(IntPtr session, int startFrame, int numFrames, int outputSampleRate, int srcType);
 
         [DllImport(dll)]
-        public static extern bool prewarnBearRenderSrc(int startFrame, int numFrames, int outputSampleRate, int srcType);
+        public static extern bool prewarnBearRender64(IntPtr session, Int64 startFrame, int numFrames);
 
         [DllImport(dll)]
-        public static extern unsafe bool getBearRender(int[] objectInputChannelNums, int objectInputChannelNumsSize,
+        public static extern bool prewarnBearRenderSrc64(IntPtr session, Int64 startFrame, int numFrames, int outputSampleRate, int srcType);
+
+        [DllImport(dll)]
+        public static extern unsafe bool getBearRender(IntPtr session, int[] objectInputChannelNums, int objectInputChannelNumsSize,
                                             int[] directSpeakersInputChannelNums, int directSpeakersInputChannelNumsSize,
                                             int[] hoaInputChannelNums, int hoaInputChannelNumsSize,
                                             float[] outputBuffer);
 
         [DllImport(dll)]
-        public static extern unsafe bool getBearRenderBounded(int[] objectInputChannelNums, ChannelAudioBounds[] objectInputAudioBounds, int objectInputCount,
+        public static extern unsafe bool getBearRenderBounded64(IntPtr session, int[] objectInputChannelNums, ChannelAudioBounds[] objectInputAudioBounds, int objectInputCount,
                                             int[] directSpeakersInputChannelNums, ChannelAudioBounds[] directSpeakersInputAudioBounds, int directSpeakersInputCount,
                                             int[] hoaInputChannelNums, ChannelAudioBounds[] hoaInputAudioBounds, int hoaInputCount,
                                             float[] outputBuffer, int outputBufferStartFrame, bool outputOverwrite);
 
         [DllImport(dll)]
-        public static extern void setBearOutputGain(float gain);
+        public static extern void setBearOutputGain(IntPtr session, float gain);
+
+        [DllImport(dll)]
+        public static extern unsafe bool addBearObjectMetadata(IntPtr session, int forBearChannel, ref RawMetadataBlock metadataBlock);
+
+        [DllImport(dll)]
+        public static extern unsafe bool addBearDirectSpeakersMetadata(IntPtr session, int forBearChannel, ref RawMetadataBlock metadataBlock);
+
+        [DllImport(dll)]
+        public static extern unsafe bool addBearHoaMetadata(IntPtr session, int[] forBearChannels, ref RawMetadataBlock metadataBlock);
 
         [DllImport(dll)]
-        public static extern unsafe bool addBearObjectMetadata(int forBearChannel, ref RawMetadataBlock metadataBlock);
+        public static extern bool addBearObjectBlock(IntPtr session, int forBearChannel, ref ItemDescriptor itemDescriptor, ref BlockRecord blockRecord);
 
         [DllImport(dll)]
-        public static extern unsafe bool addBearDirectSpeakersMetadata(int forBearChannel, ref RawMetadataBlock metadataBlock);
+        public static extern bool addBearDirectSpeakersBlock(IntPtr session, int forBearChannel, ref ItemDescriptor itemDescriptor, ref BlockRecord blockRecord);
 
         [DllImport(dll)]
-        public static extern unsafe bool addBearHoaMetadata(int[] forBearChannels, ref RawMetadataBlock metadataBlock);
+        public static extern bool addBearHoaBlock(IntPtr session, int[] forBearChannels, ref ItemDescriptor itemDescriptor, ref BlockRecord blockRecord);
 
         [DllImport(dll)]
-        public static extern bool setListener(float position_x, float position_y, float position_z, float orientation_w, float orientation_x, float orientation_y, float orientation_z);
+        public static extern bool setListener(IntPtr session, float position_x, float position_y, float position_z, float orientation_w, float orientation_x, float orientation_y, float orientation_z);
 
         // Methods to determine coordinate system
 
         [DllImport(dll)]
-        public static extern unsafe bool getListenerLook(float* orientation_x, float* orientation_y, float* orientation_z);
-        public static unsafe UnityEngine.Vector3 getLookVec()
+        public static extern unsafe bool getListenerLook(IntPtr session, float* orientation_x, float* orientation_y, float* orientation_z);
+        public static unsafe UnityEngine.Vector3 getLookVec(IntPtr session)
         {
             float x, y, z;
-            getListenerLook(&x, &y, &z);
+            getListenerLook(session, &x, &y, &z);
             return new UnityEngine.Vector3(x, y, z);
         }
 
         [DllImport(dll)]
-        public static extern unsafe bool getListenerUp(float* orientation_x, float* orientation_y, float* orientation_z);
-        public static unsafe UnityEngine.Vector3 getUpVec()
+        public static extern unsafe bool getListenerUp(IntPtr session, float* orientation_x, float* orientation_y, float* orientation_z);
+        public static unsafe UnityEngine.Vector3 getUpVec(IntPtr session)
         {
             float x, y, z;
-            getListenerUp(&x, &y, &z);
+            getListenerUp(session, &x, &y, &z);
             return new UnityEngine.Vector3(x, y, z);
         }
 
         [DllImport(dll)]
-        public static extern unsafe bool getListenerRight(float* orientation_x, float* orientation_y, float* orientation_z);
-        public static unsafe UnityEngine.Vector3 getRightVec()
+        public static extern unsafe bool getListenerRight(IntPtr session, float* orientation_x, float* orientation_y, float* orientation_z);
+        public static unsafe UnityEngine.Vector3 getRightVec(IntPtr session)
         {
             float x, y, z;
-            getListenerRight(&x, &y, &z);
+            getListenerRight(session, &x, &y, &z);
             return new UnityEngine.Vector3(x, y, z);
         }
     }
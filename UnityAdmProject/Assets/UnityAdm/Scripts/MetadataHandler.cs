@@ -27,6 +27,7 @@ namespace ADM
 
     public class RenderableItem
     {
+        public ItemDescriptor descriptor; // The latest revision - absoluteDistance is with any override applied
         public List<int> originChannelNums;
         public string name;
         public List<BlockData> blocks; // TODO: Not really blocks... ItemMetadata?
@@ -38,14 +39,14 @@ namespace ADM
         public double audioStartTime;
         public double audioEndTime;
 
-        private int _audioStartFrame = 0;
-        public int audioStartFrame
+        private Int64 _audioStartFrame = 0;
+        public Int64 audioStartFrame
         {
             get { return _audioStartFrame; }
         }
 
-        private int _audioEndFrame = int.MaxValue;
-        public int audioEndFrame
+        private Int64 _audioEndFrame = Int64.MaxValue;
+        public Int64 audioEndFrame
         {
             get { return _audioEndFrame; }
         }
@@ -53,27 +54,36 @@ namespace ADM
         public void calculateAudioFrameRange(int refSampleRate)
         {
             double sr = refSampleRate;
-            _audioStartFrame = (int)(audioStartTime * sr);
-            _audioEndFrame = int.MaxValue;
+            _audioStartFrame = (Int64)(audioStartTime * sr);
+            _audioEndFrame = Int64.MaxValue;
             if (!double.IsInfinity(audioEndTime))
             {
-                _audioEndFrame = (int)(audioEndTime * sr);
+                _audioEndFrame = (Int64)(audioEndTime * sr);
             }
         }
     };
 
     public class BlockData
     {
-        public RawMetadataBlock metadataBlock; // TODO: Try to avoid blocks since that already has a meaning in ADM and these aren't directly mappable to them (esp with combined cfs in an item)
+        public BlockRecord record; // TODO: Try to avoid blocks since that already has a meaning in ADM and these aren't directly mappable to them (esp with combined cfs in an item)
+        public ItemDescriptor descriptor; // The item's, as of this block - absoluteDistance is with any override applied
+
+        public BlockData(BlockRecord record, ItemDescriptor descriptor, Vector3 finalPosInGame, bool moveSpherically)
+        {
+            this.record = record;
+            this.descriptor = descriptor;
+            _finalPosInGame = finalPosInGame;
+            _moveSpherically = moveSpherically;
+        }
 
         public double startTime
         {
-            get { return metadataBlock.rTime; }
+            get { return record.rTime; }
         }
 
         public double duration
         {
-            get { return metadataBlock.duration; }
+            get { return record.duration; }
         }
 
         private bool _endTimeSet = false;
@@ -85,45 +95,25 @@ namespace ADM
                 if (!_endTimeSet)
                 {
                     _endTimeSet = true;
-                    _endTime = metadataBlock.rTime + metadataBlock.duration;
+                    _endTime = record.rTime + record.duration;
                 }
                 return _endTime;
             }
         }
 
+        // Worked out from the offset cartesian position when the block is stored - the record itself only keeps polar (for BEAR)
         private Vector3 _finalPosInGame;
-        private bool _finalPosInGameSet;
         public ref Vector3 finalPosInGame()
         {
-            if (!_finalPosInGameSet)
-            {
-
-                // NOTE: Z and Y are swapped!! different coordinate systems;
-                if(double.IsNaN(metadataBlock.absoluteDistance))
-                {
-                    _finalPosInGame.Set(
-                        (float)(metadataBlock.x * GlobalState.defaultReferenceDistance),
-                        (float)(metadataBlock.z * GlobalState.defaultReferenceDistance),
-                        (float)(metadataBlock.y * GlobalState.defaultReferenceDistance));
-                }
-                else
-                {
-                    _finalPosInGame.Set(
-                        (float)(metadataBlock.x * metadataBlock.absoluteDistance),
-                        (float)(metadataBlock.z * metadataBlock.absoluteDistance),
-                        (float)(metadataBlock.y * metadataBlock.absoluteDistance));
-                }
-
-                _finalPosInGameSet = true;
-            }
             return ref _finalPosInGame;
         }
 
+        private bool _moveSpherically;
         public bool moveSpherically
         {
             get
             {
-                return metadataBlock.cartesian == 0;
+                return _moveSpherically;
             }
         }
 
@@ -131,7 +121,7 @@ namespace ADM
         {
             get
             {
-                return metadataBlock.jumpPosition > 0;
+                return record.jumpPosition > 0;
             }
         }
 
@@ -139,7 +129,7 @@ namespace ADM
         {
             get
             {
-                return jumpPosition ? metadataBlock.interpolationLength : metadataBlock.duration;
+                return jumpPosition ? record.interpolationLength : record.duration;
             }
         }
 
@@ -157,7 +147,9 @@ namespace ADM
 
     public class MetadataHandler
     {
-        private RawMetadataBlock latestIncomingMetadata = new RawMetadataBlock { }; // Prevents redeclaring everytime
+        private BlockRecord[] latestIncomingRecord = new BlockRecord[1]; // Prevents redeclaring everytime
+        private BlockRecord[] incomingRecordBatch = new BlockRecord[256]; // For the initial pull - one library call per batch rather than per block
+        private ItemDescriptor latestIncomingDescriptor = new ItemDescriptor { };
         private readonly object latestIncomingMetadataLock = new object();
 
         private MetadataUpdate latestDispatchedMetadata = new MetadataUpdate { }; // Prevents redeclaring everytime
@@ -204,18 +196,18 @@ namespace ADM
 
             float startTime = Time.realtimeSinceStartup;
             if (DebugSettings.Profiling) Debug.Log("Read Starting: " + filePath);
-            int res = LibraryInterface.readAdm(StringHelpers.stringToAsciiBytes(filePath));
+            int res = LibraryInterface.readAdmAsync(LibraryInterface.session, StringHelpers.stringToAsciiBytes(filePath)); // ADM parse carries on while renderers are set up - see getBlocksInitialPull
             if (DebugSettings.Profiling) Debug.Log("Read took (ms): " + ((Time.realtimeSinceStartup - startTime) * 1000.0));
             if (res == 0)
             {
-                sampleRate = LibraryInterface.getSampleRate();
+                sampleRate = LibraryInterface.getSampleRate(LibraryInterface.session);
                 currentlyLoadedFile = filePath;
                 //getBlocksInitialPull(); Don't assume this! Other modules (renderers etc) may not be ready yet)
                 return true;
             }
             else
             {
-                Debug.LogError(LibraryInterface.getLatestExceptionString());
+                Debug.LogError(LibraryInterface.getLatestExceptionString(LibraryInterface.session));
                 return false;
             }
         }
@@ -239,7 +231,7 @@ namespace ADM
         public void shutdown()
         {
             if (DebugSettings.ModuleStartups) Debug.Log("Killing MetadataHandler...");
-            // Nothing to do here. Everything gets cleared down when the class instance is destroyed.
+            stopBlockPullThread(); // Must not outlive the session it pulls from
         }
 
         public void startBlockPullThread()
@@ -283,7 +275,7 @@ namespace ADM
                     // TODO: measure actual time since this ran (calls take time themselves)
                     Thread.Sleep(GlobalState.threadCyclePeriodMs);
                 }
-                int newItems = LibraryInterface.discoverNewRenderableItems(); // Straight to C++ lib
+                int newItems = LibraryInterface.discoverNewRenderableItems(LibraryInterface.session); // Straight to C++ lib
                 if (newItems > 0)
                 {
                     if (DebugSettings.PullStatsWorkerThread) Debug.Log("Thread discovered " + newItems + " new renderable items");
@@ -296,19 +288,40 @@ namespace ADM
         public void getBlocksInitialPull()
         {
             float startTime = Time.realtimeSinceStartup;
+            if (DebugSettings.Profiling) Debug.Log("Waiting for ADM parse... ");
+            while (LibraryInterface.getAdmParseStatus(LibraryInterface.session) == 1)
+            {
+                Thread.Sleep(1);
+            }
+            if (LibraryInterface.getAdmParseStatus(LibraryInterface.session) == 3)
+            {
+                Debug.LogError(LibraryInterface.getLatestExceptionString(LibraryInterface.session));
+            }
+            if (DebugSettings.Profiling) Debug.Log("Waited for ADM parse (ms): " + ((Time.realtimeSinceStartup - startTime) * 1000.0));
+
+            startTime = Time.realtimeSinceStartup;
             if (DebugSettings.Profiling) Debug.Log("Initial Renderable Item Discovery Starting... ");
-            int renderableItemCount = LibraryInterface.discoverNewRenderableItems(); // Straight to C++ lib
+            LibraryInterface.setMetadataDiscoveryThreads(LibraryInterface.session, 0); // Everything's discovered now, so spread it across cores
+            int renderableItemCount = LibraryInterface.discoverNewRenderableItems(LibraryInterface.session); // Straight to C++ lib
             if (DebugSettings.Profiling) Debug.Log("Initial Renderable Item Discovery took (ms): " + ((Time.realtimeSinceStartup - startTime) * 1000.0));
             if (DebugSettings.PullStatsInitial) Debug.Log("Initial renderableItemCount: " + renderableItemCount);
 
+            if (GlobalState.startingAdmPlayheadPosition > 0.0)
+            {
+                // Nothing before the start is needed - begin from the blocks in effect there
+                LibraryInterface.seekMetadata(LibraryInterface.session, GlobalState.startingAdmPlayheadPosition);
+            }
+
             startTime = Time.realtimeSinceStartup;
             if (DebugSettings.Profiling) Debug.Log("Initial Block Pull Starting... ");
             int gotBlockCount = 0;
-            while (getAnotherBlock())
+            int gotBatchCount;
+            do
             {
-                // Keep going while it's still returning true
-                gotBlockCount++;
-            }
+                // Keep going while batches are coming back full
+                gotBatchCount = getMoreBlocks();
+                gotBlockCount += gotBatchCount;
+            } while (gotBatchCount == incomingRecordBatch.Length);
             if (DebugSettings.Profiling) Debug.Log("Initial Block Pull took (ms): " + ((Time.realtimeSinceStartup - startTime) * 1000.0));
             if (DebugSettings.PullStatsInitial) Debug.Log("Initial gotBlockCount: " + gotBlockCount);
 
@@ -324,148 +337,231 @@ namespace ADM
             lock (latestIncomingMetadataLock)
             {
 
-                if (!LibraryInterface.getNextMetadataBlock(ref latestIncomingMetadata)) return false;
+                if (LibraryInterface.getNextBlockRecords(LibraryInterface.session, latestIncomingRecord, 1, 0, -1) != 1) return false;
+
+                // If here - success! latestIncomingRecord should be populated
+
+                lock (renderableItemsLock)
+                {
+                    storeIncomingBlock(ref latestIncomingRecord[0]);
+                }
+
+            }
+            return true;
+        }
 
-                // If here - success! latestMetadataBlock should be populated
+        private int getMoreBlocks()
+        {
+            lock (latestIncomingMetadataLock)
+            {
+                int count = LibraryInterface.getNextBlockRecords(LibraryInterface.session, incomingRecordBatch, incomingRecordBatch.Length, 0, -1);
 
                 lock (renderableItemsLock)
                 {
-                    if (!renderableItems.ContainsKey(latestIncomingMetadata.id))
+                    for (int i = 0; i < count; i++)
                     {
-                        prepareItem(ref latestIncomingMetadata);
-                    }
-                    for (int i = 0; i < latestIncomingMetadata.audioProgrammeIdCount; i++) {
-                        int audioProgrammeId = latestIncomingMetadata.audioProgrammeId[i];
-                        if (!renderableItems[latestIncomingMetadata.id].audioProgrammeIds.Contains(audioProgrammeId)){
-                            renderableItems[latestIncomingMetadata.id].audioProgrammeIds.Add(audioProgrammeId);
-                        }
+                        storeIncomingBlock(ref incomingRecordBatch[i]);
                     }
-                    renderableItems[latestIncomingMetadata.id].blocks.Add(populateBlockData(latestIncomingMetadata));
                 }
 
+                return count;
             }
-            return true;
         }
 
-        private BlockData populateBlockData(RawMetadataBlock metadataBlock)
+        private void storeIncomingBlock(ref BlockRecord blockRecord)
+        {
+            // Caller holds renderableItemsLock
+            RenderableItem itemData;
+            bool knownItem = renderableItems.TryGetValue(blockRecord.id, out itemData);
+            if (!knownItem || itemData.descriptor.revision != blockRecord.descriptorRevision)
+            {
+                if (!LibraryInterface.getItemDescriptor(LibraryInterface.session, blockRecord.id, ref latestIncomingDescriptor))
+                {
+                    Debug.LogWarning("No descriptor for renderable item " + blockRecord.id + ": " + LibraryInterface.getLatestExceptionString(LibraryInterface.session));
+                    return;
+                }
+                if (knownItem)
+                {
+                    reviseItem(itemData, ref latestIncomingDescriptor);
+                }
+                else
+                {
+                    prepareItem(ref latestIncomingDescriptor);
+                    itemData = renderableItems[blockRecord.id];
+                }
+            }
+            itemData.blocks.Add(populateBlockData(blockRecord, ref itemData.descriptor));
+        }
+
+        private BlockData populateBlockData(BlockRecord blockRecord, ref ItemDescriptor itemDescriptor)
         {
-            BlockData block = new BlockData();
+            double x, y, z;
+            double azimuth, elevation, distance;
 
-            if (metadataBlock.cartesian == 1)
+            if (blockRecord.cartesian == 1)
             {
-                metadataBlock.azimuth = 0.0;
-                metadataBlock.elevation = 0.0;
-                metadataBlock.distance = Mathf.Sqrt((float)((metadataBlock.x * metadataBlock.x) + (metadataBlock.y * metadataBlock.y) + (metadataBlock.z * metadataBlock.z)));
-                if (metadataBlock.distance > 0.0)
+                x = blockRecord.position[0];
+                y = blockRecord.position[1];
+                z = blockRecord.position[2];
+                azimuth = 0.0;
+                elevation = 0.0;
+                distance = Mathf.Sqrt((float)((x * x) + (y * y) + (z * z)));
+                if (distance > 0.0)
                 {
-                    metadataBlock.azimuth = -Mathf.Atan2((float)(metadataBlock.x), (float)(metadataBlock.y)) * 180.0 / Mathf.PI;
-                    metadataBlock.elevation = Mathf.Asin((float)(metadataBlock.z / metadataBlock.distance)) * 180.0 / Mathf.PI;
+                    azimuth = -Mathf.Atan2((float)(x), (float)(y)) * 180.0 / Mathf.PI;
+                    elevation = Mathf.Asin((float)(z / distance)) * 180.0 / Mathf.PI;
                 }
 
             }
+            else
+            {
+                x = y = z = 0.0;
+                azimuth = blockRecord.position[0];
+                elevation = blockRecord.position[1];
+                distance = blockRecord.position[2];
+            }
 
             // Definitely have Sph coords at this point (existing or just computed)
             // Sph offsets
             bool sphOffsetApplied = false;
-            if (metadataBlock.typeDef == (byte)AdmTypeDefs.OBJECTS)
+            if (itemDescriptor.typeDef == (byte)AdmTypeDefs.OBJECTS)
             {
                 if (GlobalState.applyObjectsSphOffset)
                 {
                     sphOffsetApplied = true;
-                    metadataBlock.azimuth += GlobalState.objectsAzimuthOffset;
-                    metadataBlock.elevation += GlobalState.objectsElevationOffset;
-                    metadataBlock.distance *= GlobalState.objectsDistanceMultiplier;
+                    azimuth += GlobalState.objectsAzimuthOffset;
+                    elevation += GlobalState.objectsElevationOffset;
+                    distance *= GlobalState.objectsDistanceMultiplier;
                 }
             }
-            else if (metadataBlock.typeDef == (byte)AdmTypeDefs.DIRECTSPEAKERS)
+            else if (itemDescriptor.typeDef == (byte)AdmTypeDefs.DIRECTSPEAKERS)
             {
                 if (GlobalState.applyDirectSpeakersSphOffset)
                 {
                     sphOffsetApplied = true;
-                    metadataBlock.azimuth += GlobalState.directSpeakersAzimuthOffset;
-                    metadataBlock.elevation += GlobalState.directSpeakersElevationOffset;
-                    metadataBlock.distance *= GlobalState.directSpeakersDistanceMultiplier;
+                    azimuth += GlobalState.directSpeakersAzimuthOffset;
+                    elevation += GlobalState.directSpeakersElevationOffset;
+                    distance *= GlobalState.directSpeakersDistanceMultiplier;
                 }
             }
 
-            if (metadataBlock.cartesian == 0 || sphOffsetApplied) // Either never had cartesian, or carts will need updating due to sph offsetting
+            if (blockRecord.cartesian == 0 || sphOffsetApplied) // Either never had cartesian, or carts will need updating due to sph offsetting
             {
                 // Update Cartesian
-                metadataBlock.x = metadataBlock.distance * Mathf.Sin((float)(-metadataBlock.azimuth * Mathf.PI / 180.0)) * Mathf.Cos((float)(metadataBlock.elevation * Mathf.PI / 180.0));
-                metadataBlock.y = metadataBlock.distance * Mathf.Cos((float)(-metadataBlock.azimuth * Mathf.PI / 180.0)) * Mathf.Cos((float)(metadataBlock.elevation * Mathf.PI / 180.0));
-                metadataBlock.z = metadataBlock.distance * Mathf.Sin((float)(metadataBlock.elevation * Mathf.PI / 180.0));
+                x = distance * Mathf.Sin((float)(-azimuth * Mathf.PI / 180.0)) * Mathf.Cos((float)(elevation * Mathf.PI / 180.0));
+                y = distance * Mathf.Cos((float)(-azimuth * Mathf.PI / 180.0)) * Mathf.Cos((float)(elevation * Mathf.PI / 180.0));
+                z = distance * Mathf.Sin((float)(elevation * Mathf.PI / 180.0));
             }
 
             // Cart offsets
             bool cartOffsetApplied = false;
-            if (metadataBlock.typeDef == (byte)AdmTypeDefs.OBJECTS)
+            if (itemDescriptor.typeDef == (byte)AdmTypeDefs.OBJECTS)
             {
                 if (GlobalState.applyObjectsCartOffset)
                 {
                     cartOffsetApplied = true;
-                    metadataBlock.x += GlobalState.objectsXOffset;
-                    metadataBlock.y += GlobalState.objectsYOffset;
-                    metadataBlock.z += GlobalState.objectsZOffset;
+                    x += GlobalState.objectsXOffset;
+                    y += GlobalState.objectsYOffset;
+                    z += GlobalState.objectsZOffset;
                 }
             }
-            else if (metadataBlock.typeDef == (byte)AdmTypeDefs.DIRECTSPEAKERS)
+            else if (itemDescriptor.typeDef == (byte)AdmTypeDefs.DIRECTSPEAKERS)
             {
                 if (GlobalState.applyDirectSpeakersCartOffset)
                 {
                     cartOffsetApplied = true;
-                    metadataBlock.x += GlobalState.directSpeakersXOffset;
-                    metadataBlock.y += GlobalState.directSpeakersYOffset;
-                    metadataBlock.z += GlobalState.directSpeakersZOffset;
+                    x += GlobalState.directSpeakersXOffset;
+                    y += GlobalState.directSpeakersYOffset;
+                    z += GlobalState.directSpeakersZOffset;
                 }
             }
 
             if (cartOffsetApplied) // Sph will need updating due to cart offsetting
             {
-                metadataBlock.azimuth = 0.0;
-                metadataBlock.elevation = 0.0;
-                metadataBlock.distance = Mathf.Sqrt((float)((metadataBlock.x * metadataBlock.x) + (metadataBlock.y * metadataBlock.y) + (metadataBlock.z * metadataBlock.z)));
-                if (metadataBlock.distance > 0.0)
+                azimuth = 0.0;
+                elevation = 0.0;
+                distance = Mathf.Sqrt((float)((x * x) + (y * y) + (z * z)));
+                if (distance > 0.0)
                 {
-                    metadataBlock.azimuth = -Mathf.Atan2((float)(metadataBlock.x), (float)(metadataBlock.y)) * 180.0 / Mathf.PI;
-                    metadataBlock.elevation = Mathf.Asin((float)(metadataBlock.z / metadataBlock.distance)) * 180.0 / Mathf.PI;
+                    azimuth = -Mathf.Atan2((float)(x), (float)(y)) * 180.0 / Mathf.PI;
+                    elevation = Mathf.Asin((float)(z / distance)) * 180.0 / Mathf.PI;
                 }
 
             }
 
-            //absoluteDistance
-            if (GlobalState.alwaysOverrideAbsoluteDistance || double.IsNaN(metadataBlock.absoluteDistance) || metadataBlock.absoluteDistance < 0.0)
+            // NOTE: Z and Y are swapped!! different coordinate systems;
+            // (absoluteDistance already defaulted by prepareItem)
+            Vector3 finalPosInGame = new Vector3(
+                (float)(x * itemDescriptor.absoluteDistance),
+                (float)(z * itemDescriptor.absoluteDistance),
+                (float)(y * itemDescriptor.absoluteDistance));
+            bool moveSpherically = blockRecord.cartesian == 0;
+
+            // BEAR takes polar
+            blockRecord.position = new double[] { azimuth, elevation, distance };
+            blockRecord.cartesian = 0;
+
+            return new BlockData(blockRecord, itemDescriptor, finalPosInGame, moveSpherically);
+        }
+
+        private void prepareItem(ref ItemDescriptor itemDescriptor)
+        {
+            RenderableItem itemData = new RenderableItem();
+            describeItem(itemData, ref itemDescriptor);
+            itemData.blocks = new List<BlockData>();
+            itemData.currentBlockIndex = 0;
+
+            renderableItems.Add(itemDescriptor.id, itemData);
+            lock (itemsAwaitingCreateLock)
             {
-                metadataBlock.absoluteDistance = GlobalState.defaultReferenceDistance;
+                itemsAwaitingCreate.Add(itemDescriptor.id);
             }
+        }
 
-            block.metadataBlock = metadataBlock;
+        private void reviseItem(RenderableItem itemData, ref ItemDescriptor itemDescriptor)
+        {
+            // A later revision of a known item's descriptor - its blocks so far keep the revision they came with
+            bool channelsChanged = itemData.originChannelNums.Count != itemDescriptor.channelCount;
+            for (int i = 0; !channelsChanged && i < itemDescriptor.channelCount; i++)
+            {
+                channelsChanged = itemData.originChannelNums[i] != itemDescriptor.channelNums[i];
+            }
+            describeItem(itemData, ref itemDescriptor);
 
-            return block;
+            if (channelsChanged)
+            {
+                // Channels have joined (HOA, as their metadata starts) - renderers map them again
+                lock (itemsAwaitingCreateLock)
+                {
+                    if (!itemsAwaitingCreate.Contains(itemDescriptor.id)) itemsAwaitingCreate.Add(itemDescriptor.id);
+                }
+            }
         }
 
-        private void prepareItem(ref RawMetadataBlock metadataBlock)
+        private void describeItem(RenderableItem itemData, ref ItemDescriptor itemDescriptor)
         {
-            RenderableItem itemData = new RenderableItem();
+            //absoluteDistance
+            if (GlobalState.alwaysOverrideAbsoluteDistance || double.IsNaN(itemDescriptor.absoluteDistance) || itemDescriptor.absoluteDistance < 0.0)
+            {
+                itemDescriptor.absoluteDistance = GlobalState.defaultReferenceDistance;
+            }
+            itemData.descriptor = itemDescriptor;
 
             itemData.originChannelNums = new List<int>();
-            for (int i = 0; i < metadataBlock.channelCount; i++)
+            for (int i = 0; i < itemDescriptor.channelCount; i++)
             {
-                itemData.originChannelNums.Add(metadataBlock.channelNums[i]);
+                itemData.originChannelNums.Add(itemDescriptor.channelNums[i]);
             }
             itemData.audioProgrammeIds = new List<int>();
-            itemData.name = StringHelpers.asciiBytesToString(metadataBlock.name);
-            itemData.blocks = new List<BlockData>();
-            itemData.currentBlockIndex = 0;
-            itemData.typeDef = (AdmTypeDefs)metadataBlock.typeDef;
-            itemData.audioStartTime = metadataBlock.audioStartTime;
-            itemData.audioEndTime = metadataBlock.audioEndTime;
-            itemData.calculateAudioFrameRange(sampleRate);
-
-            renderableItems.Add(metadataBlock.id, itemData);
-            lock (itemsAwaitingCreateLock)
+            for (int i = 0; i < itemDescriptor.audioProgrammeIdCount; i++)
             {
-                itemsAwaitingCreate.Add(metadataBlock.id);
+                itemData.audioProgrammeIds.Add(itemDescriptor.audioProgrammeId[i]);
             }
+            itemData.name = StringHelpers.asciiBytesToString(itemDescriptor.name);
+            itemData.typeDef = (AdmTypeDefs)itemDescriptor.typeDef;
+            itemData.audioStartTime = itemDescriptor.audioStartTime;
+            itemData.audioEndTime = itemDescriptor.audioEndTime;
+            itemData.calculateAudioFrameRange(sampleRate);
         }
 
         public void createPreparedItems()
@@ -602,7 +698,7 @@ namespace ADM
                     if (processingBlockIndex > 0)
                     {
                         startingPos = itemData.blocks[processingBlockIndex - 1].finalPosInGame();
-                        startingGain = (float)itemData.blocks[processingBlockIndex - 1].metadataBlock.gain;
+                        startingGain = itemData.blocks[processingBlockIndex - 1].record.gain;
                     }
 
                     if (blockData.moveSpherically)
@@ -614,7 +710,7 @@ namespace ADM
                         latestDispatchedMetadata.inGamePosition = Vector3.Lerp(startingPos, blockData.finalPosInGame(), interpolant);
                     }
 
-                    float gainDiff = (float)blockData.metadataBlock.gain - startingGain;
+                    float gainDiff = blockData.record.gain - startingGain;
                     latestDispatchedMetadata.gain = startingGain + interpolant * gainDiff;
 
                     if (DebugSettings.MetadataRunStates && itemData.metadataRunState != MetadataRunState.PROCESSING)
@@ -631,7 +727,7 @@ namespace ADM
                     // - Ensure set to final position and gain of last completed block
                     var blockData = itemData.blocks[lastCompletedBlockIndex];
                     latestDispatchedMetadata.inGamePosition = blockData.finalPosInGame();
-                    latestDispatchedMetadata.gain = (float)blockData.metadataBlock.gain;
+                    latestDispatchedMetadata.gain = blockData.record.gain;
                     if (DebugSettings.MetadataRunStates && itemData.metadataRunState != MetadataRunState.IN_GAP)
                     {
                         Debug.Log("Metadata gap for \"" + itemData.name + "\"");
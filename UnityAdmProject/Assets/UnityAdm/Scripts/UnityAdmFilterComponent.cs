@@ -65,7 +65,7 @@ namespace ADM
             }
             else
             {
-                LibraryInterface.setBearOutputGain(GlobalState.BearOutputGain);
+                LibraryInterface.setBearOutputGain(LibraryInterface.session, GlobalState.BearOutputGain);
             }
 
             sampleRateDbl = AudioSettings.outputSampleRate;
@@ -162,15 +162,15 @@ namespace ADM
 
             int dataWriteFrameCount = dataWriteEndFrame - dataWriteStartFrame;
 
-            if (dataWriteFrameCount == 0)
+            if (dataWriteFrameCount == 0 || !LibraryInterface.hasSession)
             {
                 return;
             }
 
             Profiler.BeginSample("prewarnBearRenderSrc");
-            if (!LibraryInterface.prewarnBearRenderSrc(bear.framePosition + bear.framePositionOffset, dataWriteFrameCount, sampleRateInt, (int)GlobalState.BearSrcType))
+            if (!LibraryInterface.prewarnBearRenderSrc64(LibraryInterface.session, bear.framePosition + bear.framePositionOffset, dataWriteFrameCount, sampleRateInt, (int)GlobalState.BearSrcType))
             {
-                Debug.LogError("BEAR Prewarn: " + LibraryInterface.getLatestExceptionString());
+                Debug.LogError("BEAR Prewarn: " + LibraryInterface.getLatestExceptionString(LibraryInterface.session));
                 bear.internalHaltPlayback = true;
                 return;
             }
@@ -185,11 +185,12 @@ namespace ADM
                     {
                         UInt64 id = bear.bearObjects.getIdAtIndex(index);
                         int blockNum = bear.bearObjects.getBlockSendCounterAtIndex(index);
-                        int blockNumLimit = GlobalState.metadataHandler.renderableItems[id].blocks.Count;
+                        RenderableItem item = GlobalState.metadataHandler.renderableItems[id];
+                        int blockNumLimit = item.blocks.Count;
 
                         while (blockNum < blockNumLimit)
                         {
-                            if (!LibraryInterface.addBearObjectMetadata(index, ref GlobalState.metadataHandler.renderableItems[id].blocks[blockNum].metadataBlock))
+                            if (!LibraryInterface.addBearObjectBlock(LibraryInterface.session, index, ref item.blocks[blockNum].descriptor, ref item.blocks[blockNum].record))
                             {
                                 break;
                             }
@@ -204,11 +205,12 @@ namespace ADM
                     {
                         UInt64 id = bear.bearDirectSpeakers.getIdAtIndex(index);
                         int blockNum = bear.bearDirectSpeakers.getBlockSendCounterAtIndex(index);
-                        int blockNumLimit = GlobalState.metadataHandler.renderableItems[id].blocks.Count;
+                        RenderableItem item = GlobalState.metadataHandler.renderableItems[id];
+                        int blockNumLimit = item.blocks.Count;
 
                         while (blockNum < blockNumLimit)
                         {
-                            if (!LibraryInterface.addBearDirectSpeakersMetadata(index, ref GlobalState.metadataHandler.renderableItems[id].blocks[blockNum].metadataBlock))
+                            if (!LibraryInterface.addBearDirectSpeakersBlock(LibraryInterface.session, index, ref item.blocks[blockNum].descriptor, ref item.blocks[blockNum].record))
                             {
                                 break;
                             }
@@ -223,11 +225,17 @@ namespace ADM
                     {
                         UInt64 id = bear.bearHoa.getIdAtIndex(index);
                         int blockNum = bear.bearHoa.getBlockSendCounterAtIndex(index);
-                        int blockNumLimit = GlobalState.metadataHandler.renderableItems[id].blocks.Count;
+                        RenderableItem item = GlobalState.metadataHandler.renderableItems[id];
+                        int blockNumLimit = item.blocks.Count;
 
                         while (blockNum < blockNumLimit)
                         {
-                            if (!LibraryInterface.addBearHoaMetadata(bear.bearHoa.getChannelIndicesForIndex(index), ref GlobalState.metadataHandler.renderableItems[id].blocks[blockNum].metadataBlock))
+                            int[] channelIndices = bear.bearHoa.getChannelIndicesForIndex(index, ref item.blocks[blockNum].descriptor);
+                            if (channelIndices == null)
+                            {
+                                break; // Channels have joined - wait for them to be mapped
+                            }
+                            if (!LibraryInterface.addBearHoaBlock(LibraryInterface.session, channelIndices, ref item.blocks[blockNum].descriptor, ref item.blocks[blockNum].record))
                             {
                                 break;
                             }
@@ -238,7 +246,8 @@ namespace ADM
             }
 
             Profiler.BeginSample("getBearRenderBounded");
-            bool renderRes = LibraryInterface.getBearRenderBounded(
+            bool renderRes = LibraryInterface.getBearRenderBounded64(
+                LibraryInterface.session,
                 bear.bearObjects.getChannelMap(),
                 bear.bearObjects.getAudioBounds(),
                 bear.bearObjects.countIds(),
@@ -253,7 +262,7 @@ namespace ADM
 
             if (!renderRes)
             {
-                Debug.LogWarning("BEAR Render: " + LibraryInterface.getLatestExceptionString());
+                Debug.LogWarning("BEAR Render: " + LibraryInterface.getLatestExceptionString(LibraryInterface.session));
             }
 
             bear.framePosition += dataWriteFrameCount;
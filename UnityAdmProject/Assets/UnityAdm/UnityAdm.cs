@@ -100,6 +100,11 @@ public class UnityAdm : MonoBehaviour
 
     private void Awake()
     {
+        // The session is created here on the main thread, before anything (including the audio and pull threads) can use it
+        LibraryInterface.startSession();
+#if UNITY_EDITOR
+        AssemblyReloadEvents.beforeAssemblyReload += endSession;
+#endif
     }
 
     private void Start()
@@ -221,9 +226,9 @@ public class UnityAdm : MonoBehaviour
         }
 
         // Update BEAR output gain if BEAR renderer selected
-        if (GlobalState.audioRendererType == AudioRendererType.BEAR)
+        if (GlobalState.audioRendererType == AudioRendererType.BEAR && LibraryInterface.hasSession)
         {
-            LibraryInterface.setBearOutputGain(BEAROutputGain);
+            LibraryInterface.setBearOutputGain(LibraryInterface.session, BEAROutputGain);
         }
         GlobalState.BearOutputGain = BEAROutputGain;
         if (BEARMaxObjectChannels > 128) BEARMaxObjectChannels = 128;
@@ -400,7 +405,7 @@ public class UnityAdm : MonoBehaviour
                 renderer.setAudioProgrammeId(GlobalState.selectedAudioProgrammeId);
             }
             GlobalState.audioRenderer = renderer;
-            LibraryInterface.setBearOutputGain(BEAROutputGain);
+            LibraryInterface.setBearOutputGain(LibraryInterface.session, BEAROutputGain);
         }
 
         GlobalState.metadataHandler.getBlocksInitialPull();
@@ -408,8 +413,18 @@ public class UnityAdm : MonoBehaviour
 
     void OnDestroy()
     {
+        endSession();
+    }
+
+    private void endSession()
+    {
+#if UNITY_EDITOR
+        AssemblyReloadEvents.beforeAssemblyReload -= endSession;
+#endif
+        // Renderers and the pull thread must be stopped before the session goes - they call in to it from other threads
         stopPlayback();
         shutdown();
+        LibraryInterface.endSession();
     }
 
 }
@@ -0,0 +1,148 @@
+// Checks the block records and item descriptors served from a document match, byte for byte, those served from the same
+//  document once flattened (as the metadata cache hands them back) - for objects and a first-order HOA item.
+// Usage: descriptor_check [object count (default 20)]
+
+#include <adm/adm.hpp>
+#include <adm/utilities/object_creation.hpp>
+#include <bw64/bw64.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "ChnaIndex.h"
+#include "Metadata.h"
+#include "Readers.h"
+
+namespace {
+    class CheckReader : public Reader
+    {
+    public:
+        CheckReader(const std::vector<bw64::AudioId>& audioIds)
+        {
+            chnaIndex.build(audioIds);
+        }
+
+        std::shared_ptr<AudioExtractor> getAudio() override { return nullptr; }
+        std::shared_ptr<MetadataExtractor> getMetadata() override { return nullptr; }
+        AdmParseStatus getAdmParseStatus() override { return AdmParseStatus::READY; }
+        std::string getAdmParseError() override { return std::string(); }
+
+        int getChannelNumFor(std::shared_ptr<adm::AudioTrackUid> audioTrackUid) override
+        {
+            return chnaIndex.getChannelNumFor(audioTrackUid->get<adm::AudioTrackUidId>().get<adm::AudioTrackUidIdValue>().get());
+        }
+
+    private:
+        ChnaIndex chnaIndex;
+    };
+
+    struct Served
+    {
+        std::vector<BlockRecord> blockRecords;
+        std::vector<ItemDescriptor> itemDescriptors; // Fetched whenever a record brings a new revision, as the host does
+    };
+
+    Served serveAll(MetadataExtractor& extractor)
+    {
+        Served served;
+        extractor.discoverNewRenderableItems();
+        std::vector<BlockRecord> blockRecords(16);
+        while(true) {
+            memset(blockRecords.data(), 0, blockRecords.size() * sizeof(BlockRecord));
+            int count = extractor.getNextBlockRecords(blockRecords.data(), (int)blockRecords.size());
+            if(count == 0) break;
+            served.blockRecords.insert(served.blockRecords.end(), blockRecords.begin(), blockRecords.begin() + count);
+            ItemDescriptor itemDescriptor;
+            memset(&itemDescriptor, 0, sizeof(ItemDescriptor));
+            if(extractor.getItemDescriptor(blockRecords[count - 1].id, &itemDescriptor)) {
+                served.itemDescriptors.push_back(itemDescriptor);
+            }
+        }
+        return served;
+    }
+
+    template<typename T>
+    bool sameBytes(const std::vector<T>& a, const std::vector<T>& b)
+    {
+        return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+    }
+
+    bw64::AudioId makeAudioId(int track, std::shared_ptr<adm::AudioTrackUid> audioTrackUid, std::shared_ptr<adm::AudioTrackFormat> audioTrackFormat, std::shared_ptr<adm::AudioPackFormat> audioPackFormat)
+    {
+        return bw64::AudioId(track + 1,
+                             adm::formatId(audioTrackUid->get<adm::AudioTrackUidId>()),
+                             adm::formatId(audioTrackFormat->get<adm::AudioTrackFormatId>()),
+                             adm::formatId(audioPackFormat->get<adm::AudioPackFormatId>()));
+    }
+
+    void addHoaTo(std::shared_ptr<adm::Document> document, std::shared_ptr<adm::AudioContent> audioContent, std::vector<bw64::AudioId>& audioIds)
+    {
+        auto audioPackFormat = adm::AudioPackFormatHoa::create(adm::AudioPackFormatName("HOA"));
+        auto audioObject = adm::AudioObject::create(adm::AudioObjectName("HOA"));
+        audioObject->addReference(audioPackFormat);
+        std::vector<std::pair<int, int>> orderDegrees{ { 0, 0 }, { 1, -1 }, { 1, 0 }, { 1, 1 } };
+        std::vector<std::shared_ptr<adm::AudioTrackUid>> audioTrackUids;
+        std::vector<std::shared_ptr<adm::AudioTrackFormat>> audioTrackFormats;
+        for(auto& orderDegree : orderDegrees) {
+            std::string name = "HOA " + std::to_string(orderDegree.first) + " " + std::to_string(orderDegree.second);
+            auto audioChannelFormat = adm::AudioChannelFormat::create(adm::AudioChannelFormatName(name), adm::TypeDefinition::HOA);
+            audioChannelFormat->add(adm::AudioBlockFormatHoa(adm::Order(orderDegree.first), adm::Degree(orderDegree.second)));
+            audioPackFormat->addReference(audioChannelFormat);
+            auto audioStreamFormat = adm::AudioStreamFormat::create(adm::AudioStreamFormatName(name), adm::FormatDefinition::PCM);
+            audioStreamFormat->setReference(audioChannelFormat);
+            auto audioTrackFormat = adm::AudioTrackFormat::create(adm::AudioTrackFormatName(name), adm::FormatDefinition::PCM);
+            audioTrackFormat->setReference(audioStreamFormat);
+            auto audioTrackUid = adm::AudioTrackUid::create();
+            audioTrackUid->setReference(audioTrackFormat);
+            audioTrackUid->setReference(audioPackFormat);
+            audioObject->addReference(audioTrackUid);
+            audioTrackUids.push_back(audioTrackUid);
+            audioTrackFormats.push_back(audioTrackFormat);
+        }
+        audioContent->addReference(audioObject);
+        document->add(audioObject); // IDs are given on adding, so the CHNA entries come after
+        for(size_t index = 0; index < audioTrackUids.size(); index++) {
+            audioIds.push_back(makeAudioId((int)audioIds.size(), audioTrackUids[index], audioTrackFormats[index], audioPackFormat));
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int objectCount = argc > 1 ? std::atoi(argv[1]) : 20;
+
+    auto document = adm::Document::create();
+    auto audioProgramme = adm::AudioProgramme::create(adm::AudioProgrammeName("Check"));
+    auto audioContent = adm::AudioContent::create(adm::AudioContentName("Check"));
+    audioProgramme->addReference(audioContent);
+    document->add(audioProgramme);
+
+    std::vector<bw64::AudioId> audioIds;
+    for(int object = 0; object < objectCount; object++) {
+        auto holder = adm::addSimpleObjectTo(document, "Object " + std::to_string(object));
+        audioContent->addReference(holder.audioObject);
+        audioIds.push_back(makeAudioId((int)audioIds.size(), holder.audioTrackUid, holder.audioTrackFormat, holder.audioPackFormat));
+    }
+    addHoaTo(document, audioContent, audioIds);
+
+    CheckReader reader(audioIds);
+    MetadataExtractor liveExtractor(&reader, document);
+    Served live = serveAll(liveExtractor);
+
+    MetadataExtractor flatteningExtractor(&reader, document);
+    MetadataExtractor flattenedExtractor(&reader, flatteningExtractor.flatten());
+    Served flattened = serveAll(flattenedExtractor);
+
+    bool recordsMatch = sameBytes(live.blockRecords, flattened.blockRecords);
+    bool descriptorsMatch = sameBytes(live.itemDescriptors, flattened.itemDescriptors);
+    std::printf("%zu block records, %zu item descriptors\n", live.blockRecords.size(), live.itemDescriptors.size());
+    if(!recordsMatch) {
+        std::printf("  block records differ (%zu flattened)\n", flattened.blockRecords.size());
+    }
+    if(!descriptorsMatch) {
+        std::printf("  item descriptors differ (%zu flattened)\n", flattened.itemDescriptors.size());
+    }
+
+    return !live.itemDescriptors.empty() && recordsMatch && descriptorsMatch ? 0 : 1;
+}
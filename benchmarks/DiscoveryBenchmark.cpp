@@ -0,0 +1,185 @@
+// Times MetadataExtractor discovery on synthetic documents of simple objects (one track each), with CHNA lookups through
+//  ChnaIndex against the string-comparing linear scan it replaced - then indexed again, with channels created across every hardware thread.
+// Then grows the document by 1% per step (as S-ADM frames would), timing discovery of just what was added against discovering the
+//  whole document afresh.
+// Usage: discovery_benchmark [track count (default 1000)] [growth steps (default 20)]
+
+#include <adm/adm.hpp>
+#include <adm/utilities/object_creation.hpp>
+#include <bw64/bw64.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ChnaIndex.h"
+#include "Metadata.h"
+#include "Readers.h"
+
+namespace {
+    const int repeats = 5; // Best of
+
+    class BenchmarkReader : public Reader
+    {
+    public:
+        BenchmarkReader(const std::vector<bw64::AudioId>& audioIds, bool indexed) : audioIds{ audioIds }, indexed{ indexed }
+        {
+            if(indexed) chnaIndex.build(audioIds);
+        }
+
+        std::shared_ptr<AudioExtractor> getAudio() override { return nullptr; }
+        std::shared_ptr<MetadataExtractor> getMetadata() override { return nullptr; }
+        AdmParseStatus getAdmParseStatus() override { return AdmParseStatus::READY; }
+        std::string getAdmParseError() override { return std::string(); }
+
+        void addAudioId(const bw64::AudioId& audioId)
+        {
+            audioIds.push_back(audioId);
+            uint32_t audioTrackUidValue = 0;
+            if(indexed && parseAudioTrackUidValue(audioId.uid(), audioTrackUidValue)) {
+                chnaIndex.add(audioTrackUidValue, audioId.trackIndex() - 1);
+            }
+        }
+
+        int getChannelNumFor(std::shared_ptr<adm::AudioTrackUid> audioTrackUid) override
+        {
+            if(indexed) {
+                return chnaIndex.getChannelNumFor(audioTrackUid->get<adm::AudioTrackUidId>().get<adm::AudioTrackUidIdValue>().get());
+            }
+            // As FileReader did before ChnaIndex
+            auto targetAudioTrackUidRefStr = adm::formatId(audioTrackUid->get<adm::AudioTrackUidId>());
+            for(auto& audioId : audioIds) {
+                if(targetAudioTrackUidRefStr == audioId.uid()) {
+                    return audioId.trackIndex() - 1;
+                }
+            }
+            return -1;
+        }
+
+    private:
+        std::vector<bw64::AudioId> audioIds;
+        bool indexed;
+        ChnaIndex chnaIndex;
+    };
+
+    double secondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Best time to build the reader (and so its index) and discover everything from scratch
+    double bestDiscoverySeconds(std::shared_ptr<adm::Document> document, const std::vector<bw64::AudioId>& audioIds, bool indexed, int threadCount, int& discovered)
+    {
+        double best = 1e9;
+        for(int repeat = 0; repeat < repeats; repeat++) {
+            auto start = std::chrono::steady_clock::now();
+            BenchmarkReader reader(audioIds, indexed);
+            MetadataExtractor extractor(&reader, document);
+            extractor.setDiscoveryThreadCount(threadCount);
+            discovered = extractor.discoverNewRenderableItems();
+            best = std::min(best, secondsSince(start));
+        }
+        return best;
+    }
+
+    void addTracks(std::shared_ptr<adm::Document> document, std::shared_ptr<adm::AudioContent> audioContent, int count, std::vector<bw64::AudioId>& audioIds)
+    {
+        for(int added = 0; added < count; added++) {
+            int track = (int)audioIds.size();
+            auto holder = adm::addSimpleObjectTo(document, "Object " + std::to_string(track));
+            audioContent->addReference(holder.audioObject);
+            audioIds.push_back(bw64::AudioId(track + 1,
+                                             adm::formatId(holder.audioTrackUid->get<adm::AudioTrackUidId>()),
+                                             adm::formatId(holder.audioTrackFormat->get<adm::AudioTrackFormatId>()),
+                                             adm::formatId(holder.audioPackFormat->get<adm::AudioPackFormatId>())));
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    int trackCount = argc > 1 ? std::atoi(argv[1]) : 1000;
+    int growthSteps = argc > 2 ? std::atoi(argv[2]) : 20;
+
+    auto document = adm::Document::create();
+    auto audioProgramme = adm::AudioProgramme::create(adm::AudioProgrammeName("Benchmark"));
+    auto audioContent = adm::AudioContent::create(adm::AudioContentName("Benchmark"));
+    audioProgramme->addReference(audioContent);
+    document->add(audioProgramme);
+
+    std::vector<bw64::AudioId> audioIds;
+    addTracks(document, audioContent, trackCount, audioIds);
+
+    std::printf("%d tracks\n", trackCount);
+    int linearDiscovered = 0;
+    int indexedDiscovered = 0;
+    int parallelDiscovered = 0;
+    double linearSeconds = bestDiscoverySeconds(document, audioIds, false, 1, linearDiscovered);
+    double indexedSeconds = bestDiscoverySeconds(document, audioIds, true, 1, indexedDiscovered);
+    double parallelSeconds = bestDiscoverySeconds(document, audioIds, true, 0, parallelDiscovered);
+    std::printf("  %-8s %9.2f ms  (%d items)\n", "linear", linearSeconds * 1000.0, linearDiscovered);
+    std::printf("  %-8s %9.2f ms  (%d items)\n", "indexed", indexedSeconds * 1000.0, indexedDiscovered);
+    std::printf("  %.1fx\n", linearSeconds / indexedSeconds);
+    std::printf("  %-8s %9.2f ms  (%d items, %u threads)\n", "parallel", parallelSeconds * 1000.0, parallelDiscovered, std::thread::hardware_concurrency());
+    std::printf("  %.1fx over indexed\n", indexedSeconds / parallelSeconds);
+
+    // Same items, in the same order, either way
+    std::vector<uint64_t> serialItemIds;
+    std::vector<uint64_t> parallelItemIds;
+    for(int threadCount : { 1, 0 }) {
+        BenchmarkReader reader(audioIds, true);
+        MetadataExtractor extractor(&reader, document);
+        extractor.setDiscoveryThreadCount(threadCount);
+        extractor.discoverNewRenderableItems();
+        auto& itemIds = threadCount == 1 ? serialItemIds : parallelItemIds;
+        MetadataBlock metadataBlock{};
+        while(extractor.getNextMetadataBlock(&metadataBlock)) {
+            itemIds.push_back(metadataBlock.id);
+        }
+    }
+    bool parallelMatches = serialItemIds == parallelItemIds;
+    if(!parallelMatches) {
+        std::printf("  (parallel discovery differs!)\n");
+    }
+
+    // Growth - one extractor discovering each step's additions, as a reader keeps for a growing document
+    BenchmarkReader growingReader(audioIds, true);
+    MetadataExtractor growingExtractor(&growingReader, document);
+    growingExtractor.discoverNewRenderableItems();
+
+    std::printf("growth, 1%% per step\n");
+    std::printf("  %-6s %8s %14s %14s\n", "step", "tracks", "added (ms)", "afresh (ms)");
+    double addedTotalSeconds = 0.0;
+    double afreshTotalSeconds = 0.0;
+    bool consistent = true;
+    for(int step = 1; step <= growthSteps; step++) {
+        size_t firstNewTrack = audioIds.size();
+        addTracks(document, audioContent, std::max(1, (int)audioIds.size() / 100), audioIds);
+        for(size_t track = firstNewTrack; track < audioIds.size(); track++) {
+            growingReader.addAudioId(audioIds[track]);
+        }
+        growingExtractor.markReferencesAdded(audioContent); // As SadmReader does when merging a frame adds to existing content
+
+        auto start = std::chrono::steady_clock::now();
+        growingExtractor.discoverNewRenderableItems();
+        double addedSeconds = secondsSince(start);
+
+        BenchmarkReader afreshReader(audioIds, true);
+        start = std::chrono::steady_clock::now();
+        MetadataExtractor afreshExtractor(&afreshReader, document);
+        afreshExtractor.discoverNewRenderableItems();
+        double afreshSeconds = secondsSince(start);
+
+        addedTotalSeconds += addedSeconds;
+        afreshTotalSeconds += afreshSeconds;
+        consistent = consistent && growingExtractor.getReferencedChannelNums() == afreshExtractor.getReferencedChannelNums();
+        std::printf("  %-6d %8zu %14.3f %14.3f\n", step, audioIds.size(), addedSeconds * 1000.0, afreshSeconds * 1000.0);
+    }
+    if(growthSteps > 0) {
+        std::printf("  %.1fx%s\n", afreshTotalSeconds / addedTotalSeconds, consistent ? "" : "  (discovered items differ!)");
+    }
+
+    return linearDiscovered == indexedDiscovered && parallelMatches && consistent ? 0 : 1;
+}
@@ -0,0 +1,275 @@
+// Checks 64-bit frame addressing end to end on a synthetic RF64 file of over 2^31 frames - layout parsing (from disk and from a mapping),
+//  decoding past 2^31, the silence index, and the 64-bit entry points with unbounded (INT64_MAX) frame bounds.
+// The file is mono 16-bit and written sparse - only the headers and a short burst of signal near the end take up disk space.
+// Usage: rf64_check [working directory (default current)]
+
+#include <adm/adm.hpp>
+#include <adm/utilities/object_creation.hpp>
+#include <adm/write.hpp>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Bw64Layout.h"
+#include "EssenceReader.h"
+#include "MappedFile.h"
+#include "Session.h"
+#include "SilenceIndex.h"
+
+#define CSHARP_BOOL uint32_t
+
+// Exported by main.cpp
+extern "C" {
+    Session* createSession();
+    void destroySession(Session* session);
+    CSHARP_BOOL setAudioAccessMode(Session* session, int mode);
+    int readAdm(Session* session, char filePath[2048]);
+    const char* getLatestException(Session* session);
+    int getNumberOfFrames(Session* session);
+    int64_t getNumberOfFrames64(Session* session);
+    CSHARP_BOOL getAudioBlockBounded64(Session* session, int64_t startFrame, int numFrames, int channelNums[], int channelNumsSize, int64_t lowerFrameBound, int64_t upperFrameBound, float outputBuffer[]);
+    CSHARP_BOOL isAudioChannelSilent64(Session* session, int channelNum, int64_t startFrame, int numFrames);
+}
+
+namespace {
+    const uint32_t sampleRate = 48000;
+    const int64_t fileFrames = ((int64_t)1 << 31) + 100000;
+    const int64_t signalStart = ((int64_t)1 << 31) + 4 * SilenceIndex::blockFrames; // Block aligned, so its blocks aren't partly silent
+    const int64_t signalFrames = 2 * SilenceIndex::blockFrames;
+    const int64_t silentStart = signalStart + 32 * SilenceIndex::blockFrames;
+
+    int failures = 0;
+
+    void check(bool passed, const std::string& what)
+    {
+        std::printf("  %-64s %s\n", what.c_str(), passed ? "ok" : "FAILED");
+        if(!passed) failures++;
+    }
+
+    int16_t signalSample(int64_t frame)
+    {
+        return (int16_t)((frame - signalStart) % 2000 - 999); // Never 0, so no block of it is silent
+    }
+
+    // Expected decode of any frame in the file
+    float expectedSample(int64_t frame)
+    {
+        if(frame < signalStart || frame >= signalStart + signalFrames) return 0.0f;
+        return signalSample(frame) / 32768.0f;
+    }
+
+    void putU16(std::string& bytes, uint16_t value)
+    {
+        bytes.push_back((char)(value & 0xFF));
+        bytes.push_back((char)(value >> 8));
+    }
+    void putU32(std::string& bytes, uint32_t value)
+    {
+        putU16(bytes, (uint16_t)(value & 0xFFFF));
+        putU16(bytes, (uint16_t)(value >> 16));
+    }
+    void putU64(std::string& bytes, uint64_t value)
+    {
+        putU32(bytes, (uint32_t)(value & 0xFFFFFFFF));
+        putU32(bytes, (uint32_t)(value >> 32));
+    }
+    void putChunk(std::string& bytes, const char* id, const std::string& body)
+    {
+        bytes.append(id, 4);
+        putU32(bytes, (uint32_t)body.size());
+        bytes += body;
+        if(body.size() & 1) bytes.push_back('\0');
+    }
+    void putFixed(std::string& bytes, const std::string& value, size_t length)
+    {
+        std::string padded = value.substr(0, length);
+        padded.resize(length, '\0');
+        bytes += padded;
+    }
+
+    // RF64 with ds64, fmt, chna and axml (one simple object on track 1) then a data chunk of fileFrames.
+    // Returns the data chunk's offset, or 0 if the file couldn't be written.
+    uint64_t writeTestFile(const std::string& path)
+    {
+        auto document = adm::Document::create();
+        auto holder = adm::addSimpleObjectTo(document, "Long form");
+        std::stringstream axml;
+        adm::writeXml(axml, document);
+
+        std::string chna;
+        putU16(chna, 1); // Tracks
+        putU16(chna, 1); // UIDs
+        putU16(chna, 1); // trackIndex (1-based)
+        putFixed(chna, adm::formatId(holder.audioTrackUid->get<adm::AudioTrackUidId>()), 12);
+        putFixed(chna, adm::formatId(holder.audioTrackFormat->get<adm::AudioTrackFormatId>()), 14);
+        putFixed(chna, adm::formatId(holder.audioPackFormat->get<adm::AudioPackFormatId>()), 11);
+        chna.push_back('\0');
+
+        std::string fmt;
+        putU16(fmt, 1); // PCM
+        putU16(fmt, 1); // Channels
+        putU32(fmt, sampleRate);
+        putU32(fmt, sampleRate * 2); // Bytes per second
+        putU16(fmt, 2); // Block alignment
+        putU16(fmt, 16); // Bit depth
+
+        uint64_t dataSize = (uint64_t)fileFrames * 2;
+        std::string chunks;
+        putChunk(chunks, "fmt ", fmt);
+        putChunk(chunks, "chna", chna);
+        putChunk(chunks, "axml", axml.str());
+        uint64_t headerSize = 12 + 8 + 28 + chunks.size() + 8; // RIFF header, ds64, the above, data chunk header
+        uint64_t fileSize = headerSize + dataSize;
+
+        std::string ds64;
+        putU64(ds64, fileSize - 8); // RIFF size
+        putU64(ds64, dataSize);
+        putU64(ds64, (uint64_t)fileFrames); // Sample count
+        putU32(ds64, 0); // No table
+
+        std::string header;
+        header.append("RF64", 4);
+        putU32(header, 0xFFFFFFFF);
+        header.append("WAVE", 4);
+        putChunk(header, "ds64", ds64);
+        header += chunks;
+        header.append("data", 4);
+        putU32(header, 0xFFFFFFFF); // Real size is in ds64
+
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(header.data(), header.size());
+
+        // Seeking past the end leaves holes, so only what's written here takes up space
+        std::string signal;
+        for(int64_t frame = signalStart; frame < signalStart + signalFrames; frame++) {
+            putU16(signal, (uint16_t)signalSample(frame));
+        }
+        file.seekp(header.size() + signalStart * 2);
+        file.write(signal.data(), signal.size());
+        std::string lastFrame;
+        putU16(lastFrame, 0);
+        file.seekp(fileSize - 2);
+        file.write(lastFrame.data(), lastFrame.size());
+        file.close();
+        return file ? header.size() : 0;
+    }
+
+    bool matchesExpected(const std::vector<float>& samples, int64_t startFrame)
+    {
+        for(size_t index = 0; index < samples.size(); index++) {
+            if(std::fabs(samples[index] - expectedSample(startFrame + (int64_t)index)) > 1e-6f) return false;
+        }
+        return true;
+    }
+
+    void checkLayout(const Bw64Layout& layout, uint64_t dataOffset, const std::string& source)
+    {
+        check(layout.frameCount == (uint64_t)fileFrames, source + ": frame count from ds64");
+        check(layout.dataOffset == dataOffset && layout.dataSize == (uint64_t)fileFrames * 2, source + ": data chunk");
+        check(layout.channels == 1 && layout.bitDepth == 16 && layout.sampleRate == sampleRate, source + ": fmt chunk");
+        check(layout.axmlSize > 0 && layout.chnaSize > 0, source + ": axml and chna chunks");
+    }
+
+    void checkSession(const std::string& path, int audioAccessMode, const std::string& modeName)
+    {
+        Session* session = createSession();
+        setAudioAccessMode(session, audioAccessMode);
+        char filePath[2048] = {};
+        std::strncpy(filePath, path.c_str(), sizeof(filePath) - 1);
+        bool read = readAdm(session, filePath) == 0;
+        check(read, modeName + ": readAdm" + (read ? "" : std::string(" (") + getLatestException(session) + ")"));
+        if(!read) {
+            destroySession(session);
+            return;
+        }
+
+        check(getNumberOfFrames64(session) == fileFrames, modeName + ": getNumberOfFrames64");
+        check(getNumberOfFrames(session) == INT_MAX, modeName + ": getNumberOfFrames clamps");
+
+        // Straddling the start of the signal, and the end of the file, unbounded
+        int channelNums[] = { 0 };
+        std::vector<float> samples(4 * SilenceIndex::blockFrames);
+        int64_t startFrame = signalStart - SilenceIndex::blockFrames;
+        bool got = getAudioBlockBounded64(session, startFrame, (int)samples.size(), channelNums, 1, 0, INT64_MAX, samples.data());
+        check(got && matchesExpected(samples, startFrame), modeName + ": getAudioBlockBounded64 past 2^31");
+        startFrame = fileFrames - (int64_t)samples.size() / 2;
+        std::fill(samples.begin(), samples.end(), 1.0f);
+        got = getAudioBlockBounded64(session, startFrame, (int)samples.size(), channelNums, 1, 0, INT64_MAX, samples.data());
+        check(got && matchesExpected(samples, startFrame), modeName + ": getAudioBlockBounded64 past the end");
+
+        // Bounds above 2^31 cut off what's outside them
+        std::fill(samples.begin(), samples.end(), 1.0f);
+        startFrame = signalStart;
+        int64_t upperBound = signalStart + SilenceIndex::blockFrames - 1; // Inclusive
+        got = getAudioBlockBounded64(session, startFrame, (int)samples.size(), channelNums, 1, signalStart, upperBound, samples.data());
+        bool bounded = got;
+        for(size_t index = 0; index < samples.size() && bounded; index++) {
+            int64_t frame = startFrame + (int64_t)index;
+            bounded = samples[index] == (frame <= upperBound ? expectedSample(frame) : 0.0f);
+        }
+        check(bounded, modeName + ": getAudioBlockBounded64 with bounds past 2^31");
+
+        if(audioAccessMode == (int)AudioAccessMode::BUFFERED) {
+            // Blocks are indexed as they're read - only the buffered extractor keeps a silence index
+            got = getAudioBlockBounded64(session, silentStart, SilenceIndex::blockFrames, channelNums, 1, 0, INT64_MAX, samples.data());
+            check(got && isAudioChannelSilent64(session, 0, silentStart, SilenceIndex::blockFrames), modeName + ": isAudioChannelSilent64 on silence");
+            check(!isAudioChannelSilent64(session, 0, signalStart, SilenceIndex::blockFrames), modeName + ": isAudioChannelSilent64 on signal");
+        }
+
+        destroySession(session);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::string directory = argc > 1 ? argv[1] : ".";
+    std::string path = directory + "/rf64_check.wav";
+
+    std::printf("%lld frames\n", (long long)fileFrames);
+    uint64_t dataOffset = writeTestFile(path);
+    if(dataOffset == 0) {
+        std::printf("Couldn't write %s\n", path.c_str());
+        return 1;
+    }
+
+    Bw64Layout layout;
+    std::string error;
+    check(readBw64Layout(path, layout, error), "readBw64Layout " + error);
+    checkLayout(layout, dataOffset, "readBw64Layout");
+    {
+        MappedFile mappedFile(path);
+        Bw64Layout mappedLayout;
+        check(parseBw64Layout(mappedFile.data(), mappedFile.size(), mappedLayout, error), "parseBw64Layout " + error);
+        checkLayout(mappedLayout, dataOffset, "parseBw64Layout");
+    }
+
+    // Decoding past 2^31, and the silence index over what's decoded
+    EssenceReader essenceReader(path, layout);
+    SilenceIndex silenceIndex(1, fileFrames);
+    int channelNums[] = { 0 };
+    std::vector<float> samples(64 * SilenceIndex::blockFrames);
+    int64_t startFrame = signalStart - 4 * SilenceIndex::blockFrames;
+    bool decoded = essenceReader.readFrames(startFrame, (int64_t)samples.size(), samples.data());
+    check(decoded && matchesExpected(samples, startFrame), "EssenceReader::readFrames past 2^31");
+    silenceIndex.scan({ samples.data(), startFrame, startFrame + (int64_t)samples.size(), 1, 1 }, channelNums, 1);
+    check(silenceIndex.isSilent(0, silentStart, silentStart + SilenceIndex::blockFrames), "SilenceIndex: silence past 2^31");
+    check(!silenceIndex.isSilent(0, signalStart, signalStart + signalFrames), "SilenceIndex: signal past 2^31");
+    check(!silenceIndex.isSilent(0, startFrame + (int64_t)samples.size(), fileFrames), "SilenceIndex: unscanned past 2^31");
+    check(silenceIndex.getScannedBlockCount() == 64 && silenceIndex.getSilentBlockCount() == 62, "SilenceIndex: block counts");
+
+    checkSession(path, (int)AudioAccessMode::BUFFERED, "buffered");
+    checkSession(path, (int)AudioAccessMode::MAPPED, "mapped");
+
+    std::remove(path.c_str());
+    if(failures > 0) {
+        std::printf("%d FAILED\n", failures);
+        return 1;
+    }
+    std::printf("All passed\n");
+    return 0;
+}
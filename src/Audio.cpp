@@ -1,128 +1,292 @@
 #include "Audio.h"
 #include "Readers.h"
 #include "ExceptionHandler.h"
+#include "AudioKernels.h"
+#include <algorithm>
+#include <cstring>
 
 Bw64AudioExtractor::Bw64AudioExtractor(FileReader * parentFileReader) : fileReader{ parentFileReader }
 {
+    // Cache refills are decoded with our own kernels, from the layout the reader found
+    const Bw64Layout& layout = fileReader->getLayout();
+    try {
+        essenceReader = std::make_unique<EssenceReader>(fileReader->getFilePath(), layout, fileReader->getAudioIoBackend());
+    } catch(std::exception &e) {
+        getExceptionHandler()->logException(std::string("Unable to open audio: ") + e.what());
+        essenceReader.reset();
+    }
+
+    if(essenceReader) {
+        // Windows are whole silence index blocks, so every fill can be indexed
+        int channelCount = layout.channels;
+        int64_t windowFrames = std::ceil(cacheWindowSec * layout.sampleRate);
+        windowFrames = std::max((int64_t)1, (windowFrames + SilenceIndex::blockFrames - 1) / SilenceIndex::blockFrames) * SilenceIndex::blockFrames;
+        silenceIndex = std::make_unique<SilenceIndex>(channelCount, (int64_t)layout.frameCount);
+        allChannels.resize(channelCount);
+        for(int channelNum = 0; channelNum < channelCount; channelNum++) {
+            allChannels[channelNum] = channelNum;
+        }
+        windowCache = std::make_unique<AudioWindowCache>(channelCount, windowFrames, defaultAudioCacheBudgetBytes,
+            [this](int64_t windowStart, int64_t frameCount, const std::vector<int>& windowChannelNums, float* dest) {
+                return fillWindow(windowStart, frameCount, windowChannelNums, dest);
+            });
+    }
 }
 
 Bw64AudioExtractor::~Bw64AudioExtractor()
 {
 }
 
+Bw64AudioExtractor::CursorLease::CursorLease(Bw64AudioExtractor* owner) : owner{ owner }
+{
+    std::lock_guard<std::mutex> lock(owner->cursorPoolMutex);
+    if(owner->idleCursors.empty()) {
+        cursor = std::make_unique<ReadCursor>();
+    } else {
+        cursor = std::move(owner->idleCursors.back());
+        owner->idleCursors.pop_back();
+    }
+}
+
+Bw64AudioExtractor::CursorLease::~CursorLease()
+{
+    std::lock_guard<std::mutex> lock(owner->cursorPoolMutex);
+    owner->idleCursors.push_back(std::move(cursor));
+}
+
 int Bw64AudioExtractor::getSampleRate()
 {
-    auto bw64Reader = fileReader->getReader();
-    if(!bw64Reader) return 0;
-    return bw64Reader->sampleRate();
+    return fileReader->getLayout().sampleRate;
 }
 
-int Bw64AudioExtractor::getNumberOfFrames()
+int64_t Bw64AudioExtractor::getNumberOfFrames()
 {
-    auto bw64Reader = fileReader->getReader();
-    if(!bw64Reader) return 0;
-    return bw64Reader->numberOfFrames();
+    return fileReader->getLayout().frameCount;
 }
 
-bool Bw64AudioExtractor::getAudioBlock(int startFrame, int numFrames, int channelNums[], int channelNumsSize, int lowerFrameBound, int upperFrameBound, float outputBuffer[])
+bool Bw64AudioExtractor::fillWindow(int64_t startFrame, int64_t frameCount, const std::vector<int>& channelNums, float* dest)
 {
-    auto bw64Reader = fileReader->getReader();
-    if(!bw64Reader) {
+    if(!essenceReader) {
         getExceptionHandler()->logException("No Reader available to extract audio!");
         return false;
     }
-    int availableChannels = bw64Reader->channels();
+    int availableChannels = fileReader->getLayout().channels;
+    int64_t fileFrames = fileReader->getLayout().frameCount;
 
-    if(startFrame < latestExtractedAudioBlock_StartFrame || (startFrame + numFrames) > latestExtractedAudioBlock_EndFrame) {
-        // Need to extract new block
-        newBlockExtractCounter++;
+    // Pad anything outside the file with silence
+    int64_t readStart = std::min(std::max(startFrame, (int64_t)0), startFrame + frameCount);
+    int64_t readEnd = std::max(std::min(startFrame + frameCount, fileFrames), readStart);
+    int64_t preFrames = readStart - startFrame;
+    int64_t readFrames = readEnd - readStart;
+    int64_t postFrames = startFrame + frameCount - readEnd;
 
-        // Get cache vector ready
-        size_t lookBehindFrames= std::ceil(lookBehindSec * (float)bw64Reader->sampleRate());
-        size_t lookAheadFrames = std::ceil(lookAheadSec * (float)bw64Reader->sampleRate());
-        latestExtractedAudioBlock_StartFrame = startFrame - lookBehindFrames;
-        latestExtractedAudioBlock_EndFrame = std::max(startFrame + numFrames, (int)(startFrame + lookAheadFrames));
-        latestExtractedAudioBlock_FrameCount = latestExtractedAudioBlock_EndFrame - latestExtractedAudioBlock_StartFrame;
-        size_t reqSize = latestExtractedAudioBlock_FrameCount * availableChannels;
-        if(latestExtractedAudioBlock.size() < reqSize) {
-            latestExtractedAudioBlock = std::vector<float>(reqSize); // Could resize but not interested in preserving existing data
+    if(channelNums.empty()) {
+        // All channels, interleaved
+        zeroSamples(dest, preFrames * availableChannels);
+        float* readDest = dest + preFrames * availableChannels;
+        if(readFrames > 0 && !essenceReader->readFrames(readStart, readFrames, readDest)) {
+            getExceptionHandler()->logException("Unable to read audio from " + fileReader->getFilePath());
+            return false;
+        }
+        zeroSamples(readDest + readFrames * availableChannels, postFrames * availableChannels);
+        if(silenceIndex) {
+            silenceIndex->scan({ dest, startFrame, startFrame + frameCount, availableChannels, 1 }, allChannels.data(), availableChannels);
         }
+        return true;
+    }
 
-        //Start - Calculate buffer section and padding
-        int remainingBuffer = latestExtractedAudioBlock_FrameCount;
+    // Selected channels, planar - one row of frameCount per channel
+    int channelCount = (int)channelNums.size();
+    for(int channelIndex = 0; channelIndex < channelCount; channelIndex++) {
+        zeroSamples(dest + channelIndex * frameCount, preFrames);
+        zeroSamples(dest + channelIndex * frameCount + preFrames + readFrames, postFrames);
+    }
+    if(readFrames > 0 && !essenceReader->readChannels(readStart, readFrames, channelNums.data(), channelCount, dest + preFrames, frameCount)) {
+        getExceptionHandler()->logException("Unable to read audio from " + fileReader->getFilePath());
+        return false;
+    }
+    if(silenceIndex) {
+        silenceIndex->scan({ dest, startFrame, startFrame + frameCount, 1, frameCount }, channelNums.data(), channelCount);
+    }
+    return true;
+}
 
-        int prePaddingFrameCount = 0;
-        if(latestExtractedAudioBlock_StartFrame < 0) prePaddingFrameCount = -latestExtractedAudioBlock_StartFrame;
-        if(prePaddingFrameCount > remainingBuffer) prePaddingFrameCount = remainingBuffer;
+bool Bw64AudioExtractor::acquireAudio(ReadCursor& cursor, int64_t startFrame, int numFrames, const int* channelNums, int channelNumsSize, int& channelCount)
+{
+    cursor.acquisition.clear();
 
-        remainingBuffer -= prePaddingFrameCount;
+    if(streaming.load(std::memory_order_acquire)) {
+        cursor.readAheadLock = std::unique_lock<std::mutex>(readAheadMutex);
+        if(readAhead) {
+            // Streaming - only ever copy from what the I/O thread has already decoded. Not there = silence (counted as an underrun)
+            AudioSegment segments[2];
+            int segmentCount = 0;
+            channelCount = readAhead->getChannelCount();
+            readAhead->acquire(startFrame, numFrames, segments, segmentCount);
+            cursor.acquisition.segments.insert(cursor.acquisition.segments.end(), segments, segments + segmentCount);
+            return true;
+        }
+        cursor.readAheadLock.unlock(); // Turned off since we checked
+    }
+
+    if(!windowCache) {
+        getExceptionHandler()->logException("No Reader available to extract audio!");
+        return false;
+    }
+    channelCount = fileReader->getLayout().channels;
 
-        int readFrameStart = latestExtractedAudioBlock_StartFrame;
-        if(readFrameStart < 0) readFrameStart = 0;
-        int readFrameEnd = readFrameStart + remainingBuffer;
-        if(readFrameEnd > bw64Reader->numberOfFrames()) readFrameEnd = bw64Reader->numberOfFrames();
-        if(readFrameEnd < readFrameStart) readFrameEnd = readFrameStart;
-        int readFrameCount = readFrameEnd - readFrameStart;
-        if(readFrameCount > remainingBuffer) {
-            readFrameCount = remainingBuffer;
-            readFrameEnd = readFrameStart + readFrameCount;
+    auto layout = windowCache->getLayout();
+    auto missingChannel = [&]() {
+        for(int channelIndex = 0; channelIndex < channelNumsSize; channelIndex++) {
+            int channelNum = channelNums[channelIndex];
+            if(channelNum >= 0 && channelNum < channelCount && layout->slotFor(channelNum) < 0) return true;
         }
+        return false;
+    };
+    if(missingChannel()) {
+        // Someone wants a channel the metadata didn't lead us to expect. Serve it anyway - a refill is better than silence
+        std::lock_guard<std::mutex> lock(channelSetMutex);
+        layout = windowCache->getLayout();
+        if(missingChannel()) {
+            for(int channelIndex = 0; channelIndex < channelNumsSize; channelIndex++) {
+                int channelNum = channelNums[channelIndex];
+                if(channelNum >= 0 && channelNum < channelCount && layout->slotFor(channelNum) < 0 &&
+                   !std::binary_search(cachedChannels.begin(), cachedChannels.end(), channelNum)) {
+                    cachedChannels.insert(std::lower_bound(cachedChannels.begin(), cachedChannels.end(), channelNum), channelNum);
+                }
+            }
+            windowCache->setChannelSet(cachedChannels);
+            layout = windowCache->getLayout();
+        }
+    }
 
-        remainingBuffer -= readFrameCount;
+    return windowCache->acquire(startFrame, numFrames, layout, cursor.acquisition); // fillWindow provides reason on failure
+}
 
-        int postPaddingFrameCount = remainingBuffer;
-        assert(postPaddingFrameCount >= 0);
-        ///End - Calculate buffer section and padding
+bool Bw64AudioExtractor::isSilent(int channelNum, int64_t startFrame, int64_t endFrame)
+{
+    return silenceIndex && silenceIndex->isSilent(channelNum, startFrame, endFrame);
+}
 
-        size_t outputSampleIndex = 0;
+int Bw64AudioExtractor::slotFor(const ReadCursor& cursor, int channelNum, int availableChannels)
+{
+    if(channelNum < 0 || channelNum >= availableChannels) return -1;
+    if(cursor.readAheadLock.owns_lock() || !cursor.acquisition.layout) return channelNum; // Read-ahead ring always holds every channel, interleaved
+    return cursor.acquisition.layout->slotFor(channelNum);
+}
 
-        // Pre-padding
-        int prePaddingSampleCount = prePaddingFrameCount * availableChannels;
-        for(int sampleNum = 0; sampleNum < prePaddingSampleCount; sampleNum++)
-        {
-            latestExtractedAudioBlock[outputSampleIndex] = 0.0;
-            outputSampleIndex++;
-        }
+void Bw64AudioExtractor::setCachedChannels(const std::vector<int>& channelNums)
+{
+    std::lock_guard<std::mutex> lock(channelSetMutex);
+    cachedChannels = channelNums;
+    std::sort(cachedChannels.begin(), cachedChannels.end());
+    cachedChannels.erase(std::unique(cachedChannels.begin(), cachedChannels.end()), cachedChannels.end());
+    if(windowCache) {
+        windowCache->setChannelSet(cachedChannels);
+    }
+}
 
-        // Audio samples
-        if(readFrameCount > 0) {
-            bw64Reader->seek(readFrameStart);
-            bw64Reader->read((latestExtractedAudioBlock.data() + outputSampleIndex), readFrameCount);
-            outputSampleIndex += readFrameCount * availableChannels;
-        }
+bool Bw64AudioExtractor::releaseAudio(ReadCursor& cursor)
+{
+    bool valid = true;
+    if(cursor.readAheadLock.owns_lock()) {
+        valid = readAhead->release();
+        cursor.readAheadLock.unlock();
+    }
+    cursor.acquisition.clear(); // Lets go of the windows, so eviction can recycle them
+    return valid;
+}
 
-        // Post-padding
-        int postPaddingSampleCount = postPaddingFrameCount * availableChannels;
-        for(int sampleNum = 0; sampleNum < postPaddingSampleCount; sampleNum++)
-        {
-            latestExtractedAudioBlock[outputSampleIndex] = 0.0;
-            outputSampleIndex++;
-        }
+bool Bw64AudioExtractor::setReadAhead(float newReadAheadSec)
+{
+    std::lock_guard<std::mutex> lock(readAheadMutex); // Waits for any consumer mid-read
+    streaming.store(false, std::memory_order_release);
+    readAhead.reset(); // Joins the I/O thread of any previous instance
+    readAheadSec = 0.0;
+    if(newReadAheadSec <= 0.0) return true;
 
-    } else {
-        // Reuse existing cached block
-        reuseBlockCounter++;
+    try {
+        readAhead = std::make_unique<AudioReadAhead>(fileReader->getFilePath(), fileReader->getLayout(), newReadAheadSec, lookBehindSec, fileReader->getAudioIoBackend());
+    } catch(std::exception &e) {
+        getExceptionHandler()->logException(std::string("Failed to start audio read-ahead: ") + e.what());
+        return false;
     }
+    readAheadSec = newReadAheadSec;
+    streaming.store(true, std::memory_order_release);
+    return true;
+}
+
+float Bw64AudioExtractor::getReadAhead()
+{
+    return readAheadSec;
+}
+
+int64_t Bw64AudioExtractor::getReadAheadBufferedFrames()
+{
+    std::lock_guard<std::mutex> lock(readAheadMutex);
+    return readAhead ? readAhead->getBufferedFrames() : 0;
+}
+
+uint64_t Bw64AudioExtractor::getReadAheadUnderrunCount()
+{
+    std::lock_guard<std::mutex> lock(readAheadMutex);
+    return readAhead ? readAhead->getUnderrunCount() : 0;
+}
+
+void Bw64AudioExtractor::setCacheBudget(uint64_t budgetBytes)
+{
+    if(windowCache) {
+        windowCache->setBudget(budgetBytes);
+    }
+}
+
+std::optional<EssenceIoBackend> Bw64AudioExtractor::getIoBackend()
+{
+    if(!essenceReader) return std::nullopt;
+    return essenceReader->getIoBackend();
+}
+
+AudioCacheStats Bw64AudioExtractor::getCacheStats()
+{
+    AudioCacheStats stats;
+    if(windowCache) {
+        stats.hits = windowCache->getHitCount();
+        stats.misses = windowCache->getMissCount();
+        stats.evictions = windowCache->getEvictionCount();
+        stats.residentBytes = windowCache->getResidentBytes();
+    }
+    return stats;
+}
+
+bool Bw64AudioExtractor::getAudioBlock(int64_t startFrame, int numFrames, int channelNums[], int channelNumsSize, int64_t lowerFrameBound, int64_t upperFrameBound, float outputBuffer[])
+{
+    CursorLease cursor(this);
+    int availableChannels = 0;
+    if(!acquireAudio(*cursor, startFrame, numFrames, channelNums, channelNumsSize, availableChannels)) return false; // acquireAudio provides reason
+    const AudioSegment* segments = cursor->acquisition.segments.data();
+    int segmentCount = (int)cursor->acquisition.segments.size();
 
     // Extract just the channels we want
     float* bufferPosition = outputBuffer;
-    //int64_t prevents overflows on bounds
-    int64_t relStart = startFrame - latestExtractedAudioBlock_StartFrame;
-    int64_t relEnd = relStart + numFrames;
-    int64_t relLowerFrameBound = (int64_t)lowerFrameBound - (int64_t)latestExtractedAudioBlock_StartFrame;
-    int64_t relUpperFrameBound = (int64_t)upperFrameBound - (int64_t)latestExtractedAudioBlock_StartFrame;
+    int64_t endFrame = startFrame + numFrames;
+    int segmentIndex = 0;
 
-    for(int64_t relFrameNum = relStart; relFrameNum < relEnd; relFrameNum++)
+    for(int64_t frameNum = startFrame; frameNum < endFrame; frameNum++)
     {
-        int originFrameNum = latestExtractedAudioBlock_StartFrame + relFrameNum;
-        bool inBounds = relFrameNum >= relLowerFrameBound && relFrameNum <= relUpperFrameBound;
+        while(segmentIndex < segmentCount && frameNum >= segments[segmentIndex].endFrame) segmentIndex++;
+        const AudioSegment* segment = nullptr;
+        const float* frameSamples = nullptr;
+        if(segmentIndex < segmentCount && frameNum >= segments[segmentIndex].startFrame) {
+            segment = &segments[segmentIndex];
+            frameSamples = segment->samples + (frameNum - segment->startFrame) * segment->frameStride;
+        }
+        bool inBounds = frameSamples && frameNum >= lowerFrameBound && frameNum <= upperFrameBound;
         for(int channelIndex = 0; channelIndex < channelNumsSize; channelIndex++)
         {
             if(inBounds) {
-                auto channelNum = channelNums[channelIndex];
-                if(channelNum >= 0 && channelNum < availableChannels) {
-                    int64_t blockPos = channelNum + (relFrameNum * availableChannels);
-                    *bufferPosition = latestExtractedAudioBlock[blockPos];
+                int slot = slotFor(*cursor, channelNums[channelIndex], availableChannels);
+                if(slot >= 0) {
+                    *bufferPosition = frameSamples[slot * segment->channelStride];
                 } else {
                     // TODO - should probably warn somehow. Requested channel isn't in the file.
                     *bufferPosition = 0.0;
@@ -134,5 +298,343 @@ bool Bw64AudioExtractor::getAudioBlock(int startFrame, int numFrames, int channe
         }
     }
 
+    if(!releaseAudio(*cursor)) {
+        zeroSamples(outputBuffer, (size_t)numFrames * channelNumsSize);
+    }
+
+    return true;
+}
+
+bool Bw64AudioExtractor::getAudioBlockPlanar(int64_t startFrame, int numFrames, int channelNums[], int64_t channelAudioBounds[], int channelCount, float* outputBuffers[])
+{
+    CursorLease cursor(this);
+    int availableChannels = 0;
+    if(!acquireAudio(*cursor, startFrame, numFrames, channelNums, channelCount, availableChannels)) return false; // acquireAudio provides reason
+    const AudioSegment* segments = cursor->acquisition.segments.data();
+    int segmentCount = (int)cursor->acquisition.segments.size();
+    auto& planarRuns = cursor->planarRuns;
+    auto& planarRunsUsed = cursor->planarRunsUsed;
+    auto& segmentOutputBuffers = cursor->segmentOutputBuffers;
+
+    if(segmentCount == 0) {
+        // Nothing available (streaming underrun)
+        for(int channelIndex = 0; channelIndex < channelCount; channelIndex++) {
+            zeroSamples(outputBuffers[channelIndex], numFrames);
+        }
+        releaseAudio(*cursor);
+        return true;
+    }
+
+    int64_t requestStart = startFrame;
+    int64_t requestEnd = requestStart + numFrames; // Exclusive
+
+    // Work out what each channel needs, zero anything out of bounds, and group the rest by in-bounds range
+    planarRunsUsed = 0;
+    for(int channelIndex = 0; channelIndex < channelCount; channelIndex++) {
+        float* outputBuffer = outputBuffers[channelIndex];
+        int slot = slotFor(*cursor, channelNums[channelIndex], availableChannels);
+
+        int64_t validStart = requestStart;
+        int64_t validEnd = requestEnd;
+        if(channelAudioBounds) {
+            validStart = std::max(validStart, channelAudioBounds[channelIndex * 2]);
+            validEnd = std::min(validEnd, boundEndFrame(channelAudioBounds[channelIndex * 2 + 1]));
+        }
+
+        if(slot < 0 || validStart >= validEnd) {
+            // Entirely out of bounds, or the requested channel isn't in the file - silence either way, as the interleaved path gives
+            zeroSamples(outputBuffer, numFrames);
+            continue;
+        }
+
+        // Partially bounded - pad either side of the section we'll copy
+        zeroSamples(outputBuffer, validStart - requestStart);
+        zeroSamples(outputBuffer + (validEnd - requestStart), requestEnd - validEnd);
+
+        PlanarRun* run = nullptr;
+        for(size_t runIndex = 0; runIndex < planarRunsUsed; runIndex++) {
+            if(planarRuns[runIndex].startFrame == validStart && planarRuns[runIndex].endFrame == validEnd) {
+                run = &planarRuns[runIndex];
+                break;
+            }
+        }
+        if(!run) {
+            if(planarRunsUsed == planarRuns.size()) {
+                planarRuns.emplace_back();
+            }
+            run = &planarRuns[planarRunsUsed++];
+            run->startFrame = validStart;
+            run->endFrame = validEnd;
+            run->slots.clear();
+            run->outputBuffers.clear();
+        }
+        run->slots.push_back(slot);
+        run->outputBuffers.push_back(outputBuffer + (validStart - requestStart));
+    }
+
+    // One pass over the source audio per run - nearly always just the one run (and one or two segments)
+    for(size_t runIndex = 0; runIndex < planarRunsUsed; runIndex++) {
+        auto& run = planarRuns[runIndex];
+        for(int segmentIndex = 0; segmentIndex < segmentCount; segmentIndex++) {
+            const AudioSegment& segment = segments[segmentIndex];
+            int64_t copyStart = std::max(run.startFrame, segment.startFrame);
+            int64_t copyEnd = std::min(run.endFrame, segment.endFrame);
+            if(copyStart >= copyEnd) continue;
+
+            const float* copySource = segment.samples + (copyStart - segment.startFrame) * segment.frameStride;
+            float* const* copyDestinations = run.outputBuffers.data();
+            if(copyStart != run.startFrame) {
+                segmentOutputBuffers.clear();
+                for(auto outputBuffer : run.outputBuffers) {
+                    segmentOutputBuffers.push_back(outputBuffer + (copyStart - run.startFrame));
+                }
+                copyDestinations = segmentOutputBuffers.data();
+            }
+            if(segment.channelStride == 1) {
+                deinterleaveChannels(copySource, (int)segment.frameStride, run.slots.data(), copyDestinations, (int)run.slots.size(), copyEnd - copyStart);
+            } else {
+                // Already planar - straight copies
+                for(size_t runChannel = 0; runChannel < run.slots.size(); runChannel++) {
+                    std::memcpy(copyDestinations[runChannel], copySource + run.slots[runChannel] * segment.channelStride, (copyEnd - copyStart) * sizeof(float));
+                }
+            }
+        }
+    }
+
+    if(!releaseAudio(*cursor)) {
+        for(int channelIndex = 0; channelIndex < channelCount; channelIndex++) {
+            zeroSamples(outputBuffers[channelIndex], numFrames);
+        }
+    }
+
+    return true;
+}
+
+MappedAudioExtractor::MappedAudioExtractor(std::shared_ptr<MappedFile> mappedFile, const Bw64Layout& layout) : mappedFile{ mappedFile }, layout{ layout }
+{
+    essence = mappedFile->data() + layout.dataOffset;
+    bytesPerSample = layout.bitDepth / 8;
+    sampleFormat = sampleFormatOf(layout);
+}
+
+MappedAudioExtractor::MappedAudioExtractor(const uint8_t* fileData, const Bw64Layout& layout) : layout{ layout }
+{
+    essence = fileData + layout.dataOffset;
+    bytesPerSample = layout.bitDepth / 8;
+    sampleFormat = sampleFormatOf(layout);
+}
+
+MappedAudioExtractor::~MappedAudioExtractor()
+{
+}
+
+int MappedAudioExtractor::getSampleRate()
+{
+    return layout.sampleRate;
+}
+
+int64_t MappedAudioExtractor::getNumberOfFrames()
+{
+    return layout.frameCount;
+}
+
+bool MappedAudioExtractor::getAudioBlock(int64_t startFrame, int numFrames, int channelNums[], int channelNumsSize, int64_t lowerFrameBound, int64_t upperFrameBound, float outputBuffer[])
+{
+    float* bufferPosition = outputBuffer;
+    int64_t endFrame = startFrame + numFrames;
+    int64_t fileFrames = layout.frameCount;
+    int availableChannels = layout.channels;
+
+    for(int64_t frameNum = startFrame; frameNum < endFrame; frameNum++)
+    {
+        bool inBounds = frameNum >= 0 && frameNum < fileFrames && frameNum >= lowerFrameBound && frameNum <= upperFrameBound;
+        for(int channelIndex = 0; channelIndex < channelNumsSize; channelIndex++)
+        {
+            auto channelNum = channelNums[channelIndex];
+            if(inBounds && channelNum >= 0 && channelNum < availableChannels) {
+                decodeSamplesStrided(essence + frameNum * layout.blockAlignment + channelNum * bytesPerSample, 0, sampleFormat, bufferPosition, 1);
+            } else {
+                // Out of bounds, or requested channel isn't in the file - silence, as from Bw64AudioExtractor
+                *bufferPosition = 0.0;
+            }
+            bufferPosition++;
+        }
+    }
+
+    return true;
+}
+
+bool MappedAudioExtractor::getAudioBlockPlanar(int64_t startFrame, int numFrames, int channelNums[], int64_t channelAudioBounds[], int channelCount, float* outputBuffers[])
+{
+    int64_t requestStart = startFrame;
+    int64_t requestEnd = requestStart + numFrames; // Exclusive
+
+    for(int channelIndex = 0; channelIndex < channelCount; channelIndex++) {
+        float* outputBuffer = outputBuffers[channelIndex];
+        int channelNum = channelNums[channelIndex];
+
+        int64_t validStart = std::max(requestStart, (int64_t)0);
+        int64_t validEnd = std::min(requestEnd, (int64_t)layout.frameCount);
+        if(channelAudioBounds) {
+            validStart = std::max(validStart, channelAudioBounds[channelIndex * 2]);
+            validEnd = std::min(validEnd, boundEndFrame(channelAudioBounds[channelIndex * 2 + 1]));
+        }
+
+        if(channelNum < 0 || channelNum >= layout.channels || validStart >= validEnd) {
+            zeroSamples(outputBuffer, numFrames);
+            continue;
+        }
+
+        zeroSamples(outputBuffer, validStart - requestStart);
+        decodeSamplesStrided(essence + validStart * layout.blockAlignment + channelNum * bytesPerSample, layout.blockAlignment,
+                             sampleFormat, outputBuffer + (validStart - requestStart), validEnd - validStart);
+        zeroSamples(outputBuffer + (validEnd - requestStart), requestEnd - validEnd);
+    }
+
+    return true;
+}
+
+PreloadedAudioExtractor::PreloadedAudioExtractor(FileReader * parentFileReader) : fileReader{ parentFileReader }
+{
+}
+
+PreloadedAudioExtractor::~PreloadedAudioExtractor()
+{
+}
+
+bool PreloadedAudioExtractor::load(const std::vector<int>& channelNums)
+{
+    const Bw64Layout& layout = fileReader->getLayout();
+    int availableChannels = layout.channels;
+    sampleRate = layout.sampleRate;
+    frameCount = layout.frameCount;
+    storageFormat = layout.bitDepth == 16 ? SampleFormat::INT16 : SampleFormat::FLOAT16;
+    bytesPerSample = bytesPerSampleOf(storageFormat);
+
+    std::vector<int> loadChannels;
+    for(int channelNum = 0; channelNum < availableChannels; channelNum++) {
+        if(channelNums.empty() || std::find(channelNums.begin(), channelNums.end(), channelNum) != channelNums.end()) {
+            loadChannels.push_back(channelNum);
+        }
+    }
+    channelSlots.assign(availableChannels, -1);
+    for(size_t slot = 0; slot < loadChannels.size(); slot++) {
+        channelSlots[loadChannels[slot]] = (int)slot;
+    }
+
+    std::unique_ptr<EssenceReader> essenceReader;
+    try {
+        channelStorage.assign(loadChannels.size(), std::vector<uint8_t>(frameCount * bytesPerSample));
+        essenceReader = std::make_unique<EssenceReader>(fileReader->getFilePath(), layout, fileReader->getAudioIoBackend());
+    } catch(std::exception &e) {
+        channelStorage.clear();
+        getExceptionHandler()->logException(std::string("Unable to preload audio: ") + e.what());
+        return false;
+    }
+
+    // Around a second at a time (in whole silence index blocks) - decoded planar (only the channels we keep), indexed, then compacted
+    silenceIndex = std::make_unique<SilenceIndex>(availableChannels, frameCount);
+    int64_t chunkFrames = std::max((int64_t)1, (int64_t)sampleRate / SilenceIndex::blockFrames) * SilenceIndex::blockFrames;
+    int loadChannelCount = (int)loadChannels.size();
+    std::vector<float> planar(chunkFrames * loadChannelCount);
+    std::vector<float*> planarRows;
+    for(int channelIndex = 0; channelIndex < loadChannelCount; channelIndex++) {
+        planarRows.push_back(planar.data() + channelIndex * chunkFrames);
+    }
+
+    for(int64_t chunkStart = 0; chunkStart < frameCount; chunkStart += chunkFrames) {
+        int64_t frames = std::min(chunkFrames, frameCount - chunkStart);
+        if(!essenceReader->readChannels(chunkStart, frames, loadChannels.data(), loadChannelCount, planar.data(), chunkFrames)) {
+            channelStorage.clear();
+            getExceptionHandler()->logException("Unable to preload audio from " + fileReader->getFilePath());
+            return false;
+        }
+        silenceIndex->scan({ planar.data(), chunkStart, chunkStart + frames, 1, chunkFrames }, loadChannels.data(), loadChannelCount);
+        for(int channelIndex = 0; channelIndex < loadChannelCount; channelIndex++) {
+            encodeSamples(planarRows[channelIndex], storageFormat, channelStorage[channelIndex].data() + chunkStart * bytesPerSample, frames);
+        }
+    }
+
+    return true;
+}
+
+bool PreloadedAudioExtractor::isSilent(int channelNum, int64_t startFrame, int64_t endFrame)
+{
+    if(channelNum >= 0 && channelNum < (int)channelSlots.size() && channelSlots[channelNum] < 0) return true; // Not loaded - always reads as silence
+    return silenceIndex && silenceIndex->isSilent(channelNum, startFrame, endFrame);
+}
+
+uint64_t PreloadedAudioExtractor::getResidentBytes()
+{
+    return (uint64_t)channelStorage.size() * frameCount * bytesPerSample;
+}
+
+int PreloadedAudioExtractor::getSampleRate()
+{
+    return sampleRate;
+}
+
+int64_t PreloadedAudioExtractor::getNumberOfFrames()
+{
+    return frameCount;
+}
+
+void PreloadedAudioExtractor::decodeChannel(int slot, int64_t startFrame, int64_t frameCount, float* output)
+{
+    decodeSamples(channelStorage[slot].data() + startFrame * bytesPerSample, storageFormat, output, frameCount);
+}
+
+bool PreloadedAudioExtractor::getAudioBlock(int64_t startFrame, int numFrames, int channelNums[], int channelNumsSize, int64_t lowerFrameBound, int64_t upperFrameBound, float outputBuffer[])
+{
+    int64_t requestStart = startFrame;
+    int64_t validStart = std::max({ requestStart, (int64_t)0, lowerFrameBound });
+    int64_t validEnd = std::min({ requestStart + numFrames, frameCount, boundEndFrame(upperFrameBound) });
+
+    zeroSamples(outputBuffer, (size_t)numFrames * channelNumsSize);
+    if(validStart >= validEnd) return true;
+
+    // Expand each channel in one go, then interleave
+    thread_local std::vector<float> blockScratch; // Per thread, so concurrent callers don't trample each other
+    blockScratch.resize(validEnd - validStart);
+    for(int channelIndex = 0; channelIndex < channelNumsSize; channelIndex++) {
+        int channelNum = channelNums[channelIndex];
+        if(channelNum < 0 || channelNum >= (int)channelSlots.size() || channelSlots[channelNum] < 0) continue; // Not in the file, or not loaded
+        decodeChannel(channelSlots[channelNum], validStart, validEnd - validStart, blockScratch.data());
+        float* bufferPosition = outputBuffer + (validStart - requestStart) * channelNumsSize + channelIndex;
+        for(float sample : blockScratch) {
+            *bufferPosition = sample;
+            bufferPosition += channelNumsSize;
+        }
+    }
+
+    return true;
+}
+
+bool PreloadedAudioExtractor::getAudioBlockPlanar(int64_t startFrame, int numFrames, int channelNums[], int64_t channelAudioBounds[], int channelCount, float* outputBuffers[])
+{
+    int64_t requestStart = startFrame;
+    int64_t requestEnd = requestStart + numFrames; // Exclusive
+
+    for(int channelIndex = 0; channelIndex < channelCount; channelIndex++) {
+        float* outputBuffer = outputBuffers[channelIndex];
+        int channelNum = channelNums[channelIndex];
+
+        int64_t validStart = std::max(requestStart, (int64_t)0);
+        int64_t validEnd = std::min(requestEnd, frameCount);
+        if(channelAudioBounds) {
+            validStart = std::max(validStart, channelAudioBounds[channelIndex * 2]);
+            validEnd = std::min(validEnd, boundEndFrame(channelAudioBounds[channelIndex * 2 + 1]));
+        }
+
+        if(channelNum < 0 || channelNum >= (int)channelSlots.size() || channelSlots[channelNum] < 0 || validStart >= validEnd) {
+            zeroSamples(outputBuffer, numFrames);
+            continue;
+        }
+
+        zeroSamples(outputBuffer, validStart - requestStart);
+        decodeChannel(channelSlots[channelNum], validStart, validEnd - validStart, outputBuffer + (validStart - requestStart));
+        zeroSamples(outputBuffer + (validEnd - requestStart), requestEnd - validEnd);
+    }
+
     return true;
 }
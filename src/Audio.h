@@ -1,11 +1,28 @@
 #pragma once
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <vector>
 #include <adm/adm.hpp>
 #include "Helpers.h"
+#include "ReadAhead.h"
+#include "AudioKernels.h"
+#include "Bw64Layout.h"
+#include "MappedFile.h"
+#include "EssenceReader.h"
+#include "AudioCache.h"
+#include "SilenceIndex.h"
 
 class Reader; // Forward decl
 
+// Frame bounds are inclusive, with INT64_MAX for unbounded - this gives the exclusive end without overflowing
+inline int64_t boundEndFrame(int64_t upperFrameBound)
+{
+    return upperFrameBound == INT64_MAX ? INT64_MAX : upperFrameBound + 1;
+}
+
 class AudioExtractor
 {
 public:
@@ -13,12 +30,27 @@ public:
     ~AudioExtractor() {};
 
     virtual int getSampleRate() = 0;
-    virtual int getNumberOfFrames() = 0;
-    virtual bool getAudioBlock(int startFrame, int numFrames, int channelNums[], int channelNumsSize, int lowerFrameBound, int upperFrameBound, float outputBuffer[]) = 0;
+    virtual int64_t getNumberOfFrames() = 0;
+    virtual bool getAudioBlock(int64_t startFrame, int numFrames, int channelNums[], int channelNumsSize, int64_t lowerFrameBound, int64_t upperFrameBound, float outputBuffer[]) = 0;
+    // Planar variant for pulling many channels at once - each channel is written to its own buffer (numFrames long).
+    // channelAudioBounds holds a [lower, upper] frame pair per channel (inclusive, as getAudioBlock) - nullptr for unbounded.
+    virtual bool getAudioBlockPlanar(int64_t startFrame, int numFrames, int channelNums[], int64_t channelAudioBounds[], int channelCount, float* outputBuffers[]) = 0;
+    // True only if the channel is known to be digital silence throughout [startFrame, endFrame) - callers can then skip fetching it.
+    // Extractors learn this as audio passes through them, so false just means "not known to be silent".
+    virtual bool isSilent(int channelNum, int64_t startFrame, int64_t endFrame) { return false; }
 };
 
 class FileReader; // Forward decl
 
+const uint64_t defaultAudioCacheBudgetBytes = 128 * 1024 * 1024;
+
+struct AudioCacheStats {
+    uint64_t hits{ 0 };      // Window lookups served from memory
+    uint64_t misses{ 0 };    // Windows that had to be read from the file
+    uint64_t evictions{ 0 };
+    uint64_t residentBytes{ 0 };
+};
+
 class Bw64AudioExtractor : public AudioExtractor
 {
 public:
@@ -26,25 +58,144 @@ public:
     ~Bw64AudioExtractor();
 
     int getSampleRate() override;
-    int getNumberOfFrames() override;
+    int64_t getNumberOfFrames() override;
 
-    bool getAudioBlock(int startFrame, int numFrames, int channelNums[], int channelNumsSize, int lowerFrameBound, int upperFrameBound, float outputBuffer[]) override;
+    bool getAudioBlock(int64_t startFrame, int numFrames, int channelNums[], int channelNumsSize, int64_t lowerFrameBound, int64_t upperFrameBound, float outputBuffer[]) override;
+    bool getAudioBlockPlanar(int64_t startFrame, int numFrames, int channelNums[], int64_t channelAudioBounds[], int channelCount, float* outputBuffers[]) override;
+    bool isSilent(int channelNum, int64_t startFrame, int64_t endFrame) override;
+
+    // Streaming mode - a background thread keeps readAheadSec of audio decoded ahead of the playhead. 0 = off (synchronous block reads)
+    bool setReadAhead(float readAheadSec);
+    float getReadAhead();
+    int64_t getReadAheadBufferedFrames();
+    uint64_t getReadAheadUnderrunCount();
+
+    // Synchronous block reads are cached in fixed windows, up to this many bytes in total
+    void setCacheBudget(uint64_t budgetBytes);
+    AudioCacheStats getCacheStats();
+    // Only cache these channels (planar) rather than every channel in the file (interleaved). Empty for all.
+    // Channels requested which aren't in the set are added to it on demand.
+    void setCachedChannels(const std::vector<int>& channelNums);
+    // Backend cache refills are read through - none if the file couldn't be opened
+    std::optional<EssenceIoBackend> getIoBackend();
 
 private:
     FileReader* fileReader;
 
-    // Very high probability there will be multiple sequential requests for channels of audio from the same block in the file
-    // Therefore, cache the latest extracted block... saves repeatedly declaring buffer, seeking, and reading (inc costly decoding).
-    std::vector<float> latestExtractedAudioBlock{};
-    int latestExtractedAudioBlock_StartFrame{ 0 };
-    int latestExtractedAudioBlock_EndFrame{ 0 };
-    int latestExtractedAudioBlock_FrameCount{ 0 };
-    // Note that unitys default look-ahead seems to be 800ms.. we allow more for safety, be we need to include this 'extra' in look-behind,
-    // otherwise we'll end up having to load an older block again when it moves on to the next channel, because we don't have that audio!
+    // Everything one extraction call works with. Each concurrent caller leases its own (from a pool, so nothing is allocated once warmed up)
+    //  and reads through it from windows shared with every other caller.
+    // Planar extraction groups channels which share the same in-bounds frame range so each group is one sweep of the audio.
+    struct PlanarRun {
+        int64_t startFrame;
+        int64_t endFrame;
+        std::vector<int> slots;
+        std::vector<float*> outputBuffers;
+    };
+    struct ReadCursor {
+        AudioCacheAcquisition acquisition;
+        std::unique_lock<std::mutex> readAheadLock; // Held between acquire and release when streaming
+        std::vector<PlanarRun> planarRuns;
+        size_t planarRunsUsed{ 0 };
+        std::vector<float*> segmentOutputBuffers;
+    };
+    class CursorLease {
+    public:
+        CursorLease(Bw64AudioExtractor* owner);
+        ~CursorLease();
+        ReadCursor* operator->() { return cursor.get(); }
+        ReadCursor& operator*() { return *cursor; }
+    private:
+        Bw64AudioExtractor* owner;
+        std::unique_ptr<ReadCursor> cursor;
+    };
+    std::mutex cursorPoolMutex;
+    std::vector<std::unique_ptr<ReadCursor>> idleCursors;
+
+    // Fills the cursor's segments to cover the request (or leaves them empty, if streaming and the audio isn't ready yet). Must be paired with releaseAudio.
+    // Also makes sure the listed channels are held, if only caching some.
+    bool acquireAudio(ReadCursor& cursor, int64_t startFrame, int numFrames, const int* channelNums, int channelNumsSize, int& channelCount);
+    bool releaseAudio(ReadCursor& cursor); // False if the segments were invalidated during use
+    int slotFor(const ReadCursor& cursor, int channelNum, int availableChannels); // Where a channel lives within the cursor's segments, -1 if not available
+    // Only ever called by windowCache, which serialises fills - so this has the file to itself
+    bool fillWindow(int64_t startFrame, int64_t frameCount, const std::vector<int>& channelNums, float* dest);
+
+    std::unique_ptr<EssenceReader> essenceReader; // Null if the file couldn't be opened
+
+    // The read-ahead ring has a single consumer side, so streaming consumers take turns (from acquire to release)
+    std::mutex readAheadMutex;
+    std::atomic<bool> streaming{ false };
+    std::unique_ptr<AudioReadAhead> readAhead;
+    float readAheadSec{ 0.0 };
+    // Look-behind kept by the read-ahead ring, so channels pulled slightly behind the playhead are still there
     float lookBehindSec{ 0.2 };
-    float lookAheadSec{ 1.0 };
-    // Just stats stuff, out of interest
-    uint64_t newBlockExtractCounter{ 0 };
-    uint64_t reuseBlockCounter{ 0 };
 
-};
\ No newline at end of file
+    // Very high probability there will be multiple sequential requests for channels of audio from the same part of the file, often from
+    //  several consumers at once (per-channel AudioSources, offline renders alongside playback...). Therefore, cache windows of decoded audio.
+    std::unique_ptr<AudioWindowCache> windowCache; // Null if there was no file to read
+    float cacheWindowSec{ 1.0 };
+    std::mutex channelSetMutex; // Guards cachedChannels, and serialises changes to the cache's channel set
+    std::vector<int> cachedChannels; // Sorted. Empty = all
+    std::vector<int> allChannels;
+
+    // Populated as windows are filled (not by the read-ahead ring, which isn't block aligned)
+    std::unique_ptr<SilenceIndex> silenceIndex;
+
+};
+
+class MappedAudioExtractor : public AudioExtractor
+{
+    // Serves audio straight out of a memory mapping of the file, converting only the channels requested.
+    // No private block cache - the OS page cache does that job, and unused channels never get touched.
+public:
+    MappedAudioExtractor(std::shared_ptr<MappedFile> mappedFile, const Bw64Layout& layout);
+    // Whole file already in memory that we don't own (see MemoryReader) - the caller keeps fileData alive while we're in use
+    MappedAudioExtractor(const uint8_t* fileData, const Bw64Layout& layout);
+    ~MappedAudioExtractor();
+
+    int getSampleRate() override;
+    int64_t getNumberOfFrames() override;
+
+    bool getAudioBlock(int64_t startFrame, int numFrames, int channelNums[], int channelNumsSize, int64_t lowerFrameBound, int64_t upperFrameBound, float outputBuffer[]) override;
+    bool getAudioBlockPlanar(int64_t startFrame, int numFrames, int channelNums[], int64_t channelAudioBounds[], int channelCount, float* outputBuffers[]) override;
+
+private:
+    std::shared_ptr<MappedFile> mappedFile; // Holding this keeps the mapping alive for as long as we serve from it (null when serving a caller's buffer)
+    Bw64Layout layout;
+    const uint8_t* essence;
+    SampleFormat sampleFormat;
+    int bytesPerSample;
+};
+
+class PreloadedAudioExtractor : public AudioExtractor
+{
+    // Whole file (or just the chosen channels) decoded in to memory up front, so there's no disk access at all once loaded.
+    // Held planar in a compact sample format (16-bit integer for 16-bit files, which is lossless, otherwise half-float) and expanded on request.
+public:
+    PreloadedAudioExtractor(FileReader* parentReader);
+    ~PreloadedAudioExtractor();
+
+    // Channels not listed read as silence. Empty for all channels.
+    bool load(const std::vector<int>& channelNums);
+    uint64_t getResidentBytes();
+
+    int getSampleRate() override;
+    int64_t getNumberOfFrames() override;
+
+    bool getAudioBlock(int64_t startFrame, int numFrames, int channelNums[], int channelNumsSize, int64_t lowerFrameBound, int64_t upperFrameBound, float outputBuffer[]) override;
+    bool getAudioBlockPlanar(int64_t startFrame, int numFrames, int channelNums[], int64_t channelAudioBounds[], int channelCount, float* outputBuffers[]) override;
+    bool isSilent(int channelNum, int64_t startFrame, int64_t endFrame) override;
+
+private:
+    FileReader* fileReader;
+    std::unique_ptr<SilenceIndex> silenceIndex; // Complete once loaded
+
+    // Expands [startFrame, startFrame + frameCount) of a held channel - caller keeps within the file
+    void decodeChannel(int slot, int64_t startFrame, int64_t frameCount, float* output);
+
+    int sampleRate{ 0 };
+    int64_t frameCount{ 0 };
+    SampleFormat storageFormat{ SampleFormat::FLOAT16 };
+    int bytesPerSample{ 2 };
+    std::vector<int> channelSlots; // Indexed by file channel number, -1 if not held
+    std::vector<std::vector<uint8_t>> channelStorage;
+};
@@ -0,0 +1,195 @@
+#include "AudioCache.h"
+#include <algorithm>
+
+namespace {
+    const size_t maxSpareBuffers = 4; // Only one fill runs at a time, so more would just hold memory outside the budget
+
+    inline int64_t floorDiv(int64_t value, int64_t divisor)
+    {
+        int64_t quotient = value / divisor;
+        return (value % divisor != 0 && value < 0) ? quotient - 1 : quotient; // Frames can be negative (pre-roll)
+    }
+}
+
+AudioWindowCache::AudioWindowCache(int channelCount, int64_t windowFrames, uint64_t budgetBytes, FillFn fill)
+    : channelCount{ channelCount }, windowFrames{ std::max(windowFrames, (int64_t)1) }, fill{ fill }, budgetBytes{ budgetBytes }
+{
+    currentLayout = std::make_shared<const AudioChannelLayout>();
+    spareBuffers = std::make_shared<SpareBuffers>();
+}
+
+bool AudioWindowCache::acquire(int64_t startFrame, int64_t numFrames, std::shared_ptr<const AudioChannelLayout> layout, AudioCacheAcquisition& acquisition)
+{
+    acquisition.clear();
+    acquisition.layout = layout;
+    if(numFrames <= 0) return true;
+
+    bool interleaved = layout->channelNums.empty();
+    int heldChannels = interleaved ? channelCount : (int)layout->channelNums.size();
+    int64_t firstIndex = floorDiv(startFrame, windowFrames);
+    int64_t lastIndex = floorDiv(startFrame + numFrames - 1, windowFrames);
+
+    for(int64_t index = firstIndex; index <= lastIndex; index++) {
+        std::shared_ptr<const std::vector<float>> samples;
+        {
+            std::lock_guard<std::mutex> lock(indexMutex);
+            samples = findWindow(index, layout);
+        }
+
+        if(samples) {
+            hitCount.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            std::lock_guard<std::mutex> fillLock(fillMutex);
+
+            // Someone else may have filled it while we waited
+            {
+                std::lock_guard<std::mutex> lock(indexMutex);
+                samples = findWindow(index, layout);
+            }
+
+            if(samples) {
+                hitCount.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                missCount.fetch_add(1, std::memory_order_relaxed);
+                std::vector<float> buffer = takeSpareBuffer();
+                buffer.resize(windowFrames * heldChannels);
+                if(!fill(index * windowFrames, windowFrames, layout->channelNums, buffer.data())) return false;
+                samples = makeWindowSamples(std::move(buffer));
+
+                std::lock_guard<std::mutex> lock(indexMutex);
+                if(layout == currentLayout) {
+                    // (A window made for a layout that's since been replaced still serves this request, but isn't kept)
+                    uint64_t windowBytes = bytesFor(*layout);
+                    evictUntilWithinBudget(windowBytes);
+                    windows.push_back({ index, layout, ++useClock, samples });
+                    residentBytes.fetch_add(windowBytes, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        int64_t windowStart = index * windowFrames;
+        int64_t segmentStart = std::max(startFrame, windowStart);
+        int64_t segmentEnd = std::min(startFrame + numFrames, windowStart + windowFrames);
+        if(interleaved) {
+            acquisition.segments.push_back({ samples->data() + (segmentStart - windowStart) * channelCount, segmentStart, segmentEnd, channelCount, 1 });
+        } else {
+            acquisition.segments.push_back({ samples->data() + (segmentStart - windowStart), segmentStart, segmentEnd, 1, windowFrames });
+        }
+        acquisition.heldSamples.push_back(std::move(samples));
+    }
+    return true;
+}
+
+void AudioWindowCache::setChannelSet(const std::vector<int>& channelNums)
+{
+    std::lock_guard<std::mutex> lock(indexMutex);
+    if(channelNums == currentLayout->channelNums) return;
+
+    auto layout = std::make_shared<AudioChannelLayout>();
+    layout->channelNums = channelNums;
+    if(!channelNums.empty()) {
+        layout->slots.assign(channelCount, -1);
+        for(size_t slot = 0; slot < channelNums.size(); slot++) {
+            if(channelNums[slot] >= 0 && channelNums[slot] < channelCount) {
+                layout->slots[channelNums[slot]] = (int)slot;
+            }
+        }
+    }
+    currentLayout = layout;
+
+    // Existing windows have the wrong shape
+    while(!windows.empty()) {
+        removeWindow(windows.size() - 1);
+    }
+    clearSpareBuffers();
+}
+
+std::shared_ptr<const AudioChannelLayout> AudioWindowCache::getLayout()
+{
+    std::lock_guard<std::mutex> lock(indexMutex);
+    return currentLayout;
+}
+
+void AudioWindowCache::setBudget(uint64_t newBudgetBytes)
+{
+    std::lock_guard<std::mutex> lock(indexMutex);
+    budgetBytes = newBudgetBytes;
+    evictUntilWithinBudget(0);
+    clearSpareBuffers();
+}
+
+void AudioWindowCache::clear()
+{
+    std::lock_guard<std::mutex> lock(indexMutex);
+    while(!windows.empty()) {
+        removeWindow(windows.size() - 1);
+    }
+    clearSpareBuffers();
+}
+
+std::shared_ptr<const std::vector<float>> AudioWindowCache::findWindow(int64_t index, const std::shared_ptr<const AudioChannelLayout>& layout)
+{
+    for(auto& window : windows) {
+        if(window.index == index && window.layout == layout) {
+            window.lastUse = ++useClock;
+            return window.samples;
+        }
+    }
+    return nullptr;
+}
+
+void AudioWindowCache::evictUntilWithinBudget(uint64_t reserveBytes)
+{
+    // Windows still being read elsewhere are kept alive by their readers - we just stop handing them out
+    while(!windows.empty() && residentBytes.load(std::memory_order_relaxed) + reserveBytes > budgetBytes) {
+        auto oldest = std::min_element(windows.begin(), windows.end(), [](const Window& a, const Window& b) { return a.lastUse < b.lastUse; });
+        removeWindow(oldest - windows.begin());
+        evictionCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void AudioWindowCache::removeWindow(size_t windowIndex)
+{
+    Window& window = windows[windowIndex];
+    residentBytes.fetch_sub(bytesFor(*window.layout), std::memory_order_relaxed);
+    window = std::move(windows.back());
+    windows.pop_back();
+}
+
+uint64_t AudioWindowCache::bytesFor(const AudioChannelLayout& layout) const
+{
+    size_t heldChannels = layout.channelNums.empty() ? channelCount : layout.channelNums.size();
+    return (uint64_t)windowFrames * heldChannels * sizeof(float);
+}
+
+std::vector<float> AudioWindowCache::takeSpareBuffer()
+{
+    std::lock_guard<std::mutex> lock(spareBuffers->mutex);
+    if(spareBuffers->buffers.empty()) return std::vector<float>();
+    std::vector<float> buffer = std::move(spareBuffers->buffers.back());
+    spareBuffers->buffers.pop_back();
+    return buffer;
+}
+
+void AudioWindowCache::clearSpareBuffers()
+{
+    std::lock_guard<std::mutex> lock(spareBuffers->mutex);
+    spareBuffers->buffers.clear();
+}
+
+std::shared_ptr<const std::vector<float>> AudioWindowCache::makeWindowSamples(std::vector<float>&& buffer)
+{
+    // The vector itself isn't const - only the window's view of it - so the deleter can take its allocation back.
+    // It runs once the last reference is gone, which shared_ptr orders after every read through the others.
+    auto samples = new std::vector<float>(std::move(buffer));
+    std::weak_ptr<SpareBuffers> spares = spareBuffers;
+    return std::shared_ptr<const std::vector<float>>(samples, [spares, samples](const std::vector<float>*) {
+        if(auto pool = spares.lock()) {
+            std::lock_guard<std::mutex> lock(pool->mutex);
+            if(pool->buffers.size() < maxSpareBuffers) {
+                pool->buffers.push_back(std::move(*samples));
+            }
+        }
+        delete samples;
+    });
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "ReadAhead.h"
+
+// Which channels of the file a window holds, and where. Immutable once made - windows and readers share it.
+struct AudioChannelLayout {
+    std::vector<int> channelNums; // Held channels, in slot order. Empty = every channel, interleaved
+    std::vector<int> slots;       // Indexed by file channel number, -1 if not held. Empty when holding every channel
+
+    // Caller checks channelNum is within the file
+    int slotFor(int channelNum) const { return slots.empty() ? channelNum : slots[channelNum]; }
+};
+
+// Segments of an acquire, plus the references keeping them alive. Reuse one per thread to avoid reallocating.
+struct AudioCacheAcquisition {
+    std::vector<AudioSegment> segments;
+    std::shared_ptr<const AudioChannelLayout> layout; // Shared by every segment
+    std::vector<std::shared_ptr<const std::vector<float>>> heldSamples;
+
+    void clear()
+    {
+        segments.clear();
+        heldSamples.clear();
+        layout.reset();
+    }
+};
+
+class AudioWindowCache
+{
+    // Decoded audio held as fixed-size windows aligned to multiples of windowFrames,
+    //  so consumers at different positions in the file each keep their own windows rather than evicting one another.
+    // Least recently used windows are evicted once the total exceeds the memory budget.
+    // By default every channel of the file is held, interleaved. Given a channel set, only those channels are held, planar.
+    //
+    // Thread-safe. Windows are immutable once filled and handed out by shared_ptr, so any number of threads can read them at once -
+    //  the index is only locked briefly for lookups and inserts, and eviction just drops the cache's reference.
+    // Fills are serialised (the fill function gets exclusive use of whatever it reads from), but never block readers of cached windows.
+
+public:
+    // fill must write frameCount frames from startFrame (padding with silence anywhere outside the file) -
+    //  all channels interleaved if channelNums is empty, otherwise one planar row of frameCount per listed channel.
+    typedef std::function<bool(int64_t startFrame, int64_t frameCount, const std::vector<int>& channelNums, float* dest)> FillFn;
+
+    AudioWindowCache(int channelCount, int64_t windowFrames, uint64_t budgetBytes, FillFn fill);
+
+    // Segments covering [startFrame, startFrame + numFrames), all in the given layout (normally getLayout()), filling any windows not already held.
+    // Segments stay valid for as long as the acquisition holds them. False if a fill failed.
+    bool acquire(int64_t startFrame, int64_t numFrames, std::shared_ptr<const AudioChannelLayout> layout, AudioCacheAcquisition& acquisition);
+
+    // Empty for all channels. Windows in any other layout are dropped from the cache (readers still holding them are unaffected).
+    void setChannelSet(const std::vector<int>& channelNums);
+    std::shared_ptr<const AudioChannelLayout> getLayout();
+
+    void setBudget(uint64_t budgetBytes);
+    void clear();
+
+    uint64_t getHitCount() const { return hitCount.load(std::memory_order_relaxed); }
+    uint64_t getMissCount() const { return missCount.load(std::memory_order_relaxed); }
+    uint64_t getEvictionCount() const { return evictionCount.load(std::memory_order_relaxed); }
+    uint64_t getResidentBytes() const { return residentBytes.load(std::memory_order_relaxed); }
+
+private:
+    struct Window {
+        int64_t index; // Start frame = index * windowFrames
+        std::shared_ptr<const AudioChannelLayout> layout;
+        uint64_t lastUse;
+        std::shared_ptr<const std::vector<float>> samples;
+    };
+
+    // All of these expect indexMutex to be held
+    std::shared_ptr<const std::vector<float>> findWindow(int64_t index, const std::shared_ptr<const AudioChannelLayout>& layout);
+    void evictUntilWithinBudget(uint64_t reserveBytes);
+    void removeWindow(size_t windowIndex);
+    uint64_t bytesFor(const AudioChannelLayout& layout) const;
+
+    // Buffers of windows nobody refers to any more, recycled by the next fill. Handed back by the last reference's deleter,
+    //  wherever that's dropped - so it has its own lock. Windows released after the cache has gone are just freed.
+    struct SpareBuffers {
+        std::mutex mutex;
+        std::vector<std::vector<float>> buffers;
+    };
+    std::shared_ptr<SpareBuffers> spareBuffers;
+    std::vector<float> takeSpareBuffer();
+    void clearSpareBuffers();
+    // Shares the filled buffer as a window, returning it to spareBuffers once released
+    std::shared_ptr<const std::vector<float>> makeWindowSamples(std::vector<float>&& buffer);
+
+    int channelCount;
+    int64_t windowFrames;
+    FillFn fill;
+
+    std::mutex indexMutex; // Guards everything below (except the atomics)
+    uint64_t budgetBytes;
+    std::shared_ptr<const AudioChannelLayout> currentLayout;
+    std::vector<Window> windows; // Few enough that a linear search beats anything cleverer
+    uint64_t useClock{ 0 };
+
+    std::mutex fillMutex;
+
+    std::atomic<uint64_t> hitCount{ 0 };
+    std::atomic<uint64_t> missCount{ 0 };
+    std::atomic<uint64_t> evictionCount{ 0 };
+    std::atomic<uint64_t> residentBytes{ 0 };
+};
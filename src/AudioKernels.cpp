@@ -0,0 +1,514 @@
+#include "AudioKernels.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AUDIOKERNELS_SSE
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define AUDIOKERNELS_TARGET(isa) // MSVC allows any intrinsic in any function
+#else
+#define AUDIOKERNELS_TARGET(isa) __attribute__((target(isa)))
+#include <cpuid.h>
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define AUDIOKERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+namespace {
+    // 16 frames of 128 interleaved channels is 8KB - comfortably L1 resident while each channel is pulled out of it.
+    const size_t tileFrames = 16;
+
+    inline bool isConsecutiveQuad(const int* channelNums)
+    {
+        return channelNums[1] == channelNums[0] + 1 &&
+               channelNums[2] == channelNums[0] + 2 &&
+               channelNums[3] == channelNums[0] + 3;
+    }
+
+    // Takes 4 frames of 4 adjacent channels and writes 4 samples to each of the 4 outputs
+    inline void transposeQuad(const float* src, int srcStride, float* out0, float* out1, float* out2, float* out3)
+    {
+#if defined(AUDIOKERNELS_SSE)
+        __m128 r0 = _mm_loadu_ps(src);
+        __m128 r1 = _mm_loadu_ps(src + srcStride);
+        __m128 r2 = _mm_loadu_ps(src + srcStride * 2);
+        __m128 r3 = _mm_loadu_ps(src + srcStride * 3);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        _mm_storeu_ps(out0, r0);
+        _mm_storeu_ps(out1, r1);
+        _mm_storeu_ps(out2, r2);
+        _mm_storeu_ps(out3, r3);
+#elif defined(AUDIOKERNELS_NEON)
+        float32x4x2_t t01 = vtrnq_f32(vld1q_f32(src), vld1q_f32(src + srcStride));
+        float32x4x2_t t23 = vtrnq_f32(vld1q_f32(src + srcStride * 2), vld1q_f32(src + srcStride * 3));
+        vst1q_f32(out0, vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0])));
+        vst1q_f32(out1, vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1])));
+        vst1q_f32(out2, vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0])));
+        vst1q_f32(out3, vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1])));
+#else
+        for(int frame = 0; frame < 4; frame++) {
+            const float* row = src + srcStride * frame;
+            out0[frame] = row[0];
+            out1[frame] = row[1];
+            out2[frame] = row[2];
+            out3[frame] = row[3];
+        }
+#endif
+    }
+}
+
+void deinterleaveChannels(const float* interleaved, int interleavedChannels,
+                          const int* channelNums, float* const* outputBuffers, int channelCount,
+                          size_t frameCount)
+{
+    for(size_t tileStart = 0; tileStart < frameCount; tileStart += tileFrames) {
+        size_t tileEnd = std::min(tileStart + tileFrames, frameCount);
+        const float* tile = interleaved + tileStart * interleavedChannels;
+
+        int channelIndex = 0;
+        while(channelIndex < channelCount) {
+            if(channelIndex + 3 < channelCount && isConsecutiveQuad(channelNums + channelIndex)) {
+                // Four adjacent file channels (typical for HOA and multichannel beds) - transpose 4x4 at a time
+                const float* src = tile + channelNums[channelIndex];
+                float* out0 = outputBuffers[channelIndex + 0] + tileStart;
+                float* out1 = outputBuffers[channelIndex + 1] + tileStart;
+                float* out2 = outputBuffers[channelIndex + 2] + tileStart;
+                float* out3 = outputBuffers[channelIndex + 3] + tileStart;
+                size_t frame = tileStart;
+                for(; frame + 4 <= tileEnd; frame += 4) {
+                    transposeQuad(src, interleavedChannels, out0, out1, out2, out3);
+                    src += interleavedChannels * 4;
+                    out0 += 4; out1 += 4; out2 += 4; out3 += 4;
+                }
+                for(; frame < tileEnd; frame++) {
+                    *out0++ = src[0];
+                    *out1++ = src[1];
+                    *out2++ = src[2];
+                    *out3++ = src[3];
+                    src += interleavedChannels;
+                }
+                channelIndex += 4;
+
+            } else {
+                const float* src = tile + channelNums[channelIndex];
+                float* out = outputBuffers[channelIndex] + tileStart;
+                for(size_t frame = tileStart; frame < tileEnd; frame++) {
+                    *out++ = *src;
+                    src += interleavedChannels;
+                }
+                channelIndex++;
+            }
+        }
+    }
+}
+
+void zeroSamples(float* buffer, size_t sampleCount)
+{
+    if(sampleCount > 0) {
+        std::memset(buffer, 0, sampleCount * sizeof(float)); // All-bits-zero is 0.0f for IEEE754
+    }
+}
+
+namespace {
+    const float int16Scale = 1.0f / 32768.0f;
+    const float int24Scale = 1.0f / 8388608.0f;
+    const float int32Scale = 1.0f / 2147483648.0f;
+
+    inline float decodeInt16(const uint8_t* p)
+    {
+        return (int16_t)((uint16_t)p[0] | ((uint16_t)p[1] << 8)) * int16Scale;
+    }
+
+    inline float decodeInt24(const uint8_t* p)
+    {
+        return ((int32_t)(((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24)) >> 8) * int24Scale; // Shift back down to sign-extend
+    }
+
+    inline float decodeInt32(const uint8_t* p)
+    {
+        return (int32_t)((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24)) * int32Scale;
+    }
+
+    inline uint32_t floatBits(float value)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    inline float bitsFloat(uint32_t bits)
+    {
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // IEEE 754 binary16 <-> binary32, handling subnormals, infinities and NaN. Float to half rounds to nearest even (as F16C does).
+    inline float halfToFloat(uint16_t half)
+    {
+        const uint32_t shiftedExponent = 0x7C00 << 13;
+        uint32_t bits = (uint32_t)(half & 0x7FFF) << 13;
+        uint32_t exponent = bits & shiftedExponent;
+        bits += (127 - 15) << 23; // Rebias
+        if(exponent == shiftedExponent) {
+            bits += (128 - 16) << 23; // Inf/NaN
+        } else if(exponent == 0) {
+            bits = floatBits(bitsFloat(bits + (1 << 23)) - bitsFloat(113 << 23)); // Zero/subnormal - let the FPU renormalise
+        }
+        return bitsFloat(bits | ((uint32_t)(half & 0x8000) << 16));
+    }
+
+    inline uint16_t floatToHalf(float value)
+    {
+        const uint32_t denormMagic = ((127 - 15) + (23 - 10) + 1) << 23;
+        uint32_t bits = floatBits(value);
+        uint32_t sign = bits & 0x80000000u;
+        bits ^= sign;
+        uint16_t half;
+        if(bits >= (127 + 16) << 23) {
+            half = bits > (255u << 23) ? 0x7E00 : 0x7C00; // NaN stays NaN, anything too big is Inf
+        } else if(bits < 113 << 23) {
+            half = (uint16_t)(floatBits(bitsFloat(bits) + bitsFloat(denormMagic)) - denormMagic); // Subnormal - FPU does the rounding
+        } else {
+            uint32_t mantissaOdd = (bits >> 13) & 1;
+            bits += ((uint32_t)(15 - 127) << 23) + 0xFFF + mantissaOdd;
+            half = (uint16_t)(bits >> 13);
+        }
+        return half | (uint16_t)(sign >> 16);
+    }
+
+    inline uint16_t readU16(const uint8_t* p)
+    {
+        return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+    }
+
+    // Each kernel converts as many samples as it can and returns how many, leaving the tail to the scalar code
+    typedef size_t(*DecodeFn)(const uint8_t* source, float* output, size_t count);
+
+    size_t decodeNone(const uint8_t*, float*, size_t)
+    {
+        return 0;
+    }
+
+    typedef size_t(*EncodeFn)(const float* source, uint8_t* output, size_t count);
+
+    size_t encodeNone(const float*, uint8_t*, size_t)
+    {
+        return 0;
+    }
+
+#if defined(AUDIOKERNELS_SSE)
+    // All platforms we target are little-endian, so raw PCM can be loaded straight in to lanes
+
+    size_t decodeInt16Sse(const uint8_t* source, float* output, size_t count)
+    {
+        const __m128 scale = _mm_set1_ps(int16Scale);
+        size_t i = 0;
+        for(; i + 8 <= count; i += 8) {
+            __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2));
+            // Put each sample in the top half of a 32-bit lane, then arithmetic shift down to sign-extend
+            __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(raw, raw), 16);
+            __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(raw, raw), 16);
+            _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+            _mm_storeu_ps(output + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+        }
+        return i;
+    }
+
+    AUDIOKERNELS_TARGET("ssse3")
+    size_t decodeInt24Sse(const uint8_t* source, float* output, size_t count)
+    {
+        // Byte shuffle 4 packed 3-byte samples in to the top 3 bytes of 4 lanes (-1 = zero the low byte)
+        const __m128i spread = _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+        const __m128 scale = _mm_set1_ps(int24Scale);
+        size_t i = 0;
+        // Each load is 16 bytes for 12 bytes of samples, so stop while there's still a full load left
+        for(; i + 6 <= count; i += 4) {
+            __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 3));
+            __m128i samples = _mm_srai_epi32(_mm_shuffle_epi8(raw, spread), 8);
+            _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(samples), scale));
+        }
+        return i;
+    }
+
+    size_t decodeInt32Sse(const uint8_t* source, float* output, size_t count)
+    {
+        const __m128 scale = _mm_set1_ps(int32Scale);
+        size_t i = 0;
+        for(; i + 4 <= count; i += 4) {
+            __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 4));
+            _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(raw), scale));
+        }
+        return i;
+    }
+
+    AUDIOKERNELS_TARGET("avx2")
+    size_t decodeInt16Avx2(const uint8_t* source, float* output, size_t count)
+    {
+        const __m256 scale = _mm256_set1_ps(int16Scale);
+        size_t i = 0;
+        for(; i + 16 <= count; i += 16) {
+            __m128i rawLo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2));
+            __m128i rawHi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2 + 16));
+            _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(rawLo)), scale));
+            _mm256_storeu_ps(output + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(rawHi)), scale));
+        }
+        return i;
+    }
+
+    AUDIOKERNELS_TARGET("avx2")
+    size_t decodeInt24Avx2(const uint8_t* source, float* output, size_t count)
+    {
+        // AVX2 byte shuffles don't cross 128-bit lanes, so load 4 samples in to each lane and shuffle as SSE does
+        const __m256i spread = _mm256_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+                                                -1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+        const __m256 scale = _mm256_set1_ps(int24Scale);
+        size_t i = 0;
+        // Second load reads bytes 12-27 for 8 samples (24 bytes), so keep a full load in hand
+        for(; i + 10 <= count; i += 8) {
+            const uint8_t* p = source + i * 3;
+            __m128i rawLo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            __m128i rawHi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 12));
+            __m256i raw = _mm256_inserti128_si256(_mm256_castsi128_si256(rawLo), rawHi, 1);
+            __m256i samples = _mm256_srai_epi32(_mm256_shuffle_epi8(raw, spread), 8);
+            _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_cvtepi32_ps(samples), scale));
+        }
+        return i;
+    }
+
+    AUDIOKERNELS_TARGET("avx2")
+    size_t decodeInt32Avx2(const uint8_t* source, float* output, size_t count)
+    {
+        const __m256 scale = _mm256_set1_ps(int32Scale);
+        size_t i = 0;
+        for(; i + 8 <= count; i += 8) {
+            __m256i raw = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i * 4));
+            _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_cvtepi32_ps(raw), scale));
+        }
+        return i;
+    }
+
+    AUDIOKERNELS_TARGET("avx2,f16c")
+    size_t decodeFloat16Avx2(const uint8_t* source, float* output, size_t count)
+    {
+        size_t i = 0;
+        for(; i + 8 <= count; i += 8) {
+            __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2));
+            _mm256_storeu_ps(output + i, _mm256_cvtph_ps(raw));
+        }
+        return i;
+    }
+
+    AUDIOKERNELS_TARGET("avx2,f16c")
+    size_t encodeFloat16Avx2(const float* source, uint8_t* output, size_t count)
+    {
+        size_t i = 0;
+        for(; i + 8 <= count; i += 8) {
+            __m128i half = _mm256_cvtps_ph(_mm256_loadu_ps(source + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 2), half);
+        }
+        return i;
+    }
+
+    bool cpuSupports(DecodeKernel kernel)
+    {
+        if(kernel == DecodeKernel::SCALAR) return true;
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 0);
+        int maxLeaf = info[0];
+        __cpuid(info, 1);
+        bool ssse3 = (info[2] & (1 << 9)) != 0;
+        if(kernel == DecodeKernel::SSE) return ssse3;
+        // AVX2 also needs the OS to be saving the YMM registers. The set also uses F16C (present on every AVX2 CPU we know of, but checked anyway)
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool f16c = (info[2] & (1 << 29)) != 0;
+        if(!osxsave || !f16c || maxLeaf < 7 || (_xgetbv(0) & 0x6) != 0x6) return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        if(kernel == DecodeKernel::SSE) return __builtin_cpu_supports("ssse3");
+        unsigned int eax, ebx, ecx, edx;
+        bool f16c = __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_F16C);
+        return f16c && __builtin_cpu_supports("avx2");
+#endif
+    }
+#else
+    bool cpuSupports(DecodeKernel kernel)
+    {
+        return kernel == DecodeKernel::SCALAR;
+    }
+#endif
+
+    struct DecodeKernelSet {
+        DecodeKernel kernel;
+        DecodeFn int16;
+        DecodeFn int24;
+        DecodeFn int32;
+        DecodeFn float16;
+        EncodeFn encodeFloat16;
+    };
+
+    const DecodeKernelSet scalarKernels{ DecodeKernel::SCALAR, decodeNone, decodeNone, decodeNone, decodeNone, encodeNone };
+#if defined(AUDIOKERNELS_SSE)
+    const DecodeKernelSet sseKernels{ DecodeKernel::SSE, decodeInt16Sse, decodeInt24Sse, decodeInt32Sse, decodeNone, encodeNone };
+    const DecodeKernelSet avx2Kernels{ DecodeKernel::AVX2, decodeInt16Avx2, decodeInt24Avx2, decodeInt32Avx2, decodeFloat16Avx2, encodeFloat16Avx2 };
+#endif
+
+    const DecodeKernelSet* kernelSetFor(DecodeKernel kernel)
+    {
+#if defined(AUDIOKERNELS_SSE)
+        if(kernel == DecodeKernel::AVX2) return &avx2Kernels;
+        if(kernel == DecodeKernel::SSE) return &sseKernels;
+#endif
+        return &scalarKernels;
+    }
+
+    std::atomic<const DecodeKernelSet*>& activeKernels()
+    {
+        static std::atomic<const DecodeKernelSet*> kernels{ [] {
+            for(auto kernel : { DecodeKernel::AVX2, DecodeKernel::SSE }) {
+                if(cpuSupports(kernel)) return kernelSetFor(kernel);
+            }
+            return &scalarKernels;
+        }() };
+        return kernels;
+    }
+}
+
+void decodeSamplesStrided(const uint8_t* source, size_t sourceStride, SampleFormat format, float* output, size_t count)
+{
+    // Switch outside the loop so each case is a tight loop of its own
+    switch(format) {
+    case SampleFormat::INT16:
+        for(size_t i = 0; i < count; i++, source += sourceStride) {
+            output[i] = decodeInt16(source);
+        }
+        break;
+    case SampleFormat::INT24:
+        for(size_t i = 0; i < count; i++, source += sourceStride) {
+            output[i] = decodeInt24(source);
+        }
+        break;
+    case SampleFormat::INT32:
+        for(size_t i = 0; i < count; i++, source += sourceStride) {
+            output[i] = decodeInt32(source);
+        }
+        break;
+    case SampleFormat::FLOAT32:
+        for(size_t i = 0; i < count; i++, source += sourceStride) {
+            std::memcpy(&output[i], source, sizeof(float)); // All supported platforms are little-endian
+        }
+        break;
+    case SampleFormat::FLOAT16:
+        for(size_t i = 0; i < count; i++, source += sourceStride) {
+            output[i] = halfToFloat(readU16(source));
+        }
+        break;
+    }
+}
+
+void decodeSamples(const uint8_t* source, SampleFormat format, float* output, size_t count)
+{
+    const DecodeKernelSet* kernels = activeKernels().load(std::memory_order_relaxed);
+    size_t done = 0;
+    size_t bytesPerSample = 4;
+    switch(format) {
+    case SampleFormat::INT16:
+        done = kernels->int16(source, output, count);
+        bytesPerSample = 2;
+        break;
+    case SampleFormat::INT24:
+        done = kernels->int24(source, output, count);
+        bytesPerSample = 3;
+        break;
+    case SampleFormat::INT32:
+        done = kernels->int32(source, output, count);
+        break;
+    case SampleFormat::FLOAT16:
+        done = kernels->float16(source, output, count);
+        bytesPerSample = 2;
+        break;
+    case SampleFormat::FLOAT32:
+        std::memcpy(output, source, count * sizeof(float)); // Already what we want - memcpy is as good as any kernel
+        return;
+    }
+    // Scalar for whatever the kernel couldn't fit in to whole vectors (or everything, if no SIMD)
+    decodeSamplesStrided(source + done * bytesPerSample, bytesPerSample, format, output + done, count - done);
+}
+
+void encodeSamples(const float* source, SampleFormat format, uint8_t* output, size_t count)
+{
+    size_t done = 0;
+    if(format == SampleFormat::FLOAT16) {
+        done = activeKernels().load(std::memory_order_relaxed)->encodeFloat16(source, output, count);
+    }
+    // Integer formats clip and round to nearest. Little-endian throughout.
+    auto toInteger = [](float value, float scale, float maxValue) {
+        return (int32_t)std::lrint(std::min(std::max(value * scale, -scale), maxValue));
+    };
+    for(size_t i = done; i < count; i++) {
+        float value = source[i];
+        switch(format) {
+        case SampleFormat::INT16: {
+            int32_t sample = toInteger(value, 32768.0f, 32767.0f);
+            output[i * 2] = (uint8_t)sample;
+            output[i * 2 + 1] = (uint8_t)(sample >> 8);
+            break;
+        }
+        case SampleFormat::INT24: {
+            int32_t sample = toInteger(value, 8388608.0f, 8388607.0f);
+            output[i * 3] = (uint8_t)sample;
+            output[i * 3 + 1] = (uint8_t)(sample >> 8);
+            output[i * 3 + 2] = (uint8_t)(sample >> 16);
+            break;
+        }
+        case SampleFormat::INT32: {
+            // 2147483647 isn't representable as a float - clip in double instead
+            int32_t sample = (int32_t)std::lrint(std::min(std::max((double)value * 2147483648.0, -2147483648.0), 2147483647.0));
+            for(int byte = 0; byte < 4; byte++) output[i * 4 + byte] = (uint8_t)(sample >> (byte * 8));
+            break;
+        }
+        case SampleFormat::FLOAT16: {
+            uint16_t half = floatToHalf(value);
+            output[i * 2] = (uint8_t)half;
+            output[i * 2 + 1] = (uint8_t)(half >> 8);
+            break;
+        }
+        case SampleFormat::FLOAT32:
+            std::memcpy(output + i * 4, &value, sizeof(float));
+            break;
+        }
+    }
+}
+
+int bytesPerSampleOf(SampleFormat format)
+{
+    switch(format) {
+    case SampleFormat::INT16:
+    case SampleFormat::FLOAT16:
+        return 2;
+    case SampleFormat::INT24:
+        return 3;
+    default:
+        return 4;
+    }
+}
+
+DecodeKernel getDecodeKernel()
+{
+    return activeKernels().load(std::memory_order_relaxed)->kernel;
+}
+
+bool setDecodeKernel(DecodeKernel kernel)
+{
+    if(!cpuSupports(kernel)) return false;
+    activeKernels().store(kernelSetFor(kernel), std::memory_order_relaxed);
+    return true;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Low-level sample shuffling routines used by the AudioExtractors.
+// These are deliberately free of any knowledge of files, caches or bounds - callers resolve all of that first
+//  and then hand over plain contiguous memory.
+
+// Copy frameCount frames of the listed channels out of an interleaved buffer (interleavedChannels wide) in to planar buffers.
+// channelNums and outputBuffers are both channelCount long, and all channelNums must be valid for the interleaved buffer.
+// The interleaved buffer is walked once, in tiles small enough to stay in L1, rather than once per channel.
+void deinterleaveChannels(const float* interleaved, int interleavedChannels,
+                          const int* channelNums, float* const* outputBuffers, int channelCount,
+                          size_t frameCount);
+
+void zeroSamples(float* buffer, size_t sampleCount);
+
+enum class SampleFormat { INT16, INT24, INT32, FLOAT32, FLOAT16 }; // FLOAT16 is never found in files - it's for compact in-memory storage
+int bytesPerSampleOf(SampleFormat format);
+
+// Convert count samples of raw little-endian essence, each sourceStride bytes apart, to float (full scale = +/-1.0)
+void decodeSamplesStrided(const uint8_t* source, size_t sourceStride, SampleFormat format, float* output, size_t count);
+
+// As above, for tightly packed samples (e.g, whole interleaved frames). Uses the widest SIMD the CPU supports (checked once, at first use).
+void decodeSamples(const uint8_t* source, SampleFormat format, float* output, size_t count);
+// The reverse - integer formats are clipped to full scale
+void encodeSamples(const float* source, SampleFormat format, uint8_t* output, size_t count);
+
+enum class DecodeKernel { SCALAR, SSE, AVX2 };
+DecodeKernel getDecodeKernel();
+// Force a particular kernel set (e.g, for benchmarking). Returns false if the CPU doesn't support it.
+bool setDecodeKernel(DecodeKernel kernel);
@@ -9,8 +9,6 @@
 #define DEFAULT_TENSORFILE_NAME "default.tf"
 
 namespace {
-    BearRender* bearRender = nullptr;
-
     bool fileReadable(const std::string& name) {
         if(FILE *file = fopen(name.c_str(), "r")) {
             fclose(file);
@@ -18,15 +16,16 @@ namespace {
         }
         return false;
     }
-}
 
-BearRender* getBearSingleton()
-{
-    // TODO - need a destroy method to tidy this up when unloading lib
-    if(!bearRender) {
-        bearRender = new BearRender();
+    // The legacy MetadataBlock entry points always fed BEAR the block's polar fields - keep doing so
+    void packPolarBlockRecord(const MetadataBlock& metadataBlock, BlockRecord* blockRecord)
+    {
+        packBlockRecord(metadataBlock, blockRecord);
+        blockRecord->cartesian = false;
+        blockRecord->position[0] = metadataBlock.azimuth;
+        blockRecord->position[1] = metadataBlock.elevation;
+        blockRecord->position[2] = metadataBlock.distance;
     }
-    return bearRender;
 }
 
 BearRender::BearRender()
@@ -62,6 +61,10 @@ bool BearRender::setupBear(std::shared_ptr<AudioExtractor> usingExtractor, size_
     bearDirectSpeakersInputBuffers_RawPointers = std::vector<float*>(maxDirectSpeakersChannels, nullptr);
     bearHoaInputBuffers = std::vector<std::shared_ptr<std::vector<float>>>(maxHoaChannels, nullptr);
     bearHoaInputBuffers_RawPointers = std::vector<float*>(maxHoaChannels, nullptr);
+    size_t maxInputChannels = maxObjectsChannels + maxDirectSpeakersChannels + maxHoaChannels;
+    bearInputChannelNums.reserve(maxInputChannels);
+    bearInputAudioBounds.reserve(maxInputChannels * 2);
+    bearInputBuffers.reserve(maxInputChannels);
     setBufferFrameCounts(maxAnticipatedBlockFrameRequest);
 
     return restartBear();
@@ -115,7 +118,7 @@ bool BearRender::restartBear()
     return true;
 }
 
-bool BearRender::prewarnBearRender(int startFrameAtOpSr, int numFramesAtOpSr, int opSampleRate, int useSrcType)
+bool BearRender::prewarnBearRender(int64_t startFrameAtOpSr, int numFramesAtOpSr, int opSampleRate, int useSrcType)
 {
     bool retSuccess = true;
     betweenPrewarnAndRender = false; // Only true on success
@@ -182,9 +185,9 @@ bool BearRender::prewarnBearRender(int startFrameAtOpSr, int numFramesAtOpSr, in
         //  filter and so it may be partially though a frame, causing rounding error if it is not included in subsequent calcs
         double dblInputStartFrame = ((double)(startFrameAtOpSr + primingFrames)) / srcRatio;
         double dblInputNumFrames = (double)numFramesAtOpSr / srcRatio;
-        int intInputEndFrame = (int)std::floor(dblInputStartFrame + dblInputNumFrames);
-        onRenderInputStartFrame = (int)std::floor(dblInputStartFrame) - primingFrames;
-        onRenderInputNumFrames = intInputEndFrame - onRenderInputStartFrame - primingFrames;
+        int64_t intInputEndFrame = (int64_t)std::floor(dblInputStartFrame + dblInputNumFrames);
+        onRenderInputStartFrame = (int64_t)std::floor(dblInputStartFrame) - primingFrames;
+        onRenderInputNumFrames = (int)(intInputEndFrame - onRenderInputStartFrame - primingFrames);
         onRenderOutputNumFrames = numFramesAtOpSr;
 
         srcData.output_frames = onRenderOutputNumFrames;
@@ -220,6 +223,15 @@ bool BearRender::prewarnBearRender(int startFrameAtOpSr, int numFramesAtOpSr, in
 }
 
 bool BearRender::addObjectMetadata(int forBearChannel, MetadataBlock* metadataBlock)
+{
+    ItemDescriptor itemDescriptor;
+    BlockRecord blockRecord;
+    describeItem(*metadataBlock, &itemDescriptor);
+    packPolarBlockRecord(*metadataBlock, &blockRecord);
+    return addObjectBlock(forBearChannel, &itemDescriptor, &blockRecord);
+}
+
+bool BearRender::addObjectBlock(int forBearChannel, const ItemDescriptor* itemDescriptor, const BlockRecord* blockRecord)
 {
     getExceptionHandler()->clearException(); // Clear because this method can return false without an exception.
 
@@ -238,40 +250,49 @@ bool BearRender::addObjectMetadata(int forBearChannel, MetadataBlock* metadataBl
         return false;
     }
 
-    // TODO: Cache latest bear::ObjectsInput generated and what it was generated from (metadataBlock pointer)
-    // This way, if it is rejected, on the next call if the metadataBlock pointer matches, we can just use the one we already constructed.
+    // TODO: Cache latest bear::ObjectsInput generated and what it was generated from (blockRecord pointer)
+    // This way, if it is rejected, on the next call if the blockRecord pointer matches, we can just use the one we already constructed.
 
     bear::ObjectsInput bearMetadata;
     double sampleRate = bearConfig.get_sample_rate();
 
     // Note offsetting rtime by originStartingFrame to enable seeking
-    bearMetadata.rtime = bear::Time{ (int)(sampleRate * metadataBlock->rTime) - originStartingFrame, bearConfig.get_sample_rate() };
-    if(metadataBlock->duration != INFINITY) {
-        bearMetadata.duration = bear::Time{ (int)(sampleRate * metadataBlock->duration), bearConfig.get_sample_rate() };
+    bearMetadata.rtime = bear::Time{ (int64_t)(sampleRate * blockRecord->rTime) - originStartingFrame, bearConfig.get_sample_rate() };
+    if(blockRecord->duration != INFINITY) {
+        bearMetadata.duration = bear::Time{ (int64_t)(sampleRate * blockRecord->duration), bearConfig.get_sample_rate() };
     }
 
-    // Bear only wants polar at the mo!
+    // Bear only wants polar at the mo! (the host converts cartesian blocks before passing them)
     bearMetadata.type_metadata.cartesian = false;
-    bearMetadata.type_metadata.position = ear::PolarPosition{ metadataBlock->azimuth, metadataBlock->elevation, metadataBlock->distance };
-    bearMetadata.type_metadata.gain = metadataBlock->gain;
-    bearMetadata.type_metadata.diffuse = metadataBlock->diffuse;
-    bearMetadata.type_metadata.height = metadataBlock->height;
-    bearMetadata.type_metadata.width = metadataBlock->width;
-    bearMetadata.type_metadata.depth = metadataBlock->depth;
+    bearMetadata.type_metadata.position = ear::PolarPosition{ blockRecord->position[0], blockRecord->position[1], blockRecord->position[2] };
+    bearMetadata.type_metadata.gain = blockRecord->gain;
+    bearMetadata.type_metadata.diffuse = blockRecord->diffuse;
+    bearMetadata.type_metadata.height = blockRecord->height;
+    bearMetadata.type_metadata.width = blockRecord->width;
+    bearMetadata.type_metadata.depth = blockRecord->depth;
 
-    bearMetadata.interpolationLength = (metadataBlock->jumpPosition > 0) ? bear::Time{ (int)(sampleRate * metadataBlock->interpolationLength), bearConfig.get_sample_rate() } : bearMetadata.duration;
-    bearMetadata.type_metadata.objectDivergence = ear::PolarObjectDivergence(metadataBlock->divergence, metadataBlock->divergenceAzimuthRange);
-    bearMetadata.type_metadata.channelLock = ear::ChannelLock(metadataBlock->channelLock, metadataBlock->channelLockMaxDistance);
-    bearMetadata.type_metadata.screenRef = metadataBlock->screenRef;
+    bearMetadata.interpolationLength = blockRecord->jumpPosition ? bear::Time{ (int64_t)(sampleRate * blockRecord->interpolationLength), bearConfig.get_sample_rate() } : bearMetadata.duration;
+    bearMetadata.type_metadata.objectDivergence = ear::PolarObjectDivergence(blockRecord->divergence, blockRecord->divergenceAzimuthRange);
+    bearMetadata.type_metadata.channelLock = ear::ChannelLock(blockRecord->channelLock, blockRecord->channelLockMaxDistance);
+    bearMetadata.type_metadata.screenRef = blockRecord->screenRef;
 
-    if(metadataBlock->absoluteDistance != NAN && metadataBlock->absoluteDistance >= 0.0) {
-        bearMetadata.audioPackFormat_data.absoluteDistance = metadataBlock->absoluteDistance;
+    if(itemDescriptor->absoluteDistance != NAN && itemDescriptor->absoluteDistance >= 0.0) {
+        bearMetadata.audioPackFormat_data.absoluteDistance = itemDescriptor->absoluteDistance;
     }
 
     return bearVbsAdapter->add_objects_block(onRenderInputNumFrames, forBearChannel, bearMetadata);
 }
 
 bool BearRender::addDirectSpeakersMetadata(int forBearChannel, MetadataBlock * metadataBlock)
+{
+    ItemDescriptor itemDescriptor;
+    BlockRecord blockRecord;
+    describeItem(*metadataBlock, &itemDescriptor);
+    packPolarBlockRecord(*metadataBlock, &blockRecord);
+    return addDirectSpeakersBlock(forBearChannel, &itemDescriptor, &blockRecord);
+}
+
+bool BearRender::addDirectSpeakersBlock(int forBearChannel, const ItemDescriptor* itemDescriptor, const BlockRecord* blockRecord)
 {
     getExceptionHandler()->clearException(); // Clear because this method can return false without an exception.
 
@@ -290,42 +311,51 @@ bool BearRender::addDirectSpeakersMetadata(int forBearChannel, MetadataBlock * m
         return false;
     }
 
-    // TODO: Cache latest bear::DirectSpeakersInput generated and what it was generated from (metadataBlock pointer)
-    // This way, if it is rejected, on the next call if the metadataBlock pointer matches, we can just use the one we already constructed.
+    // TODO: Cache latest bear::DirectSpeakersInput generated and what it was generated from (blockRecord pointer)
+    // This way, if it is rejected, on the next call if the blockRecord pointer matches, we can just use the one we already constructed.
 
     bear::DirectSpeakersInput bearMetadata;
     double sampleRate = bearConfig.get_sample_rate();
 
-    bearMetadata.type_metadata.audioPackFormatID = metadataBlock->audioPackFormatId;
+    bearMetadata.type_metadata.audioPackFormatID = itemDescriptor->audioPackFormatId;
 
     // Note offsetting rtime by originStartingFrame to enable seeking
-    bearMetadata.rtime = bear::Time{ (int)(sampleRate * metadataBlock->rTime) - originStartingFrame, bearConfig.get_sample_rate() };
-    if(metadataBlock->duration != INFINITY) {
-        bearMetadata.duration = bear::Time{ (int)(sampleRate * metadataBlock->duration), bearConfig.get_sample_rate() };
+    bearMetadata.rtime = bear::Time{ (int64_t)(sampleRate * blockRecord->rTime) - originStartingFrame, bearConfig.get_sample_rate() };
+    if(blockRecord->duration != INFINITY) {
+        bearMetadata.duration = bear::Time{ (int64_t)(sampleRate * blockRecord->duration), bearConfig.get_sample_rate() };
     }
 
-    bearMetadata.type_metadata.position = ear::PolarSpeakerPosition{ metadataBlock->azimuth, metadataBlock->elevation, metadataBlock->distance };
+    bearMetadata.type_metadata.position = ear::PolarSpeakerPosition{ blockRecord->position[0], blockRecord->position[1], blockRecord->position[2] };
 
-    if(metadataBlock->absoluteDistance != NAN && metadataBlock->absoluteDistance >= 0.0) {
-        bearMetadata.audioPackFormat_data.absoluteDistance = metadataBlock->absoluteDistance;
+    if(itemDescriptor->absoluteDistance != NAN && itemDescriptor->absoluteDistance >= 0.0) {
+        bearMetadata.audioPackFormat_data.absoluteDistance = itemDescriptor->absoluteDistance;
     }
 
-    if(metadataBlock->lowPass != NAN) {
-        bearMetadata.type_metadata.channelFrequency.lowPass = metadataBlock->lowPass;
+    if(itemDescriptor->lowPass != NAN) {
+        bearMetadata.type_metadata.channelFrequency.lowPass = itemDescriptor->lowPass;
     }
 
-    if(metadataBlock->highPass != NAN) {
-        bearMetadata.type_metadata.channelFrequency.highPass = metadataBlock->highPass;
+    if(itemDescriptor->highPass != NAN) {
+        bearMetadata.type_metadata.channelFrequency.highPass = itemDescriptor->highPass;
     }
 
-    if(metadataBlock->speakerLabel[0] != 0) { // First char not null... I.e, there is something
-        bearMetadata.type_metadata.speakerLabels.push_back(std::string(metadataBlock->speakerLabel));
+    if(itemDescriptor->speakerLabel[0] != 0) { // First char not null... I.e, there is something
+        bearMetadata.type_metadata.speakerLabels.push_back(std::string(itemDescriptor->speakerLabel));
     }
 
     return bearVbsAdapter->add_direct_speakers_block(onRenderInputNumFrames, forBearChannel, bearMetadata);
 }
 
 bool BearRender::addHoaMetadata(int forBearChannels[], MetadataBlock * metadataBlock)
+{
+    ItemDescriptor itemDescriptor;
+    BlockRecord blockRecord;
+    describeItem(*metadataBlock, &itemDescriptor);
+    packBlockRecord(*metadataBlock, &blockRecord);
+    return addHoaBlock(forBearChannels, &itemDescriptor, &blockRecord);
+}
+
+bool BearRender::addHoaBlock(int forBearChannels[], const ItemDescriptor* itemDescriptor, const BlockRecord* blockRecord)
 {
     getExceptionHandler()->clearException(); // Clear because this method can return false without an exception.
 
@@ -339,35 +369,35 @@ bool BearRender::addHoaMetadata(int forBearChannels[], MetadataBlock * metadataB
         return false;
     }
 
-    // TODO: Cache latest bear::DirectSpeakersInput generated and what it was generated from (metadataBlock pointer)
-    // This way, if it is rejected, on the next call if the metadataBlock pointer matches, we can just use the one we already constructed.
+    // TODO: Cache latest bear::HOAInput generated and what it was generated from (blockRecord pointer)
+    // This way, if it is rejected, on the next call if the blockRecord pointer matches, we can just use the one we already constructed.
 
     bear::HOAInput bearMetadata;
     double sampleRate = bearConfig.get_sample_rate();
 
     // Note offsetting rtime by originStartingFrame to enable seeking
-    bearMetadata.rtime = bear::Time{ (int)(sampleRate * metadataBlock->rTime) - originStartingFrame, bearConfig.get_sample_rate() };
-    if(metadataBlock->duration != INFINITY) {
-        bearMetadata.duration = bear::Time{ (int)(sampleRate * metadataBlock->duration), bearConfig.get_sample_rate() };
+    bearMetadata.rtime = bear::Time{ (int64_t)(sampleRate * blockRecord->rTime) - originStartingFrame, bearConfig.get_sample_rate() };
+    if(blockRecord->duration != INFINITY) {
+        bearMetadata.duration = bear::Time{ (int64_t)(sampleRate * blockRecord->duration), bearConfig.get_sample_rate() };
     }
 
-    bearMetadata.channels.resize(metadataBlock->channelCount);
-    bearMetadata.type_metadata.degrees.resize(metadataBlock->channelCount);
-    bearMetadata.type_metadata.orders.resize(metadataBlock->channelCount);
-    for(int i = 0; i < metadataBlock->channelCount; i++) {
+    bearMetadata.channels.resize(itemDescriptor->channelCount);
+    bearMetadata.type_metadata.degrees.resize(itemDescriptor->channelCount);
+    bearMetadata.type_metadata.orders.resize(itemDescriptor->channelCount);
+    for(int i = 0; i < itemDescriptor->channelCount; i++) {
         bearMetadata.channels[i] = forBearChannels[i];
-        bearMetadata.type_metadata.degrees[i] = metadataBlock->degree[i];
-        bearMetadata.type_metadata.orders[i] = metadataBlock->order[i];
+        bearMetadata.type_metadata.degrees[i] = itemDescriptor->degree[i];
+        bearMetadata.type_metadata.orders[i] = itemDescriptor->order[i];
     }
 
-    bearMetadata.type_metadata.nfcRefDist = metadataBlock->nfcRefDist;
-    bearMetadata.type_metadata.normalization = metadataBlock->normalisation;
-    bearMetadata.type_metadata.screenRef = metadataBlock->screenRef;
+    bearMetadata.type_metadata.nfcRefDist = itemDescriptor->nfcRefDist;
+    bearMetadata.type_metadata.normalization = itemDescriptor->normalisation;
+    bearMetadata.type_metadata.screenRef = blockRecord->screenRef;
     //TODO: not implemented; bearMetadata.type_metadata.referenceScreen
 
-    bearMetadata.audioPackFormat_data.absoluteDistance = metadataBlock->absoluteDistance;
+    bearMetadata.audioPackFormat_data.absoluteDistance = itemDescriptor->absoluteDistance;
 
-    return bearVbsAdapter->add_hoa_block(onRenderInputNumFrames, metadataBlock->id, bearMetadata);
+    return bearVbsAdapter->add_hoa_block(onRenderInputNumFrames, itemDescriptor->id, bearMetadata);
 }
 
 bool BearRender::getBearRender(int objectInputChannelNums[], int objectInputChannelNumsSize,
@@ -375,22 +405,22 @@ bool BearRender::getBearRender(int objectInputChannelNums[], int objectInputChan
                                int hoaInputChannelNums[], int hoaInputChannelNumsSize,
                                float outputBuffer[])
 {
-    auto objectInputAudioBounds = std::vector<int>(objectInputChannelNumsSize * 2, 0);
+    auto objectInputAudioBounds = std::vector<int64_t>(objectInputChannelNumsSize * 2, 0);
     for(int channelIndex = 0; channelIndex < objectInputChannelNumsSize; channelIndex++){
         objectInputAudioBounds[channelIndex * 2 + 0] = 0;
-        objectInputAudioBounds[channelIndex * 2 + 1] = INT_MAX;
+        objectInputAudioBounds[channelIndex * 2 + 1] = INT64_MAX;
     }
 
-    auto directSpeakersInputAudioBounds = std::vector<int>(directSpeakersInputChannelNumsSize * 2, 0);
+    auto directSpeakersInputAudioBounds = std::vector<int64_t>(directSpeakersInputChannelNumsSize * 2, 0);
     for(int channelIndex = 0; channelIndex < directSpeakersInputChannelNumsSize; channelIndex++){
         directSpeakersInputAudioBounds[channelIndex * 2 + 0] = 0;
-        directSpeakersInputAudioBounds[channelIndex * 2 + 1] = INT_MAX;
+        directSpeakersInputAudioBounds[channelIndex * 2 + 1] = INT64_MAX;
     }
 
-    auto hoaInputAudioBounds = std::vector<int>(hoaInputChannelNumsSize * 2, 0);
+    auto hoaInputAudioBounds = std::vector<int64_t>(hoaInputChannelNumsSize * 2, 0);
     for(int channelIndex = 0; channelIndex < hoaInputChannelNumsSize; channelIndex++){
         hoaInputAudioBounds[channelIndex * 2 + 0] = 0;
-        hoaInputAudioBounds[channelIndex * 2 + 1] = INT_MAX;
+        hoaInputAudioBounds[channelIndex * 2 + 1] = INT64_MAX;
     }
 
     return getBearRenderBounded(objectInputChannelNums, objectInputAudioBounds.data(), objectInputChannelNumsSize,
@@ -404,6 +434,30 @@ bool BearRender::getBearRenderBounded(int objectInputChannelNums[], int objectIn
                                       int directSpeakersInputChannelNums[], int directSpeakersInputAudioBounds[], int directSpeakersInputCount,
                                       int hoaInputChannelNums[], int hoaInputAudioBounds[], int hoaInputCount,
                                       float outputBuffer[], int outputBufferStartFrame, bool outputOverwrite)
+{
+    auto widen = [](int audioBounds[], int inputCount, std::vector<int64_t>& widenedAudioBounds) {
+        widenedAudioBounds.resize(inputCount * 2);
+        for(int boundIndex = 0; boundIndex < inputCount * 2; boundIndex++) {
+            widenedAudioBounds[boundIndex] = audioBounds[boundIndex];
+            if(boundIndex % 2 == 1 && audioBounds[boundIndex] == INT_MAX) {
+                widenedAudioBounds[boundIndex] = INT64_MAX; // Was unbounded - keep it that way past 2^31 frames
+            }
+        }
+    };
+    widen(objectInputAudioBounds, objectInputCount, widenedObjectInputAudioBounds);
+    widen(directSpeakersInputAudioBounds, directSpeakersInputCount, widenedDirectSpeakersInputAudioBounds);
+    widen(hoaInputAudioBounds, hoaInputCount, widenedHoaInputAudioBounds);
+
+    return getBearRenderBounded(objectInputChannelNums, widenedObjectInputAudioBounds.data(), objectInputCount,
+                                directSpeakersInputChannelNums, widenedDirectSpeakersInputAudioBounds.data(), directSpeakersInputCount,
+                                hoaInputChannelNums, widenedHoaInputAudioBounds.data(), hoaInputCount,
+                                outputBuffer, outputBufferStartFrame, outputOverwrite);
+}
+
+bool BearRender::getBearRenderBounded(int objectInputChannelNums[], int64_t objectInputAudioBounds[], int objectInputCount,
+                                      int directSpeakersInputChannelNums[], int64_t directSpeakersInputAudioBounds[], int directSpeakersInputCount,
+                                      int hoaInputChannelNums[], int64_t hoaInputAudioBounds[], int hoaInputCount,
+                                      float outputBuffer[], int outputBufferStartFrame, bool outputOverwrite)
 {
     if(!bearVbsAdapter || !bearRenderer) {
         getExceptionHandler()->logException("BEAR renderer or variable block size adapter not setup.");
@@ -427,40 +481,42 @@ bool BearRender::getBearRenderBounded(int objectInputChannelNums[], int objectIn
 
     // Process
     /// Get BEAR input audio
-
-    for(int channelIndex = 0; channelIndex < bearConfig.get_num_objects_channels(); channelIndex++) {
-        if(channelIndex < objectInputCount) {
-            int channelNum = objectInputChannelNums[channelIndex]; // No need to check within range - getAudioBlock does it
-            if(!audioExtractor->getAudioBlock(onRenderInputStartFrame, onRenderInputNumFrames, &channelNum, 1, objectInputAudioBounds[channelIndex * 2], objectInputAudioBounds[channelIndex * 2 + 1], bearObjectInputBuffers[channelIndex]->data())) {
-                return false; //getAudioBlock provides reason
+    /// All inputs are gathered up and extracted in a single batched call so the source audio is only swept once
+
+    bearInputChannelNums.clear();
+    bearInputAudioBounds.clear();
+    bearInputBuffers.clear();
+
+    int64_t inputEndFrame = onRenderInputStartFrame + onRenderInputNumFrames;
+    auto queueInputs = [this, inputEndFrame](int inputChannelNums[], int64_t inputAudioBounds[], int inputCount,
+                              std::vector<std::shared_ptr<std::vector<float>>>& inputBuffers, std::vector<float*>& inputBuffersRawPointers) {
+        for(int channelIndex = 0; channelIndex < inputBuffers.size(); channelIndex++) {
+            // Inputs which are out of bounds or known to be silent for this whole block needn't be fetched at all
+            bool silent = channelIndex >= inputCount;
+            if(!silent) {
+                int64_t validStart = std::max(onRenderInputStartFrame, inputAudioBounds[channelIndex * 2]);
+                int64_t validEnd = std::min(inputEndFrame, boundEndFrame(inputAudioBounds[channelIndex * 2 + 1]));
+                silent = validStart >= validEnd || audioExtractor->isSilent(inputChannelNums[channelIndex], validStart, validEnd);
             }
-            bearObjectInputBuffers_RawPointers[channelIndex] = bearObjectInputBuffers[channelIndex]->data();
-        } else {
-            bearObjectInputBuffers_RawPointers[channelIndex] = reusableZeroedChannel.data();
-        }
-    }
-
-    for(int channelIndex = 0; channelIndex < bearConfig.get_num_direct_speakers_channels(); channelIndex++) {
-        if(channelIndex < directSpeakersInputCount) {
-            int channelNum = directSpeakersInputChannelNums[channelIndex]; // No need to check within range - getAudioBlock does it
-            if(!audioExtractor->getAudioBlock(onRenderInputStartFrame, onRenderInputNumFrames, &channelNum, 1, directSpeakersInputAudioBounds[channelIndex * 2], directSpeakersInputAudioBounds[channelIndex * 2 + 1], bearDirectSpeakersInputBuffers[channelIndex]->data())) {
-                return false; //getAudioBlock provides reason
+            if(!silent) {
+                bearInputChannelNums.push_back(inputChannelNums[channelIndex]); // No need to check within range - getAudioBlockPlanar does it
+                bearInputAudioBounds.push_back(inputAudioBounds[channelIndex * 2]);
+                bearInputAudioBounds.push_back(inputAudioBounds[channelIndex * 2 + 1]);
+                bearInputBuffers.push_back(inputBuffers[channelIndex]->data());
+                inputBuffersRawPointers[channelIndex] = inputBuffers[channelIndex]->data();
+            } else {
+                inputBuffersRawPointers[channelIndex] = reusableZeroedChannel.data();
             }
-            bearDirectSpeakersInputBuffers_RawPointers[channelIndex] = bearDirectSpeakersInputBuffers[channelIndex]->data();
-        } else {
-            bearDirectSpeakersInputBuffers_RawPointers[channelIndex] = reusableZeroedChannel.data();
         }
-    }
+    };
 
-    for(int channelIndex = 0; channelIndex < bearConfig.get_num_hoa_channels(); channelIndex++) {
-        if(channelIndex < hoaInputCount) {
-            int channelNum = hoaInputChannelNums[channelIndex]; // No need to check within range - getAudioBlock does it
-            if(!audioExtractor->getAudioBlock(onRenderInputStartFrame, onRenderInputNumFrames, &channelNum, 1, hoaInputAudioBounds[channelIndex * 2], hoaInputAudioBounds[channelIndex * 2 + 1], bearHoaInputBuffers[channelIndex]->data())) {
-                return false; //getAudioBlock provides reason
-            }
-            bearHoaInputBuffers_RawPointers[channelIndex] = bearHoaInputBuffers[channelIndex]->data();
-        } else {
-            bearHoaInputBuffers_RawPointers[channelIndex] = reusableZeroedChannel.data();
+    queueInputs(objectInputChannelNums, objectInputAudioBounds, objectInputCount, bearObjectInputBuffers, bearObjectInputBuffers_RawPointers);
+    queueInputs(directSpeakersInputChannelNums, directSpeakersInputAudioBounds, directSpeakersInputCount, bearDirectSpeakersInputBuffers, bearDirectSpeakersInputBuffers_RawPointers);
+    queueInputs(hoaInputChannelNums, hoaInputAudioBounds, hoaInputCount, bearHoaInputBuffers, bearHoaInputBuffers_RawPointers);
+
+    if(bearInputChannelNums.size() > 0) {
+        if(!audioExtractor->getAudioBlockPlanar(onRenderInputStartFrame, onRenderInputNumFrames, bearInputChannelNums.data(), bearInputAudioBounds.data(), bearInputChannelNums.size(), bearInputBuffers.data())) {
+            return false; //getAudioBlockPlanar provides reason
         }
     }
 
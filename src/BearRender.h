@@ -24,17 +24,28 @@ public:
                    std::string fft = "");
     bool restartBear();
 
-    bool prewarnBearRender(int startFrame, int numFrames, int basedOnSampleRate = 0, int useSrcType = SRC_SINC_MEDIUM_QUALITY);
+    bool prewarnBearRender(int64_t startFrame, int numFrames, int basedOnSampleRate = 0, int useSrcType = SRC_SINC_MEDIUM_QUALITY);
 
     bool addObjectMetadata(int forBearChannel, MetadataBlock* metadataBlock);
     bool addDirectSpeakersMetadata(int forBearChannel, MetadataBlock* metadataBlock);
     bool addHoaMetadata(int forBearChannels[], MetadataBlock* metadataBlock);
 
+    // As above, from an item's descriptor and one of its block records - positions are taken as polar, so convert cartesian records first
+    bool addObjectBlock(int forBearChannel, const ItemDescriptor* itemDescriptor, const BlockRecord* blockRecord);
+    bool addDirectSpeakersBlock(int forBearChannel, const ItemDescriptor* itemDescriptor, const BlockRecord* blockRecord);
+    bool addHoaBlock(int forBearChannels[], const ItemDescriptor* itemDescriptor, const BlockRecord* blockRecord);
+
     bool getBearRender(int objectInputChannelNums[], int objectInputChannelNumsSize,
                        int directSpeakersInputChannelNums[], int directSpeakersInputChannelNumsSize,
                        int hoaInputChannelNums[], int hoaInputChannelNumsSize,
                        float outputBuffer[]);
 
+    // Audio bounds are [lower, upper] frame pairs per input (inclusive), with INT64_MAX for unbounded
+    bool getBearRenderBounded(int objectInputChannelNums[], int64_t objectInputAudioBounds[], int objectInputCount,
+                              int directSpeakersInputChannelNums[], int64_t directSpeakersInputAudioBounds[], int directSpeakersInputCount,
+                              int hoaInputChannelNums[], int64_t hoaInputAudioBounds[], int hoaInputCount,
+                              float outputBuffer[], int outputBufferStartFrame, bool outputOverwrite);
+    // 32-bit bounds, as the original C API (INT_MAX for unbounded)
     bool getBearRenderBounded(int objectInputChannelNums[], int objectInputAudioBounds[], int objectInputCount,
                               int directSpeakersInputChannelNums[], int directSpeakersInputAudioBounds[], int directSpeakersInputCount,
                               int hoaInputChannelNums[], int hoaInputAudioBounds[], int hoaInputCount,
@@ -51,12 +62,12 @@ public:
 private:
     std::shared_ptr<AudioExtractor> audioExtractor;
 
-    int originStartingFrame{ -1 };          // Which frame we started reading from in the source audios... (-1 uninitialised)
-    int originPlayheadTrackerFrames{ 0 };   // Where the read head is now in the source audio
+    int64_t originStartingFrame{ -1 };      // Which frame we started reading from in the source audios... (-1 uninitialised)
+    int64_t originPlayheadTrackerFrames{ 0 }; // Where the read head is now in the source audio
     double bearPlayheadOffsetSec{ 0.0 };    // originStartingFrame in terms of seconds
 
     int onRenderInputNumFrames{ -1 };       // Number of frames of source audios to feed in to bear on render
-    int onRenderInputStartFrame{ -1 };      // Where to begin pulling source audios from to feed in to bear on render
+    int64_t onRenderInputStartFrame{ -1 };  // Where to begin pulling source audios from to feed in to bear on render
     int onRenderOutputNumFrames{ -1 };      // Number of frames after SRC (note that post-bear (pre-src), its still onRenderInputNumFrames - bear spits out as many as it took in)
 
     float outputGain{ 1.0 };
@@ -84,10 +95,17 @@ private:
     std::vector<float*> bearDirectSpeakersInputBuffers_RawPointers;
     std::vector<std::shared_ptr<std::vector<float>>> bearHoaInputBuffers;
     std::vector<float*> bearHoaInputBuffers_RawPointers;
+    // Batched extraction lists - every BEAR input is pulled from the AudioExtractor in one call
+    std::vector<int> bearInputChannelNums;
+    std::vector<int64_t> bearInputAudioBounds;
+    std::vector<float*> bearInputBuffers;
+    // Widened copies of bounds given as 32-bit
+    std::vector<int64_t> widenedObjectInputAudioBounds;
+    std::vector<int64_t> widenedDirectSpeakersInputAudioBounds;
+    std::vector<int64_t> widenedHoaInputAudioBounds;
     void setBufferFrameCounts(size_t frameCount);
 
     bool betweenPrewarnAndRender{ false };
 
 };
 
-BearRender* getBearSingleton();
@@ -0,0 +1,132 @@
+#include "Bw64Layout.h"
+#include <cstring>
+#include <fstream>
+#include <functional>
+
+namespace {
+    const uint16_t formatTagPcm = 0x0001;
+    const uint16_t formatTagFloat = 0x0003;
+    const uint16_t formatTagExtensible = 0xFFFE;
+
+    // RIFF is little-endian throughout
+    inline uint16_t readU16(const uint8_t* p) { return (uint16_t)p[0] | ((uint16_t)p[1] << 8); }
+    inline uint32_t readU32(const uint8_t* p) { return (uint32_t)readU16(p) | ((uint32_t)readU16(p + 2) << 16); }
+    inline uint64_t readU64(const uint8_t* p) { return (uint64_t)readU32(p) | ((uint64_t)readU32(p + 4) << 32); }
+    inline bool isId(const uint8_t* p, const char* id) { return std::memcmp(p, id, 4) == 0; }
+}
+
+namespace {
+    // Walks the chunk list through readAt (reads size bytes at offset in to dest, false if they aren't all there)
+    //  so the same parsing serves both in-memory files and files on disk, where we only want to touch the headers.
+    bool walkBw64Chunks(const std::function<bool(uint64_t, uint64_t, uint8_t*)>& readAt, uint64_t fileSize, Bw64Layout& layout, std::string& error)
+    {
+        layout = Bw64Layout{};
+
+        uint8_t riffHeader[12];
+        if(fileSize < 12 || !readAt(0, 12, riffHeader) ||
+           !(isId(riffHeader, "RIFF") || isId(riffHeader, "RF64") || isId(riffHeader, "BW64")) || !isId(riffHeader + 8, "WAVE")) {
+            error = "Not a RIFF/RF64/BW64 WAVE file";
+            return false;
+        }
+
+        bool fmtFound = false;
+        bool dataFound = false;
+        uint64_t ds64DataSize = 0;
+
+        uint64_t position = 12;
+        uint8_t header[8];
+        uint8_t fields[40];
+        while(position + 8 <= fileSize && readAt(position, 8, header)) {
+            uint64_t chunkSize = readU32(header + 4);
+            uint64_t chunkOffset = position + 8;
+
+            if(isId(header, "ds64") && chunkSize >= 24 && readAt(chunkOffset, 24, fields)) {
+                ds64DataSize = readU64(fields + 8);
+
+            } else if(isId(header, "fmt ") && chunkSize >= 16 && readAt(chunkOffset, 16, fields)) {
+                layout.formatTag = readU16(fields);
+                layout.channels = readU16(fields + 2);
+                layout.sampleRate = readU32(fields + 4);
+                layout.blockAlignment = readU16(fields + 12);
+                layout.bitDepth = readU16(fields + 14);
+                if(layout.formatTag == formatTagExtensible && chunkSize >= 40 && readAt(chunkOffset, 40, fields)) {
+                    layout.formatTag = readU16(fields + 24); // First 2 bytes of the sub-format GUID are the actual format tag
+                }
+                fmtFound = true;
+
+            } else if(isId(header, "data")) {
+                if(chunkSize == 0xFFFFFFFF) chunkSize = ds64DataSize; // RF64/BW64 - real size lives in ds64
+                layout.dataOffset = chunkOffset;
+                layout.dataSize = chunkSize;
+                dataFound = true;
+
+            } else if(isId(header, "axml")) {
+                layout.axmlOffset = chunkOffset;
+                layout.axmlSize = chunkSize;
+
+            } else if(isId(header, "chna")) {
+                layout.chnaOffset = chunkOffset;
+                layout.chnaSize = chunkSize;
+            }
+
+            position = chunkOffset + chunkSize + (chunkSize & 1); // Chunks are padded to even sizes
+        }
+
+        if(!fmtFound || !dataFound) {
+            error = "File has no fmt or data chunk";
+            return false;
+        }
+        if(layout.channels == 0 || layout.blockAlignment != layout.channels * (layout.bitDepth / 8)) {
+            error = "Unsupported fmt chunk";
+            return false;
+        }
+        bool supported = (layout.formatTag == formatTagPcm && (layout.bitDepth == 16 || layout.bitDepth == 24 || layout.bitDepth == 32)) ||
+                         (layout.formatTag == formatTagFloat && layout.bitDepth == 32);
+        if(!supported) {
+            error = "Unsupported sample format (" + std::to_string(layout.bitDepth) + "-bit, format tag " + std::to_string(layout.formatTag) + ")";
+            return false;
+        }
+
+        // Trust what's actually there over what the header claims (e.g, truncated recordings)
+        if(layout.dataOffset + layout.dataSize > fileSize) {
+            layout.dataSize = fileSize - layout.dataOffset;
+        }
+        layout.frameCount = layout.dataSize / layout.blockAlignment;
+        return true;
+    }
+}
+
+bool parseBw64Layout(const uint8_t* fileData, uint64_t fileSize, Bw64Layout& layout, std::string& error)
+{
+    auto readAt = [fileData, fileSize](uint64_t offset, uint64_t size, uint8_t* dest) {
+        if(offset + size > fileSize) return false;
+        std::memcpy(dest, fileData + offset, size);
+        return true;
+    };
+    return walkBw64Chunks(readAt, fileSize, layout, error);
+}
+
+bool readBw64Layout(const std::string& filePath, Bw64Layout& layout, std::string& error)
+{
+    std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+    if(!file) {
+        error = "Can not open " + filePath;
+        return false;
+    }
+    uint64_t fileSize = file.tellg();
+    auto readAt = [&file, fileSize](uint64_t offset, uint64_t size, uint8_t* dest) {
+        if(offset + size > fileSize) return false;
+        file.seekg(offset);
+        file.read(reinterpret_cast<char*>(dest), size);
+        return (bool)file;
+    };
+    return walkBw64Chunks(readAt, fileSize, layout, error);
+}
+
+SampleFormat sampleFormatOf(const Bw64Layout& layout)
+{
+    if(layout.formatTag == formatTagFloat) return SampleFormat::FLOAT32;
+    if(layout.bitDepth == 16) return SampleFormat::INT16;
+    if(layout.bitDepth == 24) return SampleFormat::INT24;
+    return SampleFormat::INT32;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "AudioKernels.h"
+
+// Where things live in a BW64/RF64/WAV file, found by walking the RIFF chunk list directly.
+// Lets us access essence without going through a bw64::Bw64Reader (e.g, from a memory mapping).
+struct Bw64Layout {
+    uint16_t formatTag{ 0 };        // 1 = PCM, 3 = IEEE float (resolved from the sub-format for WAVE_FORMAT_EXTENSIBLE)
+    uint16_t channels{ 0 };
+    uint32_t sampleRate{ 0 };
+    uint16_t bitDepth{ 0 };
+    uint16_t blockAlignment{ 0 };   // Bytes per frame
+    uint64_t dataOffset{ 0 };       // Offsets are from the start of the file
+    uint64_t dataSize{ 0 };
+    uint64_t frameCount{ 0 };
+    uint64_t axmlOffset{ 0 };
+    uint64_t axmlSize{ 0 };
+    uint64_t chnaOffset{ 0 };
+    uint64_t chnaSize{ 0 };
+};
+
+// Returns false (with reason in error) if this isn't a file we can serve audio from
+bool parseBw64Layout(const uint8_t* fileData, uint64_t fileSize, Bw64Layout& layout, std::string& error);
+// As above, but from a file on disk - only the chunk headers (plus fmt and ds64) are read
+bool readBw64Layout(const std::string& filePath, Bw64Layout& layout, std::string& error);
+
+// Only meaningful for a layout the above accepted
+SampleFormat sampleFormatOf(const Bw64Layout& layout);
@@ -0,0 +1,45 @@
+#include "ChnaIndex.h"
+
+bool parseAudioTrackUidValue(const std::string& audioTrackUid, uint32_t& value)
+{
+    if(audioTrackUid.size() != 12 || audioTrackUid.compare(0, 4, "ATU_") != 0) return false;
+    value = 0;
+    for(size_t i = 4; i < 12; i++) {
+        char c = audioTrackUid[i];
+        uint32_t digit;
+        if(c >= '0' && c <= '9') digit = c - '0';
+        else if(c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else if(c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+        else return false;
+        value = (value << 4) | digit;
+    }
+    return true;
+}
+
+void ChnaIndex::build(const std::vector<bw64::AudioId>& audioIds)
+{
+    channelNums.clear();
+    channelNums.reserve(audioIds.size());
+    for(auto& audioId : audioIds) {
+        uint32_t audioTrackUidValue;
+        if(parseAudioTrackUidValue(audioId.uid(), audioTrackUidValue)) {
+            channelNums.emplace(audioTrackUidValue, audioId.trackIndex() - 1); // trackIndex is 1-based. emplace keeps the first.
+        }
+    }
+}
+
+void ChnaIndex::add(uint32_t audioTrackUidValue, int channelNum)
+{
+    channelNums.emplace(audioTrackUidValue, channelNum);
+}
+
+void ChnaIndex::clear()
+{
+    channelNums.clear();
+}
+
+int ChnaIndex::getChannelNumFor(uint32_t audioTrackUidValue) const
+{
+    auto it = channelNums.find(audioTrackUidValue);
+    return it == channelNums.end() ? -1 : it->second;
+}
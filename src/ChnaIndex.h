@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <bw64/bw64.hpp>
+
+class ChnaIndex
+{
+    // CHNA entries keyed by the numeric value of their audioTrackUID, built once per read.
+    // Discovery looks up every channel, so this keeps it to a hash lookup rather than a string compare against every track.
+public:
+    void build(const std::vector<bw64::AudioId>& audioIds);
+    // For mappings from elsewhere (e.g, an S-ADM transportTrackFormat) - ignored if the UID is already mapped
+    void add(uint32_t audioTrackUidValue, int channelNum);
+    void clear();
+
+    // 0-based file channel, or -1 if the UID isn't in the CHNA. Where a UID appears more than once, the first entry wins.
+    int getChannelNumFor(uint32_t audioTrackUidValue) const;
+
+private:
+    std::unordered_map<uint32_t, int> channelNums;
+};
+
+// "ATU_xxxxxxxx" (hex) to its value - false if not in that form
+bool parseAudioTrackUidValue(const std::string& audioTrackUid, uint32_t& value);
@@ -0,0 +1,392 @@
+#include "EssenceIo.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
+
+#ifdef UNITYADM_HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+const char* essenceIoBackendName(EssenceIoBackend backend)
+{
+    switch(backend) {
+        case EssenceIoBackend::AUTO: return "auto";
+        case EssenceIoBackend::STREAM: return "stream";
+        case EssenceIoBackend::PREAD: return "pread";
+        case EssenceIoBackend::IO_URING: return "io_uring";
+    }
+    return "unknown";
+}
+
+namespace {
+
+    class StreamEssenceIo : public EssenceIo
+    {
+        // Portable fallback - one blocking read at a time through a buffered stream
+    public:
+        StreamEssenceIo(const std::string& filePath)
+        {
+            file.open(filePath, std::ios::binary);
+            if(!file) {
+                throw std::runtime_error("Can not open " + filePath + " to read audio");
+            }
+        }
+
+        EssenceIoBackend getBackend() const override { return EssenceIoBackend::STREAM; }
+
+        bool read(const EssenceReadRequest* requests, size_t requestCount, const std::function<void(size_t requestIndex)>& onComplete) override
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for(size_t requestIndex = 0; requestIndex < requestCount; requestIndex++) {
+                const EssenceReadRequest& request = requests[requestIndex];
+                file.clear(); // A previous short read would otherwise leave the stream unusable
+                file.seekg(request.offset);
+                file.read(reinterpret_cast<char*>(request.dest), request.length);
+                if((size_t)file.gcount() != request.length) return false;
+                onComplete(requestIndex);
+            }
+            return true;
+        }
+
+    private:
+        std::mutex mutex; // Guards the stream's seek position
+        std::ifstream file;
+    };
+
+#ifndef _WIN32
+
+    bool preadFully(int fd, const EssenceReadRequest& request)
+    {
+        size_t done = 0;
+        while(done < request.length) {
+            ssize_t result = pread(fd, request.dest + done, request.length - done, (off_t)(request.offset + done));
+            if(result < 0 && errno == EINTR) continue;
+            if(result <= 0) return false; // Error, or hit the end of the file
+            done += result;
+        }
+        return true;
+    }
+
+    class PosixEssenceIo : public EssenceIo
+    {
+        // Owns the descriptor, and passes access hints on to the kernel
+    public:
+        PosixEssenceIo(const std::string& filePath)
+        {
+            fd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+            if(fd < 0) {
+                throw std::runtime_error("Can not open " + filePath + " to read audio");
+            }
+        }
+
+        ~PosixEssenceIo()
+        {
+            close(fd);
+        }
+
+        void adviseAccessPattern(EssenceAccessPattern pattern) override
+        {
+#ifdef POSIX_FADV_SEQUENTIAL
+            // Kernel readahead only ever runs forwards - going backwards we prefetch explicitly (adviseWillNeed) instead
+            int advice = POSIX_FADV_NORMAL;
+            if(pattern == EssenceAccessPattern::FORWARD) advice = POSIX_FADV_SEQUENTIAL;
+            if(pattern == EssenceAccessPattern::BACKWARD || pattern == EssenceAccessPattern::RANDOM) advice = POSIX_FADV_RANDOM;
+            posix_fadvise(fd, 0, 0, advice);
+#endif
+        }
+
+        void adviseWillNeed(uint64_t offset, uint64_t length) override
+        {
+#ifdef POSIX_FADV_WILLNEED
+            posix_fadvise(fd, (off_t)offset, (off_t)length, POSIX_FADV_WILLNEED);
+#elif defined(F_RDADVISE)
+            radvisory advisory;
+            advisory.ra_offset = (off_t)offset;
+            advisory.ra_count = (int)std::min(length, (uint64_t)INT32_MAX);
+            fcntl(fd, F_RDADVISE, &advisory);
+#endif
+        }
+
+    protected:
+        int fd{ -1 };
+    };
+
+    class PreadWorkerPool
+    {
+        // Shared by every pread backend, so having many files (or sessions) open doesn't mean many idle threads
+    public:
+        static PreadWorkerPool& get()
+        {
+            static PreadWorkerPool pool;
+            return pool;
+        }
+
+        size_t getWorkerCount() const { return workers.size(); }
+
+        void post(std::function<void()> task)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                tasks.push_back(std::move(task));
+            }
+            wake.notify_one();
+        }
+
+    private:
+        PreadWorkerPool()
+        {
+            size_t workerCount = std::min(std::max(std::thread::hardware_concurrency(), 2u), 8u);
+            for(size_t workerIndex = 0; workerIndex < workerCount; workerIndex++) {
+                workers.emplace_back([this]() { runWorker(); });
+            }
+        }
+
+        ~PreadWorkerPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            for(auto& worker : workers) {
+                worker.join();
+            }
+        }
+
+        void runWorker()
+        {
+            while(true) {
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    wake.wait(lock, [this]() { return stopping || !tasks.empty(); });
+                    if(tasks.empty()) return; // Stopping
+                    task = std::move(tasks.front());
+                    tasks.pop_front();
+                }
+                task();
+            }
+        }
+
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::deque<std::function<void()>> tasks;
+        bool stopping{ false };
+        std::vector<std::thread> workers;
+    };
+
+    class PreadEssenceIo : public PosixEssenceIo
+    {
+        // Requests are shared out between the calling thread and helpers from the worker pool, each doing blocking preads.
+        // The caller never waits on a helper that hasn't started - whatever the pool is too busy to pick up, the caller just does itself.
+    public:
+        PreadEssenceIo(const std::string& filePath) : PosixEssenceIo(filePath) {}
+
+        EssenceIoBackend getBackend() const override { return EssenceIoBackend::PREAD; }
+
+        bool read(const EssenceReadRequest* requests, size_t requestCount, const std::function<void(size_t requestIndex)>& onComplete) override
+        {
+            if(requestCount == 0) return true;
+
+            struct Batch {
+                const EssenceReadRequest* requests;
+                size_t requestCount;
+                const std::function<void(size_t)>* onComplete;
+                std::atomic<size_t> nextRequest{ 0 };
+                std::atomic<bool> failed{ false };
+                std::mutex mutex;
+                std::condition_variable idle;
+                size_t runningHelpers{ 0 };
+                bool closed{ false }; // Caller has finished - late helpers must not touch the requests
+            };
+            auto batch = std::make_shared<Batch>();
+            batch->requests = requests;
+            batch->requestCount = requestCount;
+            batch->onComplete = &onComplete;
+            int readFd = fd;
+
+            auto work = [readFd](Batch& batch) {
+                size_t requestIndex;
+                while((requestIndex = batch.nextRequest.fetch_add(1)) < batch.requestCount) {
+                    if(preadFully(readFd, batch.requests[requestIndex])) {
+                        (*batch.onComplete)(requestIndex);
+                    } else {
+                        batch.failed = true;
+                    }
+                }
+            };
+
+            auto& pool = PreadWorkerPool::get();
+            size_t helperCount = std::min(requestCount - 1, pool.getWorkerCount());
+            for(size_t helperIndex = 0; helperIndex < helperCount; helperIndex++) {
+                pool.post([batch, work]() {
+                    {
+                        std::lock_guard<std::mutex> lock(batch->mutex);
+                        if(batch->closed) return;
+                        batch->runningHelpers++;
+                    }
+                    work(*batch);
+                    std::lock_guard<std::mutex> lock(batch->mutex);
+                    if(--batch->runningHelpers == 0) batch->idle.notify_all();
+                });
+            }
+
+            work(*batch);
+
+            std::unique_lock<std::mutex> lock(batch->mutex);
+            batch->closed = true;
+            batch->idle.wait(lock, [&batch]() { return batch->runningHelpers == 0; });
+            return !batch->failed;
+        }
+    };
+
+#endif
+
+#ifdef UNITYADM_HAVE_LIBURING
+
+    class UringEssenceIo : public PosixEssenceIo
+    {
+        // Up to queueDepth reads submitted at once, with completions handled on the calling thread as they arrive
+        //  (so decoding one overlaps the reads still in flight). Short reads are resubmitted from where they stopped.
+    public:
+        UringEssenceIo(const std::string& filePath) : PosixEssenceIo(filePath)
+        {
+            int result = io_uring_queue_init(queueDepth, &ring, 0);
+            if(result < 0) {
+                close(fd);
+                fd = -1;
+                throw std::runtime_error("io_uring unavailable");
+            }
+        }
+
+        ~UringEssenceIo()
+        {
+            io_uring_queue_exit(&ring);
+        }
+
+        EssenceIoBackend getBackend() const override { return EssenceIoBackend::IO_URING; }
+
+        bool read(const EssenceReadRequest* requests, size_t requestCount, const std::function<void(size_t requestIndex)>& onComplete) override
+        {
+            std::lock_guard<std::mutex> lock(mutex); // One ring - one batch at a time
+
+            if(broken) {
+                // Ring failed earlier - carry on with plain preads
+                for(size_t requestIndex = 0; requestIndex < requestCount; requestIndex++) {
+                    if(!preadFully(fd, requests[requestIndex])) return false;
+                    onComplete(requestIndex);
+                }
+                return true;
+            }
+
+            progress.assign(requestCount, 0);
+            size_t nextRequest = 0;
+            size_t queued = 0;   // Prepared, not yet submitted
+            size_t inFlight = 0; // Submitted, not yet completed
+            bool failed = false;
+
+            auto queueRead = [&](size_t requestIndex) {
+                const EssenceReadRequest& request = requests[requestIndex];
+                size_t done = progress[requestIndex];
+                io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+                io_uring_prep_read(sqe, fd, request.dest + done, (unsigned)(request.length - done), request.offset + done);
+                io_uring_sqe_set_data64(sqe, requestIndex);
+                queued++;
+            };
+
+            while(true) {
+                while(!failed && nextRequest < requestCount && queued + inFlight < queueDepth) {
+                    queueRead(nextRequest++);
+                }
+                if(queued > 0 && !broken) {
+                    int submitted = io_uring_submit(&ring);
+                    if(submitted > 0) {
+                        queued -= submitted;
+                        inFlight += submitted;
+                    } else if(inFlight == 0 || (submitted != -EAGAIN && submitted != -EBUSY && submitted != -EINTR)) {
+                        // Can't make progress. Nothing queued will ever be submitted (we stop using the ring), so just drain what's in flight
+                        broken = true;
+                        failed = true;
+                        queued = 0;
+                    }
+                }
+                if(inFlight == 0) break;
+
+                io_uring_cqe* cqe = nullptr;
+                int waitResult = io_uring_wait_cqe(&ring, &cqe);
+                if(waitResult == -EINTR) continue;
+                if(waitResult < 0) {
+                    // Shouldn't happen. Give up on the ring - anything still in flight lands in buffers the caller keeps for its lifetime, so it's harmless
+                    broken = true;
+                    failed = true;
+                    break;
+                }
+                size_t requestIndex = (size_t)io_uring_cqe_get_data64(cqe);
+                int result = cqe->res;
+                io_uring_cqe_seen(&ring, cqe);
+                inFlight--;
+
+                if(result == -EINTR || result == -EAGAIN) {
+                    if(!broken) queueRead(requestIndex);
+                    else failed = true;
+                    continue;
+                }
+                if(result <= 0) {
+                    failed = true; // Error, or hit the end of the file
+                    continue;
+                }
+                progress[requestIndex] += result;
+                if(progress[requestIndex] < requests[requestIndex].length) {
+                    if(!broken) queueRead(requestIndex);
+                    else failed = true;
+                    continue;
+                }
+                onComplete(requestIndex);
+            }
+
+            return !failed;
+        }
+
+    private:
+        static const unsigned queueDepth = 32;
+        std::mutex mutex;
+        io_uring ring;
+        bool broken{ false };
+        std::vector<size_t> progress; // Bytes landed so far, per request
+    };
+
+#endif
+
+}
+
+std::unique_ptr<EssenceIo> openEssenceIo(const std::string& filePath, EssenceIoBackend backend)
+{
+#ifdef UNITYADM_HAVE_LIBURING
+    if(backend == EssenceIoBackend::AUTO || backend == EssenceIoBackend::IO_URING) {
+        try {
+            return std::make_unique<UringEssenceIo>(filePath);
+        } catch(std::exception&) {
+            // Kernel too old, or io_uring blocked (containers often disallow it) - fall through to pread
+        }
+    }
+#endif
+#ifndef _WIN32
+    if(backend != EssenceIoBackend::STREAM) {
+        return std::make_unique<PreadEssenceIo>(filePath);
+    }
+#endif
+    return std::make_unique<StreamEssenceIo>(filePath);
+}
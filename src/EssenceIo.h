@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+// Pluggable I/O beneath EssenceReader. Every backend issues positioned reads (there's no shared seek position),
+//  and those that can keep several reads in flight at once - which is what hides latency on slow or network-mounted storage.
+
+enum class EssenceIoBackend {
+    AUTO = 0,     // Best available: io_uring, then pread, then stream
+    STREAM = 1,   // std::ifstream, one read at a time. Always available
+    PREAD = 2,    // pread() from a shared worker pool (POSIX only)
+    IO_URING = 3  // io_uring submission queue (Linux, when built against liburing)
+};
+const char* essenceIoBackendName(EssenceIoBackend backend);
+
+struct EssenceReadRequest {
+    uint64_t offset;
+    size_t length;
+    uint8_t* dest;
+};
+
+enum class EssenceAccessPattern { NORMAL, FORWARD, BACKWARD, RANDOM };
+
+class EssenceIo
+{
+public:
+    virtual ~EssenceIo() {}
+
+    virtual EssenceIoBackend getBackend() const = 0;
+
+    // Reads every request, keeping as many in flight as the backend allows. onComplete(requestIndex) is called as each one lands -
+    //  possibly out of order, and possibly on another thread alongside other completions, so it must only touch that request's data.
+    // Returns once all are done. False if any read failed or came up short (onComplete isn't called for those).
+    virtual bool read(const EssenceReadRequest* requests, size_t requestCount, const std::function<void(size_t requestIndex)>& onComplete) = 0;
+
+    // Page cache hints - no-ops where the platform has no equivalent
+    virtual void adviseAccessPattern(EssenceAccessPattern pattern) {}
+    virtual void adviseWillNeed(uint64_t offset, uint64_t length) {}
+};
+
+// Opens the file with the requested backend, falling back (io_uring -> pread -> stream) to whatever this platform and build support.
+// Throws std::runtime_error if the file can't be opened at all.
+std::unique_ptr<EssenceIo> openEssenceIo(const std::string& filePath, EssenceIoBackend backend = EssenceIoBackend::AUTO);
@@ -0,0 +1,96 @@
+#include "EssenceReader.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+    const size_t rawBufferBytes = 256 * 1024;
+    const int64_t readsInFlight = 8;
+}
+
+EssenceReader::EssenceReader(const std::string& filePath, const Bw64Layout& layout, EssenceIoBackend ioBackend) : layout{ layout }
+{
+    io = openEssenceIo(filePath, ioBackend);
+    sampleFormat = sampleFormatOf(layout);
+    framesPerRead = std::max((int64_t)(rawBufferBytes / layout.blockAlignment), (int64_t)1);
+    rawBuffer = std::vector<uint8_t>(readsInFlight * framesPerRead * layout.blockAlignment);
+    requests.reserve(readsInFlight);
+    requestFrameOffsets.reserve(readsInFlight);
+}
+
+EssenceReader::~EssenceReader()
+{
+}
+
+template<typename DecodeFn>
+bool EssenceReader::readChunked(int64_t startFrame, int64_t frameCount, const DecodeFn& decode)
+{
+    if(startFrame < 0 || startFrame + frameCount > (int64_t)layout.frameCount) return false;
+    adviseFor(startFrame, frameCount);
+
+    int64_t frameOffset = 0;
+    while(frameOffset < frameCount) {
+        requests.clear();
+        requestFrameOffsets.clear();
+        for(int64_t slot = 0; slot < readsInFlight && frameOffset < frameCount; slot++) {
+            int64_t frames = std::min(frameCount - frameOffset, framesPerRead);
+            requests.push_back({ layout.dataOffset + (uint64_t)(startFrame + frameOffset) * layout.blockAlignment,
+                                 (size_t)(frames * layout.blockAlignment),
+                                 rawBuffer.data() + slot * framesPerRead * layout.blockAlignment });
+            requestFrameOffsets.push_back(frameOffset);
+            frameOffset += frames;
+        }
+        bool success = io->read(requests.data(), requests.size(), [&](size_t requestIndex) {
+            decode(requests[requestIndex].dest, requestFrameOffsets[requestIndex], (int64_t)(requests[requestIndex].length / layout.blockAlignment));
+        });
+        if(!success) return false;
+    }
+    return true;
+}
+
+void EssenceReader::adviseFor(int64_t startFrame, int64_t frameCount)
+{
+    EssenceAccessPattern pattern = EssenceAccessPattern::RANDOM;
+    if(lastEndFrame < 0 || startFrame == lastEndFrame) {
+        pattern = EssenceAccessPattern::FORWARD; // First read, or carrying on from the last
+    } else if(startFrame + frameCount <= lastStartFrame) {
+        pattern = EssenceAccessPattern::BACKWARD;
+    }
+    lastStartFrame = startFrame;
+    lastEndFrame = startFrame + frameCount;
+
+    if(pattern != accessPattern) {
+        io->adviseAccessPattern(pattern);
+        accessPattern = pattern;
+    }
+
+    // Expect the next request to be the same size again, in the same direction
+    int64_t prefetchStart = (pattern == EssenceAccessPattern::BACKWARD) ? startFrame - frameCount : startFrame + frameCount;
+    int64_t prefetchEnd = std::min(prefetchStart + frameCount, (int64_t)layout.frameCount);
+    prefetchStart = std::max(prefetchStart, (int64_t)0);
+    if(pattern != EssenceAccessPattern::RANDOM && prefetchStart < prefetchEnd) {
+        io->adviseWillNeed(layout.dataOffset + (uint64_t)prefetchStart * layout.blockAlignment, (uint64_t)(prefetchEnd - prefetchStart) * layout.blockAlignment);
+    }
+}
+
+bool EssenceReader::readFrames(int64_t startFrame, int64_t frameCount, float* output)
+{
+    return readChunked(startFrame, frameCount, [&](const uint8_t* raw, int64_t frameOffset, int64_t frames) {
+        decodeSamples(raw, sampleFormat, output + frameOffset * layout.channels, frames * layout.channels);
+    });
+}
+
+bool EssenceReader::readChannels(int64_t startFrame, int64_t frameCount, const int* channelNums, int channelCount, float* output, int64_t outputChannelStride)
+{
+    int bytesPerSample = layout.bitDepth / 8;
+    return readChunked(startFrame, frameCount, [&](const uint8_t* raw, int64_t frameOffset, int64_t frames) {
+        // The file is interleaved, so every channel still comes off disk - but only the ones we want get decoded
+        for(int channelIndex = 0; channelIndex < channelCount; channelIndex++) {
+            float* channelOutput = output + channelIndex * outputChannelStride + frameOffset;
+            if(channelNums[channelIndex] >= 0 && channelNums[channelIndex] < layout.channels) {
+                decodeSamplesStrided(raw + channelNums[channelIndex] * bytesPerSample, layout.blockAlignment, sampleFormat, channelOutput, frames);
+            } else {
+                zeroSamples(channelOutput, frames);
+            }
+        }
+    });
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Bw64Layout.h"
+#include "AudioKernels.h"
+#include "EssenceIo.h"
+
+class EssenceReader
+{
+    // Reads interleaved frames straight out of the data chunk of a BW64 file and converts them with our own decode kernels,
+    //  rather than the per-sample conversion in bw64::Bw64Reader::read. Has its own file handle, through the chosen I/O backend.
+    // Large reads are split in to several positioned reads kept in flight together, each decoded as soon as it lands.
+    // Not thread-safe - each user (cache fills, read-ahead, preloading) has its own reader.
+    // Throws std::runtime_error if the file can't be opened.
+public:
+    EssenceReader(const std::string& filePath, const Bw64Layout& layout, EssenceIoBackend ioBackend = EssenceIoBackend::AUTO);
+    ~EssenceReader();
+
+    // Frames must lie within the file. Output is interleaved, all channels. False if the read came up short.
+    bool readFrames(int64_t startFrame, int64_t frameCount, float* output);
+    // As above, but only decoding the listed channels - each to its own planar row of output, outputChannelStride apart
+    bool readChannels(int64_t startFrame, int64_t frameCount, const int* channelNums, int channelCount, float* output, int64_t outputChannelStride);
+
+    const Bw64Layout& getLayout() const { return layout; }
+    EssenceIoBackend getIoBackend() const { return io->getBackend(); }
+
+private:
+    // Splits [startFrame, startFrame + frameCount) in to reads of up to framesPerRead, up to readsInFlight at a time,
+    //  calling decode(raw, frameOffset, frames) for each as it lands (possibly concurrently - see EssenceIo::read)
+    template<typename DecodeFn>
+    bool readChunked(int64_t startFrame, int64_t frameCount, const DecodeFn& decode);
+    // Tells the backend which way playback seems to be going, and asks for the span after (or before) this one to be prefetched
+    void adviseFor(int64_t startFrame, int64_t frameCount);
+
+    std::unique_ptr<EssenceIo> io;
+    Bw64Layout layout;
+    SampleFormat sampleFormat;
+    int64_t framesPerRead{ 0 };
+    std::vector<uint8_t> rawBuffer; // readsInFlight reads' worth of undecoded essence - each small enough to still be in cache when decoded
+    std::vector<EssenceReadRequest> requests;
+    std::vector<int64_t> requestFrameOffsets;
+
+    int64_t lastStartFrame{ -1 };
+    int64_t lastEndFrame{ -1 };
+    EssenceAccessPattern accessPattern{ EssenceAccessPattern::NORMAL };
+};
@@ -1,16 +1,20 @@
 #include "ExceptionHandler.h"
 
 namespace {
-    ExceptionHandler* exceptionHandler = nullptr;
+    thread_local ExceptionHandler* currentExceptionHandler = nullptr;
+    thread_local ExceptionHandler threadExceptionHandler;
 }
 
 ExceptionHandler* getExceptionHandler()
 {
-    // TODO - need a destroy method to tidy this up when unloading lib
-    if(!exceptionHandler) {
-        exceptionHandler = new ExceptionHandler();
-    }
-    return exceptionHandler;
+    return currentExceptionHandler ? currentExceptionHandler : &threadExceptionHandler;
+}
+
+ExceptionHandler* setCurrentExceptionHandler(ExceptionHandler* exceptionHandler)
+{
+    auto previous = currentExceptionHandler;
+    currentExceptionHandler = exceptionHandler;
+    return previous;
 }
 
 ExceptionHandler::ExceptionHandler()
@@ -23,15 +27,20 @@ ExceptionHandler::~ExceptionHandler()
 
 const char * ExceptionHandler::getLatestException()
 {
-    return latestExceptionMsg.c_str();
+    thread_local std::string latestExceptionCopy; // Not the member itself - another thread may replace it while the caller reads
+    std::lock_guard<std::mutex> lock(latestExceptionMutex);
+    latestExceptionCopy = latestExceptionMsg;
+    return latestExceptionCopy.c_str();
 }
 
 void ExceptionHandler::logException(std::string ex)
 {
-    latestExceptionMsg = ex;
+    std::lock_guard<std::mutex> lock(latestExceptionMutex);
+    latestExceptionMsg = std::move(ex);
 }
 
 void ExceptionHandler::clearException()
 {
-    latestExceptionMsg = "";
+    std::lock_guard<std::mutex> lock(latestExceptionMutex);
+    latestExceptionMsg.clear();
 }
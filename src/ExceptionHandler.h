@@ -1,4 +1,5 @@
 #pragma once
+#include <mutex>
 #include <string>
 
 class ExceptionHandler
@@ -7,12 +8,18 @@ public:
     ExceptionHandler();
     ~ExceptionHandler();
 
+    // Each may be called from any thread - a session's audio reads log from several at once.
+    // The string returned is the calling thread's copy, valid until that thread next calls this.
     const char* getLatestException();
     void logException(std::string ex);
     void clearException();
 
 private:
+    std::mutex latestExceptionMutex;
     std::string latestExceptionMsg{""};
 };
 
+// The handler for the current thread's session (see SessionScope) - or, outside of one, a handler of the thread's own
 ExceptionHandler* getExceptionHandler();
+// Returns the one it replaces. Null to revert to the thread's own.
+ExceptionHandler* setCurrentExceptionHandler(ExceptionHandler* exceptionHandler);
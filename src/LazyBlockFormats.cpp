@@ -0,0 +1,184 @@
+#include "LazyBlockFormats.h"
+#include "XmlScan.h"
+#include <adm/parse.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+#include <string_view>
+
+namespace {
+    const std::string_view blockFormatEndTag = "</audioBlockFormat>";
+    const std::string_view channelFormatEndTag = "</audioChannelFormat>";
+
+    // ADM time - "hh:mm:ss.fffff" or, fractionally, "hh:mm:ss.nnnnnSddddd". 0 if absent or unreadable.
+    int64_t parseAdmTimeNs(const std::string& time)
+    {
+        const char* p = time.c_str();
+        char* end = nullptr;
+        int64_t hours = std::strtoll(p, &end, 10);
+        if(*end != ':') return 0;
+        int64_t minutes = std::strtoll(end + 1, &end, 10);
+        if(*end != ':') return 0;
+        int64_t seconds = std::strtoll(end + 1, &end, 10);
+        int64_t timeNs = ((hours * 60 + minutes) * 60 + seconds) * 1000000000LL;
+        if(*end != '.') return timeNs;
+
+        const char* fractionStart = end + 1;
+        int64_t numerator = std::strtoll(fractionStart, &end, 10);
+        if(*end == 'S') {
+            int64_t denominator = std::strtoll(end + 1, nullptr, 10);
+            if(denominator > 0) timeNs += numerator * 1000000000LL / denominator;
+        } else {
+            int64_t scale = 1000000000LL;
+            for(const char* digit = fractionStart; digit < end && scale > 1; digit++) scale /= 10;
+            timeNs += numerator * scale;
+        }
+        return timeNs;
+    }
+}
+
+void indexBlockFormats(const char* axml, size_t size, std::string& structuralXml, std::map<std::string, ChannelFormatBlockLocations>& locations)
+{
+    std::string_view xml(axml, size);
+    structuralXml.clear();
+    structuralXml.reserve(size / 4); // Usually mostly blocks
+    locations.clear();
+
+    size_t copiedUpTo = 0;
+    size_t position = 0;
+    while((position = findStartTag(xml, "audioChannelFormat", position)) != std::string_view::npos) {
+        size_t openTagEnd = findTagEnd(xml, position);
+        if(openTagEnd == std::string_view::npos) break;
+        std::string_view openTag = xml.substr(position, openTagEnd - position);
+        size_t closeTag = xml.find(channelFormatEndTag, openTagEnd);
+        std::string channelFormatId = attributeValue(openTag, "audioChannelFormatID");
+        if(openTag[openTag.size() - 2] == '/' || closeTag == std::string_view::npos || channelFormatId.empty()) {
+            position = openTagEnd; // No blocks, or nothing we could find them by later - leave as is
+            continue;
+        }
+
+        ChannelFormatBlockLocations channelLocations;
+        channelLocations.openTag = std::string(openTag);
+        size_t blockPosition = openTagEnd;
+        while((blockPosition = findStartTag(xml, "audioBlockFormat", blockPosition)) != std::string_view::npos && blockPosition < closeTag) {
+            size_t blockOpenTagEnd = findTagEnd(xml, blockPosition);
+            if(blockOpenTagEnd == std::string_view::npos || blockOpenTagEnd > closeTag) break;
+            size_t blockEnd = blockOpenTagEnd;
+            if(xml[blockOpenTagEnd - 2] != '/') {
+                blockEnd = xml.find(blockFormatEndTag, blockOpenTagEnd);
+                if(blockEnd == std::string_view::npos || blockEnd > closeTag) break;
+                blockEnd += blockFormatEndTag.size();
+            }
+            std::string_view blockOpenTag = xml.substr(blockPosition, blockOpenTagEnd - blockPosition);
+            channelLocations.blocks.push_back({ blockPosition, (uint32_t)(blockEnd - blockPosition), parseAdmTimeNs(attributeValue(blockOpenTag, "rtime")) });
+
+            structuralXml.append(xml.substr(copiedUpTo, blockPosition - copiedUpTo));
+            copiedUpTo = blockEnd;
+            blockPosition = blockEnd;
+        }
+
+        if(!channelLocations.blocks.empty()) {
+            locations[channelFormatId] = std::move(channelLocations);
+        }
+        position = closeTag + channelFormatEndTag.size();
+    }
+    structuralXml.append(xml.substr(copiedUpTo));
+}
+
+LazyBlockFormats::LazyBlockFormats(ChannelFormatBlockLocations locations) : locations{ std::move(locations) }
+{
+}
+
+LazyBlockFormats::~LazyBlockFormats()
+{
+}
+
+int LazyBlockFormats::materialisableEnd(int64_t untilNs) const
+{
+    int index = materialisedEnd;
+    while(index < getCount() && locations.blocks[index].rtimeNs < untilNs) index++;
+    return index;
+}
+
+void LazyBlockFormats::evictBefore(int index)
+{
+    if(index <= firstIndex) return;
+    size_t count = index - firstIndex;
+    objectsBlocks.erase(objectsBlocks.begin(), objectsBlocks.begin() + std::min(count, objectsBlocks.size()));
+    directSpeakersBlocks.erase(directSpeakersBlocks.begin(), directSpeakersBlocks.begin() + std::min(count, directSpeakersBlocks.size()));
+    hoaBlocks.erase(hoaBlocks.begin(), hoaBlocks.begin() + std::min(count, hoaBlocks.size()));
+    firstIndex = index;
+}
+
+int LazyBlockFormats::getIndexAt(int64_t timeNs) const
+{
+    auto after = std::upper_bound(locations.blocks.begin(), locations.blocks.end(), timeNs, [](int64_t time, const BlockFormatLocation& location) {
+        return time < location.rtimeNs;
+    });
+    return (int)(after - locations.blocks.begin()) - 1;
+}
+
+void LazyBlockFormats::restartAt(int index)
+{
+    objectsBlocks.clear();
+    directSpeakersBlocks.clear();
+    hoaBlocks.clear();
+    firstIndex = std::max(std::min(index, getCount()), 0);
+    materialisedEnd = firstIndex;
+}
+
+void LazyBlockFormats::dropFrom(size_t objectsCount, size_t directSpeakersCount, size_t hoaCount)
+{
+    objectsBlocks.erase(objectsBlocks.begin() + objectsCount, objectsBlocks.end());
+    directSpeakersBlocks.erase(directSpeakersBlocks.begin() + directSpeakersCount, directSpeakersBlocks.end());
+    hoaBlocks.erase(hoaBlocks.begin() + hoaCount, hoaBlocks.end());
+}
+
+bool LazyBlockFormats::update(int firstKeptIndex, int64_t neededUntilNs, int64_t fillUntilNs, const AxmlFragmentSource& source, std::string& error)
+{
+    evictBefore(std::min(firstKeptIndex, materialisedEnd));
+
+    int neededEnd = materialisableEnd(neededUntilNs);
+    if(neededEnd <= materialisedEnd) return true;
+    int fillEnd = std::max(materialisableEnd(fillUntilNs), neededEnd);
+
+    // Blocks of a channel are contiguous in the axml, so one read covers them all (along with any whitespace between)
+    auto& first = locations.blocks[materialisedEnd];
+    auto& last = locations.blocks[fillEnd - 1];
+    std::string fragment;
+    if(!source(first.offset, last.offset + last.length - first.offset, fragment)) {
+        error = "Unable to read audioBlockFormats from the axml";
+        return false;
+    }
+
+    std::stringstream stream;
+    stream << "<?xml version=\"1.0\" encoding=\"UTF-8\"?><ebuCoreMain><coreMetadata><format><audioFormatExtended>"
+           << locations.openTag << fragment << channelFormatEndTag
+           << "</audioFormatExtended></format></coreMetadata></ebuCoreMain>";
+
+    size_t objectsCount = objectsBlocks.size();
+    size_t directSpeakersCount = directSpeakersBlocks.size();
+    size_t hoaCount = hoaBlocks.size();
+    try {
+        auto document = adm::parseXml(stream);
+        for(auto& channelFormat : document->getElements<adm::AudioChannelFormat>()) {
+            for(auto& block : channelFormat->getElements<adm::AudioBlockFormatObjects>()) objectsBlocks.push_back(block);
+            for(auto& block : channelFormat->getElements<adm::AudioBlockFormatDirectSpeakers>()) directSpeakersBlocks.push_back(block);
+            for(auto& block : channelFormat->getElements<adm::AudioBlockFormatHoa>()) hoaBlocks.push_back(block);
+        }
+    } catch(std::exception& e) {
+        error = e.what();
+        dropFrom(objectsCount, directSpeakersCount, hoaCount);
+        return false;
+    }
+
+    // Indices must line up with the locations, so anything unexpected means none of it can be used
+    size_t parsedCount = (objectsBlocks.size() - objectsCount) + (directSpeakersBlocks.size() - directSpeakersCount) + (hoaBlocks.size() - hoaCount);
+    if(parsedCount != (size_t)(fillEnd - materialisedEnd)) {
+        error = "Expected " + std::to_string(fillEnd - materialisedEnd) + " audioBlockFormats, parsed " + std::to_string(parsedCount);
+        dropFrom(objectsCount, directSpeakersCount, hoaCount);
+        return false;
+    }
+    materialisedEnd = fillEnd;
+    return true;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <adm/adm.hpp>
+
+// Block formats make up nearly all of an object-heavy document, but playback only needs those around the playhead.
+// So the document is parsed without them, and each audioChannelFormat's blocks are parsed from the axml text as the render position approaches them.
+
+struct BlockFormatLocation {
+    uint64_t offset;    // Of the audioBlockFormat element within the axml
+    uint32_t length;
+    int64_t rtimeNs;    // 0 if it has no rtime (so is treated as starting with the channel)
+};
+
+struct ChannelFormatBlockLocations {
+    std::string openTag; // The audioChannelFormat start tag as written, so its blocks can be parsed alongside it
+    std::vector<BlockFormatLocation> blocks;
+};
+
+// Copies axml in to structuralXml, leaving out every audioBlockFormat, and records where each one was (keyed by audioChannelFormatID).
+// A light scan rather than a full parse - namespace-prefixed elements aren't recognised, so their blocks are simply left in.
+void indexBlockFormats(const char* axml, size_t size, std::string& structuralXml, std::map<std::string, ChannelFormatBlockLocations>& locations);
+
+// Reads length bytes from offset within the axml (wherever it lives - file or memory). False if they aren't all there.
+using AxmlFragmentSource = std::function<bool(uint64_t offset, uint64_t length, std::string& fragment)>;
+
+class LazyBlockFormats
+{
+    // The blocks of one audioChannelFormat, materialised for a contiguous window of block indices.
+    // Not thread-safe - owned and driven by the MetadataExtractor.
+public:
+    LazyBlockFormats(ChannelFormatBlockLocations locations);
+    ~LazyBlockFormats();
+
+    // All blocks the channel has, materialised or not
+    int getCount() const { return (int)locations.blocks.size(); }
+    int64_t getRtimeNs(int index) const { return locations.blocks[index].rtimeNs; }
+    // Index of the last block starting at or before timeNs, materialised or not - -1 if there's none
+    int getIndexAt(int64_t timeNs) const;
+    // Null if this block isn't currently materialised
+    template<typename BlockT>
+    BlockT* get(int index)
+    {
+        auto& blocks = storage<BlockT>();
+        if(index < firstIndex || index >= firstIndex + (int)blocks.size()) return nullptr;
+        return &blocks[index - firstIndex];
+    }
+
+    // Evicts blocks before firstKeptIndex. If blocks starting before neededUntilNs aren't all materialised,
+    //  materialises up to fillUntilNs (further ahead, so this isn't re-parsing a block at a time). False if the axml couldn't be read or parsed.
+    bool update(int firstKeptIndex, int64_t neededUntilNs, int64_t fillUntilNs, const AxmlFragmentSource& source, std::string& error);
+    int getMaterialisedCount() const { return materialisedEnd - firstIndex; }
+    // Drops everything materialised, so the next update materialises from index on - for moving the window somewhere else entirely
+    void restartAt(int index);
+
+private:
+    template<typename BlockT>
+    std::deque<BlockT>& storage()
+    {
+        if constexpr(std::is_same<BlockT, adm::AudioBlockFormatObjects>::value) return objectsBlocks;
+        else if constexpr(std::is_same<BlockT, adm::AudioBlockFormatDirectSpeakers>::value) return directSpeakersBlocks;
+        else return hoaBlocks;
+    }
+    // Index just past the blocks (from materialisedEnd on) starting before untilNs
+    int materialisableEnd(int64_t untilNs) const;
+    void evictBefore(int index);
+    // Undoes a partial materialisation - the sizes each store had before it
+    void dropFrom(size_t objectsCount, size_t directSpeakersCount, size_t hoaCount);
+
+    ChannelFormatBlockLocations locations;
+    int firstIndex{ 0 };        // Materialised blocks are [firstIndex, materialisedEnd)
+    int materialisedEnd{ 0 };
+    // Only the one matching the channel's typeDefinition is used
+    std::deque<adm::AudioBlockFormatObjects> objectsBlocks;
+    std::deque<adm::AudioBlockFormatDirectSpeakers> directSpeakersBlocks;
+    std::deque<adm::AudioBlockFormatHoa> hoaBlocks;
+};
@@ -0,0 +1,80 @@
+#include "MappedFile.h"
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& filePath)
+{
+    HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if(file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Could not open file for mapping: " + filePath);
+    }
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        throw std::runtime_error("Could not determine size of file for mapping: " + filePath);
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(!mapping) {
+        CloseHandle(file);
+        throw std::runtime_error("Could not create file mapping: " + filePath);
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if(!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        throw std::runtime_error("Could not map view of file: " + filePath);
+    }
+    fileHandle = file;
+    mappingHandle = mapping;
+    mappedData = static_cast<const uint8_t*>(view);
+    mappedSize = fileSize.QuadPart;
+}
+
+MappedFile::~MappedFile()
+{
+    if(mappedData) UnmapViewOfFile(mappedData);
+    if(mappingHandle) CloseHandle(mappingHandle);
+    if(fileHandle) CloseHandle(fileHandle);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& filePath)
+{
+    int fd = open(filePath.c_str(), O_RDONLY);
+    if(fd < 0) {
+        throw std::runtime_error("Could not open file for mapping: " + filePath);
+    }
+    struct stat fileStat;
+    if(fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+        close(fd);
+        throw std::runtime_error("Could not determine size of file for mapping: " + filePath);
+    }
+    void* mapping = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // Mapping holds its own reference to the file
+    if(mapping == MAP_FAILED) {
+        throw std::runtime_error("Could not map file: " + filePath);
+    }
+    madvise(mapping, fileStat.st_size, MADV_SEQUENTIAL); // Playback walks forward through the file - only a hint, so ignore failure
+    mappedData = static_cast<const uint8_t*>(mapping);
+    mappedSize = fileStat.st_size;
+}
+
+MappedFile::~MappedFile()
+{
+    if(mappedData) munmap(const_cast<uint8_t*>(mappedData), mappedSize);
+}
+
+#endif
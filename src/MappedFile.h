@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+class MappedFile
+{
+    // Read-only memory mapping of a whole file. Throws std::runtime_error if the file can't be mapped.
+public:
+    MappedFile(const std::string& filePath);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const { return mappedData; }
+    uint64_t size() const { return mappedSize; }
+
+private:
+    const uint8_t* mappedData{ nullptr };
+    uint64_t mappedSize{ 0 };
+#ifdef _WIN32
+    void* fileHandle{ nullptr };
+    void* mappingHandle{ nullptr };
+#endif
+};
@@ -2,9 +2,185 @@
 #include "Helpers.h"
 #include "Readers.h"
 #include "ExceptionHandler.h"
+#include "MetadataCache.h"
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
+namespace {
+    // As sent for each type of block - values the block doesn't have are left at their defaults
+
+    void convertBlock(ChannelBlock& channelBlock, const adm::AudioBlockFormatObjects& audioBlockFormat)
+    {
+        channelBlock.rTimeNs = 0;
+        if(audioBlockFormat.has<adm::Rtime>()) {
+            channelBlock.rTimeNs = audioBlockFormat.get<adm::Rtime>().get().count();
+        }
+        channelBlock.rTime = channelBlock.rTimeNs / 1000000000.0;
+        channelBlock.duration = INFINITY;
+        if(audioBlockFormat.has<adm::Duration>()) {
+            channelBlock.duration = audioBlockFormat.get<adm::Duration>().get().count() / 1000000000.0;
+        }
+        channelBlock.jumpPosition = false;
+        if(audioBlockFormat.has<adm::JumpPosition>()){
+            auto jumpPosition = audioBlockFormat.get<adm::JumpPosition>();
+            if(jumpPosition.has<adm::JumpPositionFlag>() && jumpPosition.get<adm::JumpPositionFlag>().get()){
+                channelBlock.jumpPosition = true;
+                channelBlock.interpolationLength = 0.0; // Contradiction in BS.2076. Supposed to default to block duration, but that would not create the instant jump behaviour
+                if(jumpPosition.has<adm::InterpolationLength>()) {
+                    channelBlock.interpolationLength = jumpPosition.get<adm::InterpolationLength>().get().count() / 1000000000.0;
+                }
+            }
+        }
+        if(audioBlockFormat.has<adm::CartesianPosition>())
+        {
+            channelBlock.cartesian = true;
+            auto position = audioBlockFormat.get<adm::CartesianPosition>();
+            channelBlock.x = position.get<adm::X>().get();
+            channelBlock.y = position.get<adm::Y>().get();
+            channelBlock.z = position.get<adm::Z>().get();
+        }
+        else if(audioBlockFormat.has<adm::SphericalPosition>())
+        {
+            channelBlock.cartesian = false;
+            auto position = audioBlockFormat.get<adm::SphericalPosition>();
+            channelBlock.azimuth = position.get<adm::Azimuth>().get();
+            channelBlock.elevation = position.get<adm::Elevation>().get();
+            channelBlock.distance = 1.0;
+            if(position.has<adm::Distance>()){
+                channelBlock.distance = position.get<adm::Distance>().get();
+            }
+        } else {
+            assert(false); // Should always have one or the other!
+        }
+        channelBlock.width = 0.0;
+        if(audioBlockFormat.has<adm::Width>()) {
+            channelBlock.width = audioBlockFormat.get<adm::Width>().get();
+        }
+        channelBlock.height = 0.0;
+        if(audioBlockFormat.has<adm::Height>()) {
+            channelBlock.height = audioBlockFormat.get<adm::Height>().get();
+        }
+        channelBlock.depth = 0.0;
+        if(audioBlockFormat.has<adm::Depth>()) {
+            channelBlock.depth = audioBlockFormat.get<adm::Depth>().get();
+        }
+        channelBlock.gain = 1.0;
+        if(audioBlockFormat.has<adm::Gain>()) {
+            channelBlock.gain = audioBlockFormat.get<adm::Gain>().get();
+        }
+        channelBlock.diffuse = 0.0;
+        if(audioBlockFormat.has<adm::Diffuse>()) {
+            channelBlock.diffuse = audioBlockFormat.get<adm::Diffuse>().get();
+        }
+        channelBlock.divergence = 0.0;
+        channelBlock.divergenceAzimuthRange = 0.0;
+        channelBlock.divergencePositionRange = 0.0;
+        if(audioBlockFormat.has<adm::ObjectDivergence>()) {
+            auto objectDivergence = audioBlockFormat.get<adm::ObjectDivergence>();
+            if(objectDivergence.has<adm::Divergence>()) {
+                channelBlock.divergence = objectDivergence.get<adm::Divergence>().get();
+            }
+            if(objectDivergence.has<adm::AzimuthRange>()) {
+                channelBlock.divergenceAzimuthRange = objectDivergence.get<adm::AzimuthRange>().get();
+            }
+            if(objectDivergence.has<adm::PositionRange>()) {
+                channelBlock.divergencePositionRange = objectDivergence.get<adm::PositionRange>().get();
+            }
+        }
+        channelBlock.channelLock = false;
+        if(audioBlockFormat.has<adm::ChannelLock>()){
+            auto channelLock = audioBlockFormat.get<adm::ChannelLock>();
+            if(channelLock.has<adm::ChannelLockFlag>() && channelLock.get<adm::ChannelLockFlag>().get()){
+                channelBlock.channelLock = true;
+                channelBlock.channelLockMaxDistance = INFINITY;
+                if(channelLock.has<adm::MaxDistance>()) {
+                    channelBlock.channelLockMaxDistance = channelLock.get<adm::MaxDistance>().get();
+                }
+            }
+        }
+        channelBlock.screenRef = false;
+        if(audioBlockFormat.has<adm::ScreenRef>()) {
+            channelBlock.screenRef = audioBlockFormat.get<adm::ScreenRef>().get();
+        }
+    }
+
+    void convertBlock(ChannelBlock& channelBlock, const adm::AudioBlockFormatDirectSpeakers& audioBlockFormat)
+    {
+        channelBlock.rTimeNs = 0;
+        if(audioBlockFormat.has<adm::Rtime>()) {
+            channelBlock.rTimeNs = audioBlockFormat.get<adm::Rtime>().get().count();
+        }
+        channelBlock.rTime = channelBlock.rTimeNs / 1000000000.0;
+        channelBlock.duration = INFINITY;
+        if(audioBlockFormat.has<adm::Duration>()) {
+            channelBlock.duration = audioBlockFormat.get<adm::Duration>().get().count() / 1000000000.0;
+        }
+        channelBlock.gain = 1.0; // Gain is a common block param, but not available for DS in libadm
+        if(audioBlockFormat.has<adm::SpeakerPosition>())
+        {
+            channelBlock.cartesian = false;
+            auto position = audioBlockFormat.get<adm::SpeakerPosition>();
+            channelBlock.azimuth = position.get<adm::Azimuth>().get();
+            channelBlock.elevation = position.get<adm::Elevation>().get();
+            channelBlock.distance = 1.0;
+            if(position.has<adm::Distance>()){
+                channelBlock.distance = position.get<adm::Distance>().get();
+            }
+        } else {
+            assert(false); // Should always have!
+        }
+        channelBlock.speakerLabel[0] = 0;
+        if(audioBlockFormat.has<adm::SpeakerLabels>()) {
+            auto speakerLabels = audioBlockFormat.get<adm::SpeakerLabels>();
+            assert(speakerLabels.size() <= 1); // Currently only supporting one label due to fully-contained, fixed-size metadata struct.
+            if(speakerLabels.size() > 0) {
+                strncpy(channelBlock.speakerLabel, speakerLabels[0].get().c_str(), sizeof(channelBlock.speakerLabel));
+            }
+        }
+    }
 
-std::string MetadataExtractor::generatePresentedName(std::vector<std::shared_ptr<adm::AudioObject>> &audioObjectTree, std::vector<std::shared_ptr<adm::AudioPackFormat>> &audioPackFormatTree, std::shared_ptr<adm::AudioChannelFormat> audioChannelFormat, adm::TypeDescriptor typeDefinition) {
+    void convertBlock(ChannelBlock& channelBlock, const adm::AudioBlockFormatHoa& audioBlockFormat)
+    {
+        channelBlock.rTimeNs = 0;
+        if(audioBlockFormat.has<adm::Rtime>()) {
+            channelBlock.rTimeNs = audioBlockFormat.get<adm::Rtime>().get().count();
+        }
+        channelBlock.rTime = channelBlock.rTimeNs / 1000000000.0;
+        channelBlock.duration = INFINITY; // Sent as the gap to the next block across all the item's channels
+        channelBlock.screenRef = false;
+        if(audioBlockFormat.has<adm::ScreenRef>()) {
+            channelBlock.screenRef = audioBlockFormat.get<adm::ScreenRef>().get();
+        }
+        strncpy(channelBlock.normalisation, "SN3D", 5);
+        if(audioBlockFormat.has<adm::Normalization>()) {
+            strncpy(channelBlock.normalisation, audioBlockFormat.get<adm::Normalization>().get().c_str(), sizeof(channelBlock.normalisation));
+        }
+        channelBlock.nfcRefDist = 0.0;
+        if(audioBlockFormat.has<adm::NfcRefDist>()) {
+            channelBlock.nfcRefDist = audioBlockFormat.get<adm::NfcRefDist>().get();
+        }
+        channelBlock.order = 0;
+        if(audioBlockFormat.has<adm::Order>()) {
+            channelBlock.order = audioBlockFormat.get<adm::Order>().get();
+        } else {
+            assert(false); //MANDATORY for Hoa Block
+        }
+        channelBlock.degree = 0;
+        if(audioBlockFormat.has<adm::Degree>()) {
+            channelBlock.degree = audioBlockFormat.get<adm::Degree>().get();
+        } else {
+            assert(false); //MANDATORY for Hoa Block
+        }
+    }
+}
+
+std::string MetadataExtractor::generatePresentedName(const std::vector<std::shared_ptr<adm::AudioObject>> &audioObjectTree, std::vector<std::shared_ptr<adm::AudioPackFormat>> &audioPackFormatTree, std::shared_ptr<adm::AudioChannelFormat> audioChannelFormat, adm::TypeDescriptor typeDefinition) {
     std::string presentedName{};
     std::string audioObjectName{};
     std::string audioPackFormatName{};
@@ -63,160 +239,703 @@ RenderableItemId MetadataExtractor::generateRenderableItemId(std::shared_ptr<adm
     return op;
 }
 
+class DiscoveryWorkers
+{
+    // Threads that each run the task given to run() alongside the calling thread, then wait for the next - see createNewChannels
+public:
+    // Throws std::system_error if a thread can't be started (having stopped any that were)
+    DiscoveryWorkers(size_t workerCount)
+    {
+        try {
+            for(size_t workerIndex = 0; workerIndex < workerCount; workerIndex++) {
+                threads.emplace_back(&DiscoveryWorkers::workerLoop, this);
+            }
+        } catch(...) {
+            stop();
+            throw;
+        }
+    }
+
+    ~DiscoveryWorkers()
+    {
+        stop();
+    }
+
+    size_t getWorkerCount() const { return threads.size(); }
+
+    // Returns once every worker and the calling thread have finished the task - rethrowing the first exception any of them threw
+    void run(const std::function<void()>& newTask)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            task = &newTask;
+            busyCount = threads.size();
+            taskException = nullptr;
+            taskGeneration++;
+        }
+        taskStart.notify_all();
+        runTask(newTask);
+        std::unique_lock<std::mutex> lock(mutex);
+        taskDone.wait(lock, [this]() { return busyCount == 0; });
+        task = nullptr;
+        if(taskException) {
+            std::rethrow_exception(taskException);
+        }
+    }
+
+private:
+    void runTask(const std::function<void()>& currentTask)
+    {
+        try {
+            currentTask();
+        } catch(...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(!taskException) taskException = std::current_exception();
+        }
+    }
+
+    void workerLoop()
+    {
+        uint64_t doneGeneration = 0;
+        while(true) {
+            const std::function<void()>* currentTask = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                taskStart.wait(lock, [&]() { return stopping || taskGeneration != doneGeneration; });
+                if(stopping) return;
+                doneGeneration = taskGeneration;
+                currentTask = task;
+            }
+            runTask(*currentTask);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                busyCount--;
+            }
+            taskDone.notify_one();
+        }
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        taskStart.notify_all();
+        for(auto& thread : threads) {
+            thread.join();
+        }
+        threads.clear();
+    }
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable taskStart;
+    std::condition_variable taskDone;
+    const std::function<void()>* task{ nullptr };
+    uint64_t taskGeneration{ 0 };
+    size_t busyCount{ 0 };
+    std::exception_ptr taskException;
+    bool stopping{ false };
+};
+
 MetadataExtractor::MetadataExtractor(Reader * parentReader, std::shared_ptr<adm::Document> parsedDocument) : parentReader{ parentReader }, parsedDocument{ parsedDocument }
 {
 }
 
+MetadataExtractor::MetadataExtractor(Reader * parentReader, std::shared_ptr<FlattenedMetadata> flattenedMetadata) : parentReader{ parentReader }, flattenedMetadata{ flattenedMetadata }
+{
+}
+
 MetadataExtractor::~MetadataExtractor()
 {
 }
 
-int MetadataExtractor::discoverNewRenderableItems()
+std::shared_ptr<FlattenedMetadata> MetadataExtractor::flatten()
 {
-    if(!parsedDocument) {
-        getExceptionHandler()->logException("No parsedDocument!");
-        return -1; // -1 = Error
+    discoverNewRenderableItems();
+
+    std::map<RenderableItemId, size_t> itemIndices;
+    for(size_t itemIndex = 0; itemIndex < validRenderableItems.size(); itemIndex++) {
+        itemIndices[validRenderableItems[itemIndex]->selfId] = itemIndex;
+    }
+    std::vector<std::vector<MetadataBlock>> itemBlocks(validRenderableItems.size());
+    MetadataBlock metadataBlock{}; // Zeroed, so nothing unset is left as garbage in the cache
+    while(getNextMetadataBlock(&metadataBlock)) {
+        itemBlocks[itemIndices[metadataBlock.id]].push_back(metadataBlock);
+        metadataBlock = MetadataBlock{};
     }
 
-    // Quick check - do we already have the same number of RenderableItemChannels as AudioTrackUids?
-    auto audioTrackUids = parsedDocument->getElements<adm::AudioTrackUid>();
-    assert(audioTrackUids.size() >= renderableItemChannels.size()); // Can't see why audioTrackUids should ever disappear from the document, even in S-ADM
-    if(audioTrackUids.size() <= renderableItemChannels.size()) return 0;
+    auto flattened = std::make_shared<FlattenedMetadata>();
+    for(size_t itemIndex = 0; itemIndex < validRenderableItems.size(); itemIndex++) {
+        auto& renderableItem = validRenderableItems[itemIndex];
+        std::vector<int> channelNums;
+        for(auto& renderableItemChannelPair : renderableItem->renderableItemChannels) {
+            if(renderableItemChannelPair.second->valid && renderableItemChannelPair.second->channelNum >= 0) {
+                channelNums.push_back(renderableItemChannelPair.second->channelNum);
+            }
+        }
+        std::vector<uint16_t> audioProgrammeIds;
+        for(auto& admTree : renderableItem->admTrees) {
+            if(admTree.audioProgramme) {
+                audioProgrammeIds.push_back(admTree.audioProgrammeId);
+            }
+        }
+        flattened->addItem(renderableItem->selfId, channelNums, audioProgrammeIds, itemBlocks[itemIndex]);
+    }
+    return flattened;
+}
 
-    // Find the new ones!
-    int newCount = 0;
+bool MetadataExtractor::getNextFlattenedMetadataBlock(MetadataBlock* metadataBlock, const MetadataBlockFilter& filter)
+{
+    // Same round-robin across items as from the document
+    uint64_t itemCount = flattenedSentCounts.size();
+    for(uint64_t checked = 0; checked < itemCount; checked++) {
+        uint64_t itemIndex = (uint64_t)(idIndexOfLastRenderableItemSent + 1 + checked) % itemCount;
+        auto& item = flattenedMetadata->getItem(itemIndex);
+        if(flattenedSentCounts[itemIndex] < item.blockCount) {
+            if(!filter.matches(item.id, flattenedMetadata->getBlock(item, 0).typeDef)) continue; // An item's blocks all share its type
+            *metadataBlock = flattenedMetadata->getBlock(item, flattenedSentCounts[itemIndex]++);
+            idIndexOfLastRenderableItemSent = (int)itemIndex;
+            return true;
+        }
+    }
+    return false;
+}
 
-    auto audioProgrammes = parsedDocument->getElements<adm::AudioProgramme>();
-    for(auto audioProgramme : audioProgrammes) {
-        newCount += discoverViaAudioProgramme(audioProgramme);
+void MetadataExtractor::setLazyBlockFormats(std::map<std::string, ChannelFormatBlockLocations> locations, AxmlFragmentSource source, double windowSec)
+{
+    lazyBlockFormats.clear();
+    for(auto& locationsPair : locations) {
+        lazyBlockFormats[locationsPair.first] = std::make_shared<LazyBlockFormats>(std::move(locationsPair.second));
     }
+    axmlFragmentSource = source;
+    lazyWindowNs = (int64_t)(std::max(windowSec, 0.0) * 1000000000.0);
+}
 
-    auto audioContents = parsedDocument->getElements<adm::AudioContent>(); // May not have parent programme
-    for(auto audioContent : audioContents) {
-        newCount += discoverViaAudioContent(nullptr, audioContent);
+void MetadataExtractor::setRenderPosition(double positionSec)
+{
+    renderPositionNs = (int64_t)(std::max(positionSec, 0.0) * 1000000000.0);
+    updateLazyBlockFormats();
+}
+
+uint64_t MetadataExtractor::getMaterialisedBlockCount()
+{
+    uint64_t count = 0;
+    for(auto& lazyBlockFormatsPair : lazyBlockFormats) {
+        count += lazyBlockFormatsPair.second->getMaterialisedCount();
     }
+    return count;
+}
 
-    auto audioObjects = parsedDocument->getElements<adm::AudioObject>(); // May not have parent content
-    for(auto audioObject : audioObjects) {
-        newCount += discoverViaAudioObject(nullptr, nullptr, std::vector<std::shared_ptr<adm::AudioObject>> {audioObject});
+void MetadataExtractor::updateLazyBlockFormats()
+{
+    if(lazyBlockFormats.empty()) return;
+
+    // Keep from the earliest block any channel still needs. HOA looks back at the last block sent, so that's kept too.
+    // Channel formats not used by a valid item are never sent from, so never materialised.
+    std::map<LazyBlockFormats*, int> firstKeptIndices;
+    for(auto& renderableItem : validRenderableItems) {
+        for(auto& renderableItemChannelPair : renderableItem->renderableItemChannels) {
+            auto& channelLazyBlockFormats = renderableItemChannelPair.second->lazyBlockFormats;
+            if(!channelLazyBlockFormats) continue;
+            int firstKeptIndex = std::max(renderableItemChannelPair.second->lastSentBlockIndex, 0);
+            // Converted blocks are dropped along with those they came from, so the table stays window-sized too
+            auto& blockTable = renderableItemChannelPair.second->blockTable;
+            if(firstKeptIndex > renderableItemChannelPair.second->blockTableFirstIndex) {
+                int droppedCount = std::min(firstKeptIndex - renderableItemChannelPair.second->blockTableFirstIndex, (int)blockTable.size());
+                blockTable.erase(blockTable.begin(), blockTable.begin() + droppedCount);
+                renderableItemChannelPair.second->blockTableFirstIndex = firstKeptIndex;
+            }
+            auto existing = firstKeptIndices.find(channelLazyBlockFormats.get());
+            if(existing == firstKeptIndices.end()) {
+                firstKeptIndices[channelLazyBlockFormats.get()] = firstKeptIndex;
+            } else {
+                existing->second = std::min(existing->second, firstKeptIndex);
+            }
+        }
     }
 
-    // Strays - add anyway to prevent constantly running this method trying to discover who they belong to
-    for(auto audioTrackUid : audioTrackUids) {
-        newCount += discoverFromAudioTrackUid(nullptr, nullptr, std::vector<std::shared_ptr<adm::AudioObject>>{}, audioTrackUid);
+    for(auto& firstKeptIndexPair : firstKeptIndices) {
+        // Fill a whole window further ahead than needed, so we're not re-parsing as each block comes in to range
+        std::string error;
+        if(!firstKeptIndexPair.first->update(firstKeptIndexPair.second, renderPositionNs + lazyWindowNs, renderPositionNs + 2 * lazyWindowNs, axmlFragmentSource, error)) {
+            getExceptionHandler()->logException("Unable to materialise audioBlockFormats: " + error);
+        }
+    }
+}
+
+template<typename BlockT>
+int MetadataExtractor::getBlockCount(const std::shared_ptr<RenderableItemChannel>& renderableItemChannel)
+{
+    if(renderableItemChannel->lazyBlockFormats) {
+        return renderableItemChannel->lazyBlockFormats->getCount();
+    }
+    return renderableItemChannel->audioChannelFormat->getElements<BlockT>().size();
+}
+
+template<typename BlockT>
+BlockT* MetadataExtractor::getBlock(const std::shared_ptr<RenderableItemChannel>& renderableItemChannel, int index)
+{
+    if(renderableItemChannel->lazyBlockFormats) {
+        return renderableItemChannel->lazyBlockFormats->get<BlockT>(index);
+    }
+    auto blocks = renderableItemChannel->audioChannelFormat->getElements<BlockT>(); // A view in to the channel format, so pointers to its blocks stay valid
+    if(index < 0 || index >= (int)blocks.size()) return nullptr;
+    return &blocks[index];
+}
+
+template<typename BlockT>
+void MetadataExtractor::topUpBlockTable(const std::shared_ptr<RenderableItemChannel>& renderableItemChannel)
+{
+    auto& blockTable = renderableItemChannel->blockTable;
+    int blockCount = getBlockCount<BlockT>(renderableItemChannel);
+    int tableEnd = renderableItemChannel->blockTableFirstIndex + (int)blockTable.size();
+    if(tableEnd >= blockCount) return;
+    if(blockTable.empty() && !renderableItemChannel->lazyBlockFormats) {
+        blockTable.reserve(blockCount); // All of them are here at discovery, so one allocation - later (S-ADM) top ups grow it geometrically
+    }
+    for(int index = tableEnd; index < blockCount; index++) {
+        auto block = getBlock<BlockT>(renderableItemChannel, index); // Null past a lazy window
+        if(!block) break;
+        ChannelBlock channelBlock{};
+        convertBlock(channelBlock, *block);
+        blockTable.push_back(channelBlock);
+    }
+}
+
+void MetadataExtractor::topUpBlockTable(const std::shared_ptr<RenderableItemChannel>& renderableItemChannel)
+{
+    if(!renderableItemChannel->audioChannelFormat) return;
+    if(renderableItemChannel->typeDefinition == adm::TypeDefinition::OBJECTS) {
+        topUpBlockTable<adm::AudioBlockFormatObjects>(renderableItemChannel);
+    } else if(renderableItemChannel->typeDefinition == adm::TypeDefinition::DIRECT_SPEAKERS) {
+        topUpBlockTable<adm::AudioBlockFormatDirectSpeakers>(renderableItemChannel);
+    } else if(renderableItemChannel->typeDefinition == adm::TypeDefinition::HOA) {
+        topUpBlockTable<adm::AudioBlockFormatHoa>(renderableItemChannel);
+    }
+}
+
+const ChannelBlock* MetadataExtractor::getChannelBlock(const std::shared_ptr<RenderableItemChannel>& renderableItemChannel, int index)
+{
+    int tableIndex = index - renderableItemChannel->blockTableFirstIndex;
+    if(tableIndex < 0) return nullptr;
+    if(tableIndex >= (int)renderableItemChannel->blockTable.size()) {
+        topUpBlockTable(renderableItemChannel);
+        if(tableIndex >= (int)renderableItemChannel->blockTable.size()) return nullptr;
+    }
+    return &renderableItemChannel->blockTable[tableIndex];
+}
+
+int MetadataExtractor::discoverNewRenderableItems()
+{
+    if(flattenedMetadata) {
+        if(!flattenedSentCounts.empty() || flattenedMetadata->getItemCount() == 0) return 0;
+        flattenedSentCounts.assign(flattenedMetadata->getItemCount(), 0);
+        for(uint64_t itemIndex = 0; itemIndex < flattenedSentCounts.size(); itemIndex++) {
+            flattenedItemIndices[flattenedMetadata->getItem(itemIndex).id] = itemIndex;
+        }
+        return (int)flattenedSentCounts.size();
+    }
+
+    if(!parsedDocument) {
+        getExceptionHandler()->logException("No parsedDocument!");
+        return -1; // -1 = Error
+    }
+
+    // Quick check - has anything been added since last time?
+    bool elementsAdded = parsedDocument->getElements<adm::AudioProgramme>().size() != walkedAudioProgrammeCount ||
+        parsedDocument->getElements<adm::AudioContent>().size() != walkedAudioContentCount ||
+        parsedDocument->getElements<adm::AudioObject>().size() != walkedAudioObjectCount ||
+        parsedDocument->getElements<adm::AudioTrackUid>().size() != walkedAudioTrackUidCount;
+    if(!elementsAdded && markedAudioProgrammes.empty() && markedAudioContents.empty() && markedAudioObjects.empty()) return 0;
+
+    // Find the new ones! Only paths through something added since last time are new, so only those are walked.
+    if(discoveryThreadCount != 1) {
+        // Walked twice - first just noting the new channels, so they can be created across threads before the walk proper registers them
+        notingNewChannels = true;
+        discoverViaAddedReferences();
+        discoverViaAddedElements();
+        notingNewChannels = false;
+        createNewChannels();
+    }
+    int newCount = discoverViaAddedReferences();
+    newCount += discoverViaAddedElements();
+    recordWalkedReferences();
+    createdChannels.clear(); // All registered by the walk - nothing should be left
+
+    if(newCount > 0) {
+        updateLazyBlockFormats(); // New items need their first window of blocks
+        for(auto& renderableItem : validRenderableItems) {
+            extendHoaTimeline(renderableItem);
+        }
     }
 
     return newCount;
 }
 
-bool MetadataExtractor::getNextMetadataBlock(MetadataBlock * metadataBlock)
+std::vector<int> MetadataExtractor::getReferencedChannelNums(int audioProgrammeIdFilter)
 {
-    getExceptionHandler()->clearException(); // Clear because this method can return false without an exception.
+    std::vector<int> channelNums;
+    for(uint64_t itemIndex = 0; itemIndex < flattenedSentCounts.size(); itemIndex++) {
+        auto& item = flattenedMetadata->getItem(itemIndex);
+        auto audioProgrammeIds = flattenedMetadata->getAudioProgrammeIds(item);
+        if(audioProgrammeIdFilter >= 0 && std::find(audioProgrammeIds, audioProgrammeIds + item.audioProgrammeIdCount, audioProgrammeIdFilter) == audioProgrammeIds + item.audioProgrammeIdCount) continue;
+        auto itemChannelNums = flattenedMetadata->getChannelNums(item);
+        channelNums.insert(channelNums.end(), itemChannelNums, itemChannelNums + item.channelNumCount);
+    }
+    for(auto& renderableItem : validRenderableItems) {
+        if(audioProgrammeIdFilter >= 0) {
+            // Same test the Unity side applies when filtering by programme
+            auto inProgramme = [audioProgrammeIdFilter](ItemAdmTree &admTree){
+                return admTree.audioProgramme && admTree.audioProgrammeId == audioProgrammeIdFilter;
+            };
+            if(std::find_if(renderableItem->admTrees.begin(), renderableItem->admTrees.end(), inProgramme) == renderableItem->admTrees.end()) continue;
+        }
+        for(auto& renderableItemChannelPair : renderableItem->renderableItemChannels) {
+            if(renderableItemChannelPair.second->valid && renderableItemChannelPair.second->channelNum >= 0) {
+                channelNums.push_back(renderableItemChannelPair.second->channelNum);
+            }
+        }
+    }
+    std::sort(channelNums.begin(), channelNums.end());
+    channelNums.erase(std::unique(channelNums.begin(), channelNums.end()), channelNums.end());
+    return channelNums;
+}
+
+int MetadataExtractor::getNextMetadataBlocks(MetadataBlock* metadataBlocks, int capacity, const MetadataBlockFilter& filter)
+{
+    int count = 0;
+    while(count < capacity && getNextMetadataBlock(&metadataBlocks[count], filter)) {
+        count++;
+    }
+    return count;
+}
 
+bool MetadataExtractor::getNextMetadataBlock(MetadataBlock * metadataBlock, const MetadataBlockFilter& filter)
+{
+    if(flattenedMetadata) return getNextFlattenedMetadataBlock(metadataBlock, filter);
+
+    std::shared_ptr<RenderableItemChannel> refItemChannel;
+    auto renderableItem = pullNextBlock(metadataBlock, filter, refItemChannel);
+    if(!renderableItem) return false;
+    populateCommonMetadata(metadataBlock, renderableItem, refItemChannel);
+    return true;
+}
+
+std::shared_ptr<RenderableItem> MetadataExtractor::pullNextBlock(MetadataBlock* metadataBlock, const MetadataBlockFilter& filter, std::shared_ptr<RenderableItemChannel>& refItemChannel)
+{
     // Quick check if nothing to send;
-    if(validRenderableItems.size() == 0) return false;
+    if(validRenderableItems.size() == 0) return nullptr;
 
     // Need to check if this item has more blocks, otherwise move on;
+    // Stops once back at the last item sent - or, before any have been (or if it's gone), once round every item. A filter can make that a full lap without finding a block.
     int checksFinalIndex = idIndexOfLastRenderableItemSent;
-    int itemIdIndex = idIndexOfLastRenderableItemSent; // We'll +1 on entering first loop
-    std::shared_ptr<RenderableItem> currentItem;
-    std::shared_ptr<RenderableItemChannel> currentItemChannel;
-    adm::TypeDescriptor currentTypeDefinition = adm::TypeDefinition::UNDEFINED;
-
-    bool nextItemFound{ false };
+    if(checksFinalIndex < 0 || checksFinalIndex >= (int)validRenderableItems.size()) checksFinalIndex = (int)validRenderableItems.size() - 1;
+    int itemIdIndex = checksFinalIndex; // We'll +1 on entering first loop
 
     do {
-        currentItemChannel.reset();
-
         // Move on to next item to check;
         itemIdIndex++;
         if(itemIdIndex >= validRenderableItems.size()) itemIdIndex = 0;
-        currentItem = validRenderableItems[itemIdIndex];
+        auto& currentItem = validRenderableItems[itemIdIndex];
+        if(!filter.matches(currentItem->selfId, currentItem->typeDefinition.get())) continue; // Straight on to the loop condition
 
         // Check it for unsent blocks
-        if(currentItem->typeDefinition == adm::TypeDefinition::OBJECTS) {
-            currentItemChannel = validRenderableItems[itemIdIndex]->renderableItemChannels.begin()->second; // Only single channel expected in this type of item
-            auto objectBlocks = currentItemChannel->audioChannelFormat->getElements<adm::AudioBlockFormatObjects>(); // This is probably quite inefficient if it's a copy op - we need a shortcut in libadm
-            int objectBlocksCount = objectBlocks.size();
-            if(currentItemChannel->lastSentBlockIndex < (objectBlocksCount - 1)) {
-                // Unsent blocks waiting on this channel
-                auto block = objectBlocks[++currentItemChannel->lastSentBlockIndex]; // Note increment!
-                populateTypeSpecificMetadata(metadataBlock, &block, currentItemChannel);
-                nextItemFound = true;
-            }
-
-        } else if(currentItem->typeDefinition == adm::TypeDefinition::DIRECT_SPEAKERS) {
-            currentItemChannel = validRenderableItems[itemIdIndex]->renderableItemChannels.begin()->second; // Only single channel expected in this type of item
-            auto dsBlocks = currentItemChannel->audioChannelFormat->getElements<adm::AudioBlockFormatDirectSpeakers>(); // This is probably quite inefficient if it's a copy op - we need a shortcut in libadm
-            int dsBlocksCount = dsBlocks.size();
-            if(currentItemChannel->lastSentBlockIndex < (dsBlocksCount - 1)) {
-                // Unsent blocks waiting on this channel
-                auto block = dsBlocks[++currentItemChannel->lastSentBlockIndex]; // Note increment!
-                populateTypeSpecificMetadata(metadataBlock, &block, currentItemChannel);
-                nextItemFound = true;
-            }
-
-        } else if(currentItem->typeDefinition == adm::TypeDefinition::HOA) {
-
-            uint64_t nextEarliestRtime;
-            adm::AudioBlockFormatHoa* nextEarliestBlock = nullptr;
-
-            for(auto& renderableItemChannelPair : validRenderableItems[itemIdIndex]->renderableItemChannels) {
-                auto hoaBlocks = renderableItemChannelPair.second->audioChannelFormat->getElements<adm::AudioBlockFormatHoa>();
-                int hoaBlocksCount = hoaBlocks.size();
-                if(renderableItemChannelPair.second->lastSentBlockIndex < (hoaBlocksCount - 1)) {
-                    // Unsent blocks waiting on this channel
-                    uint64_t nextRtime = 0;
-                    if(hoaBlocks[renderableItemChannelPair.second->lastSentBlockIndex + 1].has<adm::Rtime>()) {
-                        nextRtime = hoaBlocks[renderableItemChannelPair.second->lastSentBlockIndex + 1].get<adm::Rtime>().get().count();
-                    }
-                    if(nextEarliestBlock == nullptr || nextRtime < nextEarliestRtime) {
-                        nextEarliestRtime = nextRtime;
-                        nextEarliestBlock = &hoaBlocks[renderableItemChannelPair.second->lastSentBlockIndex + 1];
-                        currentItemChannel = renderableItemChannelPair.second;
-                    }
-                }
-            }
+        getSentCursors(currentItem, pullCursors);
+        if(populateNextBlock(metadataBlock, currentItem, pullCursors, refItemChannel)) {
+            setSentCursors(currentItem, pullCursors);
+            idIndexOfLastRenderableItemSent = itemIdIndex;
+            return currentItem;
+        }
+
+    } while(itemIdIndex != checksFinalIndex);
+
+    // Didn't return early - no new blocks available
+    return nullptr;
+}
+
+int MetadataExtractor::getNextBlockRecords(BlockRecord* blockRecords, int capacity, const MetadataBlockFilter& filter)
+{
+    MetadataBlock metadataBlock;
+    int count = 0;
+    while(count < capacity) {
+        metadataBlock = MetadataBlock{}; // Cleared each time - the item's descriptor is taken from it too, so nothing may carry over from the last item
+        if(flattenedMetadata) {
+            if(!getNextFlattenedMetadataBlock(&metadataBlock, filter)) break;
+        } else {
+            std::shared_ptr<RenderableItemChannel> refItemChannel;
+            auto renderableItem = pullNextBlock(&metadataBlock, filter, refItemChannel);
+            if(!renderableItem) break;
+            populateCommonMetadata(&metadataBlock, renderableItem, refItemChannel); // The descriptor's values - as a flattened block already has them
+        }
+        packBlockRecord(metadataBlock, &blockRecords[count]);
+        bool newRevision = describeSentBlock(metadataBlock, &blockRecords[count].descriptorRevision);
+        count++;
+        if(newRevision) break; // Nothing after it, so the descriptor the caller fetches next is still this one
+    }
+    return count;
+}
 
-            if(nextEarliestBlock != nullptr) {
-                populateHoaSpecificMetadata(metadataBlock, nextEarliestBlock, validRenderableItems[itemIdIndex]); // Also does incrementing of lastSentBlockIndexes
-                nextItemFound = true;
+bool MetadataExtractor::getItemDescriptor(RenderableItemId itemId, ItemDescriptor* itemDescriptor)
+{
+    auto sentItemDescriptor = getValuePointerFromMap(sentItemDescriptors, itemId);
+    if(!sentItemDescriptor) return false;
+    memcpy(itemDescriptor, sentItemDescriptor, sizeof(ItemDescriptor)); // Padding too, as describeSentBlock compares it
+    return true;
+}
+
+bool MetadataExtractor::describeSentBlock(const MetadataBlock& metadataBlock, uint32_t* revision)
+{
+    // Compared and stored whole - both are zeroed first (padding included), so memcmp only sees the values
+    ItemDescriptor itemDescriptor{};
+    describeItem(metadataBlock, &itemDescriptor);
+    auto& sentItemDescriptor = sentItemDescriptors[metadataBlock.id]; // Zeroed if new, so never matches a real block
+    itemDescriptor.revision = sentItemDescriptor.revision;
+    bool changed = memcmp(&itemDescriptor, &sentItemDescriptor, sizeof(ItemDescriptor)) != 0;
+    if(changed) {
+        itemDescriptor.revision++;
+        memcpy(&sentItemDescriptor, &itemDescriptor, sizeof(ItemDescriptor));
+    }
+    *revision = sentItemDescriptor.revision;
+    return changed;
+}
+
+int MetadataExtractor::getMetadataBlocksInRange(double fromSec, double toSec, MetadataBlock* metadataBlocks, int capacity, const MetadataBlockFilter& filter)
+{
+    int foundCount = 0;
+    auto found = [&](const MetadataBlock& metadataBlock) {
+        if(foundCount < capacity) metadataBlocks[foundCount] = metadataBlock;
+        foundCount++;
+    };
+
+    if(flattenedMetadata) {
+        for(uint64_t itemIndex = 0; itemIndex < flattenedSentCounts.size(); itemIndex++) {
+            auto& item = flattenedMetadata->getItem(itemIndex);
+            if(item.blockCount == 0 || !filter.matches(item.id, flattenedMetadata->getBlock(item, 0).typeDef)) continue;
+            for(uint64_t blockIndex = getFlattenedBlockIndexAt(item, fromSec); blockIndex < item.blockCount; blockIndex++) {
+                auto& metadataBlock = flattenedMetadata->getBlock(item, blockIndex);
+                if(metadataBlock.rTime > toSec) break;
+                if(metadataBlock.rTime + metadataBlock.duration > fromSec) found(metadataBlock);
             }
+        }
+        return foundCount;
+    }
 
-        } else if(currentTypeDefinition == adm::TypeDefinition::BINAURAL) {
-            // TODO - Binaural, which will work slightly differently.
+    int64_t fromNs = (int64_t)(fromSec * 1000000000.0);
+    std::vector<int> cursors;
+    for(auto& renderableItem : validRenderableItems) {
+        if(!filter.matches(renderableItem->selfId, renderableItem->typeDefinition.get())) continue;
+        getCursorsAt(renderableItem, fromNs, cursors);
+        MetadataBlock metadataBlock{};
+        std::shared_ptr<RenderableItemChannel> refItemChannel;
+        while(populateNextBlock(&metadataBlock, renderableItem, cursors, refItemChannel) && metadataBlock.rTime <= toSec) {
+            if(metadataBlock.rTime + metadataBlock.duration > fromSec) { // Not a gap before fromSec
+                populateCommonMetadata(&metadataBlock, renderableItem, refItemChannel);
+                found(metadataBlock);
+            }
+            metadataBlock = MetadataBlock{};
         }
+    }
+    return foundCount;
+}
 
-        if(nextItemFound) {
-            // Finalise by doing common parameters and return
+void MetadataExtractor::seek(double positionSec)
+{
+    if(flattenedMetadata) {
+        for(uint64_t itemIndex = 0; itemIndex < flattenedSentCounts.size(); itemIndex++) {
+            flattenedSentCounts[itemIndex] = getFlattenedBlockIndexAt(flattenedMetadata->getItem(itemIndex), positionSec);
+        }
+        return;
+    }
 
-            metadataBlock->id = currentItem->selfId;
-            metadataBlock->typeDef = currentItem->typeDefinition.get();
-            metadataBlock->audioStartTime = currentItem->startTime;
-            metadataBlock->audioEndTime = currentItem->endTime;
-            metadataBlock->absoluteDistance = currentItemChannel->absoluteDistance;
-            metadataBlock->lowPass = currentItemChannel->lowPass;
-            metadataBlock->highPass = currentItemChannel->highPass;
-            strncpy(metadataBlock->name, currentItem->presentedName.c_str(), sizeof(metadataBlock->name));
-            strncpy(metadataBlock->audioPackFormatId, currentItemChannel->audioPackFormatId.c_str(), sizeof(metadataBlock->audioPackFormatId));
+    int64_t positionNs = (int64_t)(std::max(positionSec, 0.0) * 1000000000.0);
+    std::vector<int> cursors;
+    for(auto& renderableItem : validRenderableItems) {
+        getCursorsAt(renderableItem, positionNs, cursors);
+        setSentCursors(renderableItem, cursors);
+    }
 
-            int idCount = 0;
-            for(int i = 0; i < currentItem->admTrees.size(); i++) {
-                if(currentItem->admTrees[i].audioProgramme) {
-                    metadataBlock->audioProgrammeId[idCount] = currentItem->admTrees[i].audioProgrammeId;
-                    idCount++;
+    if(!lazyBlockFormats.empty()) {
+        // Windows restart from the earliest block any of their channels now needs, wherever they were - so nothing in between is parsed
+        std::map<LazyBlockFormats*, int> firstKeptIndices;
+        for(auto& renderableItem : validRenderableItems) {
+            for(auto& renderableItemChannelPair : renderableItem->renderableItemChannels) {
+                auto& renderableItemChannel = renderableItemChannelPair.second;
+                if(!renderableItemChannel->lazyBlockFormats) continue;
+                int firstKeptIndex = std::max(renderableItemChannel->lastSentBlockIndex, 0);
+                renderableItemChannel->blockTable.clear();
+                renderableItemChannel->blockTableFirstIndex = firstKeptIndex;
+                auto existing = firstKeptIndices.find(renderableItemChannel->lazyBlockFormats.get());
+                if(existing == firstKeptIndices.end()) {
+                    firstKeptIndices[renderableItemChannel->lazyBlockFormats.get()] = firstKeptIndex;
+                } else {
+                    existing->second = std::min(existing->second, firstKeptIndex);
                 }
             }
-            metadataBlock->audioProgrammeIdCount = idCount;
+        }
+        for(auto& firstKeptIndexPair : firstKeptIndices) {
+            firstKeptIndexPair.first->restartAt(firstKeptIndexPair.second);
+        }
+    }
 
-            idIndexOfLastRenderableItemSent = itemIdIndex;
-            return true;
+    setRenderPosition(positionSec);
+}
+
+void MetadataExtractor::getSentCursors(const std::shared_ptr<RenderableItem>& renderableItem, std::vector<int>& cursors)
+{
+    cursors.clear();
+    if(renderableItem->hasHoaTimeline) {
+        cursors.push_back(renderableItem->hoaTimelineLastSentIndex);
+        return;
+    }
+    for(auto& renderableItemChannelPair : renderableItem->renderableItemChannels) {
+        cursors.push_back(renderableItemChannelPair.second->lastSentBlockIndex);
+    }
+}
+
+void MetadataExtractor::setSentCursors(const std::shared_ptr<RenderableItem>& renderableItem, const std::vector<int>& cursors)
+{
+    if(renderableItem->hasHoaTimeline) {
+        renderableItem->hoaTimelineLastSentIndex = cursors[0];
+        return;
+    }
+    int channelIndex = 0;
+    for(auto& renderableItemChannelPair : renderableItem->renderableItemChannels) {
+        renderableItemChannelPair.second->lastSentBlockIndex = cursors[channelIndex++];
+    }
+}
+
+void MetadataExtractor::getCursorsAt(const std::shared_ptr<RenderableItem>& renderableItem, int64_t timeNs, std::vector<int>& cursors)
+{
+    // Each channel on its block in effect, except the one whose block started latest - left just before it, so that's the next block
+    //  (for HOA, the channels' blocks in effect then get combined in to it). Channels with nothing by timeNs start from their first block.
+    cursors.clear();
+    if(renderableItem->hasHoaTimeline) {
+        // Just before the entry in effect
+        extendHoaTimeline(renderableItem);
+        auto& timeline = renderableItem->hoaTimeline;
+        auto after = std::upper_bound(timeline.begin(), timeline.end(), timeNs, [](int64_t time, const HoaTimelineEntry& hoaTimelineEntry) {
+            return time < hoaTimelineEntry.rTimeNs;
+        });
+        cursors.push_back(std::max((int)(after - timeline.begin()) - 2, -1));
+        return;
+    }
+    int latestChannelIndex = -1;
+    int64_t latestRtimeNs = 0;
+    for(auto& renderableItemChannelPair : renderableItem->renderableItemChannels) {
+        auto& renderableItemChannel = renderableItemChannelPair.second;
+        int blockIndex = getBlockIndexAt(renderableItemChannel, timeNs);
+        if(blockIndex >= 0) {
+            int64_t rtimeNs = renderableItemChannel->lazyBlockFormats ? renderableItemChannel->lazyBlockFormats->getRtimeNs(blockIndex) : getChannelBlock(renderableItemChannel, blockIndex)->rTimeNs;
+            if(latestChannelIndex < 0 || rtimeNs > latestRtimeNs) {
+                latestChannelIndex = (int)cursors.size();
+                latestRtimeNs = rtimeNs;
+            }
+        }
+        cursors.push_back(blockIndex);
+    }
+    if(latestChannelIndex >= 0) {
+        cursors[latestChannelIndex]--;
+    }
+}
+
+int MetadataExtractor::getBlockIndexAt(const std::shared_ptr<RenderableItemChannel>& renderableItemChannel, int64_t timeNs)
+{
+    if(renderableItemChannel->lazyBlockFormats) {
+        return renderableItemChannel->lazyBlockFormats->getIndexAt(timeNs);
+    }
+    topUpBlockTable(renderableItemChannel);
+    auto& blockTable = renderableItemChannel->blockTable;
+    auto after = std::upper_bound(blockTable.begin(), blockTable.end(), timeNs, [](int64_t time, const ChannelBlock& channelBlock) {
+        return time < channelBlock.rTimeNs;
+    });
+    return renderableItemChannel->blockTableFirstIndex + (int)(after - blockTable.begin()) - 1;
+}
+
+uint64_t MetadataExtractor::getFlattenedBlockIndexAt(const FlattenedItem& item, double timeSec)
+{
+    // The block in effect at timeSec, or the first if none is yet - an item's flattened blocks are in rtime order
+    uint64_t low = 0;
+    uint64_t high = item.blockCount;
+    while(low < high) {
+        uint64_t middle = low + (high - low) / 2;
+        if(flattenedMetadata->getBlock(item, middle).rTime <= timeSec) {
+            low = middle + 1;
+        } else {
+            high = middle;
         }
+    }
+    return low > 0 ? low - 1 : 0;
+}
 
-    } while(itemIdIndex != checksFinalIndex);
+bool MetadataExtractor::populateNextBlock(MetadataBlock* metadataBlock, const std::shared_ptr<RenderableItem>& renderableItem, std::vector<int>& cursors, std::shared_ptr<RenderableItemChannel>& refItemChannel)
+{
+    if(renderableItem->typeDefinition == adm::TypeDefinition::OBJECTS || renderableItem->typeDefinition == adm::TypeDefinition::DIRECT_SPEAKERS) {
+        refItemChannel = renderableItem->renderableItemChannels.begin()->second; // Only single channel expected in this type of item
+        // Blocks waiting on this channel? (if lazy, only those in the window so far)
+        auto channelBlock = getChannelBlock(refItemChannel, cursors[0] + 1);
+        if(!channelBlock) return false;
+        cursors[0]++;
+        populateTypeSpecificMetadata(metadataBlock, *channelBlock, refItemChannel);
+
+    } else if(renderableItem->typeDefinition == adm::TypeDefinition::HOA && renderableItem->hasHoaTimeline) {
+        // Blocks may have arrived since it was last extended (S-ADM)
+        if(cursors[0] + 1 >= (int)renderableItem->hoaTimeline.size()) {
+            extendHoaTimeline(renderableItem);
+            if(cursors[0] + 1 >= (int)renderableItem->hoaTimeline.size()) return false;
+        }
+        cursors[0]++;
+        refItemChannel = renderableItem->renderableItemChannels.begin()->second; // Pack level values are common to its channels
+        populateHoaSpecificMetadata(metadataBlock, renderableItem->hoaTimeline[cursors[0]], renderableItem);
+
+    } else if(renderableItem->typeDefinition == adm::TypeDefinition::HOA) {
+
+        const ChannelBlock* nextEarliestBlock = nullptr;
+
+        int channelIndex = 0;
+        for(auto& renderableItemChannelPair : renderableItem->renderableItemChannels) {
+            // Blocks waiting on this channel? (if lazy, only those in the window so far)
+            auto hoaBlock = getChannelBlock(renderableItemChannelPair.second, cursors[channelIndex++] + 1);
+            if(hoaBlock) {
+                if(nextEarliestBlock == nullptr || hoaBlock->rTimeNs < nextEarliestBlock->rTimeNs) {
+                    nextEarliestBlock = hoaBlock;
+                    refItemChannel = renderableItemChannelPair.second;
+                }
+            }
+        }
 
-    // Didn't return early - no new blocks available
-    return false;
+        if(nextEarliestBlock == nullptr) return false;
+        populateHoaSpecificMetadata(metadataBlock, *nextEarliestBlock, renderableItem, cursors); // Also does advancing of cursors
+
+    } else {
+        // TODO - Binaural, which will work slightly differently.
+        return false;
+    }
+
+    return true;
+}
+
+void MetadataExtractor::populateCommonMetadata(MetadataBlock* metadataBlock, const std::shared_ptr<RenderableItem>& renderableItem, const std::shared_ptr<RenderableItemChannel>& refItemChannel)
+{
+    metadataBlock->id = renderableItem->selfId;
+    metadataBlock->typeDef = renderableItem->typeDefinition.get();
+    metadataBlock->audioStartTime = renderableItem->startTime;
+    metadataBlock->audioEndTime = renderableItem->endTime;
+    metadataBlock->absoluteDistance = refItemChannel->absoluteDistance;
+    metadataBlock->lowPass = refItemChannel->lowPass;
+    metadataBlock->highPass = refItemChannel->highPass;
+    strncpy(metadataBlock->name, renderableItem->presentedName.c_str(), sizeof(metadataBlock->name));
+    strncpy(metadataBlock->audioPackFormatId, refItemChannel->audioPackFormatId.c_str(), sizeof(metadataBlock->audioPackFormatId));
+
+    int idCount = 0;
+    for(int i = 0; i < renderableItem->admTrees.size(); i++) {
+        if(renderableItem->admTrees[i].audioProgramme) {
+            metadataBlock->audioProgrammeId[idCount] = renderableItem->admTrees[i].audioProgrammeId;
+            idCount++;
+        }
+    }
+    metadataBlock->audioProgrammeIdCount = idCount;
 }
 
 int MetadataExtractor::discoverViaAudioProgramme(std::shared_ptr<adm::AudioProgramme> audioProgramme) {
@@ -230,108 +949,409 @@ int MetadataExtractor::discoverViaAudioProgramme(std::shared_ptr<adm::AudioProgr
 
 int MetadataExtractor::discoverViaAudioContent(std::shared_ptr<adm::AudioProgramme> audioProgramme, std::shared_ptr<adm::AudioContent> audioContent) {
     int newCount = 0;
+    std::vector<std::shared_ptr<adm::AudioObject>> audioObjectTree;
     auto audioObjects = audioContent->getReferences<adm::AudioObject>();
     for(auto audioObject : audioObjects) {
-        newCount += discoverViaAudioObject(audioProgramme, audioContent, std::vector<std::shared_ptr<adm::AudioObject>>{audioObject});
+        audioObjectTree.assign(1, audioObject);
+        newCount += discoverViaAudioObject(audioProgramme, audioContent, audioObjectTree);
     }
     return newCount;
 }
 
-int MetadataExtractor::discoverViaAudioObject(std::shared_ptr<adm::AudioProgramme> audioProgramme, std::shared_ptr<adm::AudioContent> audioContent, std::vector<std::shared_ptr<adm::AudioObject>> audioObjectTree) {
+int MetadataExtractor::discoverViaAudioObject(std::shared_ptr<adm::AudioProgramme> audioProgramme, std::shared_ptr<adm::AudioContent> audioContent, std::vector<std::shared_ptr<adm::AudioObject>>& audioObjectTree) {
     int newCount = 0;
     assert(audioObjectTree.size() > 0); // Must have at least one AudioObject to call this method
-    auto nestedAudioObjects = audioObjectTree.back()->getReferences<adm::AudioObject>();
+    auto audioObject = audioObjectTree.back();
+    auto nestedAudioObjects = audioObject->getReferences<adm::AudioObject>();
     for(auto nestedAudioObject : nestedAudioObjects) {
-        auto newTree = audioObjectTree;
-        newTree.push_back(nestedAudioObject);
-        newCount += discoverViaAudioObject(audioProgramme, audioContent, newTree);
+        // Extended for the nested object's walk, then put back
+        audioObjectTree.push_back(nestedAudioObject);
+        newCount += discoverViaAudioObject(audioProgramme, audioContent, audioObjectTree);
+        audioObjectTree.pop_back();
     }
-    auto audioTrackUids = audioObjectTree.back()->getReferences<adm::AudioTrackUid>();
+    auto audioTrackUids = audioObject->getReferences<adm::AudioTrackUid>();
     for(auto audioTrackUid : audioTrackUids) {
         newCount += discoverFromAudioTrackUid(audioProgramme, audioContent, audioObjectTree, audioTrackUid);
     }
     return newCount;
 }
 
-int MetadataExtractor::discoverFromAudioTrackUid(std::shared_ptr<adm::AudioProgramme> audioProgramme, std::shared_ptr<adm::AudioContent> audioContent, std::vector<std::shared_ptr<adm::AudioObject>> audioObjectTree, std::shared_ptr<adm::AudioTrackUid> audioTrackUid) {
+void MetadataExtractor::getPathsTo(const std::shared_ptr<adm::AudioObject>& audioObject, std::vector<DiscoveryPath>& paths)
+{
+    // Unordered - see discoverViaAddedReferences
+    auto parentAudioObjects = getValuePointerFromMap(audioObjectParentObjects, audioObject.get());
+    if(parentAudioObjects) {
+        for(auto& parentAudioObject : *parentAudioObjects) {
+            size_t firstPathIndex = paths.size();
+            getPathsTo(parentAudioObject, paths);
+            for(size_t pathIndex = firstPathIndex; pathIndex < paths.size(); pathIndex++) {
+                paths[pathIndex].audioObjectTree.push_back(audioObject);
+            }
+        }
+    }
+    auto parentAudioContents = getValuePointerFromMap(audioObjectParentContents, audioObject.get());
+    if(parentAudioContents) {
+        for(auto& parentAudioContent : *parentAudioContents) {
+            auto parentAudioProgrammes = getValuePointerFromMap(audioContentParents, parentAudioContent.get());
+            if(parentAudioProgrammes) {
+                for(auto& parentAudioProgramme : *parentAudioProgrammes) {
+                    paths.push_back(DiscoveryPath{ parentAudioProgramme, parentAudioContent, { audioObject } });
+                }
+            }
+            paths.push_back(DiscoveryPath{ nullptr, parentAudioContent, { audioObject } });
+        }
+    }
+    paths.push_back(DiscoveryPath{ nullptr, nullptr, { audioObject } });
+}
+
+int MetadataExtractor::discoverViaAddedReferences()
+{
+    // The paths through a new reference are those already leading to its parent, continued through it.
+    // (Those leading to it through other new references or elements are walked from them instead.)
+    // Marked elements not walked yet are new - they're walked whole as roots.
+    int newCount = 0;
 
-    RenderableItemChannelId id = generateRenderableItemId(audioObjectTree.size() > 0? audioObjectTree.back() : nullptr, audioTrackUid);
-    std::shared_ptr<RenderableItemChannel> renderableItemChannel;
-    bool newRenderableItemCreated = false;
+    for(auto& audioProgramme : markedAudioProgrammes) {
+        auto walked = getValuePointerFromMap(walkedAudioProgrammes, audioProgramme.get());
+        if(!walked) continue;
+        auto audioContents = audioProgramme->getReferences<adm::AudioContent>();
+        for(auto audioContent = std::next(audioContents.begin(), std::min(walked->audioContents, audioContents.size())); audioContent != audioContents.end(); audioContent++) {
+            newCount += discoverViaAudioContent(audioProgramme, *audioContent);
+        }
+    }
 
-    // Firstly check if we already have it!
-    auto existing = getValuePointerFromMap(renderableItemChannels, id);
-    if(existing) {
+    std::vector<std::shared_ptr<adm::AudioObject>> audioObjectTree;
+    for(auto& audioContent : markedAudioContents) {
+        auto walked = getValuePointerFromMap(walkedAudioContents, audioContent.get());
+        if(!walked) continue;
+        auto audioObjects = audioContent->getReferences<adm::AudioObject>();
+        auto parentAudioProgrammes = getValuePointerFromMap(audioContentParents, audioContent.get());
+        for(auto audioObject = std::next(audioObjects.begin(), std::min(walked->audioObjects, audioObjects.size())); audioObject != audioObjects.end(); audioObject++) {
+            if(parentAudioProgrammes) {
+                for(auto& parentAudioProgramme : *parentAudioProgrammes) {
+                    audioObjectTree.assign(1, *audioObject);
+                    newCount += discoverViaAudioObject(parentAudioProgramme, audioContent, audioObjectTree);
+                }
+            }
+            audioObjectTree.assign(1, *audioObject);
+            newCount += discoverViaAudioObject(nullptr, audioContent, audioObjectTree);
+        }
+    }
 
-        renderableItemChannel = *existing;
+    std::vector<DiscoveryPath> paths;
+    for(auto& audioObject : markedAudioObjects) {
+        auto walked = getValuePointerFromMap(walkedAudioObjects, audioObject.get());
+        if(!walked) continue;
+        auto nestedAudioObjects = audioObject->getReferences<adm::AudioObject>();
+        auto audioTrackUids = audioObject->getReferences<adm::AudioTrackUid>();
+        if(nestedAudioObjects.size() <= walked->audioObjects && audioTrackUids.size() <= walked->audioTrackUids) continue;
+
+        // In the order a full walk would reach them, so the first path to a channel is the one it's created from, as before
+        paths.clear();
+        getPathsTo(audioObject, paths);
+        std::stable_sort(paths.begin(), paths.end(), [](const DiscoveryPath& a, const DiscoveryPath& b) {
+            return (a.audioProgramme ? 0 : a.audioContent ? 1 : 2) < (b.audioProgramme ? 0 : b.audioContent ? 1 : 2);
+        });
+
+        for(auto& path : paths) {
+            for(auto nestedAudioObject = std::next(nestedAudioObjects.begin(), std::min(walked->audioObjects, nestedAudioObjects.size())); nestedAudioObject != nestedAudioObjects.end(); nestedAudioObject++) {
+                path.audioObjectTree.push_back(*nestedAudioObject);
+                newCount += discoverViaAudioObject(path.audioProgramme, path.audioContent, path.audioObjectTree);
+                path.audioObjectTree.pop_back();
+            }
+            for(auto audioTrackUid = std::next(audioTrackUids.begin(), std::min(walked->audioTrackUids, audioTrackUids.size())); audioTrackUid != audioTrackUids.end(); audioTrackUid++) {
+                newCount += discoverFromAudioTrackUid(path.audioProgramme, path.audioContent, path.audioObjectTree, *audioTrackUid);
+            }
+        }
+    }
 
-    } else {
+    return newCount;
+}
 
-        // Create it
-        renderableItemChannel = std::make_shared<RenderableItemChannel>();
-        renderableItemChannel->selfId = id;
-        renderableItemChannel->typeDefinition = adm::TypeDefinition::UNDEFINED;
-        renderableItemChannel->renderableItem.reset();
+int MetadataExtractor::discoverViaAddedElements()
+{
+    int newCount = 0;
 
-        renderableItemChannel->valid = true;
-        renderableItemChannel->channelNum = parentReader->getChannelNumFor(audioTrackUid);
-        renderableItemChannel->lastSentBlockIndex = -1; // No blocks pulled yet
+    auto audioProgrammes = parsedDocument->getElements<adm::AudioProgramme>();
+    for(auto audioProgramme = std::next(audioProgrammes.begin(), walkedAudioProgrammeCount); audioProgramme != audioProgrammes.end(); audioProgramme++) {
+        newCount += discoverViaAudioProgramme(*audioProgramme);
+    }
 
-        renderableItemChannel->audioTrackUid = audioTrackUid;
-        renderableItemChannel->audioChannelFormat = nullptr;
-        renderableItemChannel->audioStreamFormat = nullptr;
-        renderableItemChannel->audioTrackFormat = audioTrackUid->getReference<adm::AudioTrackFormat>();
-        renderableItemChannel->audioPackFormatTree = std::vector<std::shared_ptr<adm::AudioPackFormat>>();
-        renderableItemChannel->audioPackFormatId = "";
+    auto audioContents = parsedDocument->getElements<adm::AudioContent>(); // May not have parent programme
+    for(auto audioContent = std::next(audioContents.begin(), walkedAudioContentCount); audioContent != audioContents.end(); audioContent++) {
+        newCount += discoverViaAudioContent(nullptr, *audioContent);
+    }
 
-        renderableItemChannel->highPass = NAN;
-        renderableItemChannel->lowPass = NAN;
-        renderableItemChannel->absoluteDistance = NAN;
+    std::vector<std::shared_ptr<adm::AudioObject>> audioObjectTree;
+    auto audioObjects = parsedDocument->getElements<adm::AudioObject>(); // May not have parent content
+    for(auto audioObject = std::next(audioObjects.begin(), walkedAudioObjectCount); audioObject != audioObjects.end(); audioObject++) {
+        audioObjectTree.assign(1, *audioObject);
+        newCount += discoverViaAudioObject(nullptr, nullptr, audioObjectTree);
+    }
 
+    // Strays - add anyway to prevent constantly running this method trying to discover who they belong to
+    audioObjectTree.clear();
+    auto audioTrackUids = parsedDocument->getElements<adm::AudioTrackUid>();
+    for(auto audioTrackUid = std::next(audioTrackUids.begin(), walkedAudioTrackUidCount); audioTrackUid != audioTrackUids.end(); audioTrackUid++) {
+        newCount += discoverFromAudioTrackUid(nullptr, nullptr, audioObjectTree, *audioTrackUid);
+    }
 
-        // We need to get to PF/CF to discover TD and work out if we need to create a new RenderableItem...
-        //  Do that first because if we reuse existing, we can omit loads of look-ups
+    return newCount;
+}
 
-        if(renderableItemChannel->audioTrackFormat) {
-            renderableItemChannel->audioStreamFormat = renderableItemChannel->audioTrackFormat->getReference<adm::AudioStreamFormat>();
+namespace {
+    // Records the references from the element past those already walked - noting the element as their parent - and how many it now has
+    template<typename ReferenceT, typename ElementT, typename ParentsT>
+    void recordReferences(const std::shared_ptr<ElementT>& element, size_t& walkedCount, ParentsT& parents)
+    {
+        auto references = element->template getReferences<ReferenceT>();
+        for(auto reference = std::next(references.begin(), std::min(walkedCount, references.size())); reference != references.end(); reference++) {
+            parents[reference->get()].push_back(element);
         }
+        walkedCount = references.size();
+    }
 
-        if(renderableItemChannel->audioStreamFormat) {
-            renderableItemChannel->audioChannelFormat = renderableItemChannel->audioStreamFormat->getReference<adm::AudioChannelFormat>();
-            if(renderableItemChannel->audioChannelFormat->has<adm::Frequency>()) {
-                auto freq = renderableItemChannel->audioChannelFormat->get<adm::Frequency>();
-                if(freq.has<adm::LowPass>()) {
-                    renderableItemChannel->lowPass = freq.get<adm::LowPass>().get();
-                }
-                if(freq.has<adm::HighPass>()) {
-                    renderableItemChannel->highPass = freq.get<adm::HighPass>().get();
+    template<typename ElementT>
+    void addMark(std::vector<std::shared_ptr<ElementT>>& marked, const std::shared_ptr<ElementT>& element)
+    {
+        if(std::find(marked.begin(), marked.end(), element) == marked.end()) marked.push_back(element);
+    }
+}
+
+void MetadataExtractor::markReferencesAdded(const std::shared_ptr<adm::AudioProgramme>& audioProgramme)
+{
+    addMark(markedAudioProgrammes, audioProgramme);
+}
+
+void MetadataExtractor::markReferencesAdded(const std::shared_ptr<adm::AudioContent>& audioContent)
+{
+    addMark(markedAudioContents, audioContent);
+}
+
+void MetadataExtractor::markReferencesAdded(const std::shared_ptr<adm::AudioObject>& audioObject)
+{
+    addMark(markedAudioObjects, audioObject);
+}
+
+void MetadataExtractor::recordWalkedReferences()
+{
+    // Marked elements walked before, then those added since - only they can have references not recorded yet
+    for(auto& audioProgramme : markedAudioProgrammes) {
+        auto walked = getValuePointerFromMap(walkedAudioProgrammes, audioProgramme.get());
+        if(walked) recordReferences<adm::AudioContent>(audioProgramme, walked->audioContents, audioContentParents);
+    }
+    auto audioProgrammes = parsedDocument->getElements<adm::AudioProgramme>();
+    for(auto audioProgramme = std::next(audioProgrammes.begin(), walkedAudioProgrammeCount); audioProgramme != audioProgrammes.end(); audioProgramme++) {
+        recordReferences<adm::AudioContent>(*audioProgramme, walkedAudioProgrammes[audioProgramme->get()].audioContents, audioContentParents);
+    }
+    walkedAudioProgrammeCount = audioProgrammes.size();
+
+    for(auto& audioContent : markedAudioContents) {
+        auto walked = getValuePointerFromMap(walkedAudioContents, audioContent.get());
+        if(walked) recordReferences<adm::AudioObject>(audioContent, walked->audioObjects, audioObjectParentContents);
+    }
+    auto audioContents = parsedDocument->getElements<adm::AudioContent>();
+    for(auto audioContent = std::next(audioContents.begin(), walkedAudioContentCount); audioContent != audioContents.end(); audioContent++) {
+        recordReferences<adm::AudioObject>(*audioContent, walkedAudioContents[audioContent->get()].audioObjects, audioObjectParentContents);
+    }
+    walkedAudioContentCount = audioContents.size();
+
+    auto recordObject = [this](const std::shared_ptr<adm::AudioObject>& audioObject, WalkedReferenceCounts& walked) {
+        recordReferences<adm::AudioObject>(audioObject, walked.audioObjects, audioObjectParentObjects);
+        walked.audioTrackUids = audioObject->getReferences<adm::AudioTrackUid>().size();
+    };
+    for(auto& audioObject : markedAudioObjects) {
+        auto walked = getValuePointerFromMap(walkedAudioObjects, audioObject.get());
+        if(walked) recordObject(audioObject, *walked);
+    }
+    auto audioObjects = parsedDocument->getElements<adm::AudioObject>();
+    for(auto audioObject = std::next(audioObjects.begin(), walkedAudioObjectCount); audioObject != audioObjects.end(); audioObject++) {
+        recordObject(*audioObject, walkedAudioObjects[audioObject->get()]);
+    }
+    walkedAudioObjectCount = audioObjects.size();
+
+    walkedAudioTrackUidCount = parsedDocument->getElements<adm::AudioTrackUid>().size();
+
+    markedAudioProgrammes.clear();
+    markedAudioContents.clear();
+    markedAudioObjects.clear();
+}
+
+void MetadataExtractor::setDiscoveryThreadCount(int threadCount)
+{
+    discoveryThreadCount = std::max(threadCount, 0);
+    if(discoveryThreadCount == 1) {
+        discoveryWorkers.reset(); // Discovering on the calling thread alone from now on - any other count restarts them as needed
+    }
+}
+
+void MetadataExtractor::createNewChannels()
+{
+    // Each thread takes the next run of channels still to do. They're kept in the order noted, so which thread created which doesn't matter.
+    const size_t channelsPerRun = 16;
+    size_t threadCount = discoveryThreadCount > 0 ? (size_t)discoveryThreadCount : std::max(std::thread::hardware_concurrency(), 1u);
+    if(!discoveryWorkers || discoveryWorkers->getWorkerCount() != threadCount - 1) {
+        discoveryWorkers.reset();
+        try {
+            discoveryWorkers = std::make_unique<DiscoveryWorkers>(threadCount - 1); // This thread is one of them
+        } catch(std::system_error &e) {
+            // Couldn't start them - the calling thread creates them all instead
+            getExceptionHandler()->logException(std::string("Unable to start discovery threads: ") + e.what());
+        }
+    }
+
+    std::vector<std::shared_ptr<RenderableItemChannel>> created(newChannels.size());
+    std::atomic<size_t> nextRun{ 0 };
+    std::function<void()> createRuns = [&]() {
+        try {
+            while(true) {
+                size_t first = nextRun.fetch_add(channelsPerRun);
+                if(first >= newChannels.size()) return;
+                size_t end = std::min(first + channelsPerRun, newChannels.size());
+                for(size_t index = first; index < end; index++) {
+                    created[index] = createRenderableItemChannel(newChannels[index].id, newChannels[index].audioObject, newChannels[index].audioTrackUid);
                 }
             }
+        } catch(...) {
+            nextRun = newChannels.size(); // Stop the others taking more
+            throw;
         }
+    };
 
-        if(audioObjectTree.size() > 0 && renderableItemChannel->audioChannelFormat) {
-            auto pfs = audioObjectTree.back()->getReferences<adm::AudioPackFormat>();
-            for(auto pf : pfs) {
-                auto res = tracePackFormatTree(pf, renderableItemChannel->audioChannelFormat);
-                if(res.has_value() && res->size() > 0) {
-                    renderableItemChannel->audioPackFormatTree = *res;
-                    break;
-                }
+    try {
+        if(discoveryWorkers) {
+            discoveryWorkers->run(createRuns);
+        } else {
+            createRuns();
+        }
+    } catch(...) {
+        // As the serial walk would have thrown - leave nothing noted for the next discovery to trip over
+        newChannels.clear();
+        createdChannels.clear();
+        throw;
+    }
+
+    for(size_t index = 0; index < newChannels.size(); index++) {
+        setInMap(createdChannels, newChannels[index].id, created[index]);
+    }
+    newChannels.clear();
+}
+
+std::shared_ptr<RenderableItemChannel> MetadataExtractor::createRenderableItemChannel(RenderableItemChannelId id, std::shared_ptr<adm::AudioObject> audioObject, std::shared_ptr<adm::AudioTrackUid> audioTrackUid)
+{
+    auto renderableItemChannel = std::make_shared<RenderableItemChannel>();
+    renderableItemChannel->selfId = id;
+    renderableItemChannel->typeDefinition = adm::TypeDefinition::UNDEFINED;
+    renderableItemChannel->renderableItem.reset();
+
+    renderableItemChannel->valid = true;
+    renderableItemChannel->channelNum = parentReader->getChannelNumFor(audioTrackUid);
+    renderableItemChannel->lastSentBlockIndex = -1; // No blocks pulled yet
+
+    renderableItemChannel->audioTrackUid = audioTrackUid;
+    renderableItemChannel->audioChannelFormat = nullptr;
+    renderableItemChannel->audioStreamFormat = nullptr;
+    renderableItemChannel->audioTrackFormat = audioTrackUid->getReference<adm::AudioTrackFormat>();
+    renderableItemChannel->lazyBlockFormats = nullptr;
+    renderableItemChannel->blockTableFirstIndex = 0;
+    renderableItemChannel->audioPackFormatTree = std::vector<std::shared_ptr<adm::AudioPackFormat>>();
+    renderableItemChannel->audioPackFormatId = "";
+
+    renderableItemChannel->highPass = NAN;
+    renderableItemChannel->lowPass = NAN;
+    renderableItemChannel->absoluteDistance = NAN;
+
+
+    // We need to get to PF/CF to discover TD and work out if we need to create a new RenderableItem...
+    //  Do that first because if we reuse existing, we can omit loads of look-ups
+
+    if(renderableItemChannel->audioTrackFormat) {
+        renderableItemChannel->audioStreamFormat = renderableItemChannel->audioTrackFormat->getReference<adm::AudioStreamFormat>();
+    }
+
+    if(renderableItemChannel->audioStreamFormat) {
+        renderableItemChannel->audioChannelFormat = renderableItemChannel->audioStreamFormat->getReference<adm::AudioChannelFormat>();
+        if(renderableItemChannel->audioChannelFormat) {
+            auto lazy = getValuePointerFromMap(lazyBlockFormats, adm::formatId(renderableItemChannel->audioChannelFormat->get<adm::AudioChannelFormatId>()));
+            if(lazy) {
+                renderableItemChannel->lazyBlockFormats = *lazy;
             }
         }
+        if(renderableItemChannel->audioChannelFormat->has<adm::Frequency>()) {
+            auto freq = renderableItemChannel->audioChannelFormat->get<adm::Frequency>();
+            if(freq.has<adm::LowPass>()) {
+                renderableItemChannel->lowPass = freq.get<adm::LowPass>().get();
+            }
+            if(freq.has<adm::HighPass>()) {
+                renderableItemChannel->highPass = freq.get<adm::HighPass>().get();
+            }
+        }
+    }
 
-        if(renderableItemChannel->audioPackFormatTree.size() > 0) {
-            renderableItemChannel->audioPackFormatId = formatId(renderableItemChannel->audioPackFormatTree.back()->get<adm::AudioPackFormatId>());
-            if(renderableItemChannel->audioPackFormatTree.back()->has<adm::AbsoluteDistance>()) {
-                renderableItemChannel->absoluteDistance = renderableItemChannel->audioPackFormatTree.back()->get<adm::AbsoluteDistance>().get();
+    if(audioObject && renderableItemChannel->audioChannelFormat) {
+        auto pfs = audioObject->getReferences<adm::AudioPackFormat>();
+        for(auto pf : pfs) {
+            auto res = tracePackFormatTree(pf, renderableItemChannel->audioChannelFormat);
+            if(res.has_value() && res->size() > 0) {
+                renderableItemChannel->audioPackFormatTree = *res;
+                break;
             }
-            renderableItemChannel->typeDefinition = renderableItemChannel->audioPackFormatTree.back()->get<adm::TypeDescriptor>();
-        } else {
-            renderableItemChannel->valid = false;
         }
+    }
 
-        if(renderableItemChannel->channelNum < 0 || !renderableItemChannel->audioChannelFormat) {
-            renderableItemChannel->valid = false;
+    if(renderableItemChannel->audioPackFormatTree.size() > 0) {
+        renderableItemChannel->audioPackFormatId = formatId(renderableItemChannel->audioPackFormatTree.back()->get<adm::AudioPackFormatId>());
+        if(renderableItemChannel->audioPackFormatTree.back()->has<adm::AbsoluteDistance>()) {
+            renderableItemChannel->absoluteDistance = renderableItemChannel->audioPackFormatTree.back()->get<adm::AbsoluteDistance>().get();
+        }
+        renderableItemChannel->typeDefinition = renderableItemChannel->audioPackFormatTree.back()->get<adm::TypeDescriptor>();
+    } else {
+        renderableItemChannel->valid = false;
+    }
+
+    if(renderableItemChannel->channelNum < 0 || !renderableItemChannel->audioChannelFormat) {
+        renderableItemChannel->valid = false;
+    }
+
+    return renderableItemChannel;
+}
+
+int MetadataExtractor::discoverFromAudioTrackUid(std::shared_ptr<adm::AudioProgramme> audioProgramme, std::shared_ptr<adm::AudioContent> audioContent, const std::vector<std::shared_ptr<adm::AudioObject>>& audioObjectTree, std::shared_ptr<adm::AudioTrackUid> audioTrackUid) {
+
+    auto audioObject = audioObjectTree.size() > 0? audioObjectTree.back() : nullptr;
+    RenderableItemChannelId id = generateRenderableItemId(audioObject, audioTrackUid);
+    std::shared_ptr<RenderableItemChannel> renderableItemChannel;
+    bool newRenderableItemCreated = false;
+
+    // Firstly check if we already have it!
+    auto existing = getValuePointerFromMap(renderableItemChannels, id);
+    if(existing) {
+
+        renderableItemChannel = *existing;
+
+    } else if(notingNewChannels) {
+
+        // Just note it, the first time it's reached - it's created and registered later (see createNewChannels)
+        if(!getValuePointerFromMap(createdChannels, id)) {
+            setInMap(createdChannels, id, std::shared_ptr<RenderableItemChannel>());
+            newChannels.push_back({ id, audioObject, audioTrackUid });
+        }
+        return 0;
+
+    } else {
+
+        // Create it - unless it already has been, across the discovery threads
+        auto created = getValuePointerFromMap(createdChannels, id);
+        if(created && *created) {
+            renderableItemChannel = *created;
+            createdChannels.erase(id);
+        } else {
+            renderableItemChannel = createRenderableItemChannel(id, audioObject, audioTrackUid);
+        }
+        // Convert its blocks now, rather than as each is pulled (lazy channels have none materialised yet, so are converted as they are).
+        //  Here rather than when created, so only ever on this thread.
+        if(renderableItemChannel->valid) {
+            topUpBlockTable(renderableItemChannel);
         }
 
         // Register new RenderableItemChannel
@@ -471,152 +1491,152 @@ std::optional<std::vector<std::shared_ptr<adm::AudioPackFormat>>> MetadataExtrac
     return std::optional<std::vector<std::shared_ptr<adm::AudioPackFormat>>>();
 }
 
-void MetadataExtractor::populateTypeSpecificMetadata(MetadataBlock * metadataBlock, adm::AudioBlockFormatObjects * audioBlockFormat, std::shared_ptr<RenderableItemChannel> renderableItemChannel)
+void MetadataExtractor::populateTypeSpecificMetadata(MetadataBlock * metadataBlock, const ChannelBlock& channelBlock, std::shared_ptr<RenderableItemChannel> renderableItemChannel)
 {
     metadataBlock->channelCount = 1;
     metadataBlock->channelNums[0] = renderableItemChannel->channelNum;
 
-    metadataBlock->rTime = 0.0;
-    if(audioBlockFormat->has<adm::Rtime>()) {
-        metadataBlock->rTime = audioBlockFormat->get<adm::Rtime>().get().count() / 1000000000.0;
-    }
-    metadataBlock->duration = INFINITY;
-    if(audioBlockFormat->has<adm::Duration>()) {
-        metadataBlock->duration = audioBlockFormat->get<adm::Duration>().get().count() / 1000000000.0;
-    }
-    metadataBlock->jumpPosition = false;
-    if(audioBlockFormat->has<adm::JumpPosition>()){
-        auto jumpPosition = audioBlockFormat->get<adm::JumpPosition>();
-        if(jumpPosition.has<adm::JumpPositionFlag>() && jumpPosition.get<adm::JumpPositionFlag>().get()){
-            metadataBlock->jumpPosition = true;
-            metadataBlock->interpolationLength = 0.0; // Contradiction in BS.2076. Supposed to default to block duration, but that would not create the instant jump behaviour
-            if(jumpPosition.has<adm::InterpolationLength>()) {
-                metadataBlock->interpolationLength = jumpPosition.get<adm::InterpolationLength>().get().count() / 1000000000.0;
-            }
+    metadataBlock->rTime = channelBlock.rTime;
+    metadataBlock->duration = channelBlock.duration;
+    metadataBlock->jumpPosition = channelBlock.jumpPosition;
+    metadataBlock->interpolationLength = channelBlock.interpolationLength;
+    metadataBlock->cartesian = channelBlock.cartesian;
+    metadataBlock->x = channelBlock.x;
+    metadataBlock->y = channelBlock.y;
+    metadataBlock->z = channelBlock.z;
+    metadataBlock->azimuth = channelBlock.azimuth;
+    metadataBlock->elevation = channelBlock.elevation;
+    metadataBlock->distance = channelBlock.distance;
+    metadataBlock->width = channelBlock.width;
+    metadataBlock->height = channelBlock.height;
+    metadataBlock->depth = channelBlock.depth;
+    metadataBlock->gain = channelBlock.gain;
+    metadataBlock->diffuse = channelBlock.diffuse;
+    metadataBlock->divergence = channelBlock.divergence;
+    metadataBlock->divergenceAzimuthRange = channelBlock.divergenceAzimuthRange;
+    metadataBlock->divergencePositionRange = channelBlock.divergencePositionRange;
+    metadataBlock->channelLock = channelBlock.channelLock;
+    metadataBlock->channelLockMaxDistance = channelBlock.channelLockMaxDistance;
+    metadataBlock->screenRef = channelBlock.screenRef;
+    memcpy(metadataBlock->speakerLabel, channelBlock.speakerLabel, sizeof(metadataBlock->speakerLabel));
+}
+
+void MetadataExtractor::populateHoaSpecificMetadata(MetadataBlock* metadataBlock, const HoaTimelineEntry& hoaTimelineEntry, std::shared_ptr<RenderableItem> renderableItem)
+{
+    // As the per-channel version below, already resolved
+    metadataBlock->rTime = hoaTimelineEntry.rTime;
+    metadataBlock->duration = hoaTimelineEntry.duration;
+
+    metadataBlock->channelCount = hoaTimelineEntry.channelCount;
+
+    metadataBlock->gain = 1.0; // Gain is a common block param, but not available for DS in libadm
+
+    metadataBlock->cartesian = false;
+    metadataBlock->x = 0.0;
+    metadataBlock->y = 0.0;
+    metadataBlock->z = 0.0;
+    metadataBlock->azimuth = 0.0;
+    metadataBlock->elevation = 0.0;
+    metadataBlock->distance = 0.0;
+
+    metadataBlock->screenRef = hoaTimelineEntry.screenRef;
+    memcpy(metadataBlock->normalisation, hoaTimelineEntry.normalisation, sizeof(metadataBlock->normalisation));
+    metadataBlock->nfcRefDist = hoaTimelineEntry.nfcRefDist;
+
+    memcpy(metadataBlock->channelNums, hoaTimelineEntry.channelNums, sizeof(metadataBlock->channelNums));
+    memcpy(metadataBlock->order, hoaTimelineEntry.order, sizeof(metadataBlock->order));
+    memcpy(metadataBlock->degree, hoaTimelineEntry.degree, sizeof(metadataBlock->degree));
+}
+
+void MetadataExtractor::extendHoaTimeline(const std::shared_ptr<RenderableItem>& renderableItem)
+{
+    if(renderableItem->typeDefinition != adm::TypeDefinition::HOA) return;
+
+    auto& timeline = renderableItem->hoaTimeline;
+    auto& channelIndices = renderableItem->hoaTimelineChannelIndices;
+
+    if(channelIndices.size() != renderableItem->renderableItemChannels.size()) {
+        // Lazy windows drop blocks as they pass, so those items are still combined from their channels as each block is sent
+        for(auto& renderableItemChannelPair : renderableItem->renderableItemChannels) {
+            if(renderableItemChannelPair.second->lazyBlockFormats) return;
         }
-    }
-    if(audioBlockFormat->has<adm::CartesianPosition>())
-    {
-        metadataBlock->cartesian = true;
-        auto position = audioBlockFormat->get<adm::CartesianPosition>();
-        metadataBlock->x = position.get<adm::X>().get();
-        metadataBlock->y = position.get<adm::Y>().get();
-        metadataBlock->z = position.get<adm::Z>().get();
-    }
-    else if(audioBlockFormat->has<adm::SphericalPosition>())
-    {
-        metadataBlock->cartesian = false;
-        auto position = audioBlockFormat->get<adm::SphericalPosition>();
-        metadataBlock->azimuth = position.get<adm::Azimuth>().get();
-        metadataBlock->elevation = position.get<adm::Elevation>().get();
-        metadataBlock->distance = 1.0;
-        if(position.has<adm::Distance>()){
-            metadataBlock->distance = position.get<adm::Distance>().get();
+        bool resuming = renderableItem->hasHoaTimeline && renderableItem->hoaTimelineLastSentIndex >= 0;
+        int64_t lastSentRtimeNs = resuming ? timeline[renderableItem->hoaTimelineLastSentIndex].rTimeNs : 0;
+        timeline.clear();
+        channelIndices.assign(renderableItem->renderableItemChannels.size(), -1);
+        renderableItem->hasHoaTimeline = true;
+        renderableItem->hoaTimelineLastSentIndex = -1;
+        extendHoaTimeline(renderableItem);
+        if(resuming) {
+            auto after = std::upper_bound(timeline.begin(), timeline.end(), lastSentRtimeNs, [](int64_t time, const HoaTimelineEntry& hoaTimelineEntry) {
+                return time < hoaTimelineEntry.rTimeNs;
+            });
+            renderableItem->hoaTimelineLastSentIndex = (int)(after - timeline.begin()) - 1;
         }
-    } else {
-        assert(false); // Should always have one or the other!
-    }
-    metadataBlock->width = 0.0;
-    if(audioBlockFormat->has<adm::Width>()) {
-        metadataBlock->width = audioBlockFormat->get<adm::Width>().get();
-    }
-    metadataBlock->height = 0.0;
-    if(audioBlockFormat->has<adm::Height>()) {
-        metadataBlock->height = audioBlockFormat->get<adm::Height>().get();
-    }
-    metadataBlock->depth = 0.0;
-    if(audioBlockFormat->has<adm::Depth>()) {
-        metadataBlock->depth = audioBlockFormat->get<adm::Depth>().get();
+        return;
     }
-    metadataBlock->gain = 1.0;
-    if(audioBlockFormat->has<adm::Gain>()) {
-        metadataBlock->gain = audioBlockFormat->get<adm::Gain>().get();
-    }
-    metadataBlock->diffuse = 0.0;
-    if(audioBlockFormat->has<adm::Diffuse>()) {
-        metadataBlock->diffuse = audioBlockFormat->get<adm::Diffuse>().get();
-    }
-    metadataBlock->divergence = 0.0;
-    metadataBlock->divergenceAzimuthRange = 0.0;
-    metadataBlock->divergencePositionRange = 0.0;
-    if(audioBlockFormat->has<adm::ObjectDivergence>()) {
-        auto objectDivergence = audioBlockFormat->get<adm::ObjectDivergence>();
-        if(objectDivergence.has<adm::Divergence>()) {
-            metadataBlock->divergence = objectDivergence.get<adm::Divergence>().get();
-        }
-        if(objectDivergence.has<adm::AzimuthRange>()) {
-            metadataBlock->divergenceAzimuthRange = objectDivergence.get<adm::AzimuthRange>().get();
-        }
-        if(objectDivergence.has<adm::PositionRange>()) {
-            metadataBlock->divergencePositionRange = objectDivergence.get<adm::PositionRange>().get();
+
+    while(true) {
+        // The earliest block of any channel not merged in yet starts the next entry, and that block's values are the entry's
+        //  (essentially assuming the same values in all blocks in all channelformats of this hoa pack).
+        // Looking past the end of a channel tops up its table, so hold indices rather than pointers in to it.
+        HoaTimelineEntry hoaTimelineEntry{};
+        bool haveNext = false;
+        int channelIndex = 0;
+        for(auto& renderableItemChannelPair : renderableItem->renderableItemChannels) {
+            auto hoaBlock = getChannelBlock(renderableItemChannelPair.second, channelIndices[channelIndex++] + 1);
+            if(hoaBlock && (!haveNext || hoaBlock->rTimeNs < hoaTimelineEntry.rTimeNs)) {
+                haveNext = true;
+                hoaTimelineEntry.rTimeNs = hoaBlock->rTimeNs;
+                hoaTimelineEntry.rTime = hoaBlock->rTime;
+                hoaTimelineEntry.screenRef = hoaBlock->screenRef;
+                memcpy(hoaTimelineEntry.normalisation, hoaBlock->normalisation, sizeof(hoaTimelineEntry.normalisation));
+                hoaTimelineEntry.nfcRefDist = hoaBlock->nfcRefDist;
+            }
         }
-    }
-    metadataBlock->channelLock = false;
-    if(audioBlockFormat->has<adm::ChannelLock>()){
-        auto channelLock = audioBlockFormat->get<adm::ChannelLock>();
-        if(channelLock.has<adm::ChannelLockFlag>() && channelLock.get<adm::ChannelLockFlag>().get()){
-            metadataBlock->channelLock = true;
-            metadataBlock->channelLockMaxDistance = INFINITY;
-            if(channelLock.has<adm::MaxDistance>()) {
-                metadataBlock->channelLockMaxDistance = channelLock.get<adm::MaxDistance>().get();
+        if(!haveNext) return;
+
+        // Every channel on to its block in effect by then
+        channelIndex = 0;
+        for(auto& renderableItemChannelPair : renderableItem->renderableItemChannels) {
+            int& blockIndex = channelIndices[channelIndex++];
+            while(auto hoaBlock = getChannelBlock(renderableItemChannelPair.second, blockIndex + 1)) {
+                if(hoaBlock->rTimeNs > hoaTimelineEntry.rTimeNs) break;
+                blockIndex++;
             }
         }
-    }
-    metadataBlock->screenRef = false;
-    if(audioBlockFormat->has<adm::ScreenRef>()) {
-        metadataBlock->screenRef = audioBlockFormat->get<adm::ScreenRef>().get();
-    }
-}
-
-void MetadataExtractor::populateTypeSpecificMetadata(MetadataBlock * metadataBlock, adm::AudioBlockFormatDirectSpeakers * audioBlockFormat, std::shared_ptr<RenderableItemChannel> renderableItemChannel)
-{
-    metadataBlock->channelCount = 1;
-    metadataBlock->channelNums[0] = renderableItemChannel->channelNum;
 
-    metadataBlock->rTime = 0.0;
-    if(audioBlockFormat->has<adm::Rtime>()) {
-        metadataBlock->rTime = audioBlockFormat->get<adm::Rtime>().get().count() / 1000000000.0;
-    }
-    metadataBlock->duration = INFINITY;
-    if(audioBlockFormat->has<adm::Duration>()) {
-        metadataBlock->duration = audioBlockFormat->get<adm::Duration>().get().count() / 1000000000.0;
-    }
-    metadataBlock->gain = 1.0; // Gain is a common block param, but not available for DS in libadm
-    if(audioBlockFormat->has<adm::SpeakerPosition>())
-    {
-        metadataBlock->cartesian = false;
-        auto position = audioBlockFormat->get<adm::SpeakerPosition>();
-        metadataBlock->azimuth = position.get<adm::Azimuth>().get();
-        metadataBlock->elevation = position.get<adm::Elevation>().get();
-        metadataBlock->distance = 1.0;
-        if(position.has<adm::Distance>()){
-            metadataBlock->distance = position.get<adm::Distance>().get();
+        // S-ADM blocks arriving after later ones were merged only count from then on
+        if(!timeline.empty() && hoaTimelineEntry.rTimeNs <= timeline.back().rTimeNs) continue;
+
+        hoaTimelineEntry.duration = INFINITY;
+        int renderableItemChannelIndex = 0;
+        channelIndex = 0;
+        for(auto& renderableItemChannelPair : renderableItem->renderableItemChannels) {
+            int blockIndex = channelIndices[channelIndex++];
+            if(blockIndex < 0) continue; // Acceptable not to have one... metadata for channel may not have started yet
+            auto releventBlock = getChannelBlock(renderableItemChannelPair.second, blockIndex);
+            hoaTimelineEntry.channelNums[renderableItemChannelIndex] = renderableItemChannelPair.second->channelNum;
+            hoaTimelineEntry.order[renderableItemChannelIndex] = releventBlock->order;
+            hoaTimelineEntry.degree[renderableItemChannelIndex] = releventBlock->degree;
+            renderableItemChannelIndex++;
         }
-    } else {
-        assert(false); // Should always have!
-    }
-    metadataBlock->speakerLabel[0] = 0;
-    if(audioBlockFormat->has<adm::SpeakerLabels>()) {
-        auto speakerLabels = audioBlockFormat->get<adm::SpeakerLabels>();
-        assert(speakerLabels.size() <= 1); // Currently only supporting one label due to fully-contained, fixed-size metadata struct.
-        if(speakerLabels.size() > 0) {
-            strncpy(metadataBlock->speakerLabel, speakerLabels[0].get().c_str(), sizeof(metadataBlock->speakerLabel));
+        hoaTimelineEntry.channelCount = renderableItemChannelIndex;
+
+        if(!timeline.empty()) {
+            timeline.back().duration = (hoaTimelineEntry.rTimeNs - timeline.back().rTimeNs) / 1000000000.0;
         }
+        timeline.push_back(hoaTimelineEntry);
     }
 }
 
-void MetadataExtractor::populateHoaSpecificMetadata(MetadataBlock* metadataBlock, adm::AudioBlockFormatHoa* refAudioBlockFormat, std::shared_ptr<RenderableItem> renderableItem)
+void MetadataExtractor::populateHoaSpecificMetadata(MetadataBlock* metadataBlock, const ChannelBlock& refChannelBlock, std::shared_ptr<RenderableItem> renderableItem, std::vector<int>& cursors)
 {
-    uint64_t rTimeNs = 0;
+    // Copied out up front - refChannelBlock is in a table that topping up (below) can reallocate
+    int64_t rTimeNs = refChannelBlock.rTimeNs;
 
-    metadataBlock->rTime = 0.0;
+    metadataBlock->rTime = refChannelBlock.rTime;
     metadataBlock->duration = INFINITY;
-    if(refAudioBlockFormat->has<adm::Rtime>()) {
-        rTimeNs = refAudioBlockFormat->get<adm::Rtime>().get().count();
-        metadataBlock->rTime = rTimeNs / 1000000000.0;
-    }
-
-    metadataBlock->channelCount = renderableItem->renderableItemChannels.size();
 
     metadataBlock->gain = 1.0; // Gain is a common block param, but not available for DS in libadm
 
@@ -630,42 +1650,29 @@ void MetadataExtractor::populateHoaSpecificMetadata(MetadataBlock* metadataBlock
 
     // Note that for the following parameters, we're essentially assuming the same value in all blocks in all channelformats of this hoa pack
 
-    metadataBlock->screenRef = false;
-    if(refAudioBlockFormat->has<adm::ScreenRef>()) {
-        metadataBlock->screenRef = refAudioBlockFormat->get<adm::ScreenRef>().get();
-    }
-
-    strncpy(metadataBlock->normalisation, "SN3D", 5);
-    if(refAudioBlockFormat->has<adm::Normalization>()) {
-        strncpy(metadataBlock->normalisation, refAudioBlockFormat->get<adm::Normalization>().get().c_str(), sizeof(metadataBlock->normalisation));
-    }
-
-    metadataBlock->nfcRefDist = 0.0;
-    if(refAudioBlockFormat->has<adm::NfcRefDist>()) {
-        metadataBlock->nfcRefDist = refAudioBlockFormat->get<adm::NfcRefDist>().get();
-    }
+    metadataBlock->screenRef = refChannelBlock.screenRef;
+    memcpy(metadataBlock->normalisation, refChannelBlock.normalisation, sizeof(metadataBlock->normalisation));
+    metadataBlock->nfcRefDist = refChannelBlock.nfcRefDist;
 
     // We're going to iterate through the other RenderableItemChannels and get time-relevant blocks so we can build up a common, cumulative block
 
     int renderableItemChannelIndex = 0;
-    uint64_t nextEarliestRtime;
-    adm::AudioBlockFormatHoa* nextEarliestBlock = nullptr;
+    bool haveNextEarliest = false;
+    int64_t nextEarliestRtimeNs = 0;
 
+    int channelIndex = 0;
     for(auto& renderableItemChannelPair : renderableItem->renderableItemChannels) {
+        int& cursor = cursors[channelIndex++];
         int releventBlockIndex = -1;
-        auto hoaBlocks = renderableItemChannelPair.second->audioChannelFormat->getElements<adm::AudioBlockFormatHoa>();
 
-        for(int i = std::max(renderableItemChannelPair.second->lastSentBlockIndex, 0); i < hoaBlocks.size(); i++) {
-            uint64_t blockRtime = 0;
-            if(hoaBlocks[i].has<adm::Rtime>()) {
-                blockRtime = hoaBlocks[i].get<adm::Rtime>().get().count();
-            }
-            if(blockRtime <= rTimeNs) {
+        // Stops at the end of the blocks - or, if lazy, the end of the window so far. Looking past the end tops up the table, so hold indices rather than pointers in to it.
+        for(int i = std::max(cursor, 0); auto hoaBlock = getChannelBlock(renderableItemChannelPair.second, i); i++) {
+            if(hoaBlock->rTimeNs <= rTimeNs) {
                 releventBlockIndex = i;
             } else {
-                if(nextEarliestBlock == nullptr || blockRtime < nextEarliestRtime) {
-                    nextEarliestRtime = blockRtime;
-                    nextEarliestBlock = &hoaBlocks[i];
+                if(!haveNextEarliest || hoaBlock->rTimeNs < nextEarliestRtimeNs) {
+                    haveNextEarliest = true;
+                    nextEarliestRtimeNs = hoaBlock->rTimeNs;
                 }
                 break;
             }
@@ -673,29 +1680,76 @@ void MetadataExtractor::populateHoaSpecificMetadata(MetadataBlock* metadataBlock
 
         if(releventBlockIndex >= 0) { // Acceptable not to have one... metadata for channel may not have started yet
 
+            auto releventBlock = getChannelBlock(renderableItemChannelPair.second, releventBlockIndex);
             metadataBlock->channelNums[renderableItemChannelIndex] = renderableItemChannelPair.second->channelNum;
-            metadataBlock->order[renderableItemChannelIndex] = 0;
-            if(hoaBlocks[releventBlockIndex].has<adm::Order>()) {
-                metadataBlock->order[renderableItemChannelIndex] = hoaBlocks[releventBlockIndex].get<adm::Order>().get();
-            } else {
-                assert(false); //MANDATORY for Hoa Block
-            }
-            metadataBlock->degree[renderableItemChannelIndex] = 0;
-            if(hoaBlocks[releventBlockIndex].has<adm::Degree>()) {
-                metadataBlock->degree[renderableItemChannelIndex] = hoaBlocks[releventBlockIndex].get<adm::Degree>().get();
-            } else {
-                assert(false); //MANDATORY for Hoa Block
-            }
+            metadataBlock->order[renderableItemChannelIndex] = releventBlock->order;
+            metadataBlock->degree[renderableItemChannelIndex] = releventBlock->degree;
             renderableItemChannelIndex++;
 
-            renderableItemChannelPair.second->lastSentBlockIndex = releventBlockIndex;
+            cursor = releventBlockIndex;
         }
     }
+    metadataBlock->channelCount = renderableItemChannelIndex; // Only those listed - channels whose metadata hasn't started yet aren't
 
     // Set duration if we found the next block
-    if(nextEarliestBlock != nullptr) {
-        assert(rTimeNs <= nextEarliestRtime);
-        metadataBlock->duration = (nextEarliestRtime - rTimeNs) / 1000000000.0;
+    if(haveNextEarliest) {
+        assert(rTimeNs <= nextEarliestRtimeNs);
+        metadataBlock->duration = (nextEarliestRtimeNs - rTimeNs) / 1000000000.0;
     }
 
 }
+
+void describeItem(const MetadataBlock& metadataBlock, ItemDescriptor* itemDescriptor)
+{
+    // Nothing past each string's terminator or each list's count is copied - the block may be scratch reused across items,
+    //  and descriptors are compared whole to tell when they've changed (see describeSentBlock)
+    itemDescriptor->id = metadataBlock.id;
+    itemDescriptor->typeDef = metadataBlock.typeDef;
+    itemDescriptor->channelCount = std::min<uint8_t>(metadataBlock.channelCount, 64);
+    memset(itemDescriptor->channelNums, 0, sizeof(itemDescriptor->channelNums));
+    memset(itemDescriptor->order, 0, sizeof(itemDescriptor->order));
+    memset(itemDescriptor->degree, 0, sizeof(itemDescriptor->degree));
+    memcpy(itemDescriptor->channelNums, metadataBlock.channelNums, itemDescriptor->channelCount);
+    strncpy(itemDescriptor->name, metadataBlock.name, sizeof(itemDescriptor->name));
+    itemDescriptor->audioProgrammeIdCount = std::min<uint8_t>(metadataBlock.audioProgrammeIdCount, 64);
+    memset(itemDescriptor->audioProgrammeId, 0, sizeof(itemDescriptor->audioProgrammeId));
+    memcpy(itemDescriptor->audioProgrammeId, metadataBlock.audioProgrammeId, itemDescriptor->audioProgrammeIdCount * sizeof(uint16_t));
+    itemDescriptor->audioStartTime = metadataBlock.audioStartTime;
+    itemDescriptor->audioEndTime = metadataBlock.audioEndTime;
+    strncpy(itemDescriptor->audioPackFormatId, metadataBlock.audioPackFormatId, sizeof(itemDescriptor->audioPackFormatId));
+    itemDescriptor->absoluteDistance = metadataBlock.absoluteDistance;
+    itemDescriptor->highPass = metadataBlock.highPass;
+    itemDescriptor->lowPass = metadataBlock.lowPass;
+    strncpy(itemDescriptor->speakerLabel, metadataBlock.speakerLabel, sizeof(itemDescriptor->speakerLabel));
+    strncpy(itemDescriptor->normalisation, metadataBlock.normalisation, sizeof(itemDescriptor->normalisation));
+    if(metadataBlock.typeDef == adm::TypeDefinition::HOA.get()) {
+        memcpy(itemDescriptor->order, metadataBlock.order, itemDescriptor->channelCount);
+        memcpy(itemDescriptor->degree, metadataBlock.degree, itemDescriptor->channelCount);
+    }
+    itemDescriptor->nfcRefDist = metadataBlock.nfcRefDist;
+}
+
+void packBlockRecord(const MetadataBlock& metadataBlock, BlockRecord* blockRecord)
+{
+    blockRecord->id = metadataBlock.id;
+    blockRecord->rTime = metadataBlock.rTime;
+    blockRecord->duration = metadataBlock.duration;
+    blockRecord->interpolationLength = metadataBlock.jumpPosition ? metadataBlock.interpolationLength : 0.0;
+    blockRecord->cartesian = metadataBlock.cartesian;
+    blockRecord->position[0] = metadataBlock.cartesian ? metadataBlock.x : metadataBlock.azimuth;
+    blockRecord->position[1] = metadataBlock.cartesian ? metadataBlock.y : metadataBlock.elevation;
+    blockRecord->position[2] = metadataBlock.cartesian ? metadataBlock.z : metadataBlock.distance;
+    blockRecord->width = (float)metadataBlock.width;
+    blockRecord->height = (float)metadataBlock.height;
+    blockRecord->depth = (float)metadataBlock.depth;
+    blockRecord->gain = (float)metadataBlock.gain;
+    blockRecord->diffuse = (float)metadataBlock.diffuse;
+    blockRecord->divergence = (float)metadataBlock.divergence;
+    blockRecord->divergenceAzimuthRange = (float)metadataBlock.divergenceAzimuthRange;
+    blockRecord->divergencePositionRange = (float)metadataBlock.divergencePositionRange;
+    blockRecord->jumpPosition = metadataBlock.jumpPosition;
+    blockRecord->channelLock = metadataBlock.channelLock;
+    blockRecord->channelLockMaxDistance = metadataBlock.channelLock ? (float)metadataBlock.channelLockMaxDistance : 0.0f;
+    blockRecord->screenRef = metadataBlock.screenRef;
+    blockRecord->descriptorRevision = 0; // Only the extractor tracks revisions - see getNextBlockRecords
+}
@@ -4,11 +4,58 @@
 #include <optional>
 #include <adm/adm.hpp>
 #include "Helpers.h"
+#include "LazyBlockFormats.h"
 
 using RenderableItemId = uint64_t;
 using RenderableItemChannelId = uint64_t;
 struct RenderableItemChannel;
 
+// An audioBlockFormat already converted to the values sent for it - so each is only looked up in libadm once, rather than on every pull
+struct ChannelBlock {
+    int64_t rTimeNs;
+    double rTime;
+    double duration;
+    bool jumpPosition;
+    double interpolationLength;
+    bool cartesian;
+    double x;
+    double y;
+    double z;
+    double azimuth;
+    double elevation;
+    double distance;
+    double width;
+    double height;
+    double depth;
+    double gain;
+    double diffuse;
+    double divergence;
+    double divergenceAzimuthRange;
+    double divergencePositionRange;
+    bool channelLock;
+    double channelLockMaxDistance;
+    bool screenRef;
+    char speakerLabel[64];      // DirectSpeakers
+    char normalisation[8];      // HOA
+    int8_t order;               // HOA
+    int8_t degree;              // HOA
+    double nfcRefDist;          // HOA
+};
+
+// A block of a HOA item - its channels' blocks in effect from rTime, combined
+struct HoaTimelineEntry {
+    int64_t rTimeNs;
+    double rTime;
+    double duration;            // Until the next entry - INFINITY while there isn't one (yet)
+    bool screenRef;
+    char normalisation[8];
+    double nfcRefDist;
+    uint8_t channelCount;       // With a block in effect - only those are listed below
+    uint8_t channelNums[64];
+    int8_t order[64];
+    int8_t degree[64];
+};
+
 struct ItemAdmTree {
     std::shared_ptr<adm::AudioProgramme> audioProgramme;
     std::shared_ptr<adm::AudioContent> audioContent;
@@ -26,6 +73,12 @@ struct RenderableItem {
     double startTime;
     double duration;
     double endTime;
+    // HOA with no lazy channels - its channels' blocks are merged in to the blocks it sends once, as they arrive (see extendHoaTimeline).
+    //  Its cursor is then the index of the last entry sent, rather than one per channel.
+    bool hasHoaTimeline{ false };
+    std::vector<HoaTimelineEntry> hoaTimeline;
+    std::vector<int> hoaTimelineChannelIndices; // The last block of each channel merged in (renderableItemChannels order)
+    int hoaTimelineLastSentIndex{ -1 };
 };
 
 struct RenderableItemChannel {
@@ -41,6 +94,9 @@ struct RenderableItemChannel {
     std::shared_ptr<adm::AudioChannelFormat> audioChannelFormat;
     std::shared_ptr<adm::AudioStreamFormat> audioStreamFormat;
     std::shared_ptr<adm::AudioTrackFormat> audioTrackFormat;
+    std::shared_ptr<LazyBlockFormats> lazyBlockFormats; // Null when the channel format's blocks are all in the document
+    std::vector<ChannelBlock> blockTable; // Converted blocks from blockTableFirstIndex on - topped up as blocks arrive (S-ADM) or are materialised (lazy)
+    int blockTableFirstIndex;             // Only above 0 for lazy channels, where blocks evicted from the window are dropped here too
     double highPass;
     double lowPass;
     double absoluteDistance;
@@ -112,7 +168,78 @@ struct MetadataBlock
                                     //      Will need piping directly to audio output - not via any renderer
 };
 
+// The values of an item that are the same from block to block - fetched (getItemDescriptor) alongside lean BlockRecords, rather than
+//  repeated in every MetadataBlock. Some can still change as an item grows (S-ADM), so each record gives the revision it goes with.
+struct ItemDescriptor
+{
+    uint64_t id;
+    uint32_t revision;              // Bumped whenever any of the values below change - see BlockRecord::descriptorRevision
+    uint8_t typeDef;
+    uint8_t channelCount;
+    uint8_t channelNums[64];        // HOA - in the order forBearChannels are given for its blocks
+    char name[100];
+    uint16_t audioProgrammeId[64];
+    uint8_t audioProgrammeIdCount;
+
+    double audioStartTime;
+    double audioEndTime;
+
+    char audioPackFormatId[12];     // DirectSpeakers
+    double absoluteDistance;        // PackFormat - reference distance
+    double highPass;                // DirectSpeakers - ChannelFrequency
+    double lowPass;                 // DirectSpeakers - ChannelFrequency
+    char speakerLabel[64];          // DirectSpeakers
+
+    char normalisation[8];          // HOA
+    int8_t order[64];               // HOA - per channel, as channelNums
+    int8_t degree[64];              // HOA - per channel, as channelNums
+    double nfcRefDist;              // HOA
+};
+
+// What changes from block to block - see MetadataBlock for what each is for
+struct BlockRecord
+{
+    uint64_t id;                    // Of the item - see ItemDescriptor
+    double rTime;
+    double duration;
+    double interpolationLength;     // When jumpPosition
+    double position[3];             // x, y, z when cartesian - otherwise azimuth, elevation, distance
+
+    float width;
+    float height;
+    float depth;
+    float gain;
+    float diffuse;
+    float divergence;
+    float divergenceAzimuthRange;
+    float divergencePositionRange;
+    float channelLockMaxDistance;   // When channelLock
+    uint32_t descriptorRevision;    // Of the item's descriptor this block goes with - fetch it again when this differs from the one held
+
+    bool jumpPosition;
+    bool cartesian;
+    bool channelLock;
+    bool screenRef;
+};
+
+// Restricts which items blocks are pulled for - blocks of other items stay queued for a later pull
+struct MetadataBlockFilter {
+    RenderableItemId itemId{ 0 };   // 0 for any item
+    int typeDefinition{ -1 };       // adm::TypeDefinition value, or -1 for any type
+    bool matches(RenderableItemId id, int itemTypeDefinition) const
+    {
+        return (itemId == 0 || itemId == id) && (typeDefinition < 0 || typeDefinition == itemTypeDefinition);
+    }
+};
+
+// The item's static values, as they're given in each of its MetadataBlocks
+void describeItem(const MetadataBlock& metadataBlock, ItemDescriptor* itemDescriptor);
+void packBlockRecord(const MetadataBlock& metadataBlock, BlockRecord* blockRecord);
+
 class Reader;
+class FlattenedMetadata;
+struct FlattenedItem;
+class DiscoveryWorkers;
 
 class MetadataExtractor
 {
@@ -120,13 +247,53 @@ class MetadataExtractor
 
 public:
     MetadataExtractor(Reader* parentReader, std::shared_ptr<adm::Document> parsedDocument);
+    // Serves what a previous extractor flattened (see MetadataCache) - no document needed. Everything is discovered at once.
+    MetadataExtractor(Reader* parentReader, std::shared_ptr<FlattenedMetadata> flattenedMetadata);
     ~MetadataExtractor();
 
+    // Discovers everything and drains every block, in send order - leaving nothing more to send from this extractor.
+    // Blocks beyond a lazy block window won't be included, so only use with all blocks resident.
+    std::shared_ptr<FlattenedMetadata> flatten();
+
     int discoverNewRenderableItems();
+    // Discovery only looks at elements added to the document since it last ran, and at elements these name - those which have gained
+    //  references since (as an S-ADM frame can link a new object in to an existing content). Naming one again before discovery runs is harmless.
+    void markReferencesAdded(const std::shared_ptr<adm::AudioProgramme>& audioProgramme);
+    void markReferencesAdded(const std::shared_ptr<adm::AudioContent>& audioContent);
+    void markReferencesAdded(const std::shared_ptr<adm::AudioObject>& audioObject);
+    // Threads new channels are created across when discovering - 1 (the default) for just the calling thread, 0 for one per hardware thread.
+    // Items are discovered with the same IDs, in the same order, either way.
+    void setDiscoveryThreadCount(int threadCount);
 
-    bool getNextMetadataBlock(MetadataBlock* metadataBlock); // MetadataBlock = Universal struct for all type defs.
+    bool getNextMetadataBlock(MetadataBlock* metadataBlock, const MetadataBlockFilter& filter = MetadataBlockFilter()); // MetadataBlock = Universal struct for all type defs.
                                                              //When C# calls this method, it should provide a pointer to an equivalent struct to populate from here.
                                                              // Return is whether new metadata was able to be sent (i.e, available).
+    // As many blocks as are available, up to capacity, in the same order repeated getNextMetadataBlock calls would give. Returns the count.
+    int getNextMetadataBlocks(MetadataBlock* metadataBlocks, int capacity, const MetadataBlockFilter& filter = MetadataBlockFilter());
+
+    // As getNextMetadataBlocks, but only each block's own values - get the ItemDescriptor whenever a record's descriptorRevision is new.
+    // Stops after a record with a new revision, so the descriptor fetched then is the one that went with it.
+    int getNextBlockRecords(BlockRecord* blockRecords, int capacity, const MetadataBlockFilter& filter = MetadataBlockFilter());
+    // As of the item's last record pulled - false if none have been
+    bool getItemDescriptor(RenderableItemId itemId, ItemDescriptor* itemDescriptor);
+
+    // For each item, its block in effect at fromSec then those starting by toSec, in item then time order - without changing what's next to be sent.
+    // Returns how many there are, which may be more than capacity (only the first capacity are filled in).
+    // Lazy channels only have the blocks in their window, so seek to fromSec (or set the render position) first.
+    int getMetadataBlocksInRange(double fromSec, double toSec, MetadataBlock* metadataBlocks, int capacity, const MetadataBlockFilter& filter = MetadataBlockFilter());
+    // Pulls carry on from the blocks in effect at positionSec (whether that's forward or back), as if everything before had been sent.
+    // Also sets the render position, moving lazy windows straight there.
+    void seek(double positionSec);
+
+    // Sorted, unique file channel numbers used by valid RenderableItems - only those in the given audioProgramme (numeric part of its ID) if >= 0
+    std::vector<int> getReferencedChannelNums(int audioProgrammeIdFilter = -1);
+
+    // Blocks of these channel formats were left out of the parsed document - they're materialised from the axml for windowSec ahead of
+    //  the render position, and evicted once sent. Blocks beyond the window aren't sent until the render position gets nearer.
+    void setLazyBlockFormats(std::map<std::string, ChannelFormatBlockLocations> locations, AxmlFragmentSource source, double windowSec);
+    // Seconds from the start of the programme - only matters for lazy block formats
+    void setRenderPosition(double positionSec);
+    uint64_t getMaterialisedBlockCount();
 
 private:
     Reader* parentReader;
@@ -136,18 +303,119 @@ private:
     std::map<RenderableItemChannelId, std::shared_ptr<RenderableItemChannel>> renderableItemChannels;
     std::vector<std::shared_ptr<RenderableItem>> validRenderableItems; // Used for a quick iterable for sending metadata blocks
     int idIndexOfLastRenderableItemSent{ -1 };
+    // Described from each item's last block pulled as a record, whether from the document or flattened - so both give the same descriptors
+    std::map<RenderableItemId, ItemDescriptor> sentItemDescriptors;
+    // Gives the item's revision for this block - true if it's a new one, as something it describes differs from the last
+    bool describeSentBlock(const MetadataBlock& metadataBlock, uint32_t* revision);
+
+    std::shared_ptr<FlattenedMetadata> flattenedMetadata; // Serving from this instead of the document, when set
+    std::vector<uint64_t> flattenedSentCounts; // Per flattened item - empty until discovered
+    bool getNextFlattenedMetadataBlock(MetadataBlock* metadataBlock, const MetadataBlockFilter& filter);
+    uint64_t getFlattenedBlockIndexAt(const FlattenedItem& item, double timeSec);
+    std::map<RenderableItemId, uint64_t> flattenedItemIndices; // Built with flattenedSentCounts
+
+    std::map<std::string, std::shared_ptr<LazyBlockFormats>> lazyBlockFormats; // Keyed by audioChannelFormatID
+    AxmlFragmentSource axmlFragmentSource;
+    int64_t lazyWindowNs{ 0 };
+    int64_t renderPositionNs{ 0 };
+    void updateLazyBlockFormats();
+
+    // Wherever the channel's blocks live. Count is all blocks, whether materialised or not - getBlock is null for those that aren't.
+    template<typename BlockT>
+    int getBlockCount(const std::shared_ptr<RenderableItemChannel>& renderableItemChannel);
+    template<typename BlockT>
+    BlockT* getBlock(const std::shared_ptr<RenderableItemChannel>& renderableItemChannel, int index);
+    // Converts any blocks the channel has gained since its table was last topped up
+    void topUpBlockTable(const std::shared_ptr<RenderableItemChannel>& renderableItemChannel);
+    template<typename BlockT>
+    void topUpBlockTable(const std::shared_ptr<RenderableItemChannel>& renderableItemChannel);
+    // Null if the channel has no such block (yet) - only tops up the table when index is past its end, so O(1) otherwise
+    const ChannelBlock* getChannelBlock(const std::shared_ptr<RenderableItemChannel>& renderableItemChannel, int index);
+    // Index of the last block starting at or before timeNs, or -1 if there's none. Binary searched - lazy channels by their block locations.
+    int getBlockIndexAt(const std::shared_ptr<RenderableItemChannel>& renderableItemChannel, int64_t timeNs);
+
+    // Cursors are the index of the last block used from each of an item's channels (in renderableItemChannels order), for building its next block
+    //  - or, for an item with a HOA timeline, just the last entry of it sent
+    std::vector<int> pullCursors; // Reused by getNextMetadataBlock
+    void getSentCursors(const std::shared_ptr<RenderableItem>& renderableItem, std::vector<int>& cursors);
+    void setSentCursors(const std::shared_ptr<RenderableItem>& renderableItem, const std::vector<int>& cursors);
+    // Cursors from which the item's next block is the one in effect at timeNs
+    void getCursorsAt(const std::shared_ptr<RenderableItem>& renderableItem, int64_t timeNs, std::vector<int>& cursors);
+    // Fills in the type specific values of the item's block after the cursors, advancing them past it. False if there isn't one (yet).
+    // refItemChannel is the channel the common values come from.
+    bool populateNextBlock(MetadataBlock* metadataBlock, const std::shared_ptr<RenderableItem>& renderableItem, std::vector<int>& cursors, std::shared_ptr<RenderableItemChannel>& refItemChannel);
+    void populateCommonMetadata(MetadataBlock* metadataBlock, const std::shared_ptr<RenderableItem>& renderableItem, const std::shared_ptr<RenderableItemChannel>& refItemChannel);
+    // Round-robin across items, from the one after the last sent from. Only the type specific values are filled in - null if there are no blocks to send.
+    std::shared_ptr<RenderableItem> pullNextBlock(MetadataBlock* metadataBlock, const MetadataBlockFilter& filter, std::shared_ptr<RenderableItemChannel>& refItemChannel);
 
     RenderableItemChannelId generateRenderableItemChannelId(std::shared_ptr<adm::AudioTrackUid> trackUid);
     RenderableItemId generateRenderableItemId(std::shared_ptr<adm::AudioObject> audioObject, std::shared_ptr<adm::AudioTrackUid> trackUid);
-    std::string generatePresentedName(std::vector<std::shared_ptr<adm::AudioObject>> &audioObjectTree, std::vector<std::shared_ptr<adm::AudioPackFormat>> &audioPackFormatTree, std::shared_ptr<adm::AudioChannelFormat> audioChannelFormat, adm::TypeDescriptor typeDefinition);
+    std::string generatePresentedName(const std::vector<std::shared_ptr<adm::AudioObject>> &audioObjectTree, std::vector<std::shared_ptr<adm::AudioPackFormat>> &audioPackFormatTree, std::shared_ptr<adm::AudioChannelFormat> audioChannelFormat, adm::TypeDescriptor typeDefinition);
     int discoverViaAudioProgramme(std::shared_ptr<adm::AudioProgramme> audioProgramme);
     int discoverViaAudioContent(std::shared_ptr<adm::AudioProgramme> audioProgramme, std::shared_ptr<adm::AudioContent> audioContent);
-    int discoverViaAudioObject(std::shared_ptr<adm::AudioProgramme> audioProgramme, std::shared_ptr<adm::AudioContent> audioContent, std::vector<std::shared_ptr<adm::AudioObject>> audioObjectTree);
-    int discoverFromAudioTrackUid(std::shared_ptr<adm::AudioProgramme> audioProgramme, std::shared_ptr<adm::AudioContent> audioContent, std::vector<std::shared_ptr<adm::AudioObject>> audioObjectTree, std::shared_ptr<adm::AudioTrackUid> audioTrackUid);
+    int discoverViaAudioObject(std::shared_ptr<adm::AudioProgramme> audioProgramme, std::shared_ptr<adm::AudioContent> audioContent, std::vector<std::shared_ptr<adm::AudioObject>>& audioObjectTree);
+    int discoverFromAudioTrackUid(std::shared_ptr<adm::AudioProgramme> audioProgramme, std::shared_ptr<adm::AudioContent> audioContent, const std::vector<std::shared_ptr<adm::AudioObject>>& audioObjectTree, std::shared_ptr<adm::AudioTrackUid> audioTrackUid);
+    // Only reads parentReader (getChannelNumFor must only read), the lazyBlockFormats map and the document - through libadm's const getters,
+    //  while nothing modifies it (documents only grow between discoveries, on the thread that runs them). So can run on any thread.
+    // The channel is left unregistered, with its block table empty - topUpBlockTable may materialise lazy blocks, so isn't called here.
+    std::shared_ptr<RenderableItemChannel> createRenderableItemChannel(RenderableItemChannelId id, std::shared_ptr<adm::AudioObject> audioObject, std::shared_ptr<adm::AudioTrackUid> audioTrackUid);
+
+    // With more than one discovery thread, the walk is done first just noting the channels it would create, in the order it reaches them.
+    //  Those are created across the threads, then registered (along with their items) by the walk proper, just as the serial walk would.
+    int discoveryThreadCount{ 1 };
+    bool notingNewChannels{ false };
+    struct NewChannel {
+        RenderableItemChannelId id;
+        std::shared_ptr<adm::AudioObject> audioObject; // Owning the channel's trackUID - null for strays
+        std::shared_ptr<adm::AudioTrackUid> audioTrackUid;
+    };
+    std::vector<NewChannel> newChannels;
+    std::map<RenderableItemChannelId, std::shared_ptr<RenderableItemChannel>> createdChannels; // Null until created
+    void createNewChannels();
+    // Kept between discoveries (S-ADM frames and growing documents discover repeatedly) - started on first use, and again if the count changes
+    std::unique_ptr<DiscoveryWorkers> discoveryWorkers;
+
+    // Discovery only walks what's been added since it last ran - elements past those walked in each of the document's lists, and references
+    //  past those walked from the elements marked as having gained some (documents only grow, and elements and references are appended).
+    //  Elements' parents are kept so a reference added to an existing element is walked along every path already leading to it.
+    struct WalkedReferenceCounts {
+        size_t audioContents{ 0 };      // From an AudioProgramme
+        size_t audioObjects{ 0 };       // From an AudioContent, or nested in an AudioObject
+        size_t audioTrackUids{ 0 };     // From an AudioObject
+    };
+    std::map<adm::AudioProgramme*, WalkedReferenceCounts> walkedAudioProgrammes;
+    std::map<adm::AudioContent*, WalkedReferenceCounts> walkedAudioContents;
+    std::map<adm::AudioObject*, WalkedReferenceCounts> walkedAudioObjects;
+    size_t walkedAudioProgrammeCount{ 0 };  // Of each of the document's lists
+    size_t walkedAudioContentCount{ 0 };
+    size_t walkedAudioObjectCount{ 0 };
+    size_t walkedAudioTrackUidCount{ 0 };
+    // Marked since discovery last ran, in the order they were - see markReferencesAdded
+    std::vector<std::shared_ptr<adm::AudioProgramme>> markedAudioProgrammes;
+    std::vector<std::shared_ptr<adm::AudioContent>> markedAudioContents;
+    std::vector<std::shared_ptr<adm::AudioObject>> markedAudioObjects;
+    std::map<adm::AudioContent*, std::vector<std::shared_ptr<adm::AudioProgramme>>> audioContentParents;
+    std::map<adm::AudioObject*, std::vector<std::shared_ptr<adm::AudioContent>>> audioObjectParentContents;
+    std::map<adm::AudioObject*, std::vector<std::shared_ptr<adm::AudioObject>>> audioObjectParentObjects;
+    struct DiscoveryPath {
+        std::shared_ptr<adm::AudioProgramme> audioProgramme;
+        std::shared_ptr<adm::AudioContent> audioContent;
+        std::vector<std::shared_ptr<adm::AudioObject>> audioObjectTree;
+    };
+    // Every path discovery has walked to the object - from programmes, then from contents, then the object alone (as discovery walks them)
+    void getPathsTo(const std::shared_ptr<adm::AudioObject>& audioObject, std::vector<DiscoveryPath>& paths);
+    // Walks the new references of the marked elements walked before
+    int discoverViaAddedReferences();
+    // Walks new elements from each, as roots
+    int discoverViaAddedElements();
+    // Then clears the marks
+    void recordWalkedReferences();
     std::optional<std::vector<std::shared_ptr<adm::AudioPackFormat>>> tracePackFormatTree(std::shared_ptr<adm::AudioPackFormat> fromPackFormat, std::shared_ptr<adm::AudioChannelFormat> toChannelFormat, std::vector<std::shared_ptr<adm::AudioPackFormat>> history = std::vector<std::shared_ptr<adm::AudioPackFormat>>());
 
 
-    void populateTypeSpecificMetadata(MetadataBlock* metadataBlock, adm::AudioBlockFormatObjects* audioBlockFormat, std::shared_ptr<RenderableItemChannel> renderableItemChannel);
-    void populateTypeSpecificMetadata(MetadataBlock* metadataBlock, adm::AudioBlockFormatDirectSpeakers* audioBlockFormat, std::shared_ptr<RenderableItemChannel> renderableItemChannel);
-    void populateHoaSpecificMetadata(MetadataBlock* metadataBlock, adm::AudioBlockFormatHoa* refAudioBlockFormat, std::shared_ptr<RenderableItem> renderableItem);
+    void populateTypeSpecificMetadata(MetadataBlock* metadataBlock, const ChannelBlock& channelBlock, std::shared_ptr<RenderableItemChannel> renderableItemChannel);
+    void populateHoaSpecificMetadata(MetadataBlock* metadataBlock, const ChannelBlock& refChannelBlock, std::shared_ptr<RenderableItem> renderableItem, std::vector<int>& cursors);
+    void populateHoaSpecificMetadata(MetadataBlock* metadataBlock, const HoaTimelineEntry& hoaTimelineEntry, std::shared_ptr<RenderableItem> renderableItem);
+    // Merges any blocks its channels have gained in to the HOA item's timeline - started over (carrying on from the time last sent) when channels join
+    void extendHoaTimeline(const std::shared_ptr<RenderableItem>& renderableItem);
 };
\ No newline at end of file
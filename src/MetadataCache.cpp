@@ -0,0 +1,229 @@
+#include "MetadataCache.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+namespace {
+    const char cacheMagic[8] = { 'U', 'A', 'D', 'M', 'M', 'E', 'T', 'A' };
+    const uint32_t byteOrderMark = 0x01020304;
+
+    struct CacheHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrderMark;         // Native layout - only valid on a machine of the same endianness...
+        uint32_t metadataBlockSize;     // ...and the same MetadataBlock layout
+        uint32_t flattenedItemSize;
+        uint64_t contentHash;
+        uint64_t itemCount;
+        uint64_t blockCount;
+        uint64_t channelNumCount;
+        uint64_t audioProgrammeIdCount;
+        uint64_t itemsOffset;           // Each table starts 8-byte aligned
+        uint64_t blocksOffset;
+        uint64_t channelNumsOffset;
+        uint64_t audioProgrammeIdsOffset;
+    };
+
+    static_assert(std::is_trivially_copyable<MetadataBlock>::value, "MetadataBlocks are cached as raw bytes");
+    static_assert(std::is_trivially_copyable<FlattenedItem>::value, "FlattenedItems are cached as raw bytes");
+
+    uint64_t alignedTo8(uint64_t offset)
+    {
+        return (offset + 7) & ~(uint64_t)7;
+    }
+
+    const uint64_t fnvOffsetBasis = 14695981039346656037ULL;
+    const uint64_t fnvPrime = 1099511628211ULL;
+
+    uint64_t fnv1a(uint64_t hash, const void* data, size_t size)
+    {
+        auto bytes = static_cast<const uint8_t*>(data);
+        for(size_t i = 0; i < size; i++) {
+            hash = (hash ^ bytes[i]) * fnvPrime;
+        }
+        return hash;
+    }
+
+    uint64_t fnv1a(uint64_t hash, const std::string& text)
+    {
+        hash = fnv1a(hash, text.data(), text.size());
+        return fnv1a(hash, "", 1); // Terminate, so adjacent strings can't run together
+    }
+}
+
+uint64_t hashAdmChunks(const std::string& axml, const std::vector<bw64::AudioId>& audioIds)
+{
+    uint64_t hash = fnv1a(fnvOffsetBasis, axml);
+    for(auto& audioId : audioIds) {
+        uint16_t trackIndex = audioId.trackIndex();
+        hash = fnv1a(hash, &trackIndex, sizeof(trackIndex));
+        hash = fnv1a(hash, audioId.uid());
+        hash = fnv1a(hash, audioId.trackRef());
+        hash = fnv1a(hash, audioId.packRef());
+    }
+    return hash;
+}
+
+std::string metadataCachePath(const std::string& cacheDirectory, uint64_t contentHash)
+{
+    char fileName[32];
+    std::snprintf(fileName, sizeof(fileName), "%016llx.uadmcache", (unsigned long long)contentHash);
+    std::string path = cacheDirectory;
+    if(!path.empty() && path.back() != '/' && path.back() != '\\') {
+        path += '/';
+    }
+    return path + fileName;
+}
+
+FlattenedMetadata::FlattenedMetadata()
+{
+}
+
+FlattenedMetadata::~FlattenedMetadata()
+{
+}
+
+void FlattenedMetadata::addItem(uint64_t id, const std::vector<int>& itemChannelNums, const std::vector<uint16_t>& itemAudioProgrammeIds, const std::vector<MetadataBlock>& itemBlocks)
+{
+    FlattenedItem item{};
+    item.id = id;
+    item.firstBlock = ownedBlocks.size();
+    item.blockCount = itemBlocks.size();
+    item.firstChannelNum = ownedChannelNums.size();
+    item.channelNumCount = (uint32_t)itemChannelNums.size();
+    item.firstAudioProgrammeId = ownedAudioProgrammeIds.size();
+    item.audioProgrammeIdCount = (uint32_t)itemAudioProgrammeIds.size();
+
+    ownedItems.push_back(item);
+    ownedBlocks.insert(ownedBlocks.end(), itemBlocks.begin(), itemBlocks.end());
+    ownedChannelNums.insert(ownedChannelNums.end(), itemChannelNums.begin(), itemChannelNums.end());
+    ownedAudioProgrammeIds.insert(ownedAudioProgrammeIds.end(), itemAudioProgrammeIds.begin(), itemAudioProgrammeIds.end());
+
+    items = ownedItems.data();
+    blocks = ownedBlocks.data();
+    channelNums = ownedChannelNums.data();
+    audioProgrammeIds = ownedAudioProgrammeIds.data();
+    itemCount = ownedItems.size();
+}
+
+bool FlattenedMetadata::save(const std::string& path, uint64_t contentHash, std::string& error)
+{
+    if(mapping) {
+        error = "Already cached";
+        return false;
+    }
+
+    CacheHeader header{};
+    std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = metadataCacheVersion;
+    header.byteOrderMark = byteOrderMark;
+    header.metadataBlockSize = sizeof(MetadataBlock);
+    header.flattenedItemSize = sizeof(FlattenedItem);
+    header.contentHash = contentHash;
+    header.itemCount = ownedItems.size();
+    header.blockCount = ownedBlocks.size();
+    header.channelNumCount = ownedChannelNums.size();
+    header.audioProgrammeIdCount = ownedAudioProgrammeIds.size();
+    header.itemsOffset = alignedTo8(sizeof(CacheHeader));
+    header.blocksOffset = alignedTo8(header.itemsOffset + header.itemCount * sizeof(FlattenedItem));
+    header.channelNumsOffset = alignedTo8(header.blocksOffset + header.blockCount * sizeof(MetadataBlock));
+    header.audioProgrammeIdsOffset = alignedTo8(header.channelNumsOffset + header.channelNumCount * sizeof(int32_t));
+
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if(!file) {
+            error = "Can not write " + tempPath;
+            return false;
+        }
+        auto writeAt = [&file](uint64_t offset, const void* data, uint64_t size) {
+            static const char padding[8] = {};
+            file.write(padding, offset - (uint64_t)file.tellp());
+            file.write(static_cast<const char*>(data), size);
+        };
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        writeAt(header.itemsOffset, ownedItems.data(), header.itemCount * sizeof(FlattenedItem));
+        writeAt(header.blocksOffset, ownedBlocks.data(), header.blockCount * sizeof(MetadataBlock));
+        writeAt(header.channelNumsOffset, ownedChannelNums.data(), header.channelNumCount * sizeof(int32_t));
+        writeAt(header.audioProgrammeIdsOffset, ownedAudioProgrammeIds.data(), header.audioProgrammeIdCount * sizeof(uint16_t));
+        if(!file) {
+            error = "Failed writing " + tempPath;
+            file.close();
+            std::remove(tempPath.c_str());
+            return false;
+        }
+    }
+
+    std::remove(path.c_str()); // rename won't replace an existing file on every platform
+    if(std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        error = "Can not rename " + tempPath + " to " + path;
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<FlattenedMetadata> FlattenedMetadata::load(const std::string& path, uint64_t contentHash, std::string& error)
+{
+    if(!std::ifstream(path)) {
+        error = "No cache at " + path;
+        return nullptr;
+    }
+
+    std::shared_ptr<MappedFile> mapping;
+    try {
+        mapping = std::make_shared<MappedFile>(path);
+    } catch(std::exception& e) {
+        error = e.what();
+        return nullptr;
+    }
+
+    CacheHeader header;
+    if(mapping->size() < sizeof(header)) {
+        error = "Cache file truncated";
+        return nullptr;
+    }
+    std::memcpy(&header, mapping->data(), sizeof(header));
+    if(std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 || header.version != metadataCacheVersion || header.byteOrderMark != byteOrderMark ||
+       header.metadataBlockSize != sizeof(MetadataBlock) || header.flattenedItemSize != sizeof(FlattenedItem)) {
+        error = "Cache file is from an incompatible version";
+        return nullptr;
+    }
+    if(header.contentHash != contentHash) {
+        error = "Cache file is for different content";
+        return nullptr;
+    }
+
+    auto tableFits = [&mapping](uint64_t offset, uint64_t count, uint64_t elementSize) {
+        return offset % 8 == 0 && offset <= mapping->size() && count <= (mapping->size() - offset) / elementSize;
+    };
+    if(!tableFits(header.itemsOffset, header.itemCount, sizeof(FlattenedItem)) ||
+       !tableFits(header.blocksOffset, header.blockCount, sizeof(MetadataBlock)) ||
+       !tableFits(header.channelNumsOffset, header.channelNumCount, sizeof(int32_t)) ||
+       !tableFits(header.audioProgrammeIdsOffset, header.audioProgrammeIdCount, sizeof(uint16_t))) {
+        error = "Cache file truncated";
+        return nullptr;
+    }
+
+    auto flattened = std::make_shared<FlattenedMetadata>();
+    flattened->items = reinterpret_cast<const FlattenedItem*>(mapping->data() + header.itemsOffset);
+    flattened->blocks = reinterpret_cast<const MetadataBlock*>(mapping->data() + header.blocksOffset);
+    flattened->channelNums = reinterpret_cast<const int32_t*>(mapping->data() + header.channelNumsOffset);
+    flattened->audioProgrammeIds = reinterpret_cast<const uint16_t*>(mapping->data() + header.audioProgrammeIdsOffset);
+    flattened->itemCount = header.itemCount;
+
+    // Every item must index within the tables
+    for(uint64_t i = 0; i < flattened->itemCount; i++) {
+        auto& item = flattened->items[i];
+        if(item.firstBlock > header.blockCount || item.blockCount > header.blockCount - item.firstBlock ||
+           item.firstChannelNum > header.channelNumCount || item.channelNumCount > header.channelNumCount - item.firstChannelNum ||
+           item.firstAudioProgrammeId > header.audioProgrammeIdCount || item.audioProgrammeIdCount > header.audioProgrammeIdCount - item.firstAudioProgrammeId) {
+            error = "Cache file is corrupt";
+            return nullptr;
+        }
+    }
+
+    flattened->mapping = mapping;
+    return flattened;
+}
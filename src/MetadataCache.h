@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <bw64/bw64.hpp>
+#include "Metadata.h"
+#include "MappedFile.h"
+
+// Everything a MetadataExtractor would ever send for a document, already flattened - so a repeat load can skip parsing and discovery.
+// Saved as a sidecar file named by a hash of the axml and chna, in a fixed-width native layout that's served straight from a memory mapping.
+
+// Bump whenever the file layout - or what the MetadataExtractor puts in a MetadataBlock - changes, so stale caches are ignored
+const uint32_t metadataCacheVersion = 2;
+
+// FNV-1a over the axml bytes and every CHNA entry
+uint64_t hashAdmChunks(const std::string& axml, const std::vector<bw64::AudioId>& audioIds);
+std::string metadataCachePath(const std::string& cacheDirectory, uint64_t contentHash);
+
+struct FlattenedItem {
+    uint64_t id;
+    uint64_t firstBlock;        // In to the block table, in the order they're sent
+    uint64_t blockCount;
+    uint64_t firstChannelNum;   // In to the channel number table
+    uint32_t channelNumCount;
+    uint32_t audioProgrammeIdCount;
+    uint64_t firstAudioProgrammeId; // In to the audioProgramme ID table
+};
+
+class FlattenedMetadata
+{
+public:
+    FlattenedMetadata();
+    ~FlattenedMetadata();
+
+    // Building (see MetadataExtractor::flatten) - blocks in the order they're sent
+    void addItem(uint64_t id, const std::vector<int>& channelNums, const std::vector<uint16_t>& audioProgrammeIds, const std::vector<MetadataBlock>& itemBlocks);
+    // Written to a temporary file and renamed in to place, so a reader never sees it half-written
+    bool save(const std::string& path, uint64_t contentHash, std::string& error);
+    // Null (with reason in error) if missing, for other content, or from an incompatible version or build
+    static std::shared_ptr<FlattenedMetadata> load(const std::string& path, uint64_t contentHash, std::string& error);
+
+    uint64_t getItemCount() const { return itemCount; }
+    const FlattenedItem& getItem(uint64_t index) const { return items[index]; }
+    const MetadataBlock& getBlock(const FlattenedItem& item, uint64_t index) const { return blocks[item.firstBlock + index]; }
+    const int32_t* getChannelNums(const FlattenedItem& item) const { return channelNums + item.firstChannelNum; }
+    const uint16_t* getAudioProgrammeIds(const FlattenedItem& item) const { return audioProgrammeIds + item.firstAudioProgrammeId; }
+
+private:
+    // Built in these, or loaded in to mapping - either way, read through the pointers below
+    std::vector<FlattenedItem> ownedItems;
+    std::vector<MetadataBlock> ownedBlocks;
+    std::vector<int32_t> ownedChannelNums;
+    std::vector<uint16_t> ownedAudioProgrammeIds;
+    std::shared_ptr<MappedFile> mapping;
+
+    const FlattenedItem* items{ nullptr };
+    const MetadataBlock* blocks{ nullptr };
+    const int32_t* channelNums{ nullptr };
+    const uint16_t* audioProgrammeIds{ nullptr };
+    uint64_t itemCount{ 0 };
+};
@@ -0,0 +1,158 @@
+#include "ReadAhead.h"
+#include "AudioKernels.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+    inline int64_t ringSlotFor(int64_t frame, int64_t capacityFrames)
+    {
+        int64_t slot = frame % capacityFrames;
+        return slot < 0 ? slot + capacityFrames : slot; // Frames can be negative (pre-roll)
+    }
+}
+
+AudioReadAhead::AudioReadAhead(const std::string& filePath, const Bw64Layout& layout, float readAheadSec, float lookBehindSec, EssenceIoBackend ioBackend)
+{
+    // Throws if the file can't be opened - let the caller deal with it
+    essenceReader = std::make_unique<EssenceReader>(filePath, layout, ioBackend);
+    double sampleRate = layout.sampleRate;
+    channelCount = layout.channels;
+    fileFrameCount = layout.frameCount;
+    lookBehindFrames = std::ceil(lookBehindSec * sampleRate);
+    capacityFrames = std::max((int64_t)std::ceil((readAheadSec + lookBehindSec) * sampleRate), (int64_t)1);
+    chunkFrames = std::max((int64_t)(sampleRate / 20.0), (int64_t)1); // 50ms per read - small enough to stay responsive to seeks
+    ring = std::vector<float>(capacityFrames * channelCount, 0.0);
+
+    producerThread = std::thread(&AudioReadAhead::producerLoop, this);
+}
+
+AudioReadAhead::~AudioReadAhead()
+{
+    running.store(false);
+    producerWake.notify_one();
+    if(producerThread.joinable()) {
+        producerThread.join();
+    }
+}
+
+bool AudioReadAhead::acquire(int64_t startFrame, int numFrames, AudioSegment segments[2], int& segmentCount)
+{
+    segmentCount = 0;
+    acquiredEpoch = ringEpoch.load(std::memory_order_acquire);
+
+    int64_t endFrame = startFrame + numFrames;
+    int64_t ringStart = ringStartFrame.load(std::memory_order_acquire);
+    int64_t ringEnd = ringEndFrame.load(std::memory_order_acquire);
+    int64_t earliestSafeFrame = consumerFrame.load(std::memory_order_relaxed);
+    bool seekPending = seekRequestFrame.load(std::memory_order_acquire) != noSeekRequest;
+    lastRequestEndFrame.store(endFrame, std::memory_order_relaxed);
+
+    // Only frames from consumerFrame onwards are protected from being overwritten, hence checking both that and ringStart
+    if(seekPending || startFrame < ringStart || startFrame < earliestSafeFrame || endFrame > ringEnd) {
+        underrunCount.fetch_add(1, std::memory_order_relaxed);
+        if(!seekPending) {
+            if(startFrame >= earliestSafeFrame && endFrame <= ringEnd + capacityFrames / 2) {
+                // We're just ahead of the producer (e.g, slow disk) - it's heading this way anyway
+                consumerFrame.store(std::max(earliestSafeFrame, std::min(startFrame - lookBehindFrames, ringEnd)), std::memory_order_release);
+            } else {
+                // Jumped somewhere the producer isn't going - restart the ring from here
+                int64_t seekFrame = startFrame - lookBehindFrames;
+                consumerFrame.store(seekFrame, std::memory_order_release);
+                seekRequestFrame.store(seekFrame, std::memory_order_release);
+            }
+        }
+        producerWake.notify_one();
+        return false;
+    }
+
+    // Let the producer reclaim everything before our look-behind window
+    int64_t newConsumerFrame = startFrame - lookBehindFrames;
+    if(newConsumerFrame > earliestSafeFrame) {
+        consumerFrame.store(newConsumerFrame, std::memory_order_release);
+        producerWake.notify_one();
+    }
+
+    int64_t slot = ringSlotFor(startFrame, capacityFrames);
+    int64_t firstFrames = std::min((int64_t)numFrames, capacityFrames - slot);
+    segments[0] = { ring.data() + slot * channelCount, startFrame, startFrame + firstFrames, channelCount, 1 };
+    segmentCount = 1;
+    if(firstFrames < numFrames) {
+        segments[1] = { ring.data(), startFrame + firstFrames, endFrame, channelCount, 1 };
+        segmentCount = 2;
+    }
+    return true;
+}
+
+bool AudioReadAhead::release()
+{
+    // Seqlock-style check; if the producer discarded the ring while we were copying, what we copied can't be trusted
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(ringEpoch.load(std::memory_order_relaxed) != acquiredEpoch) {
+        underrunCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+int64_t AudioReadAhead::getBufferedFrames() const
+{
+    return std::max(ringEndFrame.load(std::memory_order_relaxed) - lastRequestEndFrame.load(std::memory_order_relaxed), (int64_t)0);
+}
+
+void AudioReadAhead::producerLoop()
+{
+    while(running.load()) {
+
+        int64_t seekFrame = seekRequestFrame.load(std::memory_order_acquire);
+        if(seekFrame != noSeekRequest) {
+            // Invalidate anything the consumer is holding before we start overwriting
+            ringEpoch.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            ringStartFrame.store(seekFrame, std::memory_order_release);
+            ringEndFrame.store(seekFrame, std::memory_order_release);
+            seekRequestFrame.store(noSeekRequest, std::memory_order_release);
+        }
+
+        int64_t ringEnd = ringEndFrame.load(std::memory_order_relaxed);
+        int64_t writeLimit = consumerFrame.load(std::memory_order_acquire) + capacityFrames;
+
+        if(ringEnd < writeLimit) {
+            int64_t fillTo = std::min(ringEnd + chunkFrames, writeLimit);
+            // Publish the new start first - the frames about to be overwritten are no longer available
+            int64_t ringStart = ringStartFrame.load(std::memory_order_relaxed);
+            ringStartFrame.store(std::max(ringStart, fillTo - capacityFrames), std::memory_order_release);
+            fillRing(ringEnd, fillTo);
+            ringEndFrame.store(fillTo, std::memory_order_release);
+        } else {
+            // Full - wait for the consumer to move on (or ask us to seek, or shut down)
+            std::unique_lock<std::mutex> lock(producerWakeMutex);
+            producerWake.wait_for(lock, std::chrono::milliseconds(10));
+        }
+    }
+}
+
+void AudioReadAhead::fillRing(int64_t fromFrame, int64_t toFrame)
+{
+    while(fromFrame < toFrame) {
+        int64_t slot = ringSlotFor(fromFrame, capacityFrames);
+        int64_t runEnd = std::min(toFrame, fromFrame + (capacityFrames - slot)); // Don't cross the wrap point
+        float* dest = ring.data() + slot * channelCount;
+
+        // Pad anything outside the file with silence
+        int64_t readStart = std::min(std::max(fromFrame, (int64_t)0), runEnd);
+        int64_t readEnd = std::max(std::min(runEnd, fileFrameCount), readStart);
+
+        zeroSamples(dest, (readStart - fromFrame) * channelCount);
+        dest += (readStart - fromFrame) * channelCount;
+        if(readEnd > readStart) {
+            if(!essenceReader->readFrames(readStart, readEnd - readStart, dest)) {
+                zeroSamples(dest, (readEnd - readStart) * channelCount); // Short read (file changed under us?) - better silence than stale audio
+            }
+            dest += (readEnd - readStart) * channelCount;
+        }
+        zeroSamples(dest, (runEnd - readEnd) * channelCount);
+
+        fromFrame = runEnd;
+    }
+}
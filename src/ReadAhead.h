@@ -0,0 +1,76 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "EssenceReader.h"
+
+// Run of audio held in memory, frames [startFrame, endFrame). Sample for a frame and channel slot is
+//  samples[(frame - startFrame) * frameStride + slot * channelStride] - i.e, interleaved (frameStride = channel count, channelStride = 1)
+//  or planar (frameStride = 1, channelStride = frames held per channel).
+struct AudioSegment {
+    const float* samples;
+    int64_t startFrame;
+    int64_t endFrame;
+    int64_t frameStride;
+    int64_t channelStride;
+};
+
+class AudioReadAhead
+{
+    // Streams a BW64 file in to a ring buffer on a dedicated I/O thread, keeping a set amount of audio decoded ahead of the consumer.
+    // Single-producer (the I/O thread) / single-consumer (whoever calls acquire/release - normally the audio thread).
+    // The consumer side never blocks, allocates or touches the disk. If the audio it wants isn't in the ring, that's an underrun.
+
+public:
+    // The layout is the one the synchronous path reads with, so both decode the file the same way. Throws if the file can't be opened.
+    AudioReadAhead(const std::string& filePath, const Bw64Layout& layout, float readAheadSec, float lookBehindSec, EssenceIoBackend ioBackend = EssenceIoBackend::AUTO);
+    ~AudioReadAhead();
+
+    // Provides up to 2 segments (the ring may wrap) covering [startFrame, startFrame + numFrames). Returns false on underrun.
+    // Segments remain valid until release() - which reports whether the producer invalidated them (by seeking) in the meantime.
+    bool acquire(int64_t startFrame, int numFrames, AudioSegment segments[2], int& segmentCount);
+    bool release();
+
+    int getChannelCount() const { return channelCount; }
+    int64_t getCapacityFrames() const { return capacityFrames; }
+    int64_t getBufferedFrames() const; // Frames available beyond the end of the last request
+    uint64_t getUnderrunCount() const { return underrunCount.load(std::memory_order_relaxed); }
+
+private:
+    void producerLoop();
+    void fillRing(int64_t fromFrame, int64_t toFrame);
+
+    // Separate reader to the synchronous path's (EssenceReader isn't thread-safe), over the same layout
+    std::unique_ptr<EssenceReader> essenceReader;
+    int channelCount{ 0 };
+    int64_t fileFrameCount{ 0 };
+    int64_t lookBehindFrames{ 0 };
+    int64_t capacityFrames{ 0 };
+    int64_t chunkFrames{ 0 };
+    std::vector<float> ring;
+
+    // Ring holds [ringStartFrame, ringEndFrame). Producer owns both.
+    std::atomic<int64_t> ringStartFrame{ 0 };
+    std::atomic<int64_t> ringEndFrame{ 0 };
+    // Earliest frame the consumer may still want - producer will not overwrite from here on. Consumer owns this.
+    std::atomic<int64_t> consumerFrame{ 0 };
+    std::atomic<int64_t> lastRequestEndFrame{ 0 };
+    // Consumer asks the producer to jump by posting a frame here. noSeekRequest when idle.
+    static const int64_t noSeekRequest = INT64_MIN;
+    std::atomic<int64_t> seekRequestFrame{ noSeekRequest };
+    // Bumped by the producer when it discards the ring contents on a seek, so the consumer can detect a torn read
+    std::atomic<uint32_t> ringEpoch{ 0 };
+    uint32_t acquiredEpoch{ 0 };
+
+    std::atomic<uint64_t> underrunCount{ 0 };
+
+    std::atomic<bool> running{ true };
+    std::mutex producerWakeMutex;
+    std::condition_variable producerWake;
+    std::thread producerThread;
+};
@@ -1,18 +1,114 @@
 #include "Readers.h"
 #include "Helpers.h"
 #include "ExceptionHandler.h"
+#include "MetadataCache.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
 
 namespace {
-    FileReader* fileReader = nullptr;
-}
+    const size_t sadmReadChunkBytes = 64 * 1024;
+    const size_t sadmMaxFrameBytes = 64 * 1024 * 1024; // Beyond this without a frame end, it's not S-ADM
 
-FileReader* getFileReaderSingleton()
-{
-    // TODO - need a destroy method to tidy this up when unloading lib
-    if(!fileReader) {
-        fileReader = new FileReader();
+    void reflectChnaRefsInAdm(const std::vector<bw64::AudioId>& audioIds, std::shared_ptr<adm::Document> parsedDocument)
+    {
+        // Some refs may only be provided in the CHNA, which is no good for our 'universal' metadata extractor.
+        // Therefore ensure these refs are present in the ADM.
+
+        /// Some older (and technically incorrect) ADM files only provide audioTrackUid->AudioTrackFormat refs in the CHNA chunk
+        for(auto& audioId : audioIds)
+        {
+            uint32_t audioTrackUidValue;
+            if(!parseAudioTrackUidValue(audioId.uid(), audioTrackUidValue)) continue;
+            auto audioTrackUid = parsedDocument->lookup(adm::AudioTrackUidId(adm::AudioTrackUidIdValue(audioTrackUidValue)));
+            if(!audioTrackUid) continue;
+
+            auto audioTrackFormatId = adm::parseAudioTrackFormatId(audioId.trackRef());
+            auto audioTrackFormat = parsedDocument->lookup(audioTrackFormatId);
+            if(!audioTrackFormat) continue;
+
+            audioTrackUid->setReference(audioTrackFormat);
+        }
+    }
+
+    int lookupChannelNumInChna(const ChnaIndex& chnaIndex, std::shared_ptr<adm::AudioTrackUid> audioTrackUid)
+    {
+        return chnaIndex.getChannelNumFor(audioTrackUid->get<adm::AudioTrackUidId>().get<adm::AudioTrackUidIdValue>().get()); // -1 = not found
+    }
+
+    std::string fixedLengthString(const uint8_t* chars, size_t length)
+    {
+        // CHNA strings are NUL-padded to a fixed length
+        size_t used = 0;
+        while(used < length && chars[used] != 0) used++;
+        return std::string(reinterpret_cast<const char*>(chars), used);
+    }
+
+    // Reads characters straight out of memory the caller keeps alive, so the parser can be given a stream without copying in to one
+    class MemoryStreamBuffer : public std::streambuf
+    {
+    public:
+        MemoryStreamBuffer(const char* data, size_t size)
+        {
+            char* begin = const_cast<char*>(data); // Only ever read from
+            setg(begin, begin, begin + size);
+        }
+
+    protected:
+        pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode which) override
+        {
+            if(!(which & std::ios_base::in)) return pos_type(off_type(-1));
+            off_type base = direction == std::ios_base::beg ? 0 : direction == std::ios_base::cur ? gptr() - eback() : egptr() - eback();
+            return seekpos(pos_type(base + offset), which);
+        }
+        pos_type seekpos(pos_type position, std::ios_base::openmode which) override
+        {
+            off_type offset = off_type(position);
+            if(!(which & std::ios_base::in) || offset < 0 || offset > egptr() - eback()) return pos_type(off_type(-1));
+            setg(eback(), eback() + offset, egptr());
+            return position;
+        }
+    };
+
+    // The whole document - or with a lazy window, just its structure, with block locations for the MetadataExtractor to materialise from later
+    std::shared_ptr<adm::Document> parseAxml(const char* axml, size_t size, double lazyBlockFormatsWindowSec, std::map<std::string, ChannelFormatBlockLocations>& blockLocations)
+    {
+        blockLocations.clear();
+        if(lazyBlockFormatsWindowSec > 0.0) {
+            std::string structuralXml;
+            indexBlockFormats(axml, size, structuralXml, blockLocations);
+            MemoryStreamBuffer buffer(structuralXml.data(), structuralXml.size());
+            std::istream stream(&buffer);
+            return adm::parseXml(stream);
+        }
+        MemoryStreamBuffer buffer(axml, size);
+        std::istream stream(&buffer);
+        return adm::parseXml(stream);
+    }
+
+    bool parseChna(const uint8_t* chunk, uint64_t chunkSize, std::vector<bw64::AudioId>& audioIds, std::string& error)
+    {
+        // uint16 numTracks, uint16 numUids, then numUids 40-byte entries of:
+        //  uint16 trackIndex, char uid[12], char trackRef[14], char packRef[11], 1 byte pad
+        const uint64_t entrySize = 40;
+        if(chunkSize < 4) {
+            error = "chna chunk too short";
+            return false;
+        }
+        uint16_t numUids = (uint16_t)chunk[2] | ((uint16_t)chunk[3] << 8);
+        if(4 + numUids * entrySize > chunkSize) {
+            error = "chna chunk too short for its " + std::to_string(numUids) + " entries";
+            return false;
+        }
+        audioIds.clear();
+        for(uint16_t index = 0; index < numUids; index++) {
+            const uint8_t* entry = chunk + 4 + index * entrySize;
+            uint16_t trackIndex = (uint16_t)entry[0] | ((uint16_t)entry[1] << 8);
+            if(trackIndex == 0) continue; // Unused (pre-allocated) entry
+            audioIds.push_back(bw64::AudioId(trackIndex, fixedLengthString(entry + 2, 12), fixedLengthString(entry + 14, 14), fixedLengthString(entry + 28, 11)));
+        }
+        return true;
     }
-    return fileReader;
 }
 
 FileReader::FileReader()
@@ -21,11 +117,19 @@ FileReader::FileReader()
 
 FileReader::~FileReader()
 {
+    if(admParseThread.joinable()) {
+        admParseThread.join();
+    }
 }
 
-std::shared_ptr<bw64::Bw64Reader> FileReader::getReader()
+std::string FileReader::getFilePath()
 {
-    return bw64Reader;
+    return filePath;
+}
+
+const Bw64Layout& FileReader::getLayout()
+{
+    return layout;
 }
 
 std::shared_ptr<AudioExtractor> FileReader::getAudio()
@@ -33,28 +137,412 @@ std::shared_ptr<AudioExtractor> FileReader::getAudio()
     return audioExtractor;
 }
 
+std::shared_ptr<Bw64AudioExtractor> FileReader::getBw64Audio()
+{
+    return bw64AudioExtractor;
+}
+
 std::shared_ptr<MetadataExtractor> FileReader::getMetadata()
 {
+    std::lock_guard<std::mutex> lock(admParseMutex);
     return metadataExtractor;
 }
 
+AdmParseStatus FileReader::getAdmParseStatus()
+{
+    std::lock_guard<std::mutex> lock(admParseMutex);
+    return admParseStatus;
+}
+
+std::string FileReader::getAdmParseError()
+{
+    std::lock_guard<std::mutex> lock(admParseMutex);
+    return admParseError;
+}
+
+void FileReader::close()
+{
+    // The parse can't be interrupted, but it only touches what it's given and our audioIds (which are left alone until it's done)
+    if(admParseThread.joinable()) {
+        admParseThread.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(admParseMutex);
+        parsedDocument = nullptr;
+        metadataExtractor.reset();
+        admParseStatus = AdmParseStatus::NONE;
+        admParseError.clear();
+        metadataFromCache = false;
+    }
+    layout = Bw64Layout{};
+    audioIds.clear();
+    chnaIndex.clear();
+    audioExtractor.reset();
+    bw64AudioExtractor.reset();
+    mappedFile.reset();
+    filePath.clear();
+}
+
 int FileReader::readAdm(char filePath[2048])
 {
-    bw64Reader = nullptr;
-    parsedDocument = nullptr;
+    if(readAdmAsync(filePath) != 0) {
+        return 1; // readAdmAsync provides reason
+    }
+    admParseThread.join();
+    if(getAdmParseStatus() != AdmParseStatus::READY) {
+        getExceptionHandler()->logException(getAdmParseError());
+        return 1;
+    }
+    return 0;
+}
+
+int FileReader::readAdmAsync(char filePath[2048])
+{
+    close();
+    this->filePath = filePath;
+
+    // Only the chunk headers, fmt and chna are read here - the axml is left for admParseThread
+    std::string layoutError;
+    if(!readBw64Layout(this->filePath, layout, layoutError)) {
+        getExceptionHandler()->logException("Unable to read BW64: " + layoutError);
+        return 1;
+    }
+    if(layout.axmlSize == 0) {
+        getExceptionHandler()->logException("Unable to read BW64: no axml chunk");
+        return 1;
+    }
+    if(layout.chnaSize == 0) {
+        getExceptionHandler()->logException("Unable to read BW64: no chna chunk");
+        return 1;
+    }
+    std::vector<uint8_t> chna(layout.chnaSize);
+    std::ifstream file(this->filePath, std::ios::binary);
+    file.seekg(layout.chnaOffset);
+    file.read(reinterpret_cast<char*>(chna.data()), chna.size());
+    std::string chnaError = "truncated chna chunk";
+    if(!file || !parseChna(chna.data(), chna.size(), audioIds, chnaError)) {
+        getExceptionHandler()->logException("Unable to read BW64: " + chnaError);
+        return 1;
+    }
+    chnaIndex.build(audioIds);
+
+    // Audio doesn't depend on the ADM, so set it up (possibly preloading) while the parse runs
+    {
+        std::lock_guard<std::mutex> lock(admParseMutex);
+        admParseStatus = AdmParseStatus::PARSING;
+    }
+    admParseThread = std::thread(&FileReader::parseAdm, this, lazyBlockFormatsWindowSec, metadataCacheDirectory);
+    // Without audio the file is unusable - so wait for the parse (it can't be interrupted) and discard what it published
+    auto abandonParse = [this]() {
+        admParseThread.join();
+        audioExtractor.reset();
+        bw64AudioExtractor.reset();
+        std::lock_guard<std::mutex> lock(admParseMutex);
+        parsedDocument = nullptr;
+        metadataExtractor.reset();
+        metadataFromCache = false;
+        admParseStatus = AdmParseStatus::FAILED;
+        admParseError = "Unable to set up audio";
+    };
+
+    if(audioAccessMode == AudioAccessMode::MAPPED) {
+        // From here on, audio is served straight out of the mapping
+        try {
+            mappedFile = std::make_shared<MappedFile>(filePath);
+        } catch(std::exception &e) {
+            getExceptionHandler()->logException(e.what());
+            abandonParse();
+            return 1;
+        }
+        audioExtractor = std::make_shared<MappedAudioExtractor>(mappedFile, layout);
+
+    } else if(audioAccessMode == AudioAccessMode::PRELOADED) {
+        // Discovery hasn't run yet, so "referenced" means anything the CHNA maps a track to
+        std::vector<int> channelNums;
+        if(audioCacheReferencedChannelsOnly) {
+            for(auto& audioId : audioIds) {
+                channelNums.push_back(audioId.trackIndex() - 1); // trackIndex is 1-based
+            }
+        }
+        auto preloadedAudioExtractor = std::make_shared<PreloadedAudioExtractor>(this);
+        if(!preloadedAudioExtractor->load(channelNums)) {
+            abandonParse();
+            return 1; // load provides reason
+        }
+        audioExtractor = preloadedAudioExtractor;
+
+    } else {
+        bw64AudioExtractor = std::make_shared<Bw64AudioExtractor>(this);
+        audioExtractor = bw64AudioExtractor;
+        bw64AudioExtractor->setCacheBudget(audioCacheBudgetBytes);
+        updateCachedAudioChannels();
+        if(audioReadAheadSec > 0.0 && !bw64AudioExtractor->setReadAhead(audioReadAheadSec)) {
+            abandonParse();
+            return 1; // setReadAhead provides reason
+        }
+    }
+
+    return 0;
+}
+
+void FileReader::parseAdm(double lazyBlockFormatsWindowSec, std::string metadataCacheDirectory)
+{
+    // Runs on admParseThread - reads the axml, then builds everything locally and publishes it all at once
+    std::string axml(layout.axmlSize, '\0');
+    {
+        std::ifstream file(filePath, std::ios::binary);
+        file.seekg(layout.axmlOffset);
+        file.read(&axml[0], axml.size());
+        if(!file) {
+            std::lock_guard<std::mutex> lock(admParseMutex);
+            admParseError = "Unable to read BW64: truncated axml chunk";
+            admParseStatus = AdmParseStatus::FAILED;
+            return;
+        }
+    }
+
+    uint64_t contentHash = 0;
+    if(!metadataCacheDirectory.empty()) {
+        contentHash = hashAdmChunks(axml, audioIds);
+        std::string cacheError;
+        auto flattened = FlattenedMetadata::load(metadataCachePath(metadataCacheDirectory, contentHash), contentHash, cacheError);
+        if(flattened) {
+            // Seen this before - no parse or discovery needed
+            auto extractor = std::make_shared<MetadataExtractor>(this, flattened);
+            std::lock_guard<std::mutex> lock(admParseMutex);
+            metadataExtractor = extractor;
+            metadataFromCache = true;
+            admParseStatus = AdmParseStatus::READY;
+            return;
+        }
+        lazyBlockFormatsWindowSec = 0.0; // Flattening needs every block
+    }
+
+    std::shared_ptr<adm::Document> document;
+    std::map<std::string, ChannelFormatBlockLocations> blockLocations;
+    try
+    {
+        document = parseAxml(axml.data(), axml.size(), lazyBlockFormatsWindowSec, blockLocations);
+    }
+    catch (std::exception &e)
+    {
+        std::lock_guard<std::mutex> lock(admParseMutex);
+        admParseError = e.what();
+        admParseStatus = AdmParseStatus::FAILED;
+        return;
+    }
+
+    reflectChnaRefsInAdm(audioIds, document);
+    auto extractor = std::make_shared<MetadataExtractor>(this, document);
+
+    if(!metadataCacheDirectory.empty()) {
+        // Serve from the flattened form now too, so this session behaves exactly as a cached one would - the document isn't needed after this
+        auto flattened = extractor->flatten();
+        std::string cacheError;
+        flattened->save(metadataCachePath(metadataCacheDirectory, contentHash), contentHash, cacheError); // Failing just means parsing again next time
+        extractor = std::make_shared<MetadataExtractor>(this, flattened);
+        document = nullptr;
+
+    } else if(!blockLocations.empty()) {
+        // Blocks are re-read from the axml chunk on disk as they're needed, so its text needn't stay in memory
+        AxmlFragmentSource source;
+        auto file = std::make_shared<std::ifstream>(filePath, std::ios::binary);
+        if(*file) {
+            uint64_t axmlOffset = layout.axmlOffset;
+            source = [file, axmlOffset](uint64_t offset, uint64_t length, std::string& fragment) {
+                fragment.resize(length);
+                file->clear();
+                file->seekg(axmlOffset + offset);
+                file->read(&fragment[0], length);
+                return (bool)*file;
+            };
+        } else {
+            // Can't open it again - keep the text instead
+            auto axmlText = std::make_shared<std::string>(std::move(axml));
+            source = [axmlText](uint64_t offset, uint64_t length, std::string& fragment) {
+                if(offset + length > axmlText->size()) return false;
+                fragment.assign(*axmlText, offset, length);
+                return true;
+            };
+        }
+        extractor->setLazyBlockFormats(std::move(blockLocations), source, lazyBlockFormatsWindowSec);
+    }
+
+    std::lock_guard<std::mutex> lock(admParseMutex);
+    parsedDocument = document;
+    metadataExtractor = extractor;
+    admParseStatus = AdmParseStatus::READY;
+}
+
+bool FileReader::setAudioReadAhead(float readAheadSec)
+{
+    audioReadAheadSec = std::max(readAheadSec, 0.0f);
+    if(bw64AudioExtractor) {
+        return bw64AudioExtractor->setReadAhead(audioReadAheadSec);
+    }
+    return true;
+}
+
+void FileReader::setAudioCacheBudget(uint64_t budgetBytes)
+{
+    audioCacheBudgetBytes = budgetBytes;
+    if(bw64AudioExtractor) {
+        bw64AudioExtractor->setCacheBudget(audioCacheBudgetBytes);
+    }
+}
+
+void FileReader::setAudioCacheReferencedChannelsOnly(bool referencedOnly)
+{
+    audioCacheReferencedChannelsOnly = referencedOnly;
+    updateCachedAudioChannels();
+}
+
+void FileReader::setAudioProgrammeFilter(int audioProgrammeId)
+{
+    audioProgrammeFilter = audioProgrammeId;
+    updateCachedAudioChannels();
+}
+
+void FileReader::updateCachedAudioChannels()
+{
+    if(!bw64AudioExtractor) return;
+    auto metadataExtractor = getMetadata();
+    if(audioCacheReferencedChannelsOnly && metadataExtractor) {
+        auto channelNums = metadataExtractor->getReferencedChannelNums(audioProgrammeFilter);
+        if(!channelNums.empty()) {
+            bw64AudioExtractor->setCachedChannels(channelNums);
+            return;
+        }
+    }
+    bw64AudioExtractor->setCachedChannels({}); // Everything - also used until discovery has found anything
+}
+
+void FileReader::setAudioAccessMode(AudioAccessMode mode)
+{
+    audioAccessMode = mode;
+}
+
+void FileReader::setAudioIoBackend(EssenceIoBackend backend)
+{
+    audioIoBackend = backend;
+}
+
+EssenceIoBackend FileReader::getAudioIoBackend()
+{
+    return audioIoBackend;
+}
+
+void FileReader::setLazyBlockFormatsWindow(double windowSec)
+{
+    lazyBlockFormatsWindowSec = std::max(windowSec, 0.0);
+}
+
+void FileReader::setMetadataCacheDirectory(const std::string& cacheDirectory)
+{
+    metadataCacheDirectory = cacheDirectory;
+}
+
+bool FileReader::isMetadataFromCache()
+{
+    std::lock_guard<std::mutex> lock(admParseMutex);
+    return metadataFromCache;
+}
+
+int FileReader::getChannelNumFor(std::shared_ptr<adm::AudioTrackUid> audioTrackUid)
+{
+    // This will vary depending on how mappings are provided for a Filebased or S-ADM stream, so has to be part of the reader.
+
+    /// In this case... Lookup in CHNA for file-based
+    return lookupChannelNumInChna(chnaIndex, audioTrackUid);
+}
+
+MemoryReader::MemoryReader()
+{
+}
+
+MemoryReader::~MemoryReader()
+{
+}
+
+std::shared_ptr<AudioExtractor> MemoryReader::getAudio()
+{
+    return audioExtractor;
+}
+
+std::shared_ptr<MetadataExtractor> MemoryReader::getMetadata()
+{
+    return metadataExtractor;
+}
+
+AdmParseStatus MemoryReader::getAdmParseStatus()
+{
+    return metadataExtractor ? AdmParseStatus::READY : AdmParseStatus::NONE;
+}
+
+std::string MemoryReader::getAdmParseError()
+{
+    return std::string();
+}
+
+int MemoryReader::getChannelNumFor(std::shared_ptr<adm::AudioTrackUid> audioTrackUid)
+{
+    /// Same CHNA lookup as file-based - it's the same format, just already in memory
+    return lookupChannelNumInChna(chnaIndex, audioTrackUid);
+}
+
+void MemoryReader::close()
+{
     audioExtractor.reset();
     metadataExtractor.reset();
+    parsedDocument = nullptr;
+    audioIds.clear();
+    chnaIndex.clear();
+    data = nullptr;
+    size = 0;
+}
+
+void MemoryReader::setLazyBlockFormatsWindow(double windowSec)
+{
+    lazyBlockFormatsWindowSec = std::max(windowSec, 0.0);
+}
 
+int MemoryReader::readAdm(const void* data, uint64_t size)
+{
+    close();
+    if(!data) {
+        getExceptionHandler()->logException("No data to read ADM from");
+        return 1;
+    }
+    this->data = static_cast<const uint8_t*>(data);
+    this->size = size;
+
+    Bw64Layout layout;
+    std::string layoutError;
+    if(!parseBw64Layout(this->data, size, layout, layoutError)) {
+        getExceptionHandler()->logException("Unable to read BW64 from memory: " + layoutError);
+        return 1;
+    }
+    if(layout.axmlSize == 0 || layout.axmlOffset + layout.axmlSize > size) {
+        getExceptionHandler()->logException("Unable to read BW64 from memory: missing or truncated axml chunk");
+        return 1;
+    }
+    if(layout.chnaSize == 0 || layout.chnaOffset + layout.chnaSize > size) {
+        getExceptionHandler()->logException("Unable to read BW64 from memory: missing or truncated chna chunk");
+        return 1;
+    }
+
+    std::string chnaError;
+    if(!parseChna(this->data + layout.chnaOffset, layout.chnaSize, audioIds, chnaError)) {
+        getExceptionHandler()->logException("Unable to read BW64 from memory: " + chnaError);
+        return 1;
+    }
+    chnaIndex.build(audioIds);
+
+    std::map<std::string, ChannelFormatBlockLocations> blockLocations;
     try
     {
-        bw64Reader = bw64::readFile(filePath);
-        auto aXml = bw64Reader->axmlChunk();
-        auto chnaChunk = bw64Reader->chnaChunk();
-        audioIds = chnaChunk->audioIds();
-
-        std::stringstream stream;
-        aXml->write(stream);
-        parsedDocument = adm::parseXml(stream);
+        // Parsed in place - the parser's own buffer is the only copy made, and only of the axml
+        parsedDocument = parseAxml(reinterpret_cast<const char*>(this->data + layout.axmlOffset), layout.axmlSize, lazyBlockFormatsWindowSec, blockLocations);
     }
     catch (std::exception &e)
     {
@@ -62,46 +550,201 @@ int FileReader::readAdm(char filePath[2048])
         return 1;
     }
 
-    reflectChnaRefsInAdm();
-    audioExtractor = std::make_unique<Bw64AudioExtractor>(this);
-    metadataExtractor = std::make_unique<MetadataExtractor>(this, parsedDocument);
+    reflectChnaRefsInAdm(audioIds, parsedDocument);
+    metadataExtractor = std::make_shared<MetadataExtractor>(this, parsedDocument);
+
+    if(!blockLocations.empty()) {
+        const uint8_t* axml = this->data + layout.axmlOffset;
+        uint64_t axmlSize = layout.axmlSize;
+        auto source = [axml, axmlSize](uint64_t offset, uint64_t length, std::string& fragment) {
+            if(offset + length > axmlSize) return false;
+            fragment.assign(reinterpret_cast<const char*>(axml + offset), length);
+            return true;
+        };
+        metadataExtractor->setLazyBlockFormats(std::move(blockLocations), source, lazyBlockFormatsWindowSec);
+    }
+    audioExtractor = std::make_shared<MappedAudioExtractor>(this->data, layout);
+
     return 0;
 }
 
-void FileReader::reflectChnaRefsInAdm()
+SadmReader::SadmReader()
 {
-    // Some refs may only be provided in the CHNA, which is no good for our 'universal' metadata extractor.
-    // Therefore ensure these refs are present in the ADM.
+}
 
-    /// Some older (and technically incorrect) ADM files only provide audioTrackUid->AudioTrackFormat refs in the CHNA chunk
-    for(auto& audioId : audioIds)
-    {
-        auto audioTrackUidId = adm::parseAudioTrackUidId(audioId.uid());
-        auto audioTrackUid = parsedDocument->lookup(audioTrackUidId);
-        if(!audioTrackUid) continue;
+SadmReader::~SadmReader()
+{
+    close();
+}
 
-        auto audioTrackFormatId = adm::parseAudioTrackFormatId(audioId.trackRef());
-        auto audioTrackFormat = parsedDocument->lookup(audioTrackFormatId);
-        if(!audioTrackFormat) continue;
+std::shared_ptr<AudioExtractor> SadmReader::getAudio()
+{
+    return nullptr;
+}
 
-        audioTrackUid->setReference(audioTrackFormat);
-    }
+std::shared_ptr<MetadataExtractor> SadmReader::getMetadata()
+{
+    mergeIngestedFrames();
+    return metadataExtractor;
 }
 
+int SadmReader::getChannelNumFor(std::shared_ptr<adm::AudioTrackUid> audioTrackUid)
+{
+    return lookupChannelNumInChna(chnaIndex, audioTrackUid);
+}
 
-int FileReader::getChannelNumFor(std::shared_ptr<adm::AudioTrackUid> audioTrackUid)
+AdmParseStatus SadmReader::getAdmParseStatus()
 {
-    // This will vary depending on how mappings are provided for a Filebased or S-ADM stream, so has to be part of the reader.
+    mergeIngestedFrames();
+    if(metadataExtractor) return AdmParseStatus::READY;
+    if(!reading) return AdmParseStatus::NONE;
+    std::lock_guard<std::mutex> lock(ingestMutex);
+    return feedEnded && ingestedFrames.empty() ? AdmParseStatus::FAILED : AdmParseStatus::PARSING;
+}
 
-    /// In this case... Lookup in CHNA for file-based
-    auto targetAudioTrackUidRefStr = adm::formatId(audioTrackUid->get<adm::AudioTrackUidId>());
-    for(auto& audioId : audioIds)
+std::string SadmReader::getAdmParseError()
+{
+    std::lock_guard<std::mutex> lock(ingestMutex);
+    if(ingestError.empty() && feedEnded && !metadataExtractor) return "S-ADM feed ended without a frame";
+    return ingestError;
+}
+
+int SadmReader::readSadm(const std::string& path)
+{
+    close();
+    std::string error;
+    if(!feed.open(path, error)) {
+        getExceptionHandler()->logException(error);
+        return 1;
+    }
+    reading = true;
+    stopIngest = false;
+    ingestThread = std::thread(&SadmReader::ingest, this);
+    return 0;
+}
+
+void SadmReader::close()
+{
+    stopIngest = true;
+    if(ingestThread.joinable()) {
+        ingestThread.join();
+    }
+    feed.close();
     {
-        auto audioTrackUidRefStr = audioId.uid();
-        if(targetAudioTrackUidRefStr == audioTrackUidRefStr) {
-            return audioId.trackIndex() - 1; // trackIndex is 1-based
+        std::lock_guard<std::mutex> lock(ingestMutex);
+        ingestedFrames.clear();
+        failedFrameCount = 0;
+        feedEnded = false;
+        ingestError.clear();
+    }
+    reading = false;
+    parsedDocument = nullptr;
+    chnaIndex.clear();
+    metadataExtractor.reset();
+    mergedFrameCount = 0;
+    lastLatencyMs = 0.0;
+    totalLatencyMs = 0.0;
+    maxLatencyMs = 0.0;
+}
+
+SadmIngestStats SadmReader::getIngestStats()
+{
+    SadmIngestStats stats{};
+    stats.frameCount = mergedFrameCount;
+    stats.lastLatencyMs = lastLatencyMs;
+    stats.meanLatencyMs = mergedFrameCount > 0 ? totalLatencyMs / mergedFrameCount : 0.0;
+    stats.maxLatencyMs = maxLatencyMs;
+    std::lock_guard<std::mutex> lock(ingestMutex);
+    stats.failedFrameCount = failedFrameCount;
+    stats.feedEnded = feedEnded;
+    return stats;
+}
+
+void SadmReader::ingest()
+{
+    // Only reads and parses - the document is left to the host's thread, so nothing it's using changes under it
+    SadmFrameSplitter splitter;
+    std::vector<char> buffer(sadmReadChunkBytes);
+    std::string frame;
+    std::string error;
+    int64_t count;
+    while((count = feed.read(buffer.data(), buffer.size(), stopIngest, error)) > 0) {
+        splitter.append(buffer.data(), (size_t)count);
+        while(splitter.next(frame)) {
+            IngestedFrame ingestedFrame;
+            ingestedFrame.receivedTime = std::chrono::steady_clock::now();
+            try
+            {
+                std::istringstream stream(frame);
+                ingestedFrame.document = adm::parseXml(stream, adm::xml::ParserOptions::recursive_node_search); // audioFormatExtended is within the frame
+            }
+            catch (std::exception &e)
+            {
+                std::lock_guard<std::mutex> lock(ingestMutex);
+                failedFrameCount++;
+                ingestError = std::string("S-ADM frame skipped: ") + e.what();
+                continue;
+            }
+            ingestedFrame.transportTracks = parseSadmTransportTracks(frame);
+            std::lock_guard<std::mutex> lock(ingestMutex);
+            ingestedFrames.push_back(std::move(ingestedFrame));
+        }
+        if(splitter.getBufferedSize() > sadmMaxFrameBytes) {
+            error = "S-ADM feed has no frame end within " + std::to_string(sadmMaxFrameBytes) + " bytes";
+            break;
         }
     }
 
-    return -1; // -1 = not found
+    std::lock_guard<std::mutex> lock(ingestMutex);
+    feedEnded = true;
+    if(!error.empty()) {
+        ingestError = error;
+    }
+}
+
+void SadmReader::mergeIngestedFrames()
+{
+    std::deque<IngestedFrame> frames;
+    {
+        std::lock_guard<std::mutex> lock(ingestMutex);
+        frames.swap(ingestedFrames);
+    }
+
+    for(auto& frame : frames) {
+        for(auto& transportTrack : frame.transportTracks) {
+            chnaIndex.add(transportTrack.first, transportTrack.second);
+        }
+
+        if(!parsedDocument) {
+            parsedDocument = frame.document; // Nothing to merge in to - the first frame becomes the document
+        } else {
+            try
+            {
+                SadmMergeChanges changes;
+                mergeSadmFrame(parsedDocument, frame.document, changes);
+                if(metadataExtractor) {
+                    // Discovery only looks at elements added to the document unless told which have gained references
+                    for(auto& audioProgramme : changes.audioProgrammes) metadataExtractor->markReferencesAdded(audioProgramme);
+                    for(auto& audioContent : changes.audioContents) metadataExtractor->markReferencesAdded(audioContent);
+                    for(auto& audioObject : changes.audioObjects) metadataExtractor->markReferencesAdded(audioObject);
+                }
+            }
+            catch (std::exception &e)
+            {
+                getExceptionHandler()->logException(std::string("S-ADM frame skipped: ") + e.what());
+                std::lock_guard<std::mutex> lock(ingestMutex);
+                failedFrameCount++;
+                continue;
+            }
+        }
+        if(!metadataExtractor) {
+            metadataExtractor = std::make_shared<MetadataExtractor>(this, parsedDocument);
+        }
+
+        double latencyMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame.receivedTime).count();
+        mergedFrameCount++;
+        lastLatencyMs = latencyMs;
+        totalLatencyMs += latencyMs;
+        maxLatencyMs = std::max(maxLatencyMs, latencyMs);
+    }
 }
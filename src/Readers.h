@@ -4,10 +4,30 @@
 #include <bw64/bw64.hpp>
 #include <adm/parse.hpp>
 #include <vector>
+#include <atomic>
+#include <chrono>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include "Audio.h"
 #include "Metadata.h"
+#include "ChnaIndex.h"
+#include "SadmFrames.h"
+
+enum class AudioAccessMode {
+    BUFFERED = 0,   // Blocks of the file read in to a private cache (optionally streamed by a read-ahead thread)
+    MAPPED = 1,     // File memory-mapped and served directly from the mapping
+    PRELOADED = 2   // Whole file decoded in to (compact) memory by readAdm - no disk access after that
+};
+
+enum class AdmParseStatus {
+    NONE = 0,       // Nothing read
+    PARSING = 1,    // Audio is available, metadata isn't yet
+    READY = 2,
+    FAILED = 3
+};
 
 class Reader
 {
@@ -18,7 +38,11 @@ public:
 
     virtual std::shared_ptr<AudioExtractor> getAudio() = 0;
     virtual std::shared_ptr<MetadataExtractor> getMetadata() = 0;
+    // Called from several threads at once during parallel discovery (see MetadataExtractor::setDiscoveryThreadCount) - must only read
     virtual int getChannelNumFor(std::shared_ptr<adm::AudioTrackUid> audioTrackUid) = 0;
+    virtual AdmParseStatus getAdmParseStatus() = 0;
+    // Reason for FAILED
+    virtual std::string getAdmParseError() = 0;
 };
 
 class FileReader : public Reader
@@ -27,22 +51,163 @@ public:
     FileReader();
     ~FileReader();
 
-    std::shared_ptr<bw64::Bw64Reader> getReader();
+    std::string getFilePath();
+    // Where the current file's chunks are - only the chunk headers, fmt and chna are read to find them
+    const Bw64Layout& getLayout();
     std::shared_ptr<AudioExtractor> getAudio() override;
-    std::shared_ptr<MetadataExtractor> getMetadata() override;
+    std::shared_ptr<Bw64AudioExtractor> getBw64Audio();
+    std::shared_ptr<MetadataExtractor> getMetadata() override; // Null until the ADM has been parsed
 
     int getChannelNumFor(std::shared_ptr<adm::AudioTrackUid> audioTrackUid) override;
+    AdmParseStatus getAdmParseStatus() override;
+    std::string getAdmParseError() override;
 
+    // Waits for the ADM to be parsed
     int readAdm(char filePath[2048]);
+    // Returns once the headers (fmt, chna) are read and audio is available - the axml is read and parsed on a worker thread, to be polled for with getAdmParseStatus
+    int readAdmAsync(char filePath[2048]);
+    // Drops the current file (and any mapping or open handles on it) - waiting for any parse still in progress
+    void close();
+
+    // Applies to the current file and any subsequently read
+    bool setAudioReadAhead(float readAheadSec);
+    // Applies to the current file and any subsequently read
+    void setAudioCacheBudget(uint64_t budgetBytes);
+    // Applies to files read from now on
+    void setAudioAccessMode(AudioAccessMode mode);
+    // How essence is read from disk (BUFFERED and PRELOADED modes) - applies to files read from now on
+    void setAudioIoBackend(EssenceIoBackend backend);
+    EssenceIoBackend getAudioIoBackend();
+    // Cache only the channels used by discovered items (in the filtered programme, if set) - applies to the current file and any subsequently read.
+    // In PRELOADED mode, only channels with a CHNA entry are loaded (applies to files read from now on).
+    void setAudioCacheReferencedChannelsOnly(bool referencedOnly);
+    void setAudioProgrammeFilter(int audioProgrammeId); // -1 for all programmes
+    void updateCachedAudioChannels(); // Call when new items are discovered
+    // Keep only this many seconds of audioBlockFormats (ahead of the render position) in memory - 0 for all. Applies to files read from now on.
+    void setLazyBlockFormatsWindow(double windowSec);
+    // Where flattened metadata is cached between loads of the same content (see MetadataCache) - empty (the default) to not cache.
+    // Takes precedence over a lazy block window. Applies to files read from now on.
+    void setMetadataCacheDirectory(const std::string& cacheDirectory);
+    // Whether the current file's metadata came from the cache, rather than being parsed
+    bool isMetadataFromCache();
 
 private:
+    std::string filePath;
+    float audioReadAheadSec{ 0.0 };
+    uint64_t audioCacheBudgetBytes{ defaultAudioCacheBudgetBytes };
+    bool audioCacheReferencedChannelsOnly{ false };
+    int audioProgrammeFilter{ -1 };
+    AudioAccessMode audioAccessMode{ AudioAccessMode::BUFFERED };
+    EssenceIoBackend audioIoBackend{ EssenceIoBackend::AUTO };
+    double lazyBlockFormatsWindowSec{ 0.0 };
+    std::string metadataCacheDirectory;
+    std::shared_ptr<MappedFile> mappedFile;
     std::shared_ptr<adm::Document> parsedDocument;
-    std::shared_ptr<bw64::Bw64Reader> bw64Reader;
+    Bw64Layout layout;
     std::vector<bw64::AudioId> audioIds;
-    std::shared_ptr<Bw64AudioExtractor> audioExtractor;
+    ChnaIndex chnaIndex;
+    std::shared_ptr<AudioExtractor> audioExtractor;
+    std::shared_ptr<Bw64AudioExtractor> bw64AudioExtractor; // Same as audioExtractor when in BUFFERED mode, otherwise null
     std::shared_ptr<MetadataExtractor> metadataExtractor;
 
-    void reflectChnaRefsInAdm();
+    // Worker thread reading and parsing the axml - publishes parsedDocument and metadataExtractor (under admParseMutex) when done.
+    // Reads filePath and layout, which are left alone until it's done.
+    std::thread admParseThread;
+    std::mutex admParseMutex;
+    AdmParseStatus admParseStatus{ AdmParseStatus::NONE };
+    std::string admParseError;
+    bool metadataFromCache{ false };
+    void parseAdm(double lazyBlockFormatsWindowSec, std::string metadataCacheDirectory);
 };
 
-FileReader* getFileReaderSingleton();
+class MemoryReader : public Reader
+{
+    // BW64 content the host already has in memory (e.g, from a packed asset or a network fetch).
+    // The axml and chna chunks are parsed in place, and audio is served straight out of the caller's buffer - nothing is copied,
+    //  so the buffer must stay valid and unchanged until the next read or close.
+public:
+    MemoryReader();
+    ~MemoryReader();
+
+    std::shared_ptr<AudioExtractor> getAudio() override;
+    std::shared_ptr<MetadataExtractor> getMetadata() override;
+
+    int getChannelNumFor(std::shared_ptr<adm::AudioTrackUid> audioTrackUid) override;
+    AdmParseStatus getAdmParseStatus() override; // Always parsed by the time readAdm returns
+    std::string getAdmParseError() override; // Never FAILED - readAdm logs why it failed
+
+    int readAdm(const void* data, uint64_t size);
+    void close();
+    // As FileReader - applies to content read from now on
+    void setLazyBlockFormatsWindow(double windowSec);
+
+private:
+    const uint8_t* data{ nullptr };
+    uint64_t size{ 0 };
+    double lazyBlockFormatsWindowSec{ 0.0 };
+    std::shared_ptr<adm::Document> parsedDocument;
+    std::vector<bw64::AudioId> audioIds;
+    ChnaIndex chnaIndex;
+    std::shared_ptr<AudioExtractor> audioExtractor;
+    std::shared_ptr<MetadataExtractor> metadataExtractor;
+};
+
+struct SadmIngestStats {
+    uint64_t frameCount;        // Merged in to the document
+    uint64_t failedFrameCount;  // Couldn't be parsed or merged - skipped
+    double lastLatencyMs;       // From the last byte of a frame arriving to its content being discoverable
+    double meanLatencyMs;
+    double maxLatencyMs;
+    bool feedEnded;
+};
+
+class SadmReader : public Reader
+{
+    // Serial ADM (see SadmFrames) - frames are read and parsed on a worker thread as they arrive, then merged in to one growing document
+    //  on the host's thread whenever it next asks for metadata. So one MetadataExtractor discovers items and sends blocks as they turn up.
+    // Metadata only - the audio travels with whatever carries the feed, so there's no AudioExtractor.
+public:
+    SadmReader();
+    ~SadmReader();
+
+    std::shared_ptr<AudioExtractor> getAudio() override; // Always null
+    std::shared_ptr<MetadataExtractor> getMetadata() override; // Merges frames ingested since last asked. Null until the first frame.
+
+    int getChannelNumFor(std::shared_ptr<adm::AudioTrackUid> audioTrackUid) override; // From the transportTrackFormats seen so far
+    AdmParseStatus getAdmParseStatus() override; // PARSING until the first frame is merged - FAILED if the feed ends or errors before then
+    std::string getAdmParseError() override; // Also, once READY, why the latest frame was skipped or the feed ended early
+
+    // Returns once the feed is open - frames are then ingested until it ends or is closed
+    int readSadm(const std::string& path);
+    // Stops ingesting and drops the document. Waits for a read in progress - on Windows, that's until the feed next delivers or closes.
+    void close();
+    SadmIngestStats getIngestStats();
+
+private:
+    struct IngestedFrame {
+        std::shared_ptr<adm::Document> document;
+        std::vector<std::pair<uint32_t, int>> transportTracks;
+        std::chrono::steady_clock::time_point receivedTime;
+    };
+    void ingest(); // Runs on ingestThread
+    void mergeIngestedFrames();
+
+    SadmFeed feed;
+    bool reading{ false };
+    std::thread ingestThread;
+    std::atomic<bool> stopIngest{ false };
+    // Shared with ingestThread
+    std::mutex ingestMutex;
+    std::deque<IngestedFrame> ingestedFrames;
+    uint64_t failedFrameCount{ 0 };
+    bool feedEnded{ false };
+    std::string ingestError;
+
+    std::shared_ptr<adm::Document> parsedDocument;
+    ChnaIndex chnaIndex;
+    std::shared_ptr<MetadataExtractor> metadataExtractor;
+    uint64_t mergedFrameCount{ 0 };
+    double lastLatencyMs{ 0.0 };
+    double totalLatencyMs{ 0.0 };
+    double maxLatencyMs{ 0.0 };
+};
@@ -0,0 +1,275 @@
+#include "SadmFrames.h"
+#include "ChnaIndex.h"
+#include "XmlScan.h"
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    const std::string_view frameEndTag = "</frame>";
+#ifndef _WIN32
+    const int feedPollIntervalMs = 50; // How often a wait for data checks whether to stop
+#endif
+
+    std::string_view trimmed(std::string_view text)
+    {
+        const char* whitespace = " \t\r\n";
+        size_t first = text.find_first_not_of(whitespace);
+        if(first == std::string_view::npos) return {};
+        return text.substr(first, text.find_last_not_of(whitespace) - first + 1);
+    }
+
+    template<typename ElementT>
+    std::shared_ptr<ElementT> counterpartIn(const std::shared_ptr<adm::Document>& document, const std::shared_ptr<ElementT>& element)
+    {
+        return document->lookup(element->template get<typename ElementT::id_type>());
+    }
+
+    // Copied without their references, so adding them can't pull in elements belonging to the frame's document
+    template<typename ElementT>
+    void addNewElements(const std::shared_ptr<adm::Document>& document, const std::shared_ptr<adm::Document>& frameDocument)
+    {
+        for(auto& element : frameDocument->template getElements<ElementT>()) {
+            if(!counterpartIn(document, element)) {
+                document->add(element->copy());
+            }
+        }
+    }
+
+    // Calls link(frameElement, documentElement) for each element of this type in the frame
+    template<typename ElementT, typename LinkT>
+    void linkElements(const std::shared_ptr<adm::Document>& document, const std::shared_ptr<adm::Document>& frameDocument, LinkT link)
+    {
+        for(auto& element : frameDocument->template getElements<ElementT>()) {
+            auto counterpart = counterpartIn(document, element);
+            if(counterpart) link(element, counterpart);
+        }
+    }
+
+    // True if any were new to it
+    template<typename ReferenceT, typename ElementT>
+    bool linkReferences(const std::shared_ptr<adm::Document>& document, const std::shared_ptr<ElementT>& from, const std::shared_ptr<ElementT>& to)
+    {
+        size_t referenceCount = to->template getReferences<ReferenceT>().size();
+        for(auto& reference : from->template getReferences<ReferenceT>()) {
+            auto target = counterpartIn(document, reference);
+            if(target) to->addReference(target); // No-op if already referenced
+        }
+        return to->template getReferences<ReferenceT>().size() != referenceCount;
+    }
+
+    template<typename ReferenceT, typename ElementT>
+    void linkReference(const std::shared_ptr<adm::Document>& document, const std::shared_ptr<ElementT>& from, const std::shared_ptr<ElementT>& to)
+    {
+        auto reference = from->template getReference<ReferenceT>();
+        if(reference && !to->template getReference<ReferenceT>()) {
+            auto target = counterpartIn(document, reference);
+            if(target) to->setReference(target);
+        }
+    }
+
+    template<typename BlockT>
+    int64_t rtimeNsOf(const BlockT& block)
+    {
+        return block.template has<adm::Rtime>() ? block.template get<adm::Rtime>().get().count() : 0;
+    }
+
+    template<typename BlockT>
+    void appendNewBlocks(const std::shared_ptr<adm::AudioChannelFormat>& from, const std::shared_ptr<adm::AudioChannelFormat>& to)
+    {
+        auto blocks = to->template getElements<BlockT>();
+        bool haveBlocks = blocks.size() > 0;
+        int64_t latestRtimeNs = haveBlocks ? rtimeNsOf(blocks[blocks.size() - 1]) : 0;
+        for(auto& block : from->template getElements<BlockT>()) {
+            int64_t rtimeNs = rtimeNsOf(block);
+            if(haveBlocks && rtimeNs <= latestRtimeNs) continue; // Already have it - frames repeat any block spanning their boundary
+            to->add(block);
+            haveBlocks = true;
+            latestRtimeNs = rtimeNs;
+        }
+    }
+}
+
+void SadmFrameSplitter::append(const char* data, size_t size)
+{
+    buffer.append(data, size);
+}
+
+bool SadmFrameSplitter::next(std::string& frame)
+{
+    size_t frameEnd = std::string_view(buffer).find(frameEndTag, searchedTo);
+    if(frameEnd == std::string_view::npos) {
+        // The end tag may be arriving in pieces, so only rule out where it couldn't start
+        searchedTo = buffer.size() >= frameEndTag.size() ? buffer.size() - frameEndTag.size() + 1 : 0;
+        return false;
+    }
+    frameEnd += frameEndTag.size();
+    frame.assign(buffer, 0, frameEnd);
+    buffer.erase(0, frameEnd);
+    searchedTo = 0;
+    return true;
+}
+
+void SadmFrameSplitter::clear()
+{
+    buffer.clear();
+    searchedTo = 0;
+}
+
+std::vector<std::pair<uint32_t, int>> parseSadmTransportTracks(const std::string& frame)
+{
+    // <transportTrackFormat ...><audioTrack trackID="1"><audioTrackUIDRef>ATU_00000001</audioTrackUIDRef></audioTrack>...
+    std::vector<std::pair<uint32_t, int>> tracks;
+    std::string_view xml(frame);
+    size_t headerEnd = findStartTag(xml, "audioFormatExtended", 0);
+    if(headerEnd != std::string_view::npos) xml = xml.substr(0, headerEnd);
+
+    size_t position = 0;
+    while((position = findStartTag(xml, "audioTrack", position)) != std::string_view::npos) {
+        size_t openTagEnd = findTagEnd(xml, position);
+        if(openTagEnd == std::string_view::npos) break;
+        std::string_view openTag = xml.substr(position, openTagEnd - position);
+        if(openTag[openTag.size() - 2] == '/') {
+            position = openTagEnd; // No UIDs on this track
+            continue;
+        }
+        size_t closeTag = xml.find("</audioTrack>", openTagEnd);
+        if(closeTag == std::string_view::npos) break;
+
+        int trackId = std::atoi(attributeValue(openTag, "trackID").c_str()); // 1-based, as a CHNA trackIndex
+        size_t refPosition = openTagEnd;
+        while(trackId > 0 && (refPosition = findStartTag(xml, "audioTrackUIDRef", refPosition)) != std::string_view::npos && refPosition < closeTag) {
+            size_t valueStart = findTagEnd(xml, refPosition);
+            size_t valueEnd = valueStart == std::string_view::npos ? valueStart : xml.find('<', valueStart);
+            if(valueEnd == std::string_view::npos || valueEnd > closeTag) break;
+            uint32_t audioTrackUidValue;
+            if(parseAudioTrackUidValue(std::string(trimmed(xml.substr(valueStart, valueEnd - valueStart))), audioTrackUidValue)) {
+                tracks.emplace_back(audioTrackUidValue, trackId - 1);
+            }
+            refPosition = valueEnd;
+        }
+        position = closeTag;
+    }
+    return tracks;
+}
+
+void mergeSadmFrame(std::shared_ptr<adm::Document> document, std::shared_ptr<adm::Document> frameDocument, SadmMergeChanges& changes)
+{
+    // Everything first, so references can be linked whichever order elements appear in
+    addNewElements<adm::AudioProgramme>(document, frameDocument);
+    addNewElements<adm::AudioContent>(document, frameDocument);
+    addNewElements<adm::AudioObject>(document, frameDocument);
+    addNewElements<adm::AudioPackFormat>(document, frameDocument);
+    addNewElements<adm::AudioChannelFormat>(document, frameDocument);
+    addNewElements<adm::AudioStreamFormat>(document, frameDocument);
+    addNewElements<adm::AudioTrackFormat>(document, frameDocument);
+    addNewElements<adm::AudioTrackUid>(document, frameDocument);
+
+    linkElements<adm::AudioProgramme>(document, frameDocument, [&document, &changes](auto& from, auto& to) {
+        if(linkReferences<adm::AudioContent>(document, from, to)) changes.audioProgrammes.push_back(to);
+    });
+    linkElements<adm::AudioContent>(document, frameDocument, [&document, &changes](auto& from, auto& to) {
+        if(linkReferences<adm::AudioObject>(document, from, to)) changes.audioContents.push_back(to);
+    });
+    linkElements<adm::AudioObject>(document, frameDocument, [&document, &changes](auto& from, auto& to) {
+        bool objectsAdded = linkReferences<adm::AudioObject>(document, from, to);
+        linkReferences<adm::AudioPackFormat>(document, from, to);
+        bool audioTrackUidsAdded = linkReferences<adm::AudioTrackUid>(document, from, to);
+        if(objectsAdded || audioTrackUidsAdded) changes.audioObjects.push_back(to);
+    });
+    linkElements<adm::AudioPackFormat>(document, frameDocument, [&document](auto& from, auto& to) {
+        linkReferences<adm::AudioChannelFormat>(document, from, to);
+        linkReferences<adm::AudioPackFormat>(document, from, to);
+    });
+    linkElements<adm::AudioChannelFormat>(document, frameDocument, [](auto& from, auto& to) {
+        appendNewBlocks<adm::AudioBlockFormatObjects>(from, to);
+        appendNewBlocks<adm::AudioBlockFormatDirectSpeakers>(from, to);
+        appendNewBlocks<adm::AudioBlockFormatHoa>(from, to);
+    });
+    linkElements<adm::AudioStreamFormat>(document, frameDocument, [&document](auto& from, auto& to) {
+        linkReference<adm::AudioChannelFormat>(document, from, to);
+        linkReference<adm::AudioPackFormat>(document, from, to);
+    });
+    linkElements<adm::AudioTrackFormat>(document, frameDocument, [&document](auto& from, auto& to) {
+        linkReference<adm::AudioStreamFormat>(document, from, to);
+    });
+    linkElements<adm::AudioTrackUid>(document, frameDocument, [&document](auto& from, auto& to) {
+        linkReference<adm::AudioTrackFormat>(document, from, to);
+        linkReference<adm::AudioPackFormat>(document, from, to);
+    });
+}
+
+SadmFeed::SadmFeed()
+{
+}
+
+SadmFeed::~SadmFeed()
+{
+    close();
+}
+
+bool SadmFeed::open(const std::string& path, std::string& error)
+{
+    close();
+#ifdef _WIN32
+    fd = _open(path.c_str(), _O_RDONLY | _O_BINARY);
+#else
+    fd = ::open(path.c_str(), O_RDONLY | O_NONBLOCK); // Non-blocking so opening a pipe doesn't wait for a writer
+#endif
+    if(fd < 0) {
+        error = "Can not open S-ADM feed " + path;
+        return false;
+    }
+    return true;
+}
+
+int64_t SadmFeed::read(char* buffer, size_t size, const std::atomic<bool>& stop, std::string& error)
+{
+#ifdef _WIN32
+    if(stop) return -1;
+    int count = _read(fd, buffer, (unsigned int)std::min(size, (size_t)INT_MAX));
+    if(count < 0) {
+        error = "Failed reading S-ADM feed";
+        return -1;
+    }
+    return count;
+#else
+    while(!stop) {
+        pollfd pollFd{ fd, POLLIN, 0 };
+        int ready = poll(&pollFd, 1, feedPollIntervalMs);
+        if(ready == 0) continue;
+        if(ready > 0) {
+            ssize_t count = ::read(fd, buffer, size);
+            if(count >= 0) return count; // 0 once a pipe's writer has closed it, or at the end of a file
+        }
+        if(errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) continue;
+        error = std::string("Failed reading S-ADM feed: ") + std::strerror(errno);
+        return -1;
+    }
+    return -1;
+#endif
+}
+
+void SadmFeed::close()
+{
+    if(fd >= 0) {
+#ifdef _WIN32
+        _close(fd);
+#else
+        ::close(fd);
+#endif
+        fd = -1;
+    }
+}
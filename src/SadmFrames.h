@@ -0,0 +1,60 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <adm/adm.hpp>
+
+// Serial ADM (ITU-R BS.2125) arrives as a sequence of <frame> documents - each a frameHeader (timing, and a transportTrackFormat
+//  mapping tracks to audioTrackUIDs) and the audioFormatExtended active for that frame. Consecutive frames largely repeat each other;
+//  what's new is mostly the audioBlockFormats for the frame's period.
+
+// Cuts a byte stream of concatenated frames in to whole frames, however it's chunked on arrival
+class SadmFrameSplitter
+{
+public:
+    void append(const char* data, size_t size);
+    // False until a whole frame is buffered - anything before it (XML declarations, whitespace) is included
+    bool next(std::string& frame);
+    size_t getBufferedSize() const { return buffer.size(); }
+    void clear();
+
+private:
+    std::string buffer;
+    size_t searchedTo{ 0 }; // No frame end tag before here
+};
+
+// (audioTrackUID value, 0-based channel number) for each audioTrackUIDRef in the frame header's transportTrackFormat
+std::vector<std::pair<uint32_t, int>> parseSadmTransportTracks(const std::string& frame);
+
+// The document's programmes, contents and objects a merge linked new references from (including any new to the document) -
+//  what a MetadataExtractor needs to be told of, as it only otherwise looks at elements added to the document (see markReferencesAdded)
+struct SadmMergeChanges {
+    std::vector<std::shared_ptr<adm::AudioProgramme>> audioProgrammes;
+    std::vector<std::shared_ptr<adm::AudioContent>> audioContents;
+    std::vector<std::shared_ptr<adm::AudioObject>> audioObjects;
+};
+
+// Merges a parsed frame in to the document built from the frames before it. Elements new to the document are copied in, references
+//  the frame adds are linked up, and blocks later than any the channel format already has are appended - so anything holding elements
+//  of the document (like a MetadataExtractor) sees them grow rather than being replaced. Throws if libadm rejects an element or reference.
+void mergeSadmFrame(std::shared_ptr<adm::Document> document, std::shared_ptr<adm::Document> frameDocument, SadmMergeChanges& changes);
+
+class SadmFeed
+{
+    // A local file of concatenated frames or, as a stand-in for a live feed, a named pipe (FIFO / Windows named pipe) being written to.
+public:
+    SadmFeed();
+    ~SadmFeed();
+
+    bool open(const std::string& path, std::string& error);
+    // Bytes read (up to size), 0 at the end of the feed, or -1 on error (with reason in error). Returns -1 with no error if stop is set.
+    // Waits for data - on POSIX, checking stop periodically. On Windows, only once data (or the end of the feed) arrives.
+    int64_t read(char* buffer, size_t size, const std::atomic<bool>& stop, std::string& error);
+    void close();
+
+private:
+    int fd{ -1 };
+};
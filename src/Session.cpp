@@ -0,0 +1,36 @@
+#include "Session.h"
+
+Session::Session()
+{
+}
+
+Session::~Session()
+{
+    // Readers' worker threads may still be running - stop them before anything they use goes
+    SessionScope scope(this);
+    fileReader.close();
+    memoryReader.close();
+    sadmReader.close();
+}
+
+Reader* Session::getActiveReader()
+{
+    return activeReader ? activeReader : &fileReader;
+}
+
+void Session::setActiveReader(Reader* reader)
+{
+    if(reader != &fileReader) fileReader.close();
+    if(reader != &memoryReader) memoryReader.close();
+    if(reader != &sadmReader) sadmReader.close();
+    activeReader = reader;
+}
+
+SessionScope::SessionScope(Session* session) : previousExceptionHandler{ setCurrentExceptionHandler(session->getExceptionHandler()) }
+{
+}
+
+SessionScope::~SessionScope()
+{
+    setCurrentExceptionHandler(previousExceptionHandler);
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "Readers.h"
+#include "BearRender.h"
+#include "ExceptionHandler.h"
+
+class Session
+{
+    // Everything one host player needs - a reader of each kind, a renderer, and its own latest exception.
+    // Sessions share nothing, so each can be driven from its own thread. Within a session, the audio reads (getAudioBlock*,
+    //  isAudioChannelSilent*) and getLatestException may be called concurrently - as several AudioSources do from their callbacks.
+    //  Everything else (opening, metadata, BEAR setup and rendering) must be serialised with all other calls on the session.
+public:
+    Session();
+    ~Session();
+
+    FileReader* getFileReader() { return &fileReader; }
+    MemoryReader* getMemoryReader() { return &memoryReader; }
+    SadmReader* getSadmReader() { return &sadmReader; }
+    BearRender* getBearRender() { return &bearRender; }
+    ExceptionHandler* getExceptionHandler() { return &exceptionHandler; }
+
+    // Whichever reader last read something - where audio and metadata are served from. The file reader until told otherwise.
+    Reader* getActiveReader();
+    // Closes the others, so only one holds content (and open files) at a time
+    void setActiveReader(Reader* reader);
+
+private:
+    ExceptionHandler exceptionHandler;
+    FileReader fileReader;
+    MemoryReader memoryReader;
+    SadmReader sadmReader;
+    BearRender bearRender; // After the readers, so it lets go of their audio first
+    Reader* activeReader{ nullptr };
+};
+
+class SessionScope
+{
+    // For the duration of a C API call - routes getExceptionHandler() on this thread to the session's own
+public:
+    SessionScope(Session* session);
+    ~SessionScope();
+
+private:
+    ExceptionHandler* previousExceptionHandler;
+};
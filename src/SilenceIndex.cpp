@@ -0,0 +1,82 @@
+#include "SilenceIndex.h"
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+
+namespace {
+    inline int64_t blockCeil(int64_t frame)
+    {
+        return frame <= 0 ? 0 : (frame + SilenceIndex::blockFrames - 1) / SilenceIndex::blockFrames;
+    }
+
+    inline bool isSilentRun(const float* samples, int64_t stride, int64_t count)
+    {
+        // Bit test rather than == 0.0f so -0.0 counts but denormals don't get special treatment
+        uint32_t accumulated = 0;
+        for(int64_t i = 0; i < count; i++) {
+            uint32_t bits;
+            std::memcpy(&bits, samples + i * stride, sizeof(bits));
+            accumulated |= bits;
+        }
+        return (accumulated & 0x7FFFFFFF) == 0;
+    }
+}
+
+SilenceIndex::SilenceIndex(int channelCount, int64_t fileFrames) : channelCount{ channelCount }, fileFrames{ fileFrames }
+{
+    blockCount = blockCeil(fileFrames);
+    wordsPerChannel = (blockCount + 63) / 64;
+    wordCount = channelCount * wordsPerChannel;
+    scannedBits = std::make_unique<std::atomic<uint64_t>[]>(wordCount);
+    silentBits = std::make_unique<std::atomic<uint64_t>[]>(wordCount);
+    for(int64_t word = 0; word < wordCount; word++) {
+        scannedBits[word].store(0, std::memory_order_relaxed);
+        silentBits[word].store(0, std::memory_order_relaxed);
+    }
+}
+
+void SilenceIndex::scan(const AudioSegment& segment, const int* channelNums, int slotCount)
+{
+    int64_t firstBlock = blockCeil(segment.startFrame);
+    int64_t endBlock = std::min(segment.endFrame / blockFrames, blockCount); // Exclusive
+    if(segment.endFrame >= fileFrames) endBlock = blockCount;
+
+    for(int64_t block = firstBlock; block < endBlock; block++) {
+        int64_t blockStart = block * blockFrames;
+        int64_t blockEnd = std::min(blockStart + blockFrames, segment.endFrame);
+        const float* blockSamples = segment.samples + (blockStart - segment.startFrame) * segment.frameStride;
+        for(int slot = 0; slot < slotCount; slot++) {
+            int channelNum = channelNums[slot];
+            if(channelNum < 0 || channelNum >= channelCount) continue;
+            setBit(silentBits.get(), channelNum, block, isSilentRun(blockSamples + slot * segment.channelStride, segment.frameStride, blockEnd - blockStart), std::memory_order_relaxed);
+            setBit(scannedBits.get(), channelNum, block, true, std::memory_order_release);
+        }
+    }
+}
+
+bool SilenceIndex::isSilent(int channelNum, int64_t startFrame, int64_t endFrame) const
+{
+    if(channelNum < 0 || channelNum >= channelCount) return false;
+    startFrame = std::max(startFrame, (int64_t)0);
+    endFrame = std::min(endFrame, fileFrames);
+    if(startFrame >= endFrame) return true;
+
+    for(int64_t block = startFrame / blockFrames; block <= (endFrame - 1) / blockFrames; block++) {
+        if(!testBit(scannedBits.get(), channelNum, block, std::memory_order_acquire) || !testBit(silentBits.get(), channelNum, block, std::memory_order_relaxed)) return false;
+    }
+    return true;
+}
+
+uint64_t SilenceIndex::getScannedBlockCount() const
+{
+    uint64_t count = 0;
+    for(int64_t word = 0; word < wordCount; word++) count += std::bitset<64>(scannedBits[word].load(std::memory_order_relaxed)).count();
+    return count;
+}
+
+uint64_t SilenceIndex::getSilentBlockCount() const
+{
+    uint64_t count = 0;
+    for(int64_t word = 0; word < wordCount; word++) count += std::bitset<64>(silentBits[word].load(std::memory_order_relaxed)).count();
+    return count;
+}
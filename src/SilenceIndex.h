@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include "ReadAhead.h"
+
+class SilenceIndex
+{
+    // Records, per channel and per block of blockFrames, which parts of a file are entirely digital silence.
+    // Built up as audio passes through (window fills, preloading) - blocks not yet seen count as not silent.
+    // Thread-safe - blocks can be scanned and queried from any number of threads at once. A block only counts as scanned once its silence bit is in place.
+
+public:
+    static const int64_t blockFrames = 1024;
+
+    SilenceIndex(int channelCount, int64_t fileFrames);
+
+    // Records every whole block within the segment. channelNums gives the file channel held in each slot of the segment.
+    // The final, partial block of the file counts as whole once the segment reaches the end of the file.
+    void scan(const AudioSegment& segment, const int* channelNums, int slotCount);
+
+    // True only if every frame of [startFrame, endFrame) is known to be silent. Anything outside the file is silent.
+    bool isSilent(int channelNum, int64_t startFrame, int64_t endFrame) const;
+
+    uint64_t getScannedBlockCount() const;
+    uint64_t getSilentBlockCount() const;
+
+private:
+    int channelCount;
+    int64_t fileFrames;
+    int64_t blockCount;
+    int64_t wordsPerChannel;
+    int64_t wordCount;
+    // Bit per block, channel-major
+    std::unique_ptr<std::atomic<uint64_t>[]> scannedBits;
+    std::unique_ptr<std::atomic<uint64_t>[]> silentBits;
+
+    inline bool testBit(const std::atomic<uint64_t>* bits, int channelNum, int64_t block, std::memory_order order) const
+    {
+        return (bits[channelNum * wordsPerChannel + block / 64].load(order) >> (block % 64)) & 1;
+    }
+    inline void setBit(std::atomic<uint64_t>* bits, int channelNum, int64_t block, bool value, std::memory_order order)
+    {
+        std::atomic<uint64_t>& word = bits[channelNum * wordsPerChannel + block / 64];
+        uint64_t mask = (uint64_t)1 << (block % 64);
+        if(value) {
+            word.fetch_or(mask, order);
+        } else {
+            word.fetch_and(~mask, order);
+        }
+    }
+};
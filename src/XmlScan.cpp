@@ -0,0 +1,55 @@
+#include "XmlScan.h"
+
+namespace {
+    bool isNameEnd(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '>' || c == '/';
+    }
+}
+
+size_t findStartTag(std::string_view xml, std::string_view name, size_t from)
+{
+    while((from = xml.find(name, from)) != std::string_view::npos) {
+        size_t nameEnd = from + name.size();
+        if(from > 0 && xml[from - 1] == '<' && nameEnd < xml.size() && isNameEnd(xml[nameEnd])) return from - 1;
+        from = nameEnd;
+    }
+    return std::string_view::npos;
+}
+
+size_t findTagEnd(std::string_view xml, size_t tagStart)
+{
+    char quote = 0;
+    for(size_t position = tagStart; position < xml.size(); position++) {
+        char c = xml[position];
+        if(quote) {
+            if(c == quote) quote = 0;
+        } else if(c == '"' || c == '\'') {
+            quote = c;
+        } else if(c == '>') {
+            return position + 1;
+        }
+    }
+    return std::string_view::npos;
+}
+
+std::string attributeValue(std::string_view tag, std::string_view name)
+{
+    size_t position = 0;
+    while((position = tag.find(name, position)) != std::string_view::npos) {
+        size_t valueStart = position + name.size();
+        bool wholeName = position > 0 && (tag[position - 1] == ' ' || tag[position - 1] == '\t' || tag[position - 1] == '\r' || tag[position - 1] == '\n');
+        while(valueStart < tag.size() && tag[valueStart] == ' ') valueStart++;
+        if(wholeName && valueStart + 1 < tag.size() && tag[valueStart] == '=') {
+            valueStart++;
+            while(valueStart < tag.size() && tag[valueStart] == ' ') valueStart++;
+            if(valueStart < tag.size() && (tag[valueStart] == '"' || tag[valueStart] == '\'')) {
+                size_t valueEnd = tag.find(tag[valueStart], valueStart + 1);
+                if(valueEnd == std::string_view::npos) return {};
+                return std::string(tag.substr(valueStart + 1, valueEnd - valueStart - 1));
+            }
+        }
+        position = valueStart;
+    }
+    return {};
+}
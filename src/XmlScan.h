@@ -0,0 +1,13 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Just enough XML scanning to find elements in ADM text without a full parse - namespace-prefixed names aren't recognised.
+
+// Position of the next "<name" start tag (not a longer name sharing the prefix), or npos
+size_t findStartTag(std::string_view xml, std::string_view name, size_t from);
+// Position just after the '>' closing the tag starting at tagStart (skipping any in attribute values), or npos
+size_t findTagEnd(std::string_view xml, size_t tagStart);
+// Value of the named attribute within a start tag - empty if absent
+std::string attributeValue(std::string_view tag, std::string_view name);
@@ -1,49 +1,275 @@
 #include "main.h"
 
-#include "Readers.h"
-#include "BearRender.h"
-#include "ExceptionHandler.h"
+#include "Session.h"
 
 #include <limits.h>
+#include <algorithm>
 
 #define CSHARP_BOOL uint32_t
 
+namespace {
+    // The 32-bit entry points use INT_MAX for an unbounded upper frame bound - keep it unbounded beyond 2^31 frames
+    inline int64_t widenUpperFrameBound(int upperFrameBound)
+    {
+        return upperFrameBound == INT_MAX ? INT64_MAX : upperFrameBound;
+    }
+
+    // Only BUFFERED file audio has an I/O backend, read-ahead and cache - null while a memory or S-ADM reader is active
+    std::shared_ptr<Bw64AudioExtractor> getActiveBw64Audio(Session* session)
+    {
+        if(session->getActiveReader() != session->getFileReader()) return nullptr;
+        return session->getFileReader()->getBw64Audio();
+    }
+}
+
 extern "C"
 {
 
-    DLLEXPORT int readAdm(char filePath[2048])
+    DLLEXPORT Session* createSession()
+    {
+        // Every other entry point takes a session - each holds its own file, renderer and latest exception.
+        // Sessions are independent, so several can be used at once from different threads.
+        return new Session();
+    }
+
+    DLLEXPORT void destroySession(Session* session)
+    {
+        // Closes any file or feed (waiting for worker threads) and frees everything - the handle is invalid after this
+        delete session;
+    }
+
+    DLLEXPORT int readAdm(Session* session, char filePath[2048])
+    {
+        SessionScope scope(session);
+        session->setActiveReader(session->getFileReader());
+        return session->getFileReader()->readAdm(filePath);
+    }
+
+    DLLEXPORT int readAdmAsync(Session* session, char filePath[2048])
+    {
+        // Audio is available on return - poll getAdmParseStatus for the metadata
+        SessionScope scope(session);
+        session->setActiveReader(session->getFileReader());
+        return session->getFileReader()->readAdmAsync(filePath);
+    }
+
+    DLLEXPORT int getAdmParseStatus(Session* session)
+    {
+        SessionScope scope(session);
+        auto status = session->getActiveReader()->getAdmParseStatus();
+        if(status == AdmParseStatus::FAILED) {
+            getExceptionHandler()->logException(session->getActiveReader()->getAdmParseError());
+        }
+        return (int)status;
+    }
+
+    DLLEXPORT int readAdmFromMemory(Session* session, const void* data, uint64_t size)
+    {
+        // Not copied - the caller must keep data valid and unchanged until the next readAdm/readAdmFromMemory
+        SessionScope scope(session);
+        session->setActiveReader(session->getMemoryReader());
+        return session->getMemoryReader()->readAdm(data, size);
+    }
+
+    DLLEXPORT int readSadm(Session* session, char feedPath[2048])
+    {
+        // A file of concatenated S-ADM frames, or a named pipe being fed them. Metadata only - there's no audio from this reader.
+        // Poll getAdmParseStatus for the first frame, then discover and pull blocks as usual while more arrive.
+        SessionScope scope(session);
+        session->setActiveReader(session->getSadmReader());
+        return session->getSadmReader()->readSadm(feedPath);
+    }
+
+    DLLEXPORT CSHARP_BOOL getSadmIngestStats(Session* session, uint64_t* frameCount, uint64_t* failedFrameCount, double* lastLatencyMs, double* meanLatencyMs, double* maxLatencyMs, CSHARP_BOOL* feedEnded)
     {
-        return getFileReaderSingleton()->readAdm(filePath);
+        SessionScope scope(session);
+        auto stats = session->getSadmReader()->getIngestStats();
+        *frameCount = stats.frameCount;
+        *failedFrameCount = stats.failedFrameCount;
+        *lastLatencyMs = stats.lastLatencyMs;
+        *meanLatencyMs = stats.meanLatencyMs;
+        *maxLatencyMs = stats.maxLatencyMs;
+        *feedEnded = stats.feedEnded;
+        return session->getActiveReader() == session->getSadmReader();
     }
 
-    DLLEXPORT const char* getLatestException()
+    DLLEXPORT const char* getLatestException(Session* session)
     {
-        return getExceptionHandler()->getLatestException();
+        return session->getExceptionHandler()->getLatestException();
     }
 
-    DLLEXPORT int discoverNewRenderableItems()
+    DLLEXPORT int discoverNewRenderableItems(Session* session)
     {
-        auto metadataExtractor = getFileReaderSingleton()->getMetadata();
+        SessionScope scope(session);
+        auto metadataExtractor = session->getActiveReader()->getMetadata();
         if(!metadataExtractor) {
+            if(session->getActiveReader()->getAdmParseStatus() == AdmParseStatus::PARSING) return 0; // Nothing to discover yet - not an error
             getExceptionHandler()->logException("Library Error: No metadataExtractor initialised!");
             return 0;
         }
-        return metadataExtractor->discoverNewRenderableItems();
+        int newCount = metadataExtractor->discoverNewRenderableItems();
+        if(newCount > 0) {
+            session->getFileReader()->updateCachedAudioChannels();
+        }
+        return newCount;
     }
 
-    DLLEXPORT CSHARP_BOOL getNextMetadataBlock(MetadataBlock* metadataBlock)
+    DLLEXPORT CSHARP_BOOL getNextMetadataBlock(Session* session, MetadataBlock* metadataBlock)
     {
-        auto metadataExtractor = getFileReaderSingleton()->getMetadata();
+        SessionScope scope(session);
+        auto metadataExtractor = session->getActiveReader()->getMetadata();
         if(!metadataExtractor) {
+            if(session->getActiveReader()->getAdmParseStatus() == AdmParseStatus::PARSING) return false;
             getExceptionHandler()->logException("Library Error: No metadataExtractor initialised!");
             return false;
         }
+        getExceptionHandler()->clearException(); // Clear because this method can return false without an exception.
         return metadataExtractor->getNextMetadataBlock(metadataBlock);
     }
 
-    DLLEXPORT int getSampleRate()
+    DLLEXPORT int getNextMetadataBlocks(Session* session, MetadataBlock metadataBlocks[], int capacity, uint64_t itemIdFilter, int typeDefinitionFilter)
     {
-        auto audioExtractor = getFileReaderSingleton()->getAudio();
+        // Fills up to capacity blocks in one call, returning how many. itemIdFilter 0 and typeDefinitionFilter -1 match everything -
+        //  blocks of unmatched items stay queued for a later pull.
+        SessionScope scope(session);
+        auto metadataExtractor = session->getActiveReader()->getMetadata();
+        if(!metadataExtractor) {
+            if(session->getActiveReader()->getAdmParseStatus() == AdmParseStatus::PARSING) return 0;
+            getExceptionHandler()->logException("Library Error: No metadataExtractor initialised!");
+            return 0;
+        }
+        getExceptionHandler()->clearException(); // Clear because this method can return 0 without an exception.
+        MetadataBlockFilter filter;
+        filter.itemId = itemIdFilter;
+        filter.typeDefinition = typeDefinitionFilter;
+        return metadataExtractor->getNextMetadataBlocks(metadataBlocks, capacity, filter);
+    }
+
+    DLLEXPORT int getNextBlockRecords(Session* session, BlockRecord blockRecords[], int capacity, uint64_t itemIdFilter, int typeDefinitionFilter)
+    {
+        // As getNextMetadataBlocks, but without the per-item values - use getItemDescriptor for those whenever a record's descriptorRevision is new.
+        SessionScope scope(session);
+        auto metadataExtractor = session->getActiveReader()->getMetadata();
+        if(!metadataExtractor) {
+            if(session->getActiveReader()->getAdmParseStatus() == AdmParseStatus::PARSING) return 0;
+            getExceptionHandler()->logException("Library Error: No metadataExtractor initialised!");
+            return 0;
+        }
+        getExceptionHandler()->clearException(); // Clear because this method can return 0 without an exception.
+        MetadataBlockFilter filter;
+        filter.itemId = itemIdFilter;
+        filter.typeDefinition = typeDefinitionFilter;
+        return metadataExtractor->getNextBlockRecords(blockRecords, capacity, filter);
+    }
+
+    DLLEXPORT CSHARP_BOOL getItemDescriptor(Session* session, uint64_t itemId, ItemDescriptor* itemDescriptor)
+    {
+        SessionScope scope(session);
+        auto metadataExtractor = session->getActiveReader()->getMetadata();
+        if(!metadataExtractor) {
+            if(session->getActiveReader()->getAdmParseStatus() == AdmParseStatus::PARSING) return false;
+            getExceptionHandler()->logException("Library Error: No metadataExtractor initialised!");
+            return false;
+        }
+        return metadataExtractor->getItemDescriptor(itemId, itemDescriptor);
+    }
+
+    DLLEXPORT int getMetadataBlocksInRange(Session* session, double fromSec, double toSec, MetadataBlock metadataBlocks[], int capacity, uint64_t itemIdFilter, int typeDefinitionFilter)
+    {
+        // Per item, the block in effect at fromSec and those starting by toSec - doesn't affect getNextMetadataBlock(s).
+        // Returns how many there are, which may exceed capacity (only capacity are filled in). Filters as getNextMetadataBlocks.
+        SessionScope scope(session);
+        auto metadataExtractor = session->getActiveReader()->getMetadata();
+        if(!metadataExtractor) {
+            if(session->getActiveReader()->getAdmParseStatus() == AdmParseStatus::PARSING) return 0;
+            getExceptionHandler()->logException("Library Error: No metadataExtractor initialised!");
+            return 0;
+        }
+        getExceptionHandler()->clearException(); // Clear because this method can return 0 without an exception.
+        MetadataBlockFilter filter;
+        filter.itemId = itemIdFilter;
+        filter.typeDefinition = typeDefinitionFilter;
+        return metadataExtractor->getMetadataBlocksInRange(fromSec, toSec, metadataBlocks, capacity, filter);
+    }
+
+    DLLEXPORT CSHARP_BOOL seekMetadata(Session* session, double positionSec)
+    {
+        // getNextMetadataBlock(s) carry on from the blocks in effect at positionSec. Also sets the render position (see setMetadataRenderPosition).
+        SessionScope scope(session);
+        auto metadataExtractor = session->getActiveReader()->getMetadata();
+        if(!metadataExtractor) {
+            if(session->getActiveReader()->getAdmParseStatus() == AdmParseStatus::PARSING) return false;
+            getExceptionHandler()->logException("Library Error: No metadataExtractor initialised!");
+            return false;
+        }
+        metadataExtractor->seek(positionSec);
+        return true;
+    }
+
+    DLLEXPORT void setMetadataBlockWindow(Session* session, double windowSec)
+    {
+        // 0 keeps every audioBlockFormat in memory. Applies to content read from now on.
+        SessionScope scope(session);
+        session->getFileReader()->setLazyBlockFormatsWindow(windowSec);
+        session->getMemoryReader()->setLazyBlockFormatsWindow(windowSec);
+    }
+
+    DLLEXPORT void setMetadataCacheDirectory(Session* session, char cacheDirectory[2048])
+    {
+        // Empty to not cache. Applies to files read from now on - memory and S-ADM content is never cached.
+        SessionScope scope(session);
+        session->getFileReader()->setMetadataCacheDirectory(cacheDirectory);
+    }
+
+    DLLEXPORT CSHARP_BOOL isMetadataFromCache(Session* session)
+    {
+        SessionScope scope(session);
+        return session->getFileReader()->isMetadataFromCache();
+    }
+
+    DLLEXPORT CSHARP_BOOL setMetadataRenderPosition(Session* session, double positionSec)
+    {
+        SessionScope scope(session);
+        auto metadataExtractor = session->getActiveReader()->getMetadata();
+        if(!metadataExtractor) {
+            if(session->getActiveReader()->getAdmParseStatus() == AdmParseStatus::PARSING) return false;
+            getExceptionHandler()->logException("Library Error: No metadataExtractor initialised!");
+            return false;
+        }
+        metadataExtractor->setRenderPosition(positionSec);
+        return true;
+    }
+
+    DLLEXPORT CSHARP_BOOL setMetadataDiscoveryThreads(Session* session, int threadCount)
+    {
+        // 0 for one per hardware thread, 1 to discover on the calling thread alone. Applies to the current content's later discoveries.
+        SessionScope scope(session);
+        auto metadataExtractor = session->getActiveReader()->getMetadata();
+        if(!metadataExtractor) {
+            if(session->getActiveReader()->getAdmParseStatus() == AdmParseStatus::PARSING) return false;
+            getExceptionHandler()->logException("Library Error: No metadataExtractor initialised!");
+            return false;
+        }
+        metadataExtractor->setDiscoveryThreadCount(threadCount);
+        return true;
+    }
+
+    DLLEXPORT uint64_t getMetadataMaterialisedBlockCount(Session* session)
+    {
+        SessionScope scope(session);
+        auto metadataExtractor = session->getActiveReader()->getMetadata();
+        if(!metadataExtractor) {
+            if(session->getActiveReader()->getAdmParseStatus() == AdmParseStatus::PARSING) return 0;
+            getExceptionHandler()->logException("Library Error: No metadataExtractor initialised!");
+            return 0;
+        }
+        return metadataExtractor->getMaterialisedBlockCount();
+    }
+
+    DLLEXPORT int getSampleRate(Session* session)
+    {
+        SessionScope scope(session);
+        auto audioExtractor = session->getActiveReader()->getAudio();
         if(!audioExtractor) {
             getExceptionHandler()->logException("Library Error: No audioExtractor initialised!");
             return 0;
@@ -51,9 +277,21 @@ extern "C"
         return audioExtractor->getSampleRate();
     }
 
-    DLLEXPORT int getNumberOfFrames()
+    DLLEXPORT int getNumberOfFrames(Session* session)
     {
-        auto audioExtractor = getFileReaderSingleton()->getAudio();
+        SessionScope scope(session);
+        auto audioExtractor = session->getActiveReader()->getAudio();
+        if(!audioExtractor) {
+            getExceptionHandler()->logException("Library Error: No audioExtractor initialised!");
+            return 0;
+        }
+        return (int)std::min(audioExtractor->getNumberOfFrames(), (int64_t)INT_MAX); // Use getNumberOfFrames64 for long-form files
+    }
+
+    DLLEXPORT int64_t getNumberOfFrames64(Session* session)
+    {
+        SessionScope scope(session);
+        auto audioExtractor = session->getActiveReader()->getAudio();
         if(!audioExtractor) {
             getExceptionHandler()->logException("Library Error: No audioExtractor initialised!");
             return 0;
@@ -61,9 +299,21 @@ extern "C"
         return audioExtractor->getNumberOfFrames();
     }
 
-    DLLEXPORT CSHARP_BOOL getAudioBlockBounded(int startFrame, int numFrames, int channelNums[], int channelNumsSize, int lowerFrameBound, int upperFrameBound, float outputBuffer[])
+    DLLEXPORT CSHARP_BOOL getAudioBlockBounded(Session* session, int startFrame, int numFrames, int channelNums[], int channelNumsSize, int lowerFrameBound, int upperFrameBound, float outputBuffer[])
     {
-        auto audioExtractor = getFileReaderSingleton()->getAudio();
+        SessionScope scope(session);
+        auto audioExtractor = session->getActiveReader()->getAudio();
+        if(!audioExtractor) {
+            getExceptionHandler()->logException("Library Error: No audioExtractor initialised!");
+            return false;
+        }
+        return audioExtractor->getAudioBlock(startFrame, numFrames, channelNums, channelNumsSize, lowerFrameBound, widenUpperFrameBound(upperFrameBound), outputBuffer);
+    }
+
+    DLLEXPORT CSHARP_BOOL getAudioBlockBounded64(Session* session, int64_t startFrame, int numFrames, int channelNums[], int channelNumsSize, int64_t lowerFrameBound, int64_t upperFrameBound, float outputBuffer[])
+    {
+        SessionScope scope(session);
+        auto audioExtractor = session->getActiveReader()->getAudio();
         if(!audioExtractor) {
             getExceptionHandler()->logException("Library Error: No audioExtractor initialised!");
             return false;
@@ -71,113 +321,300 @@ extern "C"
         return audioExtractor->getAudioBlock(startFrame, numFrames, channelNums, channelNumsSize, lowerFrameBound, upperFrameBound, outputBuffer);
     }
 
-    DLLEXPORT CSHARP_BOOL getAudioBlock(int startFrame, int numFrames, int channelNums[], int channelNumsSize, float outputBuffer[])
+    DLLEXPORT CSHARP_BOOL getAudioBlock(Session* session, int startFrame, int numFrames, int channelNums[], int channelNumsSize, float outputBuffer[])
+    {
+        SessionScope scope(session);
+        auto audioExtractor = session->getActiveReader()->getAudio();
+        if(!audioExtractor) {
+            getExceptionHandler()->logException("Library Error: No audioExtractor initialised!");
+            return false;
+        }
+        return audioExtractor->getAudioBlock(startFrame, numFrames, channelNums, channelNumsSize, 0, INT64_MAX, outputBuffer);
+    }
+
+    DLLEXPORT CSHARP_BOOL getAudioBlock64(Session* session, int64_t startFrame, int numFrames, int channelNums[], int channelNumsSize, float outputBuffer[])
+    {
+        SessionScope scope(session);
+        auto audioExtractor = session->getActiveReader()->getAudio();
+        if(!audioExtractor) {
+            getExceptionHandler()->logException("Library Error: No audioExtractor initialised!");
+            return false;
+        }
+        return audioExtractor->getAudioBlock(startFrame, numFrames, channelNums, channelNumsSize, 0, INT64_MAX, outputBuffer);
+    }
+
+    DLLEXPORT CSHARP_BOOL isAudioChannelSilent(Session* session, int channelNum, int startFrame, int numFrames)
+    {
+        SessionScope scope(session);
+        auto audioExtractor = session->getActiveReader()->getAudio();
+        if(!audioExtractor) {
+            getExceptionHandler()->logException("Library Error: No audioExtractor initialised!");
+            return false;
+        }
+        return audioExtractor->isSilent(channelNum, startFrame, (int64_t)startFrame + numFrames);
+    }
+
+    DLLEXPORT CSHARP_BOOL isAudioChannelSilent64(Session* session, int channelNum, int64_t startFrame, int numFrames)
+    {
+        SessionScope scope(session);
+        auto audioExtractor = session->getActiveReader()->getAudio();
+        if(!audioExtractor) {
+            getExceptionHandler()->logException("Library Error: No audioExtractor initialised!");
+            return false;
+        }
+        return audioExtractor->isSilent(channelNum, startFrame, startFrame + numFrames);
+    }
+
+    DLLEXPORT CSHARP_BOOL setAudioAccessMode(Session* session, int mode)
+    {
+        SessionScope scope(session);
+        if(mode != (int)AudioAccessMode::BUFFERED && mode != (int)AudioAccessMode::MAPPED && mode != (int)AudioAccessMode::PRELOADED) {
+            getExceptionHandler()->logException("Unknown audio access mode: " + std::to_string(mode));
+            return false;
+        }
+        session->getFileReader()->setAudioAccessMode((AudioAccessMode)mode);
+        return true;
+    }
+
+    DLLEXPORT CSHARP_BOOL setAudioIoBackend(Session* session, int backend)
+    {
+        SessionScope scope(session);
+        if(backend < (int)EssenceIoBackend::AUTO || backend > (int)EssenceIoBackend::IO_URING) {
+            getExceptionHandler()->logException("Unknown audio I/O backend: " + std::to_string(backend));
+            return false;
+        }
+        session->getFileReader()->setAudioIoBackend((EssenceIoBackend)backend);
+        return true;
+    }
+
+    DLLEXPORT int getAudioIoBackend(Session* session)
+    {
+        // What's actually in use after any fallback - -1 if not reading through a backend (non-BUFFERED mode, not reading a file, or the file couldn't be opened)
+        SessionScope scope(session);
+        auto audioExtractor = getActiveBw64Audio(session);
+        if(!audioExtractor) return -1;
+        auto backend = audioExtractor->getIoBackend();
+        return backend ? (int)*backend : -1;
+    }
+
+    DLLEXPORT CSHARP_BOOL setAudioReadAhead(Session* session, float readAheadSec)
     {
-        auto audioExtractor = getFileReaderSingleton()->getAudio();
+        SessionScope scope(session);
+        return session->getFileReader()->setAudioReadAhead(readAheadSec);
+    }
+
+    DLLEXPORT int getAudioReadAheadBufferedFrames(Session* session)
+    {
+        SessionScope scope(session);
+        auto audioExtractor = getActiveBw64Audio(session);
+        if(!audioExtractor) {
+            getExceptionHandler()->logException("Library Error: No audioExtractor initialised!");
+            return 0;
+        }
+        return (int)std::min(audioExtractor->getReadAheadBufferedFrames(), (int64_t)INT_MAX);
+    }
+
+    DLLEXPORT uint64_t getAudioReadAheadUnderrunCount(Session* session)
+    {
+        SessionScope scope(session);
+        auto audioExtractor = getActiveBw64Audio(session);
+        if(!audioExtractor) {
+            getExceptionHandler()->logException("Library Error: No audioExtractor initialised!");
+            return 0;
+        }
+        return audioExtractor->getReadAheadUnderrunCount();
+    }
+
+    DLLEXPORT void setAudioCacheBudget(Session* session, uint64_t budgetBytes)
+    {
+        SessionScope scope(session);
+        session->getFileReader()->setAudioCacheBudget(budgetBytes);
+    }
+
+    DLLEXPORT CSHARP_BOOL getAudioCacheStats(Session* session, uint64_t* hits, uint64_t* misses, uint64_t* evictions, uint64_t* residentBytes)
+    {
+        SessionScope scope(session);
+        *hits = *misses = *evictions = *residentBytes = 0;
+        auto audioExtractor = getActiveBw64Audio(session);
         if(!audioExtractor) {
             getExceptionHandler()->logException("Library Error: No audioExtractor initialised!");
             return false;
         }
-        return audioExtractor->getAudioBlock(startFrame, numFrames, channelNums, channelNumsSize, 0, INT_MAX, outputBuffer);
+        auto stats = audioExtractor->getCacheStats();
+        *hits = stats.hits;
+        *misses = stats.misses;
+        *evictions = stats.evictions;
+        *residentBytes = stats.residentBytes;
+        return true;
+    }
+
+    DLLEXPORT void setAudioCacheReferencedChannelsOnly(Session* session, CSHARP_BOOL referencedOnly)
+    {
+        // Only files are cached or preloaded, so applies to the file reader whichever reader is active
+        SessionScope scope(session);
+        session->getFileReader()->setAudioCacheReferencedChannelsOnly(referencedOnly);
+    }
+
+    DLLEXPORT void setAudioProgrammeFilter(Session* session, int audioProgrammeId)
+    {
+        SessionScope scope(session);
+        session->getFileReader()->setAudioProgrammeFilter(audioProgrammeId);
     }
 
     // BEAR
 
-    DLLEXPORT CSHARP_BOOL setupBear(int maxObjectsChannels, int maxDirectSpeakersChannels, int maxHoaChannels)
+    DLLEXPORT CSHARP_BOOL setupBear(Session* session, int maxObjectsChannels, int maxDirectSpeakersChannels, int maxHoaChannels)
     {
-        auto audioExtractor = getFileReaderSingleton()->getAudio();
+        SessionScope scope(session);
+        auto audioExtractor = session->getActiveReader()->getAudio();
         if(!audioExtractor) {
             getExceptionHandler()->logException("Library Error: No audioExtractor initialised!");
             return false;
         }
-        return getBearSingleton()->setupBear(audioExtractor, maxObjectsChannels, maxDirectSpeakersChannels, maxHoaChannels);
+        return session->getBearRender()->setupBear(audioExtractor, maxObjectsChannels, maxDirectSpeakersChannels, maxHoaChannels);
     }
 
-    DLLEXPORT CSHARP_BOOL setupBearEx(int maxObjectsChannels, int maxDirectSpeakersChannels, int maxHoaChannels, int maxAnticipatedBlockFrameRequest, int rendererInternalBlockFrameCount, char dataPath[2048], char fftImpl[64])
+    DLLEXPORT CSHARP_BOOL setupBearEx(Session* session, int maxObjectsChannels, int maxDirectSpeakersChannels, int maxHoaChannels, int maxAnticipatedBlockFrameRequest, int rendererInternalBlockFrameCount, char dataPath[2048], char fftImpl[64])
     {
-        auto audioExtractor = getFileReaderSingleton()->getAudio();
+        SessionScope scope(session);
+        auto audioExtractor = session->getActiveReader()->getAudio();
         if(!audioExtractor) {
             getExceptionHandler()->logException("Library Error: No audioExtractor initialised!");
             return false;
         }
-        return getBearSingleton()->setupBear(audioExtractor, maxObjectsChannels, maxDirectSpeakersChannels, maxHoaChannels, maxAnticipatedBlockFrameRequest, rendererInternalBlockFrameCount, std::string{ dataPath }, std::string{ fftImpl });
+        return session->getBearRender()->setupBear(audioExtractor, maxObjectsChannels, maxDirectSpeakersChannels, maxHoaChannels, maxAnticipatedBlockFrameRequest, rendererInternalBlockFrameCount, std::string{ dataPath }, std::string{ fftImpl });
+    }
+
+    DLLEXPORT CSHARP_BOOL restartBear(Session* session)
+    {
+        SessionScope scope(session);
+        return session->getBearRender()->restartBear();
     }
 
-    DLLEXPORT CSHARP_BOOL restartBear()
+    DLLEXPORT CSHARP_BOOL prewarnBearRender(Session* session, int startFrame, int numFrames)
     {
-        return getBearSingleton()->restartBear();
+        SessionScope scope(session);
+        return session->getBearRender()->prewarnBearRender(startFrame, numFrames);
     }
 
-    DLLEXPORT CSHARP_BOOL prewarnBearRender(int startFrame, int numFrames)
+    DLLEXPORT CSHARP_BOOL prewarnBearRenderSrc(Session* session, int startFrame, int numFrames, int basedOnSampleRate, int srcType)
     {
-        return getBearSingleton()->prewarnBearRender(startFrame, numFrames);
+        SessionScope scope(session);
+        return session->getBearRender()->prewarnBearRender(startFrame, numFrames, basedOnSampleRate, srcType);
     }
 
-    DLLEXPORT CSHARP_BOOL prewarnBearRenderSrc(int startFrame, int numFrames, int basedOnSampleRate, int srcType)
+    DLLEXPORT CSHARP_BOOL prewarnBearRender64(Session* session, int64_t startFrame, int numFrames)
     {
-        return getBearSingleton()->prewarnBearRender(startFrame, numFrames, basedOnSampleRate, srcType);
+        SessionScope scope(session);
+        return session->getBearRender()->prewarnBearRender(startFrame, numFrames);
     }
 
-    DLLEXPORT CSHARP_BOOL getBearRender(int objectInputChannelNums[], int objectInputChannelNumsSize,
+    DLLEXPORT CSHARP_BOOL prewarnBearRenderSrc64(Session* session, int64_t startFrame, int numFrames, int basedOnSampleRate, int srcType)
+    {
+        SessionScope scope(session);
+        return session->getBearRender()->prewarnBearRender(startFrame, numFrames, basedOnSampleRate, srcType);
+    }
+
+    DLLEXPORT CSHARP_BOOL getBearRender(Session* session, int objectInputChannelNums[], int objectInputChannelNumsSize,
                                         int directSpeakersInputChannelNums[], int directSpeakersInputChannelNumsSize,
                                         int hoaInputChannelNums[], int hoaInputChannelNumsSize,
                                         float outputBuffer[])
     {
-        return getBearSingleton()->getBearRender(objectInputChannelNums, objectInputChannelNumsSize,
+        SessionScope scope(session);
+        return session->getBearRender()->getBearRender(objectInputChannelNums, objectInputChannelNumsSize,
                                                  directSpeakersInputChannelNums, directSpeakersInputChannelNumsSize,
                                                  hoaInputChannelNums, hoaInputChannelNumsSize,
                                                  outputBuffer);
     }
 
-    DLLEXPORT CSHARP_BOOL getBearRenderBounded(int objectInputChannelNums[], int objectInputAudioBounds[], int objectInputCount,
+    DLLEXPORT CSHARP_BOOL getBearRenderBounded(Session* session, int objectInputChannelNums[], int objectInputAudioBounds[], int objectInputCount,
                                                int directSpeakersInputChannelNums[], int directSpeakersInputAudioBounds[], int directSpeakersInputCount,
                                                int hoaInputChannelNums[], int hoaInputAudioBounds[], int hoaInputCount,
                                                float outputBuffer[], int outputBufferStartFrame, CSHARP_BOOL outputOverwrite)
     {
-        return getBearSingleton()->getBearRenderBounded(objectInputChannelNums, objectInputAudioBounds, objectInputCount,
+        SessionScope scope(session);
+        return session->getBearRender()->getBearRenderBounded(objectInputChannelNums, objectInputAudioBounds, objectInputCount,
+                                                 directSpeakersInputChannelNums, directSpeakersInputAudioBounds, directSpeakersInputCount,
+                                                 hoaInputChannelNums, hoaInputAudioBounds, hoaInputCount,
+                                                 outputBuffer, outputBufferStartFrame, outputOverwrite);
+    }
+
+    DLLEXPORT CSHARP_BOOL getBearRenderBounded64(Session* session, int objectInputChannelNums[], int64_t objectInputAudioBounds[], int objectInputCount,
+                                                 int directSpeakersInputChannelNums[], int64_t directSpeakersInputAudioBounds[], int directSpeakersInputCount,
+                                                 int hoaInputChannelNums[], int64_t hoaInputAudioBounds[], int hoaInputCount,
+                                                 float outputBuffer[], int outputBufferStartFrame, CSHARP_BOOL outputOverwrite)
+    {
+        SessionScope scope(session);
+        return session->getBearRender()->getBearRenderBounded(objectInputChannelNums, objectInputAudioBounds, objectInputCount,
                                                  directSpeakersInputChannelNums, directSpeakersInputAudioBounds, directSpeakersInputCount,
                                                  hoaInputChannelNums, hoaInputAudioBounds, hoaInputCount,
                                                  outputBuffer, outputBufferStartFrame, outputOverwrite);
     }
 
-    DLLEXPORT void setBearOutputGain(float gain)
+    DLLEXPORT void setBearOutputGain(Session* session, float gain)
+    {
+        SessionScope scope(session);
+        session->getBearRender()->setOutputGain(gain);
+    }
+
+    DLLEXPORT CSHARP_BOOL addBearObjectMetadata(Session* session, int forBearChannel, MetadataBlock* metadataBlock)
+    {
+        SessionScope scope(session);
+        return session->getBearRender()->addObjectMetadata(forBearChannel, metadataBlock);
+    }
+
+    DLLEXPORT CSHARP_BOOL addBearDirectSpeakersMetadata(Session* session, int forBearChannel, MetadataBlock* metadataBlock)
+    {
+        SessionScope scope(session);
+        return session->getBearRender()->addDirectSpeakersMetadata(forBearChannel, metadataBlock);
+    }
+
+    DLLEXPORT CSHARP_BOOL addBearHoaMetadata(Session* session, int forBearChannels[], MetadataBlock* metadataBlock)
     {
-        getBearSingleton()->setOutputGain(gain);
+        SessionScope scope(session);
+        return session->getBearRender()->addHoaMetadata(forBearChannels, metadataBlock);
     }
 
-    DLLEXPORT CSHARP_BOOL addBearObjectMetadata(int forBearChannel, MetadataBlock* metadataBlock)
+    DLLEXPORT CSHARP_BOOL addBearObjectBlock(Session* session, int forBearChannel, ItemDescriptor* itemDescriptor, BlockRecord* blockRecord)
     {
-        return getBearSingleton()->addObjectMetadata(forBearChannel, metadataBlock);
+        SessionScope scope(session);
+        return session->getBearRender()->addObjectBlock(forBearChannel, itemDescriptor, blockRecord);
     }
 
-    DLLEXPORT CSHARP_BOOL addBearDirectSpeakersMetadata(int forBearChannel, MetadataBlock* metadataBlock)
+    DLLEXPORT CSHARP_BOOL addBearDirectSpeakersBlock(Session* session, int forBearChannel, ItemDescriptor* itemDescriptor, BlockRecord* blockRecord)
     {
-        return getBearSingleton()->addDirectSpeakersMetadata(forBearChannel, metadataBlock);
+        SessionScope scope(session);
+        return session->getBearRender()->addDirectSpeakersBlock(forBearChannel, itemDescriptor, blockRecord);
     }
 
-    DLLEXPORT CSHARP_BOOL addBearHoaMetadata(int forBearChannels[], MetadataBlock* metadataBlock)
+    DLLEXPORT CSHARP_BOOL addBearHoaBlock(Session* session, int forBearChannels[], ItemDescriptor* itemDescriptor, BlockRecord* blockRecord)
     {
-        return getBearSingleton()->addHoaMetadata(forBearChannels, metadataBlock);
+        SessionScope scope(session);
+        return session->getBearRender()->addHoaBlock(forBearChannels, itemDescriptor, blockRecord);
     }
 
-    DLLEXPORT CSHARP_BOOL setListener(float position_x, float position_y, float position_z , float orientation_w, float orientation_x, float orientation_y, float orientation_z)
+    DLLEXPORT CSHARP_BOOL setListener(Session* session, float position_x, float position_y, float position_z , float orientation_w, float orientation_x, float orientation_y, float orientation_z)
     {
-        return getBearSingleton()->setListener(position_x, position_y, position_z , orientation_w, orientation_x, orientation_y, orientation_z);
+        SessionScope scope(session);
+        return session->getBearRender()->setListener(position_x, position_y, position_z , orientation_w, orientation_x, orientation_y, orientation_z);
     }
 
-    DLLEXPORT CSHARP_BOOL getListenerLook(float* orientation_x, float* orientation_y, float* orientation_z)
+    DLLEXPORT CSHARP_BOOL getListenerLook(Session* session, float* orientation_x, float* orientation_y, float* orientation_z)
     {
-        return getBearSingleton()->getListenerLook(orientation_x, orientation_y, orientation_z);
+        SessionScope scope(session);
+        return session->getBearRender()->getListenerLook(orientation_x, orientation_y, orientation_z);
     }
 
-    DLLEXPORT CSHARP_BOOL getListenerUp(float* orientation_x, float* orientation_y, float* orientation_z)
+    DLLEXPORT CSHARP_BOOL getListenerUp(Session* session, float* orientation_x, float* orientation_y, float* orientation_z)
     {
-        return getBearSingleton()->getListenerUp(orientation_x, orientation_y, orientation_z);
+        SessionScope scope(session);
+        return session->getBearRender()->getListenerUp(orientation_x, orientation_y, orientation_z);
     }
 
-    DLLEXPORT CSHARP_BOOL getListenerRight(float* orientation_x, float* orientation_y, float* orientation_z)
+    DLLEXPORT CSHARP_BOOL getListenerRight(Session* session, float* orientation_x, float* orientation_y, float* orientation_z)
     {
-        return getBearSingleton()->getListenerRight(orientation_x, orientation_y, orientation_z);
+        SessionScope scope(session);
+        return session->getBearRender()->getListenerRight(orientation_x, orientation_y, orientation_z);
     }
 }
 